@@ -3,9 +3,11 @@
 
 // generated using ls | sed -E "s_(.*)_#include <routingkit/\1>_"
 
+#include <routingkit/astar.h>
 #include <routingkit/bit_vector.h>
 #include <routingkit/constants.h>
 #include <routingkit/contraction_hierarchy.h>
+#include <routingkit/contraction_hierarchy_phast.h>
 #include <routingkit/customizable_contraction_hierarchy.h>
 #include <routingkit/dijkstra.h>
 #include <routingkit/filter.h>
@@ -16,6 +18,7 @@
 #include <routingkit/id_queue.h>
 #include <routingkit/id_set_queue.h>
 #include <routingkit/inverse_vector.h>
+#include <routingkit/landmark_potential.h>
 #include <routingkit/min_max.h>
 #include <routingkit/nested_dissection.h>
 #include <routingkit/osm_decoder.h>
@@ -28,5 +31,6 @@
 #include <routingkit/timer.h>
 #include <routingkit/timestamp_flag.h>
 #include <routingkit/vector_io.h>
+#include <routingkit/vector_view.h>
 
 #endif
@@ -0,0 +1,225 @@
+#ifndef ROUTING_KIT_ASTAR_H
+#define ROUTING_KIT_ASTAR_H
+
+#include <routingkit/id_queue.h>
+#include <routingkit/constants.h>
+#include <routingkit/timestamp_flag.h>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+namespace RoutingKit{
+
+// A* is Dijkstra's algorithm guided towards a single target by a potential. The potential
+// is an object with a member
+//
+//   unsigned operator()(unsigned node, unsigned target)const;
+//
+// that returns a lower bound on the distance from node to target. The bound must be
+// consistent, i.e., for every arc xy with weight w, potential(x,t) <= w + potential(y,t)
+// must hold. The bound must be smaller than inf_weight. The potential is not copied and
+// can therefore be shared by several AStar objects.
+//
+// Nodes are settled in the order of their distance plus potential. If the potential is
+// consistent, a node's distance is final once it is settled. The search is finished once
+// the target is settled.
+template<class Potential, class Queue = MinIDQueue>
+class AStar{
+public:
+	AStar():first_out(nullptr), potential(nullptr), target(invalid_id){}
+
+	AStar(const std::vector<unsigned>&first_out, const std::vector<unsigned>&tail, const std::vector<unsigned>&head, const Potential&potential):
+		tentative_distance(first_out.size()-1),
+		predecessor_arc(first_out.size()-1),
+		node_potential(first_out.size()-1),
+		was_pushed(first_out.size()-1),
+		was_popped(first_out.size()-1),
+		queue(first_out.size()-1),
+		first_out(&first_out),
+		tail(&tail),
+		head(&head),
+		potential(&potential),
+		target(invalid_id){
+		assert(!first_out.empty());
+		assert(first_out.front() == 0);
+		assert(first_out.back() == tail.size());
+		assert(first_out.back() == head.size());
+	}
+
+	AStar&reset(unsigned target){
+		assert(first_out != nullptr && "object must have an attached graph");
+		assert(target < first_out->size()-1);
+		queue.clear();
+		was_pushed.reset_all();
+		was_popped.reset_all();
+		this->target = target;
+		return *this;
+	}
+
+	AStar&add_source(unsigned id, unsigned departure_time = 0){
+		assert(id < first_out->size()-1);
+		assert(target != invalid_id && "reset must be called with a target before adding sources");
+		if(!was_pushed.is_set(id)){
+			was_pushed.set(id);
+			node_potential[id] = (*potential)(id, target);
+			assert(node_potential[id] < inf_weight);
+			queue.push({id, departure_time + node_potential[id]});
+		}else if(departure_time < tentative_distance[id]){
+			queue.decrease_key({id, departure_time + node_potential[id]});
+		}else{
+			return *this;
+		}
+		tentative_distance[id] = departure_time;
+		predecessor_arc[id] = invalid_id;
+		return *this;
+	}
+
+	bool is_finished()const{
+		return queue.empty() || was_popped.is_set(target);
+	}
+
+	bool was_node_reached(unsigned x)const{
+		assert(x < first_out->size()-1);
+		return was_popped.is_set(x);
+	}
+
+	struct SettleResult{
+		unsigned node;
+		unsigned distance;
+	};
+
+	template<class GetWeightFunc>
+	SettleResult settle(const GetWeightFunc&get_weight){
+		assert(!is_finished());
+
+		unsigned x = queue.pop().id;
+		unsigned distance_to_x = tentative_distance[x];
+		was_popped.set(x);
+
+		for(unsigned a=(*first_out)[x]; a<(*first_out)[x+1]; ++a){
+			unsigned y = (*head)[a];
+			if(was_popped.is_set(y))
+				continue;
+			unsigned w = get_weight(a, distance_to_x);
+			if(w >= inf_weight)
+				continue;
+			unsigned d = distance_to_x + w;
+			if(!was_pushed.is_set(y)){
+				was_pushed.set(y);
+				node_potential[y] = (*potential)(y, target);
+				assert(node_potential[y] < inf_weight);
+				queue.push({y, d + node_potential[y]});
+			}else if(d < tentative_distance[y]){
+				queue.decrease_key({y, d + node_potential[y]});
+			}else{
+				continue;
+			}
+			tentative_distance[y] = d;
+			predecessor_arc[y] = a;
+		}
+		return SettleResult{x, distance_to_x};
+	}
+
+	unsigned get_distance_to(unsigned x) const {
+		assert(x < first_out->size()-1);
+		if(was_popped.is_set(x))
+			return tentative_distance[x];
+		else
+			return inf_weight;
+	}
+
+	std::vector<unsigned>get_node_path_to(unsigned x) const {
+		assert(x < first_out->size()-1);
+		std::vector<unsigned>path;
+		if(was_node_reached(x)){
+			unsigned p;
+			while(p = predecessor_arc[x], p != invalid_id){
+				path.push_back(x);
+				x = (*tail)[p];
+			}
+			path.push_back(x);
+			std::reverse(path.begin(), path.end());
+		}
+		return path;
+	}
+
+	std::vector<unsigned>get_arc_path_to(unsigned x) const {
+		assert(x < first_out->size()-1);
+		std::vector<unsigned>path;
+		if(was_node_reached(x)){
+			unsigned p;
+			while(p = predecessor_arc[x], p != invalid_id){
+				path.push_back(p);
+				x = (*tail)[p];
+			}
+			std::reverse(path.begin(), path.end());
+		}
+		return path;
+	}
+
+private:
+	std::vector<unsigned>tentative_distance;
+	std::vector<unsigned>predecessor_arc;
+	std::vector<unsigned>node_potential;
+
+	TimestampFlags was_pushed;
+	TimestampFlags was_popped;
+	Queue queue;
+
+	const std::vector<unsigned>*first_out;
+	const std::vector<unsigned>*tail;
+	const std::vector<unsigned>*head;
+	const Potential*potential;
+	unsigned target;
+};
+
+// A potential for AStar that is the straight-line distance between node and target
+// multiplied by weight_per_meter. The nodes are stored as 3D points in meters in separate
+// x, y, and z arrays, so evaluating the potential needs no trigonometric functions. The
+// straight line through the earth is never longer than the great-circle distance.
+//
+// weight_per_meter must be small enough that no arc xy has a weight smaller than
+// weight_per_meter times the straight-line distance between x and y. Otherwise, the
+// potential is not consistent and AStar can return paths that are too long. Pass the value
+// computed by compute_largest_valid_weight_per_meter for the weights used in the search.
+// Factors derived from the unit of the weights, such as 1 for geo distances in meters, are
+// only valid if every weight is rounded up. The geo distances and travel times computed by
+// RoutingKit are rounded down, so an arc can be shorter than the straight line.
+class GeoDistancePotential{
+public:
+	GeoDistancePotential():weight_per_meter(0){}
+
+	GeoDistancePotential(const std::vector<float>&latitude, const std::vector<float>&longitude, double weight_per_meter);
+
+	unsigned node_count()const{
+		return x.size();
+	}
+
+	unsigned operator()(unsigned node, unsigned target)const{
+		assert(node < node_count());
+		assert(target < node_count());
+		double
+			dx = x[node] - x[target],
+			dy = y[node] - y[target],
+			dz = z[node] - z[target];
+		double p = weight_per_meter * sqrt(dx*dx + dy*dy + dz*dz);
+		// Capping a consistent potential keeps it consistent.
+		if(p < inf_weight)
+			return (unsigned)p;
+		else
+			return inf_weight-1;
+	}
+
+	static double compute_largest_valid_weight_per_meter(
+		const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, const std::vector<unsigned>&weight,
+		const std::vector<float>&latitude, const std::vector<float>&longitude
+	);
+
+//private:
+	double weight_per_meter;
+	std::vector<double>x, y, z;
+};
+
+} // RoutingKit
+
+#endif
@@ -5,10 +5,12 @@
 #include <routingkit/timestamp_flag.h>
 #include <routingkit/bit_vector.h>
 #include <routingkit/permutation.h>
+#include <routingkit/vector_view.h>
 
 #include <vector>
 #include <string>
 #include <functional>
+#include <memory>
 #include <cassert>
 #include <type_traits>
 #include <limits.h>
@@ -21,19 +23,22 @@ public:
 
 	static ContractionHierarchy build(
 		unsigned node_count, std::vector<unsigned>tail, std::vector<unsigned>head, std::vector<unsigned>weight,
-		const std::function<void(std::string)>&log_message = std::function<void(std::string)>(), unsigned max_pop_count = default_max_pop_count
+		const std::function<void(std::string)>&log_message = std::function<void(std::string)>(), unsigned max_pop_count = default_max_pop_count,
+		unsigned thread_count = 1
 	);
 
 	static ContractionHierarchy build_given_rank(
 		std::vector<unsigned>rank,
 		std::vector<unsigned>tail, std::vector<unsigned>head, std::vector<unsigned>weight,
-		const std::function<void(std::string)>&log_message = std::function<void(std::string)>(), unsigned max_pop_count = default_max_pop_count
+		const std::function<void(std::string)>&log_message = std::function<void(std::string)>(), unsigned max_pop_count = default_max_pop_count,
+		unsigned thread_count = 1
 	);
 
 	static ContractionHierarchy build_given_order(
 		std::vector<unsigned>order,
 		std::vector<unsigned>tail, std::vector<unsigned>head, std::vector<unsigned>weight,
-		const std::function<void(std::string)>&log_message = std::function<void(std::string)>(), unsigned max_pop_count = default_max_pop_count
+		const std::function<void(std::string)>&log_message = std::function<void(std::string)>(), unsigned max_pop_count = default_max_pop_count,
+		unsigned thread_count = 1
 	);
 
 	static ContractionHierarchy read(std::function<void(char*, unsigned long long)>data_source);
@@ -46,6 +51,11 @@ public:
 	void write(std::ostream&out) const;
 	void save_file(const std::string&file_name) const;
 
+	// Writes the CH in a versioned format in which every array starts at a page boundary.
+	// Such a file is not read by load_file but mapped into memory by ContractionHierarchyView::map_file.
+	void write_mappable(std::function<void(const char*, unsigned long long)>data_sink) const;
+	void save_mappable_file(const std::string&file_name) const;
+
 	unsigned node_count()const{
 		return rank.size();
 	}
@@ -66,6 +76,44 @@ public:
 
 void check_contraction_hierarchy_for_errors(const ContractionHierarchy&ch);
 
+// A read-only view of a CH with the same members as ContractionHierarchy. It either refers
+// to the arrays of a ContractionHierarchy object, which must outlive the view, or to a file
+// written by save_mappable_file. In the latter case, the file is mapped into memory and
+// nothing is copied. The mapping is shared by all copies of the view and is released when
+// the last copy is destroyed. Processes that map the same file share its pages.
+class ContractionHierarchyView{
+public:
+	ContractionHierarchyView(){}
+	ContractionHierarchyView(const ContractionHierarchy&ch);
+
+	static ContractionHierarchyView map_file(const std::string&file_name);
+
+	unsigned node_count()const{
+		return rank.size();
+	}
+
+	// Is false for a default constructed view.
+	explicit operator bool()const{
+		return !forward.first_out.empty();
+	}
+
+	struct Side{
+		ConstVectorView<unsigned>first_out;
+		ConstVectorView<unsigned>head;
+		ConstVectorView<unsigned>weight;
+
+		ConstBitVectorView is_shortcut_an_original_arc;
+		ConstVectorView<unsigned>shortcut_first_arc;
+		ConstVectorView<unsigned>shortcut_second_arc;
+	};
+
+	ConstVectorView<unsigned>rank, order;
+	Side forward, backward;
+
+//private:
+	std::shared_ptr<const void>mapped_file;
+};
+
 template<class Weight>
 struct ContractionHierarchyExtraWeight{
 
@@ -101,18 +149,34 @@ namespace detail{
 	using GetExtraWeightType = typename GetExtraWeightTypeHelper<T>::type;
 }
 
-class ContractionHierarchyQuery{
+// Queue is the priority queue of the forward and the backward search. It can be
+// BasicMinIDQueue<Arity, unsigned> with an Arity of 2, 4, or 8, or MinIDRadixQueue.
+// ContractionHierarchyQuery uses MinIDQueue, i.e., an arity of 4.
+template<class Queue>
+class BasicContractionHierarchyQuery{
 public:
-	ContractionHierarchyQuery():ch(0){}
-	explicit ContractionHierarchyQuery(const ContractionHierarchy&ch);
+	BasicContractionHierarchyQuery():stall_on_demand(true), settled_node_count(0), stalled_node_count(0){}
+	explicit BasicContractionHierarchyQuery(const ContractionHierarchy&ch);
+	explicit BasicContractionHierarchyQuery(ContractionHierarchyView ch);
 
-	ContractionHierarchyQuery&reset();
-	ContractionHierarchyQuery&reset(const ContractionHierarchy&ch);
+	BasicContractionHierarchyQuery&reset();
+	BasicContractionHierarchyQuery&reset(const ContractionHierarchy&ch);
+	BasicContractionHierarchyQuery&reset(ContractionHierarchyView ch);
 
-	ContractionHierarchyQuery&add_source(unsigned s, unsigned dist_to_s = 0);
-	ContractionHierarchyQuery&add_target(unsigned t, unsigned dist_to_t = 0);
+	BasicContractionHierarchyQuery&add_source(unsigned s, unsigned dist_to_s = 0);
+	BasicContractionHierarchyQuery&add_target(unsigned t, unsigned dist_to_t = 0);
 
-	ContractionHierarchyQuery&run();
+	BasicContractionHierarchyQuery&run();
+
+	// Stall-on-demand prunes the searches at nodes that can be reached more cheaply using
+	// a downward arc from a node of higher rank. It is used by run, run_to_pinned_targets,
+	// and run_to_pinned_sources and is enabled by default. The setting survives reset.
+	BasicContractionHierarchyQuery&set_stall_on_demand(bool enabled);
+
+	// The number of nodes popped from the queues and the number of those nodes that were
+	// stalled during the last call to run, run_to_pinned_targets, or run_to_pinned_sources.
+	unsigned get_settled_node_count()const;
+	unsigned get_stalled_node_count()const;
 
 	unsigned get_used_source();
 	unsigned get_used_target();
@@ -124,28 +188,28 @@ public:
 	template<class ExtraWeight, class LinkFunction>
 	detail::GetExtraWeightType<ExtraWeight> get_extra_weight_distance(const ExtraWeight&extra_weight, const LinkFunction&link);
 
-	ContractionHierarchyQuery& reset_source();
-	ContractionHierarchyQuery& pin_targets(const std::vector<unsigned>&);
+	BasicContractionHierarchyQuery& reset_source();
+	BasicContractionHierarchyQuery& pin_targets(const std::vector<unsigned>&);
 	unsigned get_pinned_target_count();
-	ContractionHierarchyQuery& run_to_pinned_targets();
+	BasicContractionHierarchyQuery& run_to_pinned_targets();
 
-	ContractionHierarchyQuery& get_distances_to_targets(unsigned*dist);
+	BasicContractionHierarchyQuery& get_distances_to_targets(unsigned*dist);
 	std::vector<unsigned> get_distances_to_targets();
 
-	ContractionHierarchyQuery& reset_target();
-	ContractionHierarchyQuery& pin_sources(const std::vector<unsigned>&);
+	BasicContractionHierarchyQuery& reset_target();
+	BasicContractionHierarchyQuery& pin_sources(const std::vector<unsigned>&);
 	unsigned get_pinned_source_count();
-	ContractionHierarchyQuery& run_to_pinned_sources();
+	BasicContractionHierarchyQuery& run_to_pinned_sources();
 
-	ContractionHierarchyQuery& get_distances_to_sources(unsigned*dist);
+	BasicContractionHierarchyQuery& get_distances_to_sources(unsigned*dist);
 	std::vector<unsigned> get_distances_to_sources();
 
 	// TODO: Mirror these functions in CCH
 
-	ContractionHierarchyQuery& get_used_sources_to_targets(unsigned*dist);
+	BasicContractionHierarchyQuery& get_used_sources_to_targets(unsigned*dist);
 	std::vector<unsigned> get_used_sources_to_targets();
 
-	ContractionHierarchyQuery& get_used_targets_to_sources(unsigned*dist);
+	BasicContractionHierarchyQuery& get_used_targets_to_sources(unsigned*dist);
 	std::vector<unsigned> get_used_targets_to_sources();
 
 	// The get_extra_weight_distances function follow a pattern.
@@ -193,22 +257,25 @@ public:
 
 	template<class ExtraWeight, class LinkFunction>                                          std::vector<detail::GetExtraWeightType<ExtraWeight>> get_extra_weight_distances_to_targets(const ExtraWeight&extra_weight, const LinkFunction&link);
 	template<class ExtraWeight, class LinkFunction, class TmpContainer>                      std::vector<detail::GetExtraWeightType<ExtraWeight>> get_extra_weight_distances_to_targets(const ExtraWeight&extra_weight, const LinkFunction&link, TmpContainer&tmp);
-	template<class ExtraWeight, class LinkFunction, class TmpContainer, class DistContainer> ContractionHierarchyQuery&                           get_extra_weight_distances_to_targets(const ExtraWeight&extra_weight, const LinkFunction&link, TmpContainer&tmp, DistContainer&dist);
+	template<class ExtraWeight, class LinkFunction, class TmpContainer, class DistContainer> BasicContractionHierarchyQuery&                      get_extra_weight_distances_to_targets(const ExtraWeight&extra_weight, const LinkFunction&link, TmpContainer&tmp, DistContainer&dist);
 	template<class ExtraWeight, class LinkFunction>                                          std::vector<detail::GetExtraWeightType<ExtraWeight>> get_extra_weight_distances_to_sources(const ExtraWeight&extra_weight, const LinkFunction&link);
 	template<class ExtraWeight, class LinkFunction, class TmpContainer>                      std::vector<detail::GetExtraWeightType<ExtraWeight>> get_extra_weight_distances_to_sources(const ExtraWeight&extra_weight, const LinkFunction&link, TmpContainer&tmp);
-	template<class ExtraWeight, class LinkFunction, class TmpContainer, class DistContainer> ContractionHierarchyQuery&                           get_extra_weight_distances_to_sources(const ExtraWeight&extra_weight, const LinkFunction&link, TmpContainer&tmp, DistContainer&dist);
+	template<class ExtraWeight, class LinkFunction, class TmpContainer, class DistContainer> BasicContractionHierarchyQuery&                      get_extra_weight_distances_to_sources(const ExtraWeight&extra_weight, const LinkFunction&link, TmpContainer&tmp, DistContainer&dist);
 
 //private:
-	const ContractionHierarchy*ch;
+	ContractionHierarchyView ch;
 
 	TimestampFlags was_forward_pushed, was_backward_pushed;
-	MinIDQueue forward_queue, backward_queue;
+	Queue forward_queue, backward_queue;
 	std::vector<unsigned>forward_tentative_distance, backward_tentative_distance;
 	std::vector<unsigned>forward_predecessor_node, backward_predecessor_node;
 	std::vector<unsigned>forward_predecessor_arc, backward_predecessor_arc;
 	unsigned shortest_path_meeting_node;
 	unsigned many_to_many_source_or_target_count;
 
+	bool stall_on_demand;
+	unsigned settled_node_count, stalled_node_count;
+
 	enum class InternalState:unsigned{
 		initialized,
 		run,
@@ -219,6 +286,83 @@ public:
 	}state;
 };
 
+typedef BasicContractionHierarchyQuery<MinIDQueue> ContractionHierarchyQuery;
+
+// Computes distance tables from a set of source nodes to a set of target nodes. The backward
+// search of every target is run only once and its search space is stored in buckets at the
+// nodes. Every source then needs a single forward search that scans the buckets of the
+// nodes it settles.
+class ContractionHierarchyManyToMany{
+public:
+	ContractionHierarchyManyToMany():ch(nullptr), target_count(0){}
+	explicit ContractionHierarchyManyToMany(const ContractionHierarchy&ch);
+
+	ContractionHierarchyManyToMany&reset(const ContractionHierarchy&ch);
+
+	// Runs the backward searches and fills the buckets. Afterwards, the buckets are only read
+	// and can be shared by all threads of get_distances.
+	ContractionHierarchyManyToMany&set_targets(const std::vector<unsigned>&target_list, unsigned thread_count = 1);
+	unsigned get_target_count()const;
+
+	// Writes the distance from source_list[i] to target_list[j] to dist[i*get_target_count()+j].
+	// dist must have room for source_list.size()*get_target_count() elements. If no path
+	// exists, the distance is inf_weight. The sources are distributed over thread_count threads.
+	// No memory is allocated, if the object was used with at least as many threads before.
+	ContractionHierarchyManyToMany&get_distances(const std::vector<unsigned>&source_list, unsigned*dist, unsigned thread_count = 1);
+	std::vector<unsigned>get_distances(const std::vector<unsigned>&source_list, unsigned thread_count = 1);
+
+//private:
+	struct SearchState{
+		TimestampFlags was_pushed;
+		MinIDQueue queue;
+		std::vector<unsigned>tentative_distance;
+	};
+
+	struct BucketEntry{
+		unsigned target;
+		unsigned distance;
+	};
+
+	void prepare_search_states(unsigned thread_count);
+
+	const ContractionHierarchy*ch;
+	unsigned target_count;
+	std::vector<unsigned>bucket_first_entry;
+	std::vector<BucketEntry>bucket_entry;
+	std::vector<SearchState>search_state;
+};
+
+// Answers a batch of independent point-to-point queries using thread_count threads. Every
+// thread owns a ContractionHierarchyQuery object, which is allocated once and reused for
+// all batches. Threads that finish early take over the remaining queries.
+class ContractionHierarchyBatchQuery{
+public:
+	ContractionHierarchyBatchQuery(){}
+	explicit ContractionHierarchyBatchQuery(ContractionHierarchyView ch, unsigned thread_count = 1);
+
+	ContractionHierarchyBatchQuery&reset(ContractionHierarchyView ch, unsigned thread_count = 1);
+
+	unsigned get_thread_count()const;
+
+	// Computes the distance from source_list[i] to target_list[i] for every i < query_count and
+	// writes it to dist[i]. If no path exists, the distance is inf_weight. If node_path or
+	// arc_path is not null, the path is written to node_path[i] or arc_path[i] in the same
+	// format as ContractionHierarchyQuery::get_node_path and get_arc_path. If query_time is
+	// not null, the running time of query i in microseconds is written to query_time[i].
+	ContractionHierarchyBatchQuery&run(
+		const unsigned*source_list, const unsigned*target_list, unsigned query_count,
+		unsigned*dist,
+		std::vector<unsigned>*node_path = nullptr,
+		std::vector<unsigned>*arc_path = nullptr,
+		long long*query_time = nullptr
+	);
+
+	std::vector<unsigned>get_distances(const std::vector<unsigned>&source_list, const std::vector<unsigned>&target_list);
+
+//private:
+	std::vector<ContractionHierarchyQuery>query;
+};
+
 struct SaturatedWeightAddition{
 	unsigned operator()(unsigned l, unsigned r)const;
 	int operator()(int l, int r)const;
@@ -226,30 +370,54 @@ struct SaturatedWeightAddition{
 
 // ------ Template & inline implementations; no more interface descriptions beyond this line -------
 
+template<class Queue>
+inline
+unsigned BasicContractionHierarchyQuery<Queue>::get_settled_node_count()const{
+	return settled_node_count;
+}
+
+template<class Queue>
+inline
+unsigned BasicContractionHierarchyQuery<Queue>::get_stalled_node_count()const{
+	return stalled_node_count;
+}
+
+inline
+unsigned ContractionHierarchyManyToMany::get_target_count()const{
+	return target_count;
+}
+
+inline
+unsigned ContractionHierarchyBatchQuery::get_thread_count()const{
+	return query.size();
+}
+
+template<class Queue>
 inline
-unsigned ContractionHierarchyQuery::get_pinned_target_count(){
-	assert(state == ContractionHierarchyQuery::InternalState::target_run || state == ContractionHierarchyQuery::InternalState::target_pinned);
+unsigned BasicContractionHierarchyQuery<Queue>::get_pinned_target_count(){
+	assert(state == InternalState::target_run || state == InternalState::target_pinned);
 	return many_to_many_source_or_target_count;
 }
 
+template<class Queue>
 inline
-unsigned ContractionHierarchyQuery::get_pinned_source_count(){
-	assert(state == ContractionHierarchyQuery::InternalState::source_run || state == ContractionHierarchyQuery::InternalState::source_pinned);
+unsigned BasicContractionHierarchyQuery<Queue>::get_pinned_source_count(){
+	assert(state == InternalState::source_run || state == InternalState::source_pinned);
 	return many_to_many_source_or_target_count;
 }
 
-template<class ExtraWeight, class LinkFunction>
-std::vector<detail::GetExtraWeightType<ExtraWeight>> ContractionHierarchyQuery::get_extra_weight_distances_to_targets(
+template<class Queue> template<class ExtraWeight, class LinkFunction>
+std::vector<detail::GetExtraWeightType<ExtraWeight>> BasicContractionHierarchyQuery<Queue>::get_extra_weight_distances_to_targets(
 	const ExtraWeight&extra_weight,
 	const LinkFunction&link
 ){
-	std::vector<detail::GetExtraWeightType<ExtraWeight>>tmp(ch->node_count()), dist(get_pinned_target_count());
+	std::vector<detail::GetExtraWeightType<ExtraWeight>>tmp(ch.node_count()), dist(get_pinned_target_count());
 	get_extra_weight_distances_to_targets(extra_weight, link, tmp, dist);
 	return dist; // NVRO
 }
 
-template<class ExtraWeight, class LinkFunction, class TmpContainer>
-std::vector<detail::GetExtraWeightType<ExtraWeight>> ContractionHierarchyQuery::get_extra_weight_distances_to_targets(
+template<class Queue> template<class ExtraWeight, class LinkFunction, class TmpContainer>
+std::vector<detail::GetExtraWeightType<ExtraWeight>> BasicContractionHierarchyQuery<Queue>::get_extra_weight_distances_to_targets(
 	const ExtraWeight&extra_weight,
 	const LinkFunction&link,
 	TmpContainer&tmp
@@ -260,18 +428,18 @@ std::vector<detail::GetExtraWeightType<ExtraWeight>> ContractionHierarchyQuery::
 }
 
 
-template<class ExtraWeight, class LinkFunction>
-std::vector<detail::GetExtraWeightType<ExtraWeight>> ContractionHierarchyQuery::get_extra_weight_distances_to_sources(
+template<class Queue> template<class ExtraWeight, class LinkFunction>
+std::vector<detail::GetExtraWeightType<ExtraWeight>> BasicContractionHierarchyQuery<Queue>::get_extra_weight_distances_to_sources(
 	const ExtraWeight&extra_weight,
 	const LinkFunction&link
 ){
-	std::vector<detail::GetExtraWeightType<ExtraWeight>>tmp(ch->node_count()), dist(get_pinned_source_count());
+	std::vector<detail::GetExtraWeightType<ExtraWeight>>tmp(ch.node_count()), dist(get_pinned_source_count());
 	get_extra_weight_distances_to_sources(extra_weight, link, tmp, dist);
 	return dist; // NVRO
 }
 
-template<class ExtraWeight, class LinkFunction, class TmpContainer>
-std::vector<detail::GetExtraWeightType<ExtraWeight>> ContractionHierarchyQuery::get_extra_weight_distances_to_sources(
+template<class Queue> template<class ExtraWeight, class LinkFunction, class TmpContainer>
+std::vector<detail::GetExtraWeightType<ExtraWeight>> BasicContractionHierarchyQuery<Queue>::get_extra_weight_distances_to_sources(
 	const ExtraWeight&extra_weight,
 	const LinkFunction&link,
 	TmpContainer&tmp
@@ -332,9 +500,9 @@ namespace detail{
 		const InputWeightContainer&input_weight;
 		const LinkFunction&link;
 
-		const ContractionHierarchy&ch;
+		ContractionHierarchyView ch;
 
-		ShortcutWeights(const InputWeightContainer&input_weight, const LinkFunction&link, const ContractionHierarchy&ch):
+		ShortcutWeights(const InputWeightContainer&input_weight, const LinkFunction&link, const ContractionHierarchyView&ch):
 			input_weight(input_weight), link(link), ch(ch){}
 
 		Weight get_forward_weight(unsigned a)const{
@@ -363,7 +531,7 @@ namespace detail{
 
 		const ContractionHierarchyExtraWeight<WeightT>&extra_weight;
 
-		explicit ShortcutWeights(const ContractionHierarchyExtraWeight<WeightT>&extra_weight, const LinkFunction&, const ContractionHierarchy&):
+		explicit ShortcutWeights(const ContractionHierarchyExtraWeight<WeightT>&extra_weight, const LinkFunction&, const ContractionHierarchyView&):
 			extra_weight(extra_weight){}
 
 		const Weight&get_forward_weight(unsigned a)const{
@@ -376,7 +544,7 @@ namespace detail{
 	};
 
 	template<class ExtraWeight, class LinkFunction>
-	ShortcutWeights<ExtraWeight, LinkFunction> make_shortcut_weights(const ExtraWeight&extra_weight, const LinkFunction&link, const ContractionHierarchy&ch){
+	ShortcutWeights<ExtraWeight, LinkFunction> make_shortcut_weights(const ExtraWeight&extra_weight, const LinkFunction&link, const ContractionHierarchyView&ch){
 		return ShortcutWeights<ExtraWeight, LinkFunction>{extra_weight, link, ch};
 	}
 
@@ -488,14 +656,14 @@ namespace detail{
 
 }
 
-template<class ExtraWeight, class LinkFunction>
-detail::GetExtraWeightType<ExtraWeight> ContractionHierarchyQuery::get_extra_weight_distance(
+template<class Queue> template<class ExtraWeight, class LinkFunction>
+detail::GetExtraWeightType<ExtraWeight> BasicContractionHierarchyQuery<Queue>::get_extra_weight_distance(
 	const ExtraWeight&extra_weight,
 	const LinkFunction&link){
 	assert(ch && "query object must have an attached CH");
-	assert(state == ContractionHierarchyQuery::InternalState::run);
+	assert(state == InternalState::run);
 
-	auto shortcut_weight = detail::make_shortcut_weights(extra_weight, link, *ch);
+	auto shortcut_weight = detail::make_shortcut_weights(extra_weight, link, ch);
 
 	return detail::internal_get_extra_weight_distance(
 		shortcut_weight, link,
@@ -549,10 +717,10 @@ namespace detail{
 		const std::vector<unsigned>&predecessor_arc,
 
 		const ExtraWeight&extra_weight,
-		const std::vector<unsigned>&forward_first_out,
-		const std::vector<unsigned>&forward_head,
-		const std::vector<unsigned>&backward_first_out,
-		const std::vector<unsigned>&backward_head,
+		ConstVectorView<unsigned>forward_first_out,
+		ConstVectorView<unsigned>forward_head,
+		ConstVectorView<unsigned>backward_first_out,
+		ConstVectorView<unsigned>backward_head,
 
 		TmpContainer&source_to_node_distance,
 		TimestampFlags&has_source_to_node_distance,
@@ -662,16 +830,16 @@ namespace detail{
 	}
 }
 
-template<class ExtraWeight, class LinkFunction, class TmpContainer, class DistContainer>
-ContractionHierarchyQuery& ContractionHierarchyQuery::get_extra_weight_distances_to_targets(
+template<class Queue> template<class ExtraWeight, class LinkFunction, class TmpContainer, class DistContainer>
+BasicContractionHierarchyQuery<Queue>& BasicContractionHierarchyQuery<Queue>::get_extra_weight_distances_to_targets(
 	const ExtraWeight&extra_weight,
 	const LinkFunction&link,
 	TmpContainer&tmp,
 	DistContainer&dist
 ){
-	assert(state == ContractionHierarchyQuery::InternalState::target_run);
+	assert(state == InternalState::target_run);
 
-	auto shortcut_weight = detail::make_shortcut_weights(extra_weight, link, *ch);
+	auto shortcut_weight = detail::make_shortcut_weights(extra_weight, link, ch);
 
 	detail::extract_distances_to_targets(
 		backward_predecessor_node, many_to_many_source_or_target_count,
@@ -680,10 +848,10 @@ ContractionHierarchyQuery& ContractionHierarchyQuery::get_extra_weight_distances
 		forward_predecessor_node, forward_predecessor_arc,
 
 		shortcut_weight,
-		ch->forward.first_out,
-		ch->forward.head,
-		ch->backward.first_out,
-		ch->backward.head,
+		ch.forward.first_out,
+		ch.forward.head,
+		ch.backward.first_out,
+		ch.backward.head,
 
 		tmp,
 		was_backward_pushed,
@@ -698,18 +866,18 @@ ContractionHierarchyQuery& ContractionHierarchyQuery::get_extra_weight_distances
 	return *this;
 }
 
-template<class ExtraWeight, class LinkFunction, class TmpContainer, class DistContainer>
-ContractionHierarchyQuery& ContractionHierarchyQuery::get_extra_weight_distances_to_sources(
+template<class Queue> template<class ExtraWeight, class LinkFunction, class TmpContainer, class DistContainer>
+BasicContractionHierarchyQuery<Queue>& BasicContractionHierarchyQuery<Queue>::get_extra_weight_distances_to_sources(
 	const ExtraWeight&extra_weight,
 	const LinkFunction&link,
 	TmpContainer&tmp,
 	DistContainer&dist
 ){
-	assert(state == ContractionHierarchyQuery::InternalState::source_run);
+	assert(state == InternalState::source_run);
 
 	auto inverted_link = detail::inverse_link_function(link);
 
-	auto shortcut_weight = detail::make_shortcut_weights(extra_weight, link, *ch);
+	auto shortcut_weight = detail::make_shortcut_weights(extra_weight, link, ch);
 	auto inverted_shortcut_weight = detail::inverse_shortcut_weights(shortcut_weight);
 
 	detail::extract_distances_to_targets(
@@ -719,10 +887,10 @@ ContractionHierarchyQuery& ContractionHierarchyQuery::get_extra_weight_distances
 		backward_predecessor_node, backward_predecessor_arc,
 
 		inverted_shortcut_weight,
-		ch->backward.first_out,
-		ch->backward.head,
-		ch->forward.first_out,
-		ch->forward.head,
+		ch.backward.first_out,
+		ch.backward.head,
+		ch.forward.first_out,
+		ch.forward.head,
 
 		tmp,
 		was_forward_pushed,
@@ -737,6 +905,10 @@ ContractionHierarchyQuery& ContractionHierarchyQuery::get_extra_weight_distances
 	return *this;
 }
 
+extern template class BasicContractionHierarchyQuery<BasicMinIDQueue<2, unsigned>>;
+extern template class BasicContractionHierarchyQuery<MinIDQueue>;
+extern template class BasicContractionHierarchyQuery<BasicMinIDQueue<8, unsigned>>;
+extern template class BasicContractionHierarchyQuery<MinIDRadixQueue>;
 extern template struct ContractionHierarchyExtraWeight<unsigned>;
 extern template struct ContractionHierarchyExtraWeight<int>;
 extern template ContractionHierarchyQuery& ContractionHierarchyQuery::get_extra_weight_distances_to_targets<std::vector<int>, SaturatedWeightAddition, std::vector<int>, std::vector<int>>(const std::vector<int>&, const SaturatedWeightAddition&, std::vector<int>&, std::vector<int>&);
@@ -0,0 +1,189 @@
+#ifndef ROUTING_KIT_CONTRACTION_HIERARCHY_PHAST_H
+#define ROUTING_KIT_CONTRACTION_HIERARCHY_PHAST_H
+
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/id_queue.h>
+#include <routingkit/timestamp_flag.h>
+
+#include <vector>
+
+namespace RoutingKit{
+
+// Computes the distances from a set of source nodes to all nodes. An upward search in the
+// forward CH is followed by a single sweep over all downward arcs in decreasing rank order.
+// As the nodes of a ContractionHierarchy are stored by rank, the sweep reads the arcs
+// sequentially.
+class ContractionHierarchyPHAST{
+public:
+	ContractionHierarchyPHAST():ch(nullptr){}
+	explicit ContractionHierarchyPHAST(const ContractionHierarchy&ch);
+
+	ContractionHierarchyPHAST&reset();
+	ContractionHierarchyPHAST&reset(const ContractionHierarchy&ch);
+
+	ContractionHierarchyPHAST&add_source(unsigned s, unsigned dist_to_s = 0);
+
+	// Does not allocate memory.
+	ContractionHierarchyPHAST&run();
+
+	unsigned get_distance(unsigned node)const;
+
+	// dist must have room for ch.node_count() elements. dist[x] is set to the distance to node x.
+	ContractionHierarchyPHAST&get_distances(unsigned*dist);
+	std::vector<unsigned>get_distances();
+
+	// Element r is the distance to node ch.order[r]. Avoids the permutation of get_distances.
+	const std::vector<unsigned>&get_distances_by_rank()const;
+
+//private:
+	const ContractionHierarchy*ch;
+
+	TimestampFlags was_pushed;
+	MinIDQueue queue;
+	std::vector<unsigned>distance;
+
+	enum class InternalState:unsigned{
+		initialized,
+		run
+	}state;
+};
+
+// Computes the distances from up to K source nodes to all nodes in a single downward sweep.
+// The K distances of a node are stored next to each other, and each downward arc relaxes all
+// K of them at once using SIMD instructions if the target architecture supports them. This
+// amortizes the memory accesses of the sweep over K sources. K is 4, 8, or 16.
+template<unsigned K>
+class ContractionHierarchyMultiSourcePHAST{
+public:
+	static const unsigned max_source_count = K;
+
+	ContractionHierarchyMultiSourcePHAST():ch(nullptr), source_count(0){}
+	explicit ContractionHierarchyMultiSourcePHAST(const ContractionHierarchy&ch);
+
+	ContractionHierarchyMultiSourcePHAST&reset(const ContractionHierarchy&ch);
+
+	// Computes the distances from source_list[0] ... source_list[source_count-1]. source_count
+	// must be at most K. Does not allocate memory.
+	ContractionHierarchyMultiSourcePHAST&run(const unsigned*source_list, unsigned source_count);
+	ContractionHierarchyMultiSourcePHAST&run(const std::vector<unsigned>&source_list);
+
+	unsigned get_source_count()const;
+
+	unsigned get_distance(unsigned source_index, unsigned node)const;
+
+	// dist must have room for ch.node_count() elements. dist[x] is set to the distance from
+	// source source_index to node x.
+	ContractionHierarchyMultiSourcePHAST&get_distances(unsigned source_index, unsigned*dist);
+	std::vector<unsigned>get_distances(unsigned source_index);
+
+	// Element r*K+i is the distance from source i to node ch.order[r].
+	const std::vector<unsigned>&get_interleaved_distances_by_rank()const;
+
+//private:
+	const ContractionHierarchy*ch;
+	unsigned source_count;
+
+	TimestampFlags was_pushed, was_reached;
+	MinIDQueue queue;
+	std::vector<unsigned>tentative_distance;
+	std::vector<unsigned>distance;
+};
+
+// Computes the distances from a set of source nodes to a fixed set of target nodes. Selecting
+// the targets extracts the union of their backward search spaces into a compact downward
+// graph, whose nodes are renumbered by decreasing rank. Every query then consists of an
+// upward search and a sweep over the extracted arcs only. This is faster than PHAST if the
+// target set is much smaller than the graph and faster than pinned queries if it is large.
+class ContractionHierarchyRPHAST{
+public:
+	ContractionHierarchyRPHAST():ch(nullptr), target_count(0){}
+	explicit ContractionHierarchyRPHAST(const ContractionHierarchy&ch);
+
+	ContractionHierarchyRPHAST&reset(const ContractionHierarchy&ch);
+
+	ContractionHierarchyRPHAST&select_targets(const std::vector<unsigned>&target_list);
+	unsigned get_target_count()const;
+	// The number of nodes in the extracted downward graph.
+	unsigned get_selected_node_count()const;
+
+	// Removes all sources but keeps the selected targets.
+	ContractionHierarchyRPHAST&reset();
+	ContractionHierarchyRPHAST&add_source(unsigned s, unsigned dist_to_s = 0);
+
+	// Does not allocate memory.
+	ContractionHierarchyRPHAST&run();
+
+	// dist must have room for get_target_count() elements. dist[i] is set to the distance
+	// to target_list[i].
+	ContractionHierarchyRPHAST&get_distances_to_targets(unsigned*dist);
+	std::vector<unsigned>get_distances_to_targets();
+
+//private:
+	const ContractionHierarchy*ch;
+
+	TimestampFlags was_pushed;
+	MinIDQueue queue;
+	std::vector<unsigned>tentative_distance;
+
+	// The selected nodes are numbered by decreasing rank. Arcs point to selected nodes of
+	// higher rank and therefore to smaller local IDs.
+	std::vector<unsigned>selected_node_rank;
+	std::vector<unsigned>selected_first_out;
+	std::vector<unsigned>selected_head;
+	std::vector<unsigned>selected_weight;
+	std::vector<unsigned>selected_distance;
+
+	unsigned target_count;
+	std::vector<unsigned>target_local_id;
+
+	enum class InternalState:unsigned{
+		initialized,
+		run
+	}state;
+};
+
+// ------ Template & inline implementations; no more interface descriptions beyond this line -------
+
+inline
+unsigned ContractionHierarchyPHAST::get_distance(unsigned node)const{
+	assert(state == ContractionHierarchyPHAST::InternalState::run);
+	assert(node < ch->node_count() && "node out of bounds");
+	return distance[ch->rank[node]];
+}
+
+inline
+const std::vector<unsigned>&ContractionHierarchyPHAST::get_distances_by_rank()const{
+	assert(state == ContractionHierarchyPHAST::InternalState::run);
+	return distance;
+}
+
+inline
+unsigned ContractionHierarchyRPHAST::get_target_count()const{
+	return target_count;
+}
+
+inline
+unsigned ContractionHierarchyRPHAST::get_selected_node_count()const{
+	return selected_node_rank.size();
+}
+
+template<unsigned K>
+unsigned ContractionHierarchyMultiSourcePHAST<K>::get_source_count()const{
+	return source_count;
+}
+
+template<unsigned K>
+unsigned ContractionHierarchyMultiSourcePHAST<K>::get_distance(unsigned source_index, unsigned node)const{
+	assert(source_index < source_count && "source index out of bounds");
+	assert(node < ch->node_count() && "node out of bounds");
+	return distance[(unsigned long long)ch->rank[node]*K + source_index];
+}
+
+template<unsigned K>
+const std::vector<unsigned>&ContractionHierarchyMultiSourcePHAST<K>::get_interleaved_distances_by_rank()const{
+	return distance;
+}
+
+} // RoutingKit
+
+#endif
@@ -5,10 +5,16 @@
 #include <routingkit/id_set_queue.h>
 #include <routingkit/bit_vector.h>
 #include <routingkit/id_mapper.h>
+#include <routingkit/vector_view.h>
 
 #include <vector>
 #include <string>
 #include <functional>
+#include <memory>
+#include <array>
+#include <mutex>
+#include <list>
+#include <unordered_map>
 
 namespace RoutingKit{
 
@@ -31,11 +37,21 @@ struct CustomizableContractionHierarchy{
 		return up_head.size();
 	}
 
+	// The file format is versioned and every array starts at a page boundary. The same file
+	// can be read by load_file or mapped into memory by CustomizableContractionHierarchyView::map_file.
+	static CustomizableContractionHierarchy read(std::function<void(char*, unsigned long long)>data_source);
+	static CustomizableContractionHierarchy load_file(const std::string&file_name);
+
+	void write(std::function<void(const char*, unsigned long long)>data_sink) const;
+	void save_file(const std::string&file_name) const;
+
 // private:
 	std::vector<unsigned>order;
 	std::vector<unsigned>rank;
 	
 	std::vector<unsigned>elimination_tree_parent;
+	// The number of arcs on the path to the root of the elimination tree.
+	std::vector<unsigned>elimination_tree_depth;
 	
 	std::vector<unsigned>up_first_out;
 	std::vector<unsigned>up_head;
@@ -79,6 +95,15 @@ struct CustomizableContractionHierarchyMetric{
 
 	ContractionHierarchy build_contraction_hierarchy_using_perfect_witness_search();
 
+	// Saves the customized weights. read and load_file replace the weights by the saved ones.
+	// The metric must already be attached to the CCH for which the weights were saved.
+	// Calling customize afterwards is not necessary.
+	CustomizableContractionHierarchyMetric& read(std::function<void(char*, unsigned long long)>data_source);
+	CustomizableContractionHierarchyMetric& load_file(const std::string&file_name);
+
+	void write(std::function<void(const char*, unsigned long long)>data_sink) const;
+	void save_file(const std::string&file_name) const;
+
 // private:
 	std::vector<unsigned>forward;
 	std::vector<unsigned>backward;
@@ -87,6 +112,81 @@ struct CustomizableContractionHierarchyMetric{
 
 };
 
+// Read-only views of a CCH and of a customized metric with the same members as the
+// owning objects. A view either refers to an owning object, which must outlive the view,
+// or to a file written by save_file that is mapped into memory. In the latter case nothing
+// is copied and all processes that map the same file share its pages. The mapping is
+// released when the last copy of the view is destroyed. Query objects can run on views.
+struct CustomizableContractionHierarchyView{
+	CustomizableContractionHierarchyView():does_cch_arc_have_input_arc_mapper(nullptr), does_cch_arc_have_extra_input_arc_mapper(nullptr){}
+	CustomizableContractionHierarchyView(const CustomizableContractionHierarchy&cch);
+
+	static CustomizableContractionHierarchyView map_file(const std::string&file_name);
+
+	unsigned node_count()const{
+		return rank.size();
+	}
+
+	unsigned input_arc_count() const {
+		return input_arc_to_cch_arc.size();
+	}
+
+	unsigned cch_arc_count() const {
+		return up_head.size();
+	}
+
+// private:
+	ConstVectorView<unsigned>order;
+	ConstVectorView<unsigned>rank;
+
+	ConstVectorView<unsigned>elimination_tree_parent;
+	ConstVectorView<unsigned>elimination_tree_depth;
+
+	ConstVectorView<unsigned>up_first_out;
+	ConstVectorView<unsigned>up_head;
+	ConstVectorView<unsigned>up_tail;
+
+	ConstVectorView<unsigned>down_first_out;
+	ConstVectorView<unsigned>down_head;
+	ConstVectorView<unsigned>down_to_up;
+
+	ConstVectorView<unsigned>input_arc_to_cch_arc;
+	ConstBitVectorView is_input_arc_upward;
+
+	ConstBitVectorView does_cch_arc_have_input_arc;
+	const LocalIDMapper*does_cch_arc_have_input_arc_mapper;
+
+	ConstVectorView<unsigned>forward_input_arc_of_cch;
+	ConstVectorView<unsigned>backward_input_arc_of_cch;
+
+	ConstBitVectorView does_cch_arc_have_extra_input_arc;
+	const LocalIDMapper*does_cch_arc_have_extra_input_arc_mapper;
+
+	ConstVectorView<unsigned>first_extra_forward_input_arc_of_cch;
+	ConstVectorView<unsigned>first_extra_backward_input_arc_of_cch;
+
+	ConstVectorView<unsigned>extra_forward_input_arc_of_cch;
+	ConstVectorView<unsigned>extra_backward_input_arc_of_cch;
+
+	std::shared_ptr<const void>mapped_file;
+};
+
+struct CustomizableContractionHierarchyMetricView{
+	CustomizableContractionHierarchyMetricView():input_weight(nullptr){}
+	CustomizableContractionHierarchyMetricView(const CustomizableContractionHierarchyMetric&metric);
+
+	// input_weight is only needed to compute arc paths and may be null otherwise.
+	static CustomizableContractionHierarchyMetricView map_file(CustomizableContractionHierarchyView cch, const std::string&file_name, const unsigned*input_weight = nullptr);
+
+// private:
+	ConstVectorView<unsigned>forward;
+	ConstVectorView<unsigned>backward;
+	CustomizableContractionHierarchyView cch;
+	const unsigned*input_weight;
+
+	std::shared_ptr<const void>mapped_file;
+};
+
 struct CustomizableContractionHierarchyParallelization{
 	CustomizableContractionHierarchyParallelization(){}
 	explicit CustomizableContractionHierarchyParallelization(const CustomizableContractionHierarchy&cch);
@@ -107,8 +207,79 @@ struct CustomizableContractionHierarchyParallelization{
 
 };
 
+// Same interface as CustomizableContractionHierarchyParallelization but with a different
+// schedule. The lower part of the elimination tree is split into disjoint subtrees that
+// threads customize independently as tasks. Only the arcs of the remaining top nodes are
+// processed level by level. No atomic operations are needed, and the number of barriers
+// only depends on the height of the top part.
+struct CustomizableContractionHierarchySubtreeParallelization{
+	CustomizableContractionHierarchySubtreeParallelization():cch(nullptr){}
+	explicit CustomizableContractionHierarchySubtreeParallelization(const CustomizableContractionHierarchy&cch);
+
+	CustomizableContractionHierarchySubtreeParallelization& reset(const CustomizableContractionHierarchy&cch){
+		*this = CustomizableContractionHierarchySubtreeParallelization(cch);
+		return *this;
+	}
+
+	CustomizableContractionHierarchySubtreeParallelization& customize(CustomizableContractionHierarchyMetric&metric);
+	CustomizableContractionHierarchySubtreeParallelization& customize(CustomizableContractionHierarchyMetric&metric, unsigned thread_count);
+
+	unsigned get_subtree_count()const{
+		return first_node_of_subtree.size()-1;
+	}
+
+	unsigned get_top_level_count()const{
+		return first_arc_of_top_level.size()-1;
+	}
+
+// private:
+	// The nodes of every subtree by increasing ID. The subtrees are ordered by decreasing size.
+	std::vector<unsigned>first_node_of_subtree;
+	std::vector<unsigned>subtree_node;
+	// The upward arcs of the top nodes, grouped by the height of their tail in the elimination tree.
+	std::vector<unsigned>first_arc_of_top_level;
+	std::vector<unsigned>top_arc;
+	const CustomizableContractionHierarchy*cch;
+};
+
+// Stores all lower triangles of the CCH as a flat list grouped by their top arc. The
+// top arcs are ordered by tail, which is the order in which customize finalizes them.
+// Customizing then is a single sequential pass over the list instead of a walk over the
+// up and down adjacency arrays. The list needs memory_usage() bytes, which is 8 bytes
+// per triangle plus 4 bytes per CCH arc. Whether this pays off depends on the graph and
+// on how often the metric is customized.
+struct CustomizableContractionHierarchyTriangles{
+	CustomizableContractionHierarchyTriangles(){}
+	explicit CustomizableContractionHierarchyTriangles(const CustomizableContractionHierarchy&cch, const std::function<void(const std::string&)>&log_message = std::function<void(const std::string&)>());
+
+	CustomizableContractionHierarchyTriangles& reset(const CustomizableContractionHierarchy&cch, const std::function<void(const std::string&)>&log_message = std::function<void(const std::string&)>()){
+		*this = CustomizableContractionHierarchyTriangles(cch, log_message);
+		return *this;
+	}
+
+	CustomizableContractionHierarchyTriangles& customize(CustomizableContractionHierarchyMetric&metric);
+
+	unsigned long long triangle_count()const{
+		return triangle_arcs.size()/2;
+	}
+
+	unsigned long long memory_usage()const{
+		return sizeof(unsigned)*((unsigned long long)first_triangle_of_arc.size() + triangle_arcs.size());
+	}
+
+// private:
+	std::vector<unsigned>first_triangle_of_arc;
+	// The bottom and mid arc of each triangle are interleaved.
+	std::vector<unsigned>triangle_arcs;
+	const CustomizableContractionHierarchy*cch;
+};
+
 struct CustomizableContractionHierarchyPartialCustomization{
-	CustomizableContractionHierarchyPartialCustomization(){}
+	CustomizableContractionHierarchyPartialCustomization():
+		cch(nullptr),
+		full_customization_threshold(default_full_customization_threshold),
+		last_customization_method(CustomizationMethod::none),
+		last_recomputed_arc_count(0){}
 	explicit CustomizableContractionHierarchyPartialCustomization(const CustomizableContractionHierarchy&cch);
 
 	CustomizableContractionHierarchyPartialCustomization&reset();
@@ -117,23 +288,209 @@ struct CustomizableContractionHierarchyPartialCustomization{
 	CustomizableContractionHierarchyPartialCustomization&update_arc(unsigned xy);
 	CustomizableContractionHierarchyPartialCustomization&customize(CustomizableContractionHierarchyMetric&metric);
 
+	// Processes the affected arcs level by level and the arcs of a level in parallel. If
+	// more than full_customization_threshold times the number of CCH arcs are affected, all
+	// arcs from the current level on are recomputed instead, which avoids the bookkeeping
+	// for affected arcs. The first call computes the levels in linear time.
+	CustomizableContractionHierarchyPartialCustomization&customize(CustomizableContractionHierarchyMetric&metric, unsigned thread_count);
+
+	// Below this fraction of recomputed arcs the level-based method was faster on the graphs
+	// measured using test_customizable_contraction_hierarchy_customization. The best value
+	// depends on the graph and the machine. It can be changed freely.
+	static constexpr double default_full_customization_threshold = 0.2;
+
+	enum class CustomizationMethod{
+		none,
+		sequential,
+		parallel_levels,
+		// The parallel customization switched to recomputing all remaining arcs.
+		full
+	};
+
+	// Reports how the last call to customize proceeded.
+	CustomizationMethod get_last_customization_method()const{
+		return last_customization_method;
+	}
+
+	unsigned get_last_recomputed_arc_count()const{
+		return last_recomputed_arc_count;
+	}
+
 // private:
 	IDSetMinQueue q;
 	const CustomizableContractionHierarchy*cch;
+
+	double full_customization_threshold;
+	CustomizationMethod last_customization_method;
+	unsigned last_recomputed_arc_count;
+
+	std::vector<unsigned>first_arc_of_level;
+	std::vector<unsigned>arcs_ordered_by_level;
+	std::vector<unsigned>arc_level;
+	std::vector<std::vector<unsigned>>dirty_arcs_of_level;
+	BitVector is_arc_dirty;
+	std::vector<unsigned>dirty_arc_index;
+};
+
+// Allows to recustomize a metric while queries run concurrently on it. Customization
+// always writes into a back buffer that no query uses. Once finished, the buffer is
+// published atomically and becomes the current metric. Every published metric has an
+// epoch number that increases with every publication. A query pins the metric that was
+// current when get_metric was called and can finish on it even if newer metrics are
+// published in the meantime. A buffer is reused or freed once no view refers to it anymore.
+//
+// get_metric and get_epoch can be called from any thread. The customization functions can
+// also be called from any thread, but concurrent calls are serialized. The manager holds a
+// reference to cch. The input weights are copied.
+struct CustomizableContractionHierarchyMetricManager{
+	CustomizableContractionHierarchyMetricManager():cch(nullptr), last_epoch(0){}
+	// Customizes the first metric, which gets epoch 1.
+	CustomizableContractionHierarchyMetricManager(const CustomizableContractionHierarchy&cch, std::vector<unsigned>input_weight, unsigned thread_count = 1);
+
+	CustomizableContractionHierarchyMetricManager(const CustomizableContractionHierarchyMetricManager&) = delete;
+	CustomizableContractionHierarchyMetricManager&operator=(const CustomizableContractionHierarchyMetricManager&) = delete;
+
+	// The returned view keeps the metric alive. If epoch is not null, then it is set to the
+	// epoch of the returned metric.
+	CustomizableContractionHierarchyMetricView get_metric(unsigned long long*epoch = nullptr)const;
+	unsigned long long get_epoch()const;
+
+	// Customizes a metric with completely new weights and publishes it. Returns its epoch.
+	unsigned long long customize(std::vector<unsigned>input_weight, unsigned thread_count = 1);
+
+	// Copies the current metric, changes the weights of the given input arcs, updates the
+	// copy using partial customization and publishes it. Returns its epoch.
+	unsigned long long update_arcs(const std::vector<unsigned>&arc, const std::vector<unsigned>&new_weight, unsigned thread_count = 1);
+
+	// The number of metrics currently allocated, including the current one.
+	unsigned get_buffer_count()const;
+
+// private:
+	struct Buffer{
+		std::vector<unsigned>input_weight;
+		CustomizableContractionHierarchyMetric metric;
+		unsigned long long epoch;
+	};
+
+	// The buffers that no view refers to anymore. publish hands out every buffer with a
+	// deleter that moves it into this list under lock. The views release their reads of a
+	// buffer before the deleter runs, and the lock makes them visible to the customization
+	// that takes the buffer out of the list. The list outlives the manager if views do.
+	struct FreeBufferList{
+		FreeBufferList():allocated_buffer_count(0){}
+
+		// Both members are protected by lock. buffer has room for all allocated buffers, so
+		// the deleter never allocates.
+		std::mutex lock;
+		std::vector<std::unique_ptr<Buffer>>buffer;
+		unsigned allocated_buffer_count;
+	};
+
+	std::unique_ptr<Buffer>acquire_back_buffer();
+	unsigned long long publish(std::unique_ptr<Buffer>buffer);
+
+	const CustomizableContractionHierarchy*cch;
+	std::shared_ptr<FreeBufferList>free_buffers;
+
+	// Only accessed using std::atomic_load and std::atomic_store.
+	std::shared_ptr<Buffer>current;
+
+	// All members below are protected by writer_lock.
+	mutable std::mutex writer_lock;
+	unsigned long long last_epoch;
+	CustomizableContractionHierarchyPartialCustomization partial_customization;
+	CustomizableContractionHierarchyParallelization parallelization;
 };
 
+// Records for every CCH arc and direction the lowest node of a triangle that determines the
+// customized weight of the arc, or invalid_id if the weight is that of an input arc. Paths
+// can then be unpacked by a simple recursion instead of searching for lower triangles.
+struct CustomizableContractionHierarchyMiddleNodes{
+	CustomizableContractionHierarchyMiddleNodes(){}
+
+	// Customizes metric as metric.customize() does and records the middle nodes in the same pass.
+	CustomizableContractionHierarchyMiddleNodes& customize(CustomizableContractionHierarchyMetric&metric);
+
+	// Computes the middle nodes of a metric that was customized in some other way, for
+	// example in parallel, partially, or loaded from a file. The arcs are independent and
+	// are distributed over thread_count threads.
+	CustomizableContractionHierarchyMiddleNodes& compute(const CustomizableContractionHierarchyMetric&metric, unsigned thread_count = 1);
+
+// private:
+	std::vector<unsigned>forward_middle_node;
+	std::vector<unsigned>backward_middle_node;
+};
+
+// Caches the input arcs of the CCH arcs on the shortest paths, i.e., the arcs that are not
+// the result of unpacking another arc. The least recently used entries are evicted once more
+// than max_input_arc_count input arcs are cached. One cache can be shared by all query
+// threads. It must be cleared when the metric is customized anew.
+struct CustomizableContractionHierarchyUnpackingCache{
+	explicit CustomizableContractionHierarchyUnpackingCache(unsigned long long max_input_arc_count = 1u<<24);
+
+	CustomizableContractionHierarchyUnpackingCache(const CustomizableContractionHierarchyUnpackingCache&) = delete;
+	CustomizableContractionHierarchyUnpackingCache& operator=(const CustomizableContractionHierarchyUnpackingCache&) = delete;
+
+	void clear();
+
+	unsigned long long get_hit_count()const;
+	unsigned long long get_miss_count()const;
+	unsigned long long get_cached_input_arc_count()const;
+
+// private:
+	struct Entry{
+		unsigned long long key;
+		std::vector<unsigned>input_arc;
+	};
+
+	// Appends the cached input arcs of the key to path. Returns false if there are none.
+	bool append_if_cached(unsigned long long key, std::vector<unsigned>&path);
+	void insert(unsigned long long key, std::vector<unsigned>input_arc);
+
+	mutable std::mutex lock;
+	unsigned long long max_input_arc_count;
+	unsigned long long cached_input_arc_count;
+	unsigned long long hit_count, miss_count;
+	std::list<Entry>entry_list;
+	std::unordered_map<unsigned long long, std::list<Entry>::iterator>entry_of_key;
+};
+
+// A query constructed from or reset to a CustomizableContractionHierarchyMetric follows
+// that object. reset and run use its current weights, also after the metric was reset to
+// another weight vector or CCH and customized anew. A query constructed from or reset to a
+// view uses the arrays the view refers to.
 struct CustomizableContractionHierarchyQuery{
-	CustomizableContractionHierarchyQuery(){}
+	CustomizableContractionHierarchyQuery():use_pruning(false), use_stall_on_demand(false), scanned_node_count(0), pruned_node_count(0), stalled_node_count(0), relaxed_arc_count(0), owning_metric(nullptr){}
 	explicit CustomizableContractionHierarchyQuery(const CustomizableContractionHierarchyMetric&metric);
+	explicit CustomizableContractionHierarchyQuery(CustomizableContractionHierarchyMetricView metric);
 
 	CustomizableContractionHierarchyQuery&reset();
 	CustomizableContractionHierarchyQuery&reset(const CustomizableContractionHierarchyMetric&metric);
+	CustomizableContractionHierarchyQuery&reset(CustomizableContractionHierarchyMetricView metric);
 
 	CustomizableContractionHierarchyQuery&add_source(unsigned s, unsigned dist_to_s = 0);
 	CustomizableContractionHierarchyQuery&add_target(unsigned t, unsigned dist_to_t = 0);
 
 	CustomizableContractionHierarchyQuery&run();
 
+	// By default, run relaxes all upward arcs of all nodes on the elimination tree paths of
+	// the sources and targets. If pruning is enabled, both paths are walked together in
+	// increasing rank order. A node's arcs are then not relaxed if its tentative distance is at
+	// least the length of the shortest path found so far. Stall-on-demand also skips a node if
+	// a higher node on the same path plus the arc between them gives a shorter distance.
+	// Neither setting changes the distance. If there are several shortest paths, then a
+	// different one can be returned. Both only affect run, are disabled by default, and
+	// survive reset.
+	CustomizableContractionHierarchyQuery&set_pruning(bool enabled);
+	CustomizableContractionHierarchyQuery&set_stall_on_demand(bool enabled);
+
+	// Statistics of the last call to run. The scanned nodes are the nodes on the elimination
+	// tree paths. The pruned and stalled nodes are the scanned nodes whose arcs were not relaxed.
+	unsigned get_scanned_node_count()const;
+	unsigned get_pruned_node_count()const;
+	unsigned get_stalled_node_count()const;
+	unsigned get_relaxed_arc_count()const;
+
 	unsigned get_used_source();
 	unsigned get_used_target();
 
@@ -141,6 +498,11 @@ struct CustomizableContractionHierarchyQuery{
 	std::vector<unsigned> get_node_path();
 	std::vector<unsigned> get_arc_path();
 
+	// Unpack the path using middle nodes computed for the current metric. If cache is not
+	// null, it is used for the CCH arcs on the shortest path.
+	std::vector<unsigned> get_node_path(const CustomizableContractionHierarchyMiddleNodes&middle_nodes, CustomizableContractionHierarchyUnpackingCache*cache = nullptr);
+	std::vector<unsigned> get_arc_path(const CustomizableContractionHierarchyMiddleNodes&middle_nodes, CustomizableContractionHierarchyUnpackingCache*cache = nullptr);
+
 	// One-To-Many
 	CustomizableContractionHierarchyQuery& reset_source();
 	CustomizableContractionHierarchyQuery& pin_targets(const std::vector<unsigned>&);
@@ -167,11 +529,180 @@ struct CustomizableContractionHierarchyQuery{
 	std::vector<unsigned>forward_predecessor_node, backward_predecessor_node;
 
 	std::vector<bool>in_forward_search_space, in_backward_search_space;
+
+	// Only used by run if pruning or stall-on-demand is enabled.
+	std::vector<unsigned>forward_search_space, backward_search_space;
 	
 	unsigned shortest_path_meeting_node;
 
+	bool use_pruning, use_stall_on_demand;
+	unsigned scanned_node_count, pruned_node_count, stalled_node_count, relaxed_arc_count;
+
+	CustomizableContractionHierarchyView cch;
+	CustomizableContractionHierarchyMetricView metric;
+	unsigned state;
+
+	// If not null, metric is rebuilt from owning_metric by reset and run.
+	const CustomizableContractionHierarchyMetric*owning_metric;
+
+	CustomizableContractionHierarchyQuery&reset_search_state();
+	void update_metric_from_owning_metric();
+};
+
+// A point-to-point query whose memory is proportional to the depth of the elimination tree
+// instead of the node count. The tentative distances and predecessors are stored in arrays
+// indexed by the position on the elimination tree paths of the source and the target.
+// Only one source and one target are supported. The two paths are walked together and
+// nodes whose distance is not below the shortest path found so far are not relaxed.
+// Like CustomizableContractionHierarchyQuery, a query constructed from or reset to a
+// CustomizableContractionHierarchyMetric uses the current weights of that object after
+// every reset.
+struct CustomizableContractionHierarchyCompactQuery{
+	CustomizableContractionHierarchyCompactQuery():shortest_path_meeting_node(invalid_id), shortest_path_length(inf_weight), relaxed_arc_count(0), state(0), owning_metric(nullptr){}
+	explicit CustomizableContractionHierarchyCompactQuery(const CustomizableContractionHierarchyMetric&metric);
+	explicit CustomizableContractionHierarchyCompactQuery(CustomizableContractionHierarchyMetricView metric);
+
+	CustomizableContractionHierarchyCompactQuery&reset();
+	CustomizableContractionHierarchyCompactQuery&reset(const CustomizableContractionHierarchyMetric&metric);
+	CustomizableContractionHierarchyCompactQuery&reset(CustomizableContractionHierarchyMetricView metric);
+
+	CustomizableContractionHierarchyCompactQuery&add_source(unsigned s, unsigned dist_to_s = 0);
+	CustomizableContractionHierarchyCompactQuery&add_target(unsigned t, unsigned dist_to_t = 0);
+
+	CustomizableContractionHierarchyCompactQuery&run();
+
+	unsigned get_used_source();
+	unsigned get_used_target();
+
+	unsigned get_distance();
+	std::vector<unsigned> get_node_path();
+	std::vector<unsigned> get_arc_path();
+
+	unsigned get_relaxed_arc_count()const;
+
+	// The number of bytes currently allocated by the query object.
+	unsigned long long memory_usage()const;
+
+// private:
+	std::vector<unsigned>forward_node, backward_node;
+	std::vector<unsigned>forward_tentative_distance, backward_tentative_distance;
+	std::vector<unsigned>forward_predecessor_node, backward_predecessor_node;
+
+	unsigned shortest_path_meeting_node;
+	unsigned shortest_path_length;
+	unsigned relaxed_arc_count;
+
+	CustomizableContractionHierarchyMetricView metric;
+	unsigned state;
+
+	// If not null, metric is rebuilt from owning_metric by reset.
+	const CustomizableContractionHierarchyMetric*owning_metric;
+};
+
+// Computes distance tables from a set of source nodes to a set of target nodes. The search
+// space of a node is its path to the root of the elimination tree. The backward search of
+// every target is run only once and stored in buckets at the nodes of its path. Every source
+// then walks up its own path and scans the buckets of the nodes on it.
+struct CustomizableContractionHierarchyManyToMany{
+	CustomizableContractionHierarchyManyToMany():target_count(0){}
+	explicit CustomizableContractionHierarchyManyToMany(const CustomizableContractionHierarchyMetric&metric);
+	explicit CustomizableContractionHierarchyManyToMany(CustomizableContractionHierarchyMetricView metric);
+
+	CustomizableContractionHierarchyManyToMany&reset(const CustomizableContractionHierarchyMetric&metric);
+	CustomizableContractionHierarchyManyToMany&reset(CustomizableContractionHierarchyMetricView metric);
+
+	// Runs the backward searches and fills the buckets. Afterwards, the buckets are only read
+	// and can be shared by all threads of get_distances. The buckets must be recomputed if
+	// the metric is customized anew.
+	CustomizableContractionHierarchyManyToMany&set_targets(const std::vector<unsigned>&target_list, unsigned thread_count = 1);
+	unsigned get_target_count()const;
+
+	// Writes the distance from source_list[i] to target_list[j] to dist[i*get_target_count()+j].
+	// dist must have room for source_list.size()*get_target_count() elements. If no path
+	// exists, the distance is inf_weight. The sources are distributed over thread_count threads.
+	// No memory is allocated, if the object was used with at least as many threads before.
+	CustomizableContractionHierarchyManyToMany&get_distances(const std::vector<unsigned>&source_list, unsigned*dist, unsigned thread_count = 1);
+	std::vector<unsigned>get_distances(const std::vector<unsigned>&source_list, unsigned thread_count = 1);
+
+// private:
+	struct BucketEntry{
+		unsigned target;
+		unsigned distance;
+	};
+
+	void prepare_tentative_distances(unsigned thread_count);
+
+	CustomizableContractionHierarchyMetricView metric;
+	unsigned target_count;
+	std::vector<unsigned>bucket_first_entry;
+	std::vector<BucketEntry>bucket_entry;
+	std::vector<std::vector<unsigned>>tentative_distance_of_thread;
+};
+
+// Stores K metrics of the same CCH. The K weights of an arc are stored next to each other,
+// and customize relaxes all K of them with one pass over the triangles using SIMD
+// instructions if the target architecture supports them. This amortizes the triangle
+// enumeration and the memory accesses over K metrics. K is 2, 4, 8, or 16.
+template<unsigned K>
+struct CustomizableContractionHierarchyMultiMetric{
+	static const unsigned metric_count = K;
+
+	CustomizableContractionHierarchyMultiMetric():cch(nullptr){}
+	// input_weight[i] is the input weight of the i-th metric. Only the pointers are stored.
+	CustomizableContractionHierarchyMultiMetric(const CustomizableContractionHierarchy&cch, const std::array<const unsigned*, K>&input_weight);
+	CustomizableContractionHierarchyMultiMetric(const CustomizableContractionHierarchy&cch, const std::vector<std::vector<unsigned>>&input_weight);
+
+	CustomizableContractionHierarchyMultiMetric& reset(const CustomizableContractionHierarchy&cch, const std::array<const unsigned*, K>&input_weight);
+	CustomizableContractionHierarchyMultiMetric& reset(const CustomizableContractionHierarchy&cch, const std::vector<std::vector<unsigned>>&input_weight);
+
+	CustomizableContractionHierarchyMultiMetric& customize();
+
+	// Copies the customized weights of the i-th metric into metric, which must be attached
+	// to the same CCH. The result is the same as customizing metric.
+	void extract_metric(unsigned metric_index, CustomizableContractionHierarchyMetric&metric)const;
+
+// private:
+	// Element a*K+i is the weight of CCH arc a in the i-th metric.
+	std::vector<unsigned>forward;
+	std::vector<unsigned>backward;
 	const CustomizableContractionHierarchy*cch;
-	const CustomizableContractionHierarchyMetric*metric;
+	std::array<const unsigned*, K>input_weight;
+};
+
+// Answers a query on all K metrics of a CustomizableContractionHierarchyMultiMetric at once.
+// Each node of the elimination tree search spaces is visited once and all K tentative
+// distances are relaxed together. Only distances are computed. Use a
+// CustomizableContractionHierarchyQuery on an extracted metric to obtain paths.
+template<unsigned K>
+struct CustomizableContractionHierarchyMultiMetricQuery{
+	CustomizableContractionHierarchyMultiMetricQuery():metric(nullptr){}
+	explicit CustomizableContractionHierarchyMultiMetricQuery(const CustomizableContractionHierarchyMultiMetric<K>&metric);
+
+	CustomizableContractionHierarchyMultiMetricQuery& reset();
+	CustomizableContractionHierarchyMultiMetricQuery& reset(const CustomizableContractionHierarchyMultiMetric<K>&metric);
+
+	CustomizableContractionHierarchyMultiMetricQuery& add_source(unsigned s, unsigned dist_to_s = 0);
+	CustomizableContractionHierarchyMultiMetricQuery& add_target(unsigned t, unsigned dist_to_t = 0);
+
+	CustomizableContractionHierarchyMultiMetricQuery& run();
+
+	unsigned get_distance(unsigned metric_index)const;
+	std::array<unsigned, K> get_distances()const;
+
+// private:
+	const CustomizableContractionHierarchyMultiMetric<K>*metric;
+
+	// Element x*K+i is the tentative distance of node x in the i-th metric.
+	std::vector<unsigned>forward_tentative_distance;
+	std::vector<unsigned>backward_tentative_distance;
+
+	// The nodes whose tentative distances are not inf_weight.
+	BitVector in_forward_search_space;
+	BitVector in_backward_search_space;
+	std::vector<unsigned>forward_search_space;
+	std::vector<unsigned>backward_search_space;
+
+	std::array<unsigned, K>shortest_path_length;
 	unsigned state;
 };
 
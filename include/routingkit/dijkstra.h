@@ -5,14 +5,20 @@
 #include <routingkit/constants.h>
 #include <routingkit/timestamp_flag.h>
 #include <vector>
+#include <algorithm>
 
 namespace RoutingKit{
 
-class Dijkstra{
+// The priority queue can be any BasicMinIDQueue<Arity, unsigned> or MinIDRadixQueue. The
+// radix queue requires monotone keys. This holds as long as no source is added with a
+// departure time smaller than the distance of a node that was already settled since the
+// last reset.
+template<class Queue>
+class BasicDijkstra{
 public:
-	Dijkstra():first_out(nullptr){}
+	BasicDijkstra():first_out(nullptr){}
 
-	Dijkstra(const std::vector<unsigned>&first_out, const std::vector<unsigned>&tail, const std::vector<unsigned>&head):
+	BasicDijkstra(const std::vector<unsigned>&first_out, const std::vector<unsigned>&tail, const std::vector<unsigned>&head):
 		tentative_distance(first_out.size()-1),
 		predecessor_arc(first_out.size()-1),
 		was_popped(first_out.size()-1),
@@ -28,13 +34,13 @@ public:
 
 	}
 
-	Dijkstra&reset(){
+	BasicDijkstra&reset(){
 		queue.clear();
 		was_popped.reset_all();
 		return *this;
 	}
 
-	Dijkstra&reset(const std::vector<unsigned>&first_out, const std::vector<unsigned>&tail, const std::vector<unsigned>&head){
+	BasicDijkstra&reset(const std::vector<unsigned>&first_out, const std::vector<unsigned>&tail, const std::vector<unsigned>&head){
 		assert(!first_out.empty());
 		assert(first_out.front() == 0);
 		assert(first_out.back() == tail.size());
@@ -54,12 +60,12 @@ public:
 			tentative_distance.resize(first_out.size()-1);
 			predecessor_arc.resize(first_out.size()-1);
 			was_popped = TimestampFlags(first_out.size()-1);
-			queue = MinIDQueue(first_out.size()-1);
+			queue = Queue(first_out.size()-1);
 			return *this;
 		}
 	}
 
-	Dijkstra&add_source(unsigned id, unsigned departure_time = 0){
+	BasicDijkstra&add_source(unsigned id, unsigned departure_time = 0){
 		assert(id < first_out->size()-1);
 		tentative_distance[id] = departure_time;
 		predecessor_arc[id] = invalid_id;
@@ -151,13 +157,15 @@ private:
 	std::vector<unsigned>predecessor_arc;
 
 	TimestampFlags was_popped;
-	MinIDQueue queue;
+	Queue queue;
 
 	const std::vector<unsigned>*first_out;
 	const std::vector<unsigned>*tail;
 	const std::vector<unsigned>*head;
 };
 
+typedef BasicDijkstra<MinIDQueue> Dijkstra;
+
 class ScalarGetWeight{
 public:
 	explicit ScalarGetWeight(const std::vector<unsigned>&weight):weight(&weight){}
@@ -171,6 +179,298 @@ private:
 	const std::vector<unsigned>*weight;
 };
 
+// Point-to-point search that grows a forward search from the sources and a backward search
+// from the targets until they meet. The backward graph contains for every arc xy of the
+// forward graph an arc yx. backward_arc_to_forward_arc maps the backward arcs to their
+// forward arcs and is needed to report the arc path in terms of forward arcs. It can be
+// computed as follows, where tail and head are the arrays of the forward graph:
+//
+//   auto backward_arc_to_forward_arc = compute_stable_sort_permutation_using_key(head, node_count, [](unsigned x){return x;});
+//   auto backward_first_out = invert_vector(apply_permutation(backward_arc_to_forward_arc, head), node_count);
+//   auto backward_head = apply_permutation(backward_arc_to_forward_arc, tail);
+//   auto backward_weight = apply_permutation(backward_arc_to_forward_arc, weight);
+//
+// The searches stop as soon as the sum of the smallest keys in both queues is no smaller
+// than the shortest path found. The queue can be any BasicMinIDQueue<Arity, unsigned> or
+// MinIDRadixQueue.
+template<class Queue>
+class BasicBidirectionalDijkstra{
+public:
+	BasicBidirectionalDijkstra():forward_first_out(nullptr), settled_node_count(0){}
+
+	BasicBidirectionalDijkstra(
+		const std::vector<unsigned>&forward_first_out, const std::vector<unsigned>&forward_head, const std::vector<unsigned>&forward_weight,
+		const std::vector<unsigned>&backward_first_out, const std::vector<unsigned>&backward_head, const std::vector<unsigned>&backward_weight,
+		const std::vector<unsigned>&backward_arc_to_forward_arc
+	):
+		forward_first_out(nullptr),
+		settled_node_count(0){
+		reset(
+			forward_first_out, forward_head, forward_weight,
+			backward_first_out, backward_head, backward_weight,
+			backward_arc_to_forward_arc
+		);
+	}
+
+	BasicBidirectionalDijkstra&reset(){
+		assert(forward_first_out != nullptr && "object must have an attached graph");
+		forward_queue.clear();
+		backward_queue.clear();
+		was_forward_pushed.reset_all();
+		was_backward_pushed.reset_all();
+		shortest_path_length = inf_weight;
+		shortest_path_meeting_node = invalid_id;
+		return *this;
+	}
+
+	BasicBidirectionalDijkstra&reset(
+		const std::vector<unsigned>&forward_first_out, const std::vector<unsigned>&forward_head, const std::vector<unsigned>&forward_weight,
+		const std::vector<unsigned>&backward_first_out, const std::vector<unsigned>&backward_head, const std::vector<unsigned>&backward_weight,
+		const std::vector<unsigned>&backward_arc_to_forward_arc
+	){
+		assert(!forward_first_out.empty());
+		assert(forward_first_out.size() == backward_first_out.size());
+		assert(forward_first_out.back() == forward_head.size());
+		assert(forward_first_out.back() == forward_weight.size());
+		assert(backward_first_out.back() == backward_head.size());
+		assert(backward_first_out.back() == backward_weight.size());
+		assert(backward_first_out.back() == backward_arc_to_forward_arc.size());
+
+		bool is_same_size = this->forward_first_out != nullptr && forward_first_out.size() == this->forward_first_out->size();
+
+		this->forward_first_out = &forward_first_out;
+		this->forward_head = &forward_head;
+		this->forward_weight = &forward_weight;
+		this->backward_first_out = &backward_first_out;
+		this->backward_head = &backward_head;
+		this->backward_weight = &backward_weight;
+		this->backward_arc_to_forward_arc = &backward_arc_to_forward_arc;
+
+		if(!is_same_size){
+			unsigned node_count = forward_first_out.size()-1;
+			was_forward_pushed = TimestampFlags(node_count);
+			was_backward_pushed = TimestampFlags(node_count);
+			forward_queue = Queue(node_count);
+			backward_queue = Queue(node_count);
+			forward_tentative_distance.resize(node_count);
+			backward_tentative_distance.resize(node_count);
+			forward_predecessor_node.resize(node_count);
+			backward_predecessor_node.resize(node_count);
+			forward_predecessor_arc.resize(node_count);
+			backward_predecessor_arc.resize(node_count);
+		}
+		return reset();
+	}
+
+	//! Adds a source node. All paths from s are regarded as dist_to_s longer.
+	BasicBidirectionalDijkstra&add_source(unsigned s, unsigned dist_to_s = 0){
+		assert(s < forward_first_out->size()-1);
+		add_source_or_target(s, dist_to_s, was_forward_pushed, forward_queue, forward_tentative_distance, forward_predecessor_node, forward_predecessor_arc);
+		return *this;
+	}
+
+	//! Adds a target node. All paths to t are regarded as dist_to_t longer.
+	BasicBidirectionalDijkstra&add_target(unsigned t, unsigned dist_to_t = 0){
+		assert(t < forward_first_out->size()-1);
+		add_source_or_target(t, dist_to_t, was_backward_pushed, backward_queue, backward_tentative_distance, backward_predecessor_node, backward_predecessor_arc);
+		return *this;
+	}
+
+	BasicBidirectionalDijkstra&run(){
+		assert(forward_first_out != nullptr && "object must have an attached graph");
+
+		settled_node_count = 0;
+
+		bool forward_next = true;
+		for(;;){
+			if(forward_queue.empty() && backward_queue.empty())
+				break;
+
+			// Every path that is not found yet consists of a forward path that ends in a node
+			// of the forward queue and a backward path that ends in a node of the backward queue.
+			if(forward_queue.empty()){
+				if(backward_queue.peek().key >= shortest_path_length)
+					break;
+				forward_next = false;
+			} else if(backward_queue.empty()){
+				if(forward_queue.peek().key >= shortest_path_length)
+					break;
+				forward_next = true;
+			} else if(forward_queue.peek().key + backward_queue.peek().key >= shortest_path_length){
+				break;
+			}
+
+			if(forward_next){
+				settle_node(
+					*forward_first_out, *forward_head, *forward_weight,
+					was_forward_pushed, forward_queue, forward_tentative_distance, forward_predecessor_node, forward_predecessor_arc,
+					was_backward_pushed, backward_tentative_distance
+				);
+			} else {
+				settle_node(
+					*backward_first_out, *backward_head, *backward_weight,
+					was_backward_pushed, backward_queue, backward_tentative_distance, backward_predecessor_node, backward_predecessor_arc,
+					was_forward_pushed, forward_tentative_distance
+				);
+			}
+			forward_next = !forward_next;
+		}
+		return *this;
+	}
+
+	//! Returns the length of the shortest path including the source and target offsets or inf_weight, if no path exists.
+	unsigned get_distance()const{
+		return shortest_path_length;
+	}
+
+	//! Returns the source at which the shortest path starts or invalid_id, if no path exists.
+	unsigned get_used_source()const{
+		if(shortest_path_meeting_node == invalid_id)
+			return invalid_id;
+		unsigned x = shortest_path_meeting_node;
+		while(forward_predecessor_node[x] != invalid_id)
+			x = forward_predecessor_node[x];
+		return x;
+	}
+
+	//! Returns the target at which the shortest path ends or invalid_id, if no path exists.
+	unsigned get_used_target()const{
+		if(shortest_path_meeting_node == invalid_id)
+			return invalid_id;
+		unsigned x = shortest_path_meeting_node;
+		while(backward_predecessor_node[x] != invalid_id)
+			x = backward_predecessor_node[x];
+		return x;
+	}
+
+	std::vector<unsigned>get_node_path()const{
+		std::vector<unsigned>path;
+		if(shortest_path_meeting_node != invalid_id){
+			unsigned x = shortest_path_meeting_node;
+			while(x != invalid_id){
+				path.push_back(x);
+				x = forward_predecessor_node[x];
+			}
+			std::reverse(path.begin(), path.end());
+			x = backward_predecessor_node[shortest_path_meeting_node];
+			while(x != invalid_id){
+				path.push_back(x);
+				x = backward_predecessor_node[x];
+			}
+		}
+		return path; // NVRO
+	}
+
+	//! Returns the arc IDs of the path with respect to the forward graph.
+	std::vector<unsigned>get_arc_path()const{
+		std::vector<unsigned>path;
+		if(shortest_path_meeting_node != invalid_id){
+			unsigned x = shortest_path_meeting_node;
+			while(forward_predecessor_node[x] != invalid_id){
+				path.push_back(forward_predecessor_arc[x]);
+				x = forward_predecessor_node[x];
+			}
+			std::reverse(path.begin(), path.end());
+			x = shortest_path_meeting_node;
+			while(backward_predecessor_node[x] != invalid_id){
+				path.push_back((*backward_arc_to_forward_arc)[backward_predecessor_arc[x]]);
+				x = backward_predecessor_node[x];
+			}
+		}
+		return path; // NVRO
+	}
+
+	//! Returns the number of nodes removed from both queues during the last call to run.
+	unsigned get_settled_node_count()const{
+		return settled_node_count;
+	}
+
+private:
+	void add_source_or_target(
+		unsigned x, unsigned dist_to_x,
+		TimestampFlags&was_pushed, Queue&queue, std::vector<unsigned>&tentative_distance,
+		std::vector<unsigned>&predecessor_node, std::vector<unsigned>&predecessor_arc
+	){
+		if(!was_pushed.is_set(x)){
+			was_pushed.set(x);
+			queue.push({x, dist_to_x});
+		} else if(dist_to_x < tentative_distance[x]){
+			queue.decrease_key({x, dist_to_x});
+		} else {
+			return;
+		}
+		tentative_distance[x] = dist_to_x;
+		predecessor_node[x] = invalid_id;
+		predecessor_arc[x] = invalid_id;
+	}
+
+	void update_shortest_path(
+		unsigned x, unsigned distance_to_x,
+		const TimestampFlags&was_other_pushed, const std::vector<unsigned>&other_tentative_distance
+	){
+		if(was_other_pushed.is_set(x)){
+			unsigned d = distance_to_x + other_tentative_distance[x];
+			if(d < shortest_path_length){
+				shortest_path_length = d;
+				shortest_path_meeting_node = x;
+			}
+		}
+	}
+
+	void settle_node(
+		const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, const std::vector<unsigned>&weight,
+		TimestampFlags&was_pushed, Queue&queue, std::vector<unsigned>&tentative_distance,
+		std::vector<unsigned>&predecessor_node, std::vector<unsigned>&predecessor_arc,
+		const TimestampFlags&was_other_pushed, const std::vector<unsigned>&other_tentative_distance
+	){
+		auto p = queue.pop();
+		unsigned x = p.id;
+		++settled_node_count;
+
+		// Needed if x is a source and a target at the same time.
+		update_shortest_path(x, p.key, was_other_pushed, other_tentative_distance);
+
+		for(unsigned xy=first_out[x]; xy<first_out[x+1]; ++xy){
+			unsigned y = head[xy], w = weight[xy];
+			if(w >= inf_weight)
+				continue;
+			unsigned d = p.key + w;
+			if(!was_pushed.is_set(y)){
+				was_pushed.set(y);
+				queue.push({y, d});
+			} else if(queue.contains_id(y) && d < tentative_distance[y]){
+				queue.decrease_key({y, d});
+			} else {
+				continue;
+			}
+			tentative_distance[y] = d;
+			predecessor_node[y] = x;
+			predecessor_arc[y] = xy;
+			update_shortest_path(y, d, was_other_pushed, other_tentative_distance);
+		}
+	}
+
+	const std::vector<unsigned>*forward_first_out;
+	const std::vector<unsigned>*forward_head;
+	const std::vector<unsigned>*forward_weight;
+	const std::vector<unsigned>*backward_first_out;
+	const std::vector<unsigned>*backward_head;
+	const std::vector<unsigned>*backward_weight;
+	const std::vector<unsigned>*backward_arc_to_forward_arc;
+
+	TimestampFlags was_forward_pushed, was_backward_pushed;
+	Queue forward_queue, backward_queue;
+	std::vector<unsigned>forward_tentative_distance, backward_tentative_distance;
+	std::vector<unsigned>forward_predecessor_node, backward_predecessor_node;
+	std::vector<unsigned>forward_predecessor_arc, backward_predecessor_arc;
+
+	unsigned shortest_path_length;
+	unsigned shortest_path_meeting_node;
+	unsigned settled_node_count;
+};
+
+typedef BasicBidirectionalDijkstra<MinIDQueue> BidirectionalDijkstra;
+
 }
 
 #endif
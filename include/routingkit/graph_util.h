@@ -1,6 +1,8 @@
 #ifndef ROUTING_KIT_GRAPH_UTIL_H
 #define ROUTING_KIT_GRAPH_UTIL_H
 
+#include <routingkit/vector_view.h>
+
 #include <vector>
 
 namespace RoutingKit{
@@ -8,11 +10,11 @@ namespace RoutingKit{
 std::vector<unsigned>convert_node_path_to_arc_path(const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, std::vector<unsigned>path);
 std::vector<unsigned>convert_arc_path_to_node_path(unsigned source, const std::vector<unsigned>&head, std::vector<unsigned>path);
 
-unsigned find_arc(const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, unsigned x, unsigned y);
-unsigned find_arc_or_return_invalid(const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, unsigned x, unsigned y);
+unsigned find_arc(ConstVectorView<unsigned>first_out, ConstVectorView<unsigned>head, unsigned x, unsigned y);
+unsigned find_arc_or_return_invalid(ConstVectorView<unsigned>first_out, ConstVectorView<unsigned>head, unsigned x, unsigned y);
 
-unsigned find_arc_given_sorted_head(const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, unsigned x, unsigned y);
-unsigned find_arc_or_return_invalid_given_sorted_head(const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, unsigned x, unsigned y);
+unsigned find_arc_given_sorted_head(ConstVectorView<unsigned>first_out, ConstVectorView<unsigned>head, unsigned x, unsigned y);
+unsigned find_arc_or_return_invalid_given_sorted_head(ConstVectorView<unsigned>first_out, ConstVectorView<unsigned>head, unsigned x, unsigned y);
 
 
 
@@ -8,20 +8,29 @@
 
 namespace RoutingKit{
 
-struct IDKeyPair{
+template<class Key>
+struct BasicIDKeyPair{
 	unsigned id;
-	unsigned key;
+	Key key;
 };
 
+typedef BasicIDKeyPair<unsigned> IDKeyPair;
+
 //! A priority queue where the elements are IDs from 0 to id_count-1 where id_count is a number that is set in the constructor.
-//! The elements are sorted by integer keys.
-class MinIDQueue{
+//! The elements are sorted by integer keys of type Key. The queue is a heap in which every
+//! node has Arity children. Small arities are faster for small queues, for example in CH
+//! queries, whereas larger arities have fewer cache misses on large queues.
+template<unsigned Arity, class Key>
+class BasicMinIDQueue{
 private:
-	static const unsigned tree_arity = 4;
+	static_assert(Arity >= 2, "a heap needs at least two children per node");
+	static constexpr unsigned tree_arity = Arity;
 public:
-	MinIDQueue():heap_size(0){}
+	typedef BasicIDKeyPair<Key> IDKeyPair;
+
+	BasicMinIDQueue():heap_size(0){}
 
-	explicit MinIDQueue(unsigned id_count):
+	explicit BasicMinIDQueue(unsigned id_count):
 		id_pos(id_count, invalid_id),
 		heap(id_count),
 		heap_size(0){}
@@ -54,7 +63,7 @@ public:
 		heap_size = 0;
 	}
 
-	friend void swap(MinIDQueue&l, MinIDQueue&r){
+	friend void swap(BasicMinIDQueue&l, BasicMinIDQueue&r){
 		using std::swap;
 		swap(l.id_pos, r.id_pos);
 		swap(l.heap, r.heap);
@@ -63,7 +72,7 @@ public:
 
 	//! Returns the current key of an element.
 	//! Undefined if the element is not part of the queue.
-	unsigned get_key(unsigned id)const{
+	Key get_key(unsigned id)const{
 		assert(id < id_count());
 		assert(id_pos[id] != invalid_id);
 		return heap[id_pos[id]].key;
@@ -176,6 +185,211 @@ private:
 	unsigned heap_size;
 };
 
+typedef BasicMinIDQueue<4, unsigned> MinIDQueue;
+
+//! A radix heap with the same interface as MinIDQueue.
+//! The keys must be monotone, i.e., no key that is pushed or changed may be smaller than the
+//! key of the last popped element. This is the case for Dijkstra's algorithm and the CH
+//! searches if all weights are non-negative. An element is stored in the bucket that
+//! corresponds to the highest bit in which its key differs from the last popped key. push and
+//! decrease_key are O(1). An element can only move to lower buckets and therefore pop is
+//! amortized O(log(max key)).
+class MinIDRadixQueue{
+private:
+	static const unsigned bucket_count = 33;
+public:
+	MinIDRadixQueue():element_count(0), last_popped_key(0), is_min_known(false){}
+
+	explicit MinIDRadixQueue(unsigned id_count):
+		id_pos(id_count, invalid_id),
+		id_bucket(id_count),
+		element_count(0),
+		last_popped_key(0),
+		is_min_known(false){}
+
+	//! Returns whether the queue is empty. Equivalent to checking whether size() returns 0.
+	bool empty()const{
+		return element_count == 0;
+	}
+
+	//! Returns the number of elements in the queue.
+	unsigned size()const{
+		return element_count;
+	}
+
+	//! Returns the id_count value passed to the constructor.
+	unsigned id_count()const{
+		return id_pos.size();
+	}
+
+	//! Checks whether an element is in the queue.
+	bool contains_id(unsigned id){
+		assert(id < id_count());
+		return id_pos[id] != invalid_id;
+	}
+
+	//! Removes all elements from the queue. Afterwards, keys are no longer required to be
+	//! at least the last popped key.
+	void clear(){
+		for(auto&b:bucket){
+			for(auto&p:b)
+				id_pos[p.id] = invalid_id;
+			b.clear();
+		}
+		element_count = 0;
+		last_popped_key = 0;
+		is_min_known = false;
+	}
+
+	friend void swap(MinIDRadixQueue&l, MinIDRadixQueue&r){
+		using std::swap;
+		swap(l.id_pos, r.id_pos);
+		swap(l.id_bucket, r.id_bucket);
+		for(unsigned i=0; i<bucket_count; ++i)
+			swap(l.bucket[i], r.bucket[i]);
+		swap(l.element_count, r.element_count);
+		swap(l.last_popped_key, r.last_popped_key);
+		swap(l.is_min_known, r.is_min_known);
+		swap(l.known_min, r.known_min);
+	}
+
+	//! Returns the current key of an element.
+	//! Undefined if the element is not part of the queue.
+	unsigned get_key(unsigned id)const{
+		assert(id < id_count());
+		assert(id_pos[id] != invalid_id);
+		return bucket[id_bucket[id]][id_pos[id]].key;
+	}
+
+	//! Returns the smallest element key pair without removing it from the queue.
+	//! The minimum is remembered until it is popped or its key increased. Alternating calls
+	//! to peek and pop therefore only scan every bucket once.
+	IDKeyPair peek()const{
+		assert(!empty());
+		if(!bucket[0].empty())
+			return bucket[0].back();
+		if(!is_min_known){
+			unsigned b = 1;
+			while(bucket[b].empty())
+				++b;
+			known_min = bucket[b][0];
+			for(auto p:bucket[b])
+				if(p.key < known_min.key)
+					known_min = p;
+			is_min_known = true;
+		}
+		return known_min;
+	}
+
+	//! Returns the smallest element key pair and removes it form the queue.
+	IDKeyPair pop(){
+		assert(!empty());
+		if(bucket[0].empty()){
+			last_popped_key = peek().key;
+
+			unsigned b = id_bucket[known_min.id];
+			// All elements move to lower buckets, at least one of them to bucket 0.
+			for(auto p:bucket[b])
+				append_to_bucket(p);
+			bucket[b].clear();
+		}
+		is_min_known = false;
+
+		--element_count;
+		IDKeyPair p = bucket[0].back();
+		bucket[0].pop_back();
+		id_pos[p.id] = invalid_id;
+		return p;
+	}
+
+	//! Inserts a element key pair.
+	//! Undefined if the element is part of the queue or if the key is smaller than the last popped key.
+	void push(IDKeyPair p){
+		assert(p.id < id_count());
+		assert(!contains_id(p.id));
+		assert(p.key >= last_popped_key && "keys in a radix queue must be monotone");
+
+		++element_count;
+		append_to_bucket(p);
+		if(is_min_known && p.key < known_min.key)
+			known_min = p;
+	}
+
+	//! Updates the key of an element if the new key is smaller than the old key.
+	//! Does nothing if the new key is larger.
+	//! Undefined if the element is not part of the queue or if the key is smaller than the last popped key.
+	bool decrease_key(IDKeyPair p){
+		assert(p.id < id_count());
+		assert(contains_id(p.id));
+		assert(p.key >= last_popped_key && "keys in a radix queue must be monotone");
+
+		if(get_key(p.id) > p.key){
+			move_to_bucket_of_key(p);
+			if(is_min_known && p.key < known_min.key)
+				known_min = p;
+			return true;
+		} else {
+			return false;
+		}
+	}
+
+	//! Updates the key of an element if the new key is larger than the old key.
+	//! Does nothing if the new key is smaller.
+	//! Undefined if the element is not part of the queue.
+	bool increase_key(IDKeyPair p){
+		assert(p.id < id_count());
+		assert(contains_id(p.id));
+
+		if(get_key(p.id) < p.key){
+			move_to_bucket_of_key(p);
+			if(is_min_known && p.id == known_min.id)
+				is_min_known = false;
+			return true;
+		} else {
+			return false;
+		}
+	}
+
+private:
+	unsigned get_bucket_of_key(unsigned key)const{
+		if(key == last_popped_key)
+			return 0;
+		else
+			return 32 - __builtin_clz(key ^ last_popped_key);
+	}
+
+	void append_to_bucket(IDKeyPair p){
+		unsigned b = get_bucket_of_key(p.key);
+		id_bucket[p.id] = b;
+		id_pos[p.id] = bucket[b].size();
+		bucket[b].push_back(p);
+	}
+
+	void move_to_bucket_of_key(IDKeyPair p){
+		unsigned old_bucket = id_bucket[p.id], new_bucket = get_bucket_of_key(p.key);
+		unsigned pos = id_pos[p.id];
+		if(old_bucket == new_bucket){
+			bucket[old_bucket][pos].key = p.key;
+		} else {
+			auto&b = bucket[old_bucket];
+			b[pos] = b.back();
+			id_pos[b[pos].id] = pos;
+			b.pop_back();
+			append_to_bucket(p);
+		}
+	}
+
+	std::vector<unsigned>id_pos;
+	std::vector<unsigned char>id_bucket;
+	std::vector<IDKeyPair>bucket[bucket_count];
+
+	unsigned element_count;
+	unsigned last_popped_key;
+
+	mutable bool is_min_known;
+	mutable IDKeyPair known_min;
+};
+
 } // namespace RoutingKit
 
 #endif
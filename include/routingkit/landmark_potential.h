@@ -0,0 +1,153 @@
+#ifndef ROUTING_KIT_LANDMARK_POTENTIAL_H
+#define ROUTING_KIT_LANDMARK_POTENTIAL_H
+
+#include <routingkit/constants.h>
+#include <routingkit/vector_view.h>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <assert.h>
+
+namespace RoutingKit{
+
+// Landmark selection for ALT (A*, landmarks, and the triangle inequality). Both functions
+// return landmark_count distinct nodes and are deterministic for a given seed.
+//
+// The farthest heuristic repeatedly picks the node that is farthest away from all
+// landmarks selected so far. Nodes that cannot be reached from any landmark are picked
+// first. The first landmark is the node farthest away from a random node.
+//
+// The avoid heuristic grows a shortest path tree from a random root and weighs every node
+// by how much the current landmarks underestimate its distance from the root. It then picks
+// the subtree with the largest total weight that contains no landmark and descends from its
+// top node along the heaviest children to a leaf, which becomes the next landmark. This
+// places landmarks in regions that are badly covered. Which heuristic gives better lower
+// bounds depends on the graph. Only if the leaves of several random trees are all landmarks,
+// the next landmark is picked as by the farthest heuristic. If farthest_fallback_count is
+// not null, it is set to the number of landmarks picked this way.
+std::vector<unsigned>select_farthest_landmarks(
+	const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, const std::vector<unsigned>&weight,
+	unsigned landmark_count, unsigned seed = 0
+);
+
+std::vector<unsigned>select_avoid_landmarks(
+	const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, const std::vector<unsigned>&weight,
+	unsigned landmark_count, unsigned seed = 0, unsigned*farthest_fallback_count = nullptr
+);
+
+// Computes the ALT lower bound on the distance from node to target, i.e., the maximum over
+// all landmarks l of dist(l,target)-dist(l,node) and dist(node,l)-dist(target,l). If the
+// distances of a landmark prove that target cannot be reached from node, the result is
+// inf_weight-1. The tables store the distances of node x and landmark i at
+// x*landmark_count+i, so only two short rows are read per call.
+inline unsigned compute_landmark_lower_bound(
+	unsigned landmark_count, const unsigned*distance_from_landmark, const unsigned*distance_to_landmark,
+	unsigned node, unsigned target
+){
+	const unsigned
+		*from_node = distance_from_landmark + (unsigned long long)node*landmark_count,
+		*from_target = distance_from_landmark + (unsigned long long)target*landmark_count,
+		*to_node = distance_to_landmark + (unsigned long long)node*landmark_count,
+		*to_target = distance_to_landmark + (unsigned long long)target*landmark_count;
+
+	unsigned bound = 0;
+	for(unsigned i=0; i<landmark_count; ++i){
+		if(from_node[i] != inf_weight){
+			if(from_target[i] == inf_weight)
+				return inf_weight-1;
+			if(from_target[i] > from_node[i] && from_target[i] - from_node[i] > bound)
+				bound = from_target[i] - from_node[i];
+		}
+		if(to_target[i] != inf_weight){
+			if(to_node[i] == inf_weight)
+				return inf_weight-1;
+			if(to_node[i] > to_target[i] && to_node[i] - to_target[i] > bound)
+				bound = to_node[i] - to_target[i];
+		}
+	}
+	return bound;
+}
+
+// A potential for AStar that stores the distances from and to a set of landmarks. The
+// potential is consistent for the weights it was computed with and stays consistent if
+// weights are increased or arcs are closed afterwards. The tables therefore need not be
+// recomputed when the metric only becomes slower, for example because of road closures.
+//
+// The tables are computed using one Dijkstra search per landmark and direction. The
+// searches are distributed over thread_count threads.
+class LandmarkPotential{
+public:
+	LandmarkPotential(){}
+
+	LandmarkPotential(
+		const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, const std::vector<unsigned>&weight,
+		std::vector<unsigned>landmark, unsigned thread_count = 1
+	);
+
+	unsigned landmark_count()const{
+		return landmark.size();
+	}
+
+	unsigned node_count()const{
+		if(landmark.empty())
+			return 0;
+		return distance_from_landmark.size() / landmark.size();
+	}
+
+	unsigned operator()(unsigned node, unsigned target)const{
+		assert(node < node_count());
+		assert(target < node_count());
+		return compute_landmark_lower_bound(landmark.size(), distance_from_landmark.data(), distance_to_landmark.data(), node, target);
+	}
+
+	// The three vectors are stored using save_vector. They can be loaded using load_files or
+	// mapped into memory using LandmarkPotentialView::map_files.
+	void save_files(const std::string&landmark_file, const std::string&distance_from_landmark_file, const std::string&distance_to_landmark_file)const;
+	static LandmarkPotential load_files(const std::string&landmark_file, const std::string&distance_from_landmark_file, const std::string&distance_to_landmark_file);
+
+//private:
+	std::vector<unsigned>landmark;
+	std::vector<unsigned>distance_from_landmark;
+	std::vector<unsigned>distance_to_landmark;
+};
+
+// A read-only view of a LandmarkPotential with the same members. It either refers to a
+// LandmarkPotential object, which must outlive the view, or to files written by
+// save_files. In the latter case, the files are mapped into memory and nothing is copied.
+// The mappings are shared by all copies of the view and are released when the last copy
+// is destroyed.
+class LandmarkPotentialView{
+public:
+	LandmarkPotentialView(){}
+	LandmarkPotentialView(const LandmarkPotential&p);
+
+	static LandmarkPotentialView map_files(const std::string&landmark_file, const std::string&distance_from_landmark_file, const std::string&distance_to_landmark_file);
+
+	unsigned landmark_count()const{
+		return landmark.size();
+	}
+
+	unsigned node_count()const{
+		if(landmark.empty())
+			return 0;
+		return distance_from_landmark.size() / landmark.size();
+	}
+
+	unsigned operator()(unsigned node, unsigned target)const{
+		assert(node < node_count());
+		assert(target < node_count());
+		return compute_landmark_lower_bound(landmark.size(), distance_from_landmark.data(), distance_to_landmark.data(), node, target);
+	}
+
+//private:
+	ConstVectorView<unsigned>landmark;
+	ConstVectorView<unsigned>distance_from_landmark;
+	ConstVectorView<unsigned>distance_to_landmark;
+
+	std::shared_ptr<const void>mapped_file;
+};
+
+} // RoutingKit
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef ROUTING_KIT_VECTOR_VIEW_H
+#define ROUTING_KIT_VECTOR_VIEW_H
+
+#include <routingkit/bit_vector.h>
+
+#include <vector>
+#include <stdint.h>
+#include <assert.h>
+
+namespace RoutingKit{
+
+// Read-only, non-owning access to a contiguous array. The array is either owned by an
+// std::vector or lives in a memory mapped file. The referred memory must outlive the view.
+template<class T>
+class ConstVectorView{
+public:
+	ConstVectorView():data_(nullptr), size_(0){}
+	ConstVectorView(const T*data, uint64_t size):data_(data), size_(size){}
+	ConstVectorView(const std::vector<T>&vec):data_(vec.data()), size_(vec.size()){}
+
+	bool empty()const { return size_ == 0; }
+	uint64_t size()const { return size_; }
+
+	const T&operator[](uint64_t i)const{
+		assert(i < size_ && "argument out of bounds");
+		return data_[i];
+	}
+
+	const T*data()const{ return data_; }
+	const T*begin()const{ return data_; }
+	const T*end()const{ return data_ + size_; }
+
+	std::vector<T>to_vector()const{ return std::vector<T>(begin(), end()); }
+private:
+	const T*data_;
+	uint64_t size_;
+};
+
+// Read-only, non-owning access to the bits of a BitVector. The bits are stored in the
+// same layout as in BitVector, i.e., bit x is bit x%64 of the 64-bit word x/64.
+class ConstBitVectorView{
+public:
+	ConstBitVectorView():data_(nullptr), size_(0){}
+	ConstBitVectorView(const uint64_t*data, uint64_t size):data_(data), size_(size){}
+	ConstBitVectorView(const BitVector&vec):data_(vec.data()), size_(vec.size()){}
+
+	bool empty()const { return size_ == 0; }
+	uint64_t size()const { return size_; }
+
+	bool is_set(uint64_t x)const{
+		assert(x < size_ && "argument out of bounds");
+		return data_[x/64] & (1ull << (x%64));
+	}
+
+	const uint64_t*data()const{ return data_; }
+private:
+	const uint64_t*data_;
+	uint64_t size_;
+};
+
+} // namespace RoutingKit
+
+#endif
@@ -0,0 +1,66 @@
+#include <routingkit/astar.h>
+
+#include <vector>
+#include <limits>
+#include <math.h>
+#include <assert.h>
+
+namespace RoutingKit{
+
+GeoDistancePotential::GeoDistancePotential(const std::vector<float>&latitude, const std::vector<float>&longitude, double weight_per_meter):
+	weight_per_meter(weight_per_meter),
+	x(latitude.size()), y(latitude.size()), z(latitude.size()){
+	assert(latitude.size() == longitude.size());
+	assert(weight_per_meter >= 0);
+
+	const double pi_div_180 = 3.14159265359/180.0;
+	const double earth_radius = 6371000.785; // in meter, same as in geo_dist
+
+	const unsigned node_count = latitude.size();
+	for(unsigned i=0; i<node_count; ++i){
+		double lat = latitude[i]*pi_div_180, lon = longitude[i]*pi_div_180;
+		x[i] = earth_radius * cos(lat) * cos(lon);
+		y[i] = earth_radius * cos(lat) * sin(lon);
+		z[i] = earth_radius * sin(lat);
+	}
+}
+
+double GeoDistancePotential::compute_largest_valid_weight_per_meter(
+	const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, const std::vector<unsigned>&weight,
+	const std::vector<float>&latitude, const std::vector<float>&longitude
+){
+	assert(!first_out.empty());
+	assert(first_out.back() == head.size());
+	assert(first_out.back() == weight.size());
+	assert(latitude.size() == first_out.size()-1);
+	assert(longitude.size() == first_out.size()-1);
+
+	// The potential is computed from the same 3D points.
+	GeoDistancePotential unit_potential(latitude, longitude, 1.0);
+
+	double largest_valid_weight_per_meter = std::numeric_limits<double>::infinity();
+	const unsigned node_count = first_out.size()-1;
+	for(unsigned x=0; x<node_count; ++x){
+		for(unsigned xy=first_out[x]; xy<first_out[x+1]; ++xy){
+			if(weight[xy] >= inf_weight)
+				continue;
+			unsigned y = head[xy];
+			double
+				dx = unit_potential.x[x] - unit_potential.x[y],
+				dy = unit_potential.y[x] - unit_potential.y[y],
+				dz = unit_potential.z[x] - unit_potential.z[y];
+			double len = sqrt(dx*dx + dy*dy + dz*dz);
+			if(len > 0 && weight[xy] < largest_valid_weight_per_meter * len)
+				largest_valid_weight_per_meter = weight[xy] / len;
+		}
+	}
+
+	if(largest_valid_weight_per_meter == std::numeric_limits<double>::infinity())
+		return 0;
+	// weight/len is rounded and the potential is evaluated in floating point, so factor*len
+	// can slightly exceed the weight of the tightest arc. A small margin keeps the floored
+	// potential consistent.
+	return largest_valid_weight_per_meter * (1.0 - 1e-9);
+}
+
+} // RoutingKit
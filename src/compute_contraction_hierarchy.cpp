@@ -22,14 +22,20 @@ int main(int argc, char*argv[]){
 
 		string ch_file;
 
-		if(argc != 5){
-			cerr << argv[0] << " graph_first_out graph_head graph_weight ch_file" << endl;
+		unsigned thread_count = 1;
+
+		if(argc != 5 && argc != 6){
+			cerr << argv[0] << " graph_first_out graph_head graph_weight ch_file [thread_count]" << endl;
 			return 1;
 		}else{
 			graph_first_out = argv[1];
 			graph_head = argv[2];
 			graph_weight = argv[3];
 			ch_file = argv[4];
+			if(argc == 6)
+				thread_count = stoul(argv[5]);
+			if(thread_count == 0)
+				throw runtime_error("thread_count must not be 0.");
 		}
 
 		cout << "Loading graph ... " << flush;
@@ -60,7 +66,7 @@ int main(int argc, char*argv[]){
 			throw runtime_error("The weight vector must be as long as the number of arcs");
 
 		
-		auto ch = ContractionHierarchy::build(node_count, invert_inverse_vector(first_out), head, weight, [](string msg){cout << msg << endl;});
+		auto ch = ContractionHierarchy::build(node_count, invert_inverse_vector(first_out), head, weight, [](string msg){cout << msg << endl;}, ContractionHierarchy::default_max_pop_count, thread_count);
 		check_contraction_hierarchy_for_errors(ch);
 		ch.save_file(ch_file);
 
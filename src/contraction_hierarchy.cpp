@@ -5,10 +5,17 @@
 #include <routingkit/timer.h>
 #include <routingkit/graph_util.h>
 #include <routingkit/vector_io.h>
+#include "mapped_file.h"
+#include "contraction_hierarchy_upward_search.h"
 
 #include <vector>
 #include <fstream>
 #include <stdexcept>
+#include <algorithm>
+#include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace RoutingKit{
 
@@ -80,15 +87,183 @@ namespace{
 		}
 	}
 
+	// Stores for every node a list of arcs. All lists are stored in a single large arena. Every
+	// list has some slack at its end. If the slack is exhausted, the list is moved to the end of
+	// the arena and its old space becomes garbage. If the arena is full, the garbage is removed
+	// by moving all lists to the front. This avoids millions of small heap allocations.
+	template<class Arc>
+	class ArcArena{
+	public:
+		ArcArena(){}
+
+		explicit ArcArena(const std::vector<unsigned>&deg):
+			begin_(deg.size()), deg_(deg.size(), 0), capacity_(deg.size()),
+			compaction_count_(0), compaction_time_(0), grow_count_(0), grow_time_(0){
+			unsigned long long arena_size = 0;
+			for(unsigned x=0; x<deg.size(); ++x){
+				begin_[x] = arena_size;
+				capacity_[x] = initial_capacity(deg[x]);
+				arena_size += capacity_[x];
+			}
+			end_ = arena_size;
+			arc_.resize(arena_size + arena_size/4);
+			peak_arena_size_ = arc_.capacity();
+		}
+
+		unsigned deg(unsigned x)const{
+			return deg_[x];
+		}
+
+		const Arc&get(unsigned x, unsigned i)const{
+			assert(i < deg_[x]);
+			return arc_[begin_[x]+i];
+		}
+
+		Arc&get(unsigned x, unsigned i){
+			assert(i < deg_[x]);
+			return arc_[begin_[x]+i];
+		}
+
+		// Makes sure that arc_count arcs fit into the list of x. Afterwards, push_back does not
+		// allocate until the list has arc_count arcs and can therefore be called from several
+		// threads for different nodes.
+		void reserve(unsigned x, unsigned arc_count){
+			if(arc_count > capacity_[x])
+				move_to_end(x, std::max(arc_count, 2*capacity_[x]));
+		}
+
+		void push_back(unsigned x, Arc a){
+			if(deg_[x] == capacity_[x])
+				move_to_end(x, std::max(deg_[x]+1, 2*capacity_[x]));
+			arc_[begin_[x]+deg_[x]] = a;
+			++deg_[x];
+		}
+
+		// Removes the i-th arc of x while preserving the order of the other arcs.
+		void erase(unsigned x, unsigned i){
+			assert(i < deg_[x]);
+			Arc*list = &arc_[begin_[x]];
+			std::copy(list+i+1, list+deg_[x], list+i);
+			--deg_[x];
+		}
+
+		// Releases the space of x. The space becomes garbage until the next compaction.
+		void clear(unsigned x){
+			deg_[x] = 0;
+			capacity_[x] = 0;
+		}
+
+		unsigned long long arena_size()const{ return arc_.size(); }
+		// The largest number of arcs for which memory was allocated at the same time.
+		unsigned long long peak_arena_size()const{ return peak_arena_size_; }
+		unsigned compaction_count()const{ return compaction_count_; }
+		long long compaction_time()const{ return compaction_time_; }
+		unsigned grow_count()const{ return grow_count_; }
+		long long grow_time()const{ return grow_time_; }
+
+	private:
+		static unsigned initial_capacity(unsigned deg){
+			return deg + deg/4 + 1;
+		}
+
+		void move_to_end(unsigned x, unsigned new_capacity){
+			if(end_ + new_capacity > arc_.size())
+				make_room(new_capacity);
+			std::copy(arc_.begin()+begin_[x], arc_.begin()+begin_[x]+deg_[x], arc_.begin()+end_);
+			begin_[x] = end_;
+			capacity_[x] = new_capacity;
+			end_ += new_capacity;
+		}
+
+		void make_room(unsigned long long arc_count){
+			unsigned long long live_arc_count = 0;
+			for(unsigned x=0; x<capacity_.size(); ++x)
+				live_arc_count += capacity_[x];
+
+			// Only compact if this frees a significant amount of space as compaction requires
+			// a pass over all nodes.
+			if(live_arc_count < end_ - end_/4)
+				compact();
+
+			if(end_ + arc_count > arc_.size()){
+				long long timer = -get_micro_time();
+				unsigned long long old_capacity = arc_.capacity();
+				unsigned long long new_size = std::max((unsigned long long)(arc_.size() + arc_.size()/2), end_ + arc_count);
+				// Reserve exactly, as resize may allocate up to twice the old size.
+				arc_.reserve(new_size);
+				arc_.resize(new_size);
+				// While the arcs are moved, the old and the new buffer are both allocated.
+				peak_arena_size_ = std::max(peak_arena_size_, old_capacity + arc_.capacity());
+				timer += get_micro_time();
+				grow_time_ += timer;
+				++grow_count_;
+			}
+		}
+
+		// Moves all lists to the front of the arena in the order of their current position.
+		// As lists are only moved towards the front, this can be done in-place.
+		void compact(){
+			long long timer = -get_micro_time();
+
+			std::vector<unsigned>node_list;
+			for(unsigned x=0; x<capacity_.size(); ++x)
+				if(capacity_[x] != 0)
+					node_list.push_back(x);
+			std::sort(node_list.begin(), node_list.end(), [&](unsigned l, unsigned r){return begin_[l] < begin_[r];});
+
+			unsigned long long new_end = 0;
+			for(auto x:node_list){
+				assert(new_end <= begin_[x]);
+				std::copy(arc_.begin()+begin_[x], arc_.begin()+begin_[x]+deg_[x], arc_.begin()+new_end);
+				begin_[x] = new_end;
+				new_end += capacity_[x];
+			}
+			end_ = new_end;
+
+			timer += get_micro_time();
+			compaction_time_ += timer;
+			++compaction_count_;
+		}
+
+		std::vector<Arc>arc_;
+		std::vector<unsigned long long>begin_;
+		std::vector<unsigned>deg_;
+		std::vector<unsigned>capacity_;
+		unsigned long long end_;
+
+		unsigned long long peak_arena_size_;
+		unsigned compaction_count_;
+		long long compaction_time_;
+		unsigned grow_count_;
+		long long grow_time_;
+	};
+
 	class Graph{
 	public:
+		struct Arc{
+			unsigned node;
+			unsigned weight;
+			unsigned hop_length;
+			unsigned mid_node;
+		};
+
 		Graph(){}
 
 		Graph(unsigned node_count, const std::vector<unsigned>&tail, const std::vector<unsigned>&head, const std::vector<unsigned>&weight):
-			out_(node_count),
-			in_(node_count),
 			level_(node_count, 0){
 
+			{
+				std::vector<unsigned>out_deg(node_count, 0), in_deg(node_count, 0);
+				for(unsigned a=0; a<head.size(); ++a){
+					if(tail[a] != head[a]){
+						++out_deg[tail[a]];
+						++in_deg[head[a]];
+					}
+				}
+				out_ = ArcArena<Arc>(out_deg);
+				in_ = ArcArena<Arc>(in_deg);
+			}
+
 			for(unsigned a=0; a<head.size(); ++a){
 				unsigned x = tail[a];
 				unsigned y = head[a];
@@ -96,8 +271,8 @@ namespace{
 
 
 				if(x != y){
-					out_[x].push_back({y, w, 1, invalid_id});
-					in_[y].push_back({x, w, 1, invalid_id});
+					out_.push_back(x, {y, w, 1, invalid_id});
+					in_.push_back(y, {x, w, 1, invalid_id});
 				}
 			}
 		}
@@ -109,27 +284,29 @@ namespace{
 			assert(y < node_count());
 
 			auto reduce_arc_if_exists = [weight, hop_length, mid_node](
-				unsigned x, std::vector<Arc>&x_out,
-				unsigned y, std::vector<Arc>&y_in
+				unsigned x, ArcArena<Arc>&out,
+				unsigned y, ArcArena<Arc>&in
 			){
 
 				// Does arc exist?
-				for(unsigned out_arc = 0; out_arc < x_out.size(); ++out_arc){
-					if(x_out[out_arc].node == y){
+				for(unsigned out_arc = 0; out_arc < out.deg(x); ++out_arc){
+					Arc&x_out = out.get(x, out_arc);
+					if(x_out.node == y){
 
 						// Is the existing arc longer?
-						if(x_out[out_arc].weight <= weight)
+						if(x_out.weight <= weight)
 							return true;
 
 						// We need to adjust the weights
-						for(unsigned in_arc = 0; in_arc < y_in.size(); ++in_arc){
-							if(y_in[in_arc].node == x){
-								x_out[out_arc].weight = weight;
-								x_out[out_arc].hop_length = hop_length;
-								x_out[out_arc].mid_node = mid_node;
-								y_in[in_arc].weight = weight;
-								y_in[in_arc].hop_length = hop_length;
-								y_in[in_arc].mid_node = mid_node;
+						for(unsigned in_arc = 0; in_arc < in.deg(y); ++in_arc){
+							Arc&y_in = in.get(y, in_arc);
+							if(y_in.node == x){
+								x_out.weight = weight;
+								x_out.hop_length = hop_length;
+								x_out.mid_node = mid_node;
+								y_in.weight = weight;
+								y_in.hop_length = hop_length;
+								y_in.mid_node = mid_node;
 								return true;
 							}
 						}
@@ -139,76 +316,79 @@ namespace{
 				return false;
 			};
 
-			if(out_[x].size() <= in_[y].size()){
-				if(reduce_arc_if_exists(x, out_[x], y, in_[y]))
+			if(out_.deg(x) <= in_.deg(y)){
+				if(reduce_arc_if_exists(x, out_, y, in_))
 					return;
 			} else {
-				if(reduce_arc_if_exists(y, in_[y], x, out_[x]))
+				if(reduce_arc_if_exists(y, in_, x, out_))
 					return;
 			}
 
 			// The edges does not exist -> add the edge
-			out_[x].push_back({y,weight,hop_length,mid_node});
-			in_[y].push_back({x,weight,hop_length,mid_node});
+			out_.push_back(x, {y,weight,hop_length,mid_node});
+			in_.push_back(y, {x,weight,hop_length,mid_node});
+		}
+
+		// After these calls, add_arc_or_reduce_arc_weight does not allocate memory as long as
+		// the degrees stay below the reserved arc counts. It can then be called from several
+		// threads as long as the threads do not modify the arcs of the same nodes.
+		void reserve_out_arcs(unsigned node, unsigned arc_count){
+			assert(node < node_count());
+			out_.reserve(node, arc_count);
+		}
+
+		void reserve_in_arcs(unsigned node, unsigned arc_count){
+			assert(node < node_count());
+			in_.reserve(node, arc_count);
 		}
 
 		void remove_all_incident_arcs(unsigned x){
 			assert(x < node_count());
 
-			auto remove_back_arcs = [&](unsigned x, const std::vector<Arc>&x_out, std::vector<std::vector<Arc>>&in){
-				for(unsigned out_arc = 0; out_arc < x_out.size(); ++out_arc){
-					unsigned y = x_out[out_arc].node;
-					for(auto in_arc = in[y].begin(); ; ++in_arc){
-						assert(in_arc != in[y].end());
-						if(in_arc->node == x){
-							in[y].erase(in_arc);
+			auto remove_back_arcs = [&](unsigned x, const ArcArena<Arc>&out, ArcArena<Arc>&in){
+				for(unsigned out_arc = 0; out_arc < out.deg(x); ++out_arc){
+					unsigned y = out.get(x, out_arc).node;
+					for(unsigned in_arc = 0; ; ++in_arc){
+						assert(in_arc != in.deg(y));
+						if(in.get(y, in_arc).node == x){
+							in.erase(y, in_arc);
 							break;
 						}
 					}
 				}
 			};
 
-			remove_back_arcs(x, out_[x], in_);
-			remove_back_arcs(x, in_[x], out_);
+			remove_back_arcs(x, out_, in_);
+			remove_back_arcs(x, in_, out_);
 
-			in_[x].clear();
-			out_[x].clear();
-			in_[x].shrink_to_fit();
-			out_[x].shrink_to_fit();
+			in_.clear(x);
+			out_.clear(x);
 		}
 
-		struct Arc{
-			unsigned node;
-			unsigned weight;
-			unsigned hop_length;
-			unsigned mid_node;
-		};
-
 		unsigned out_deg(unsigned node)const{
 			assert(node < node_count());
-			return out_[node].size();
+			return out_.deg(node);
 		}
 
 		unsigned in_deg(unsigned node)const{
 			assert(node < node_count());
-			return in_[node].size();
+			return in_.deg(node);
 		}
 
 		Arc out(unsigned node, unsigned out_arc)const{
 			assert(node < node_count());
-			assert(out_arc < out_[node].size());
-			return out_[node][out_arc];
+			assert(out_arc < out_deg(node));
+			return out_.get(node, out_arc);
 		}
 
 		Arc in(unsigned node, unsigned in_arc)const{
 			assert(node < node_count());
-			assert(in_arc < in_[node].size());
-			return in_[node][in_arc];
+			assert(in_arc < in_deg(node));
+			return in_.get(node, in_arc);
 		}
 
 		unsigned node_count()const{
-			assert(in_.size() == out_.size());
-			return out_.size();
+			return level_.size();
 		}
 
 		unsigned level(unsigned node)const{
@@ -222,8 +402,17 @@ namespace{
 				level_[node] = level;
 			}
 		}
+
+		void log_memory_statistics(const std::function<void(std::string)>&log_message)const{
+			if(log_message){
+				unsigned long long per_node_bytes = (unsigned long long)node_count()*(sizeof(unsigned) + 2*(sizeof(unsigned long long)+2*sizeof(unsigned)));
+				unsigned long long peak_arena_bytes = (out_.peak_arena_size() + in_.peak_arena_size())*sizeof(Arc);
+				log_message("Contraction graph needed at most "+std::to_string(per_node_bytes + peak_arena_bytes)+" bytes, of which "+std::to_string(peak_arena_bytes)+" bytes were arc arenas.");
+				log_message("Contraction graph arc arenas were compacted "+std::to_string(out_.compaction_count()+in_.compaction_count())+" times, needing "+std::to_string(out_.compaction_time()+in_.compaction_time())+"musec, and were grown "+std::to_string(out_.grow_count()+in_.grow_count())+" times, needing "+std::to_string(out_.grow_time()+in_.grow_time())+"musec.");
+			}
+		}
 	private:
-		std::vector<std::vector<Arc>>out_, in_;
+		ArcArena<Arc>out_, in_;
 		std::vector<unsigned>level_;
 	};
 
@@ -231,6 +420,7 @@ namespace{
 	public:
 		ShorterPathTest(){}
 		ShorterPathTest(const Graph&graph, unsigned max_pop_count):
+			bypass_node_set(nullptr),
 			max_pop_count(max_pop_count), graph(&graph),
 			forward_tentative_distance(graph.node_count()), backward_tentative_distance(graph.node_count()),
 			forward_queue(graph.node_count()), backward_queue(graph.node_count()),
@@ -328,6 +518,9 @@ namespace{
 				if(next_node == bypass)
 					continue;
 
+				if(bypass_node_set != nullptr && (*bypass_node_set)[next_node])
+					continue;
+
 				unsigned next_node_distance = distance_to_popped_node + graph_out(popped_node, out_arc).weight;
 
 				if(was_forward_pushed.is_set(next_node)){
@@ -362,7 +555,14 @@ namespace{
 		}
 
 		unsigned bypass_node;
+		const std::vector<char>*bypass_node_set;
 	public:
+		// If set, all nodes x with (*bypass_node_set)[x] != 0 are ignored by the witness searches
+		// in addition to the bypass node. This is needed when several nodes are contracted at once.
+		void set_bypass_node_set(const std::vector<char>*new_bypass_node_set){
+			bypass_node_set = new_bypass_node_set;
+		}
+
 		void pin_source(unsigned s, unsigned new_bypass_node){
 			was_forward_pushed.reset_all();
 			forward_queue.clear();
@@ -563,7 +763,12 @@ namespace{
 		return 1 + 1000*level + (1000*added_arc_count) / removed_arc_count + (1000*added_hop_count) / removed_hop_count;
 	}
 
-	void contract_node(Graph&graph, ShorterPathTest&shorter_path_test, unsigned node_being_contracted){
+	// OnShortcut has the signature
+	//   on_shortcut(unsigned tail, unsigned head, unsigned weight, unsigned hop_length)
+	// It is called for every shortcut that must be inserted when node_being_contracted is removed.
+
+	template<class OnShortcut>
+	void forall_shortcuts_needed_to_contract_node(const Graph&graph, ShorterPathTest&shorter_path_test, unsigned node_being_contracted, const OnShortcut&on_shortcut){
 		for(unsigned in_arc = 0; in_arc < graph.in_deg(node_being_contracted); ++in_arc){
 			unsigned in_node = graph.in(node_being_contracted, in_arc).node;
 			shorter_path_test.pin_source(in_node, node_being_contracted);
@@ -576,8 +781,8 @@ namespace{
 							graph.in(node_being_contracted, in_arc).weight + graph.out(node_being_contracted, out_arc).weight
 						)
 					){
-						graph.add_arc_or_reduce_arc_weight(
-							in_node, node_being_contracted, out_node,
+						on_shortcut(
+							in_node, out_node,
 							graph.in(node_being_contracted, in_arc).weight     + graph.out(node_being_contracted, out_arc).weight,
 							graph.in(node_being_contracted, in_arc).hop_length + graph.out(node_being_contracted, out_arc).hop_length
 						);
@@ -585,6 +790,15 @@ namespace{
 				}
 			}
 		}
+	}
+
+	void contract_node(Graph&graph, ShorterPathTest&shorter_path_test, unsigned node_being_contracted){
+		forall_shortcuts_needed_to_contract_node(
+			graph, shorter_path_test, node_being_contracted,
+			[&](unsigned tail, unsigned head, unsigned weight, unsigned hop_length){
+				graph.add_arc_or_reduce_arc_weight(tail, node_being_contracted, head, weight, hop_length);
+			}
+		);
 
 		graph.remove_all_incident_arcs(node_being_contracted);
 
@@ -605,6 +819,50 @@ namespace {
 		Side forward, backward;
 	};
 
+	void add_arcs_of_node_to_ch(
+		const Graph&graph,
+		ContractionHierarchy&ch,
+		ContractionHierarchyExtraInfo&ch_extra,
+		unsigned node_being_contracted
+	){
+		for(unsigned out_arc = 0; out_arc < graph.out_deg(node_being_contracted); ++out_arc){
+			ch_extra.forward.tail.push_back(node_being_contracted);
+
+			const auto&a = graph.out(node_being_contracted, out_arc);
+			if(ch.forward.head.size() == invalid_id)
+				throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
+			ch.forward.head.push_back(a.node);
+			ch.forward.weight.push_back(a.weight);
+			ch_extra.forward.mid_node.push_back(a.mid_node);
+		}
+
+		for(unsigned in_arc = 0; in_arc < graph.in_deg(node_being_contracted); ++in_arc){
+			ch_extra.backward.tail.push_back(node_being_contracted);
+
+			const auto&a = graph.in(node_being_contracted, in_arc);
+			if(ch.backward.head.size() == invalid_id)
+				throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
+			ch.backward.head.push_back(a.node);
+			ch.backward.weight.push_back(a.weight);
+			ch_extra.backward.mid_node.push_back(a.mid_node);
+		}
+	}
+
+	void shrink_ch_arcs_to_fit(
+		ContractionHierarchy&ch,
+		ContractionHierarchyExtraInfo&ch_extra
+	){
+		ch.forward.head.shrink_to_fit();
+		ch.forward.weight.shrink_to_fit();
+		ch_extra.forward.mid_node.shrink_to_fit();
+		ch_extra.forward.tail.shrink_to_fit();
+
+		ch.backward.head.shrink_to_fit();
+		ch.backward.weight.shrink_to_fit();
+		ch_extra.backward.mid_node.shrink_to_fit();
+		ch_extra.backward.tail.shrink_to_fit();
+	}
+
 	void build_ch_and_order(
 		Graph&graph,
 		ContractionHierarchy&ch,
@@ -679,28 +937,7 @@ namespace {
 			}
 
 			// Add the arcs to the search graph
-
-			for(unsigned out_arc = 0; out_arc < graph.out_deg(node_being_contracted); ++out_arc){
-				ch_extra.forward.tail.push_back(node_being_contracted);
-
-				const auto&a = graph.out(node_being_contracted, out_arc);
-				if(ch.forward.head.size() == invalid_id)
-					throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
-				ch.forward.head.push_back(a.node);
-				ch.forward.weight.push_back(a.weight);
-				ch_extra.forward.mid_node.push_back(a.mid_node);
-			}
-
-			for(unsigned in_arc = 0; in_arc < graph.in_deg(node_being_contracted); ++in_arc){
-				ch_extra.backward.tail.push_back(node_being_contracted);
-
-				const auto&a = graph.in(node_being_contracted, in_arc);
-				if(ch.backward.head.size() == invalid_id)
-					throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
-				ch.backward.head.push_back(a.node);
-				ch.backward.weight.push_back(a.weight);
-				ch_extra.backward.mid_node.push_back(a.mid_node);
-			}
+			add_arcs_of_node_to_ch(graph, ch, ch_extra, node_being_contracted);
 
 			unsigned neighbor_level = graph.level(node_being_contracted)+1;
 			unsigned out_deg = graph.out_deg(node_being_contracted);
@@ -733,15 +970,7 @@ namespace {
 			}
 		}
 
-		ch.forward.head.shrink_to_fit();
-		ch.forward.weight.shrink_to_fit();
-		ch_extra.forward.mid_node.shrink_to_fit();
-		ch_extra.forward.tail.shrink_to_fit();
-
-		ch.backward.head.shrink_to_fit();
-		ch.backward.weight.shrink_to_fit();
-		ch_extra.backward.mid_node.shrink_to_fit();
-		ch_extra.backward.tail.shrink_to_fit();
+		shrink_ch_arcs_to_fit(ch, ch_extra);
 
 		if(log_message){
 			timer += get_micro_time();
@@ -751,6 +980,330 @@ namespace {
 	}
 
 
+	unsigned get_thread_id(){
+		#ifdef _OPENMP
+		return omp_get_thread_num();
+		#else
+		return 0;
+		#endif
+	}
+
+	// Breaks ties between nodes of equal importance. Using the node IDs directly results in
+	// very small independent sets if the IDs are spatially correlated, as is the case for most
+	// road graphs.
+	unsigned tie_break_hash(unsigned x){
+		x ^= x >> 16;
+		x *= 0x45d9f3bu;
+		x ^= x >> 16;
+		x *= 0x45d9f3bu;
+		x ^= x >> 16;
+		return x;
+	}
+
+	// Tests whether x is less than every node within two hops with respect to is_less.
+	template<class IsLess>
+	bool is_less_than_all_nodes_within_two_hops(const Graph&graph, unsigned x, const IsLess&is_less){
+		auto is_less_than_neighbor_and_its_neighbors = [&](unsigned y){
+			if(is_less(y, x))
+				return false;
+			for(unsigned out_arc = 0; out_arc < graph.out_deg(y); ++out_arc){
+				unsigned z = graph.out(y, out_arc).node;
+				if(z != x && is_less(z, x))
+					return false;
+			}
+			for(unsigned in_arc = 0; in_arc < graph.in_deg(y); ++in_arc){
+				unsigned z = graph.in(y, in_arc).node;
+				if(z != x && is_less(z, x))
+					return false;
+			}
+			return true;
+		};
+
+		for(unsigned out_arc = 0; out_arc < graph.out_deg(x); ++out_arc)
+			if(!is_less_than_neighbor_and_its_neighbors(graph.out(x, out_arc).node))
+				return false;
+		for(unsigned in_arc = 0; in_arc < graph.in_deg(x); ++in_arc)
+			if(!is_less_than_neighbor_and_its_neighbors(graph.in(x, in_arc).node))
+				return false;
+		return true;
+	}
+
+	// Moves all nodes from remaining_node_list to independent_set that are less than every
+	// node within two hops. The selected nodes are therefore not adjacent and do not share
+	// neighbors. They are flagged in is_in_independent_set and sorted with respect to is_less.
+	template<class IsLess>
+	void extract_independent_node_set(
+		const Graph&graph,
+		std::vector<unsigned>&remaining_node_list,
+		std::vector<char>&is_in_independent_set,
+		std::vector<unsigned>&independent_set,
+		const IsLess&is_less,
+		unsigned thread_count
+	){
+		const unsigned remaining_node_count = remaining_node_list.size();
+
+		#ifdef _OPENMP
+		#pragma omp parallel for num_threads(thread_count) schedule(dynamic, 1024)
+		#endif
+		for(unsigned i=0; i<remaining_node_count; ++i){
+			unsigned x = remaining_node_list[i];
+			is_in_independent_set[x] = is_less_than_all_nodes_within_two_hops(graph, x, is_less);
+		}
+
+		independent_set.clear();
+		unsigned out = 0;
+		for(unsigned i=0; i<remaining_node_count; ++i){
+			unsigned x = remaining_node_list[i];
+			if(is_in_independent_set[x])
+				independent_set.push_back(x);
+			else
+				remaining_node_list[out++] = x;
+		}
+		remaining_node_list.erase(remaining_node_list.begin()+out, remaining_node_list.end());
+
+		// The least node always is selected
+		assert(!independent_set.empty());
+
+		std::sort(independent_set.begin(), independent_set.end(), is_less);
+	}
+
+	// Contracts the nodes of an independent set as computed by extract_independent_node_set.
+	// The witness searches run in parallel on the unmodified graph and ignore all nodes of
+	// the set. Afterwards, the shortcuts are inserted in parallel. This does not need any
+	// locking because the neighborhoods of the nodes are disjoint.
+	class IndependentNodeSetContractor{
+	public:
+		IndependentNodeSetContractor(Graph&graph, unsigned max_pop_count, unsigned thread_count):
+			graph(graph),
+			thread_count(thread_count),
+			shorter_path_test(thread_count, ShorterPathTest(graph, max_pop_count)),
+			shortcuts_of_thread(thread_count),
+			added_out_arc_count(graph.node_count(), 0),
+			added_in_arc_count(graph.node_count(), 0){}
+
+		ShorterPathTest&get_shorter_path_test(unsigned thread_id){
+			return shorter_path_test[thread_id];
+		}
+
+		void contract(const std::vector<unsigned>&independent_set, const std::vector<char>&is_in_independent_set){
+			const unsigned independent_set_size = independent_set.size();
+
+			shortcut_thread.resize(independent_set_size);
+			shortcut_begin.resize(independent_set_size);
+			shortcut_end.resize(independent_set_size);
+			for(auto&s:shortcuts_of_thread)
+				s.clear();
+
+			#ifdef _OPENMP
+			#pragma omp parallel num_threads(thread_count)
+			#endif
+			{
+				unsigned thread_id = get_thread_id();
+				std::vector<Shortcut>&shortcuts = shortcuts_of_thread[thread_id];
+				shorter_path_test[thread_id].set_bypass_node_set(&is_in_independent_set);
+
+				#ifdef _OPENMP
+				#pragma omp for schedule(dynamic, 16)
+				#endif
+				for(unsigned i=0; i<independent_set_size; ++i){
+					shortcut_thread[i] = thread_id;
+					shortcut_begin[i] = shortcuts.size();
+					forall_shortcuts_needed_to_contract_node(
+						graph, shorter_path_test[thread_id], independent_set[i],
+						[&](unsigned tail, unsigned head, unsigned weight, unsigned hop_length){
+							shortcuts.push_back({tail, head, weight, hop_length});
+						}
+					);
+					shortcut_end[i] = shortcuts.size();
+				}
+
+				shorter_path_test[thread_id].set_bypass_node_set(nullptr);
+			}
+
+			// Inserting arcs in parallel is only possible if the graph does not need to allocate
+			// memory. We therefore reserve space for every shortcut up front.
+			for(unsigned i=0; i<independent_set_size; ++i){
+				const std::vector<Shortcut>&shortcuts = shortcuts_of_thread[shortcut_thread[i]];
+				for(unsigned j=shortcut_begin[i]; j<shortcut_end[i]; ++j){
+					++added_out_arc_count[shortcuts[j].tail];
+					++added_in_arc_count[shortcuts[j].head];
+				}
+			}
+			for(unsigned i=0; i<independent_set_size; ++i){
+				const std::vector<Shortcut>&shortcuts = shortcuts_of_thread[shortcut_thread[i]];
+				for(unsigned j=shortcut_begin[i]; j<shortcut_end[i]; ++j){
+					unsigned x = shortcuts[j].tail, y = shortcuts[j].head;
+					if(added_out_arc_count[x] != 0){
+						graph.reserve_out_arcs(x, graph.out_deg(x) + added_out_arc_count[x]);
+						added_out_arc_count[x] = 0;
+					}
+					if(added_in_arc_count[y] != 0){
+						graph.reserve_in_arcs(y, graph.in_deg(y) + added_in_arc_count[y]);
+						added_in_arc_count[y] = 0;
+					}
+				}
+			}
+
+			#ifdef _OPENMP
+			#pragma omp parallel for num_threads(thread_count) schedule(dynamic, 16)
+			#endif
+			for(unsigned i=0; i<independent_set_size; ++i){
+				unsigned node_being_contracted = independent_set[i];
+				const std::vector<Shortcut>&shortcuts = shortcuts_of_thread[shortcut_thread[i]];
+				for(unsigned j=shortcut_begin[i]; j<shortcut_end[i]; ++j)
+					graph.add_arc_or_reduce_arc_weight(shortcuts[j].tail, node_being_contracted, shortcuts[j].head, shortcuts[j].weight, shortcuts[j].hop_length);
+				graph.remove_all_incident_arcs(node_being_contracted);
+			}
+		}
+
+	private:
+		struct Shortcut{
+			unsigned tail;
+			unsigned head;
+			unsigned weight;
+			unsigned hop_length;
+		};
+
+		Graph&graph;
+		unsigned thread_count;
+		std::vector<ShorterPathTest>shorter_path_test;
+		std::vector<std::vector<Shortcut>>shortcuts_of_thread;
+		std::vector<unsigned>shortcut_thread, shortcut_begin, shortcut_end;
+		std::vector<unsigned>added_out_arc_count, added_in_arc_count;
+	};
+
+	// Contracts the nodes in rounds. In every round, all nodes are selected that are less
+	// important than every node within two hops. These are contracted in parallel.
+	void build_ch_and_order_in_parallel(
+		Graph&graph,
+		ContractionHierarchy&ch,
+		ContractionHierarchyExtraInfo&ch_extra,
+		unsigned max_pop_count,
+		unsigned thread_count,
+		const std::function<void(std::string)>&log_message
+	){
+		long long timer = 0;  // initialize to avoid warning, not needed
+		long long last_log_message_time = 0;  // initialize to avoid warning, not needed
+		if(log_message){
+			last_log_message_time = get_micro_time();
+			timer = -last_log_message_time;
+			log_message("Start estimating node importance using "+std::to_string(thread_count)+" threads.");
+		}
+
+		const unsigned node_count = graph.node_count();
+
+		IndependentNodeSetContractor contractor(graph, max_pop_count, thread_count);
+
+		ch.rank.resize(node_count);
+		ch.order.resize(node_count);
+
+		std::vector<unsigned>importance(node_count);
+
+		#ifdef _OPENMP
+		#pragma omp parallel for num_threads(thread_count) schedule(dynamic, 1024)
+		#endif
+		for(unsigned x=0; x<node_count; ++x)
+			importance[x] = estimate_node_importance(graph, contractor.get_shorter_path_test(get_thread_id()), x);
+
+		if(log_message){
+			timer += get_micro_time();
+			log_message("Finished estimating node importance. Needed "+std::to_string(timer)+"musec time.");
+			log_message("Start contracting nodes.");
+			timer = -get_micro_time();
+		}
+
+		auto is_less_important = [&](unsigned x, unsigned y){
+			if(importance[x] != importance[y])
+				return importance[x] < importance[y];
+			unsigned x_hash = tie_break_hash(x), y_hash = tie_break_hash(y);
+			if(x_hash != y_hash)
+				return x_hash < y_hash;
+			return x < y;
+		};
+
+		std::vector<unsigned>remaining_node_list = identity_permutation(node_count);
+
+		std::vector<char>is_in_independent_set(node_count, false);
+		std::vector<unsigned>independent_set;
+
+		std::vector<unsigned>neighbor_list;
+		std::vector<bool>is_neighbor(node_count, false);
+
+		unsigned contracted_node_count = 0;
+		unsigned round_count = 0;
+
+		while(contracted_node_count != node_count){
+			extract_independent_node_set(graph, remaining_node_list, is_in_independent_set, independent_set, is_less_important, thread_count);
+
+			const unsigned independent_set_size = independent_set.size();
+
+			unsigned max_in_deg = 0, max_out_deg = 0;
+
+			for(unsigned i=0; i<independent_set_size; ++i){
+				unsigned node_being_contracted = independent_set[i];
+
+				ch.rank[node_being_contracted] = contracted_node_count + i;
+				ch.order[contracted_node_count + i] = node_being_contracted;
+
+				add_arcs_of_node_to_ch(graph, ch, ch_extra, node_being_contracted);
+
+				max_in_deg = std::max(max_in_deg, graph.in_deg(node_being_contracted));
+				max_out_deg = std::max(max_out_deg, graph.out_deg(node_being_contracted));
+
+				unsigned neighbor_level = graph.level(node_being_contracted)+1;
+
+				auto on_neighbor = [&](unsigned x){
+					assert(!is_in_independent_set[x]);
+					if(!is_neighbor[x]){
+						neighbor_list.push_back(x);
+						is_neighbor[x] = true;
+						graph.raise_level(x, neighbor_level);
+					}
+				};
+
+				for(unsigned in_arc = 0; in_arc < graph.in_deg(node_being_contracted); ++in_arc)
+					on_neighbor(graph.in(node_being_contracted, in_arc).node);
+				for(unsigned out_arc = 0; out_arc < graph.out_deg(node_being_contracted); ++out_arc)
+					on_neighbor(graph.out(node_being_contracted, out_arc).node);
+			}
+
+			contractor.contract(independent_set, is_in_independent_set);
+
+			for(auto x:independent_set)
+				is_in_independent_set[x] = false;
+
+			const unsigned neighbor_count = neighbor_list.size();
+
+			#ifdef _OPENMP
+			#pragma omp parallel for num_threads(thread_count) schedule(dynamic, 64)
+			#endif
+			for(unsigned i=0; i<neighbor_count; ++i)
+				importance[neighbor_list[i]] = estimate_node_importance(graph, contractor.get_shorter_path_test(get_thread_id()), neighbor_list[i]);
+
+			for(auto x:neighbor_list)
+				is_neighbor[x] = false;
+			neighbor_list.clear();
+
+			contracted_node_count += independent_set_size;
+			++round_count;
+
+			if(log_message){
+				long long current_time = get_micro_time();
+				if(current_time - last_log_message_time > 1000000){
+					last_log_message_time = current_time;
+					log_message("Contracted "+std::to_string(contracted_node_count) + " of " + std::to_string(node_count) + " in "+std::to_string(round_count)+" rounds. The last round contracted "+std::to_string(independent_set_size)+" nodes with a maximum in degree of " + std::to_string(max_in_deg)+ " and a maximum out degree of " + std::to_string(max_out_deg)+". Running for "+std::to_string(timer+current_time)+"musec.");
+				}
+			}
+		}
+
+		shrink_ch_arcs_to_fit(ch, ch_extra);
+
+		if(log_message){
+			timer += get_micro_time();
+			log_message("Finished contracting nodes in "+std::to_string(round_count)+" rounds. Needed "+std::to_string(timer)+"musec.");
+		}
+	}
+
 	void build_ch_given_rank(
 		Graph&graph,
 		ContractionHierarchy&ch,
@@ -777,27 +1330,7 @@ namespace {
 		for(unsigned i=0; i < node_count; ++i){
 			unsigned node_being_contracted = ch.order[i];
 
-			for(unsigned out_arc = 0; out_arc < graph.out_deg(node_being_contracted); ++out_arc){
-				ch_extra.forward.tail.push_back(node_being_contracted);
-
-				const auto&a = graph.out(node_being_contracted, out_arc);
-				if(ch.forward.head.size() == invalid_id)
-					throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
-				ch.forward.head.push_back(a.node);
-				ch.forward.weight.push_back(a.weight);
-				ch_extra.forward.mid_node.push_back(a.mid_node);
-			}
-
-			for(unsigned in_arc = 0; in_arc < graph.in_deg(node_being_contracted); ++in_arc){
-				ch_extra.backward.tail.push_back(node_being_contracted);
-
-				const auto&a = graph.in(node_being_contracted, in_arc);
-				if(ch.backward.head.size() == invalid_id)
-					throw std::runtime_error("CH may contain at most 2^32-1 shortcuts per direction");
-				ch.backward.head.push_back(a.node);
-				ch.backward.weight.push_back(a.weight);
-				ch_extra.backward.mid_node.push_back(a.mid_node);
-			}
+			add_arcs_of_node_to_ch(graph, ch, ch_extra, node_being_contracted);
 
 			unsigned out_deg = graph.out_deg(node_being_contracted);
 			unsigned in_deg = graph.in_deg(node_being_contracted);
@@ -813,15 +1346,7 @@ namespace {
 			}
 		}
 
-		ch.forward.head.shrink_to_fit();
-		ch.forward.weight.shrink_to_fit();
-		ch_extra.forward.mid_node.shrink_to_fit();
-		ch_extra.forward.tail.shrink_to_fit();
-
-		ch.backward.head.shrink_to_fit();
-		ch.backward.weight.shrink_to_fit();
-		ch_extra.backward.mid_node.shrink_to_fit();
-		ch_extra.backward.tail.shrink_to_fit();
+		shrink_ch_arcs_to_fit(ch, ch_extra);
 
 		if(log_message){
 			timer += get_micro_time();
@@ -829,6 +1354,107 @@ namespace {
 		}
 	}
 
+	// Contracts the nodes in rounds. A node is eligible for contraction if its rank is smaller
+	// than the ranks of all its remaining neighbors. The shortcuts created by such a node only
+	// connect nodes of higher rank. In every round, all eligible nodes are selected that have
+	// a smaller rank than every eligible node within two hops. These are contracted in parallel.
+	void build_ch_given_rank_in_parallel(
+		Graph&graph,
+		ContractionHierarchy&ch,
+		ContractionHierarchyExtraInfo&ch_extra,
+		const std::vector<unsigned>&rank,
+		unsigned max_pop_count,
+		unsigned thread_count,
+		const std::function<void(std::string)>&log_message
+	){
+		unsigned node_count = graph.node_count();
+
+		long long timer = 0;  // initialize to avoid warning, not needed
+		long long last_log_message_time = 0;  // initialize to avoid warning, not needed
+		if(log_message){
+			last_log_message_time = get_micro_time();
+			timer = -last_log_message_time;
+			log_message("Start building contraction hierarchy with given rank using "+std::to_string(thread_count)+" threads.");
+		}
+
+		IndependentNodeSetContractor contractor(graph, max_pop_count, thread_count);
+		ch.rank = rank;
+
+		ch.order = invert_permutation(rank);
+
+		std::vector<char>is_eligible(node_count);
+
+		// Eligible nodes come first. Nodes that are not eligible are never selected as they
+		// have a neighbor of smaller rank.
+		auto is_contracted_earlier = [&](unsigned x, unsigned y){
+			if(is_eligible[x] != is_eligible[y])
+				return is_eligible[x] > is_eligible[y];
+			return rank[x] < rank[y];
+		};
+
+		std::vector<unsigned>remaining_node_list = ch.order;
+
+		std::vector<char>is_in_independent_set(node_count, false);
+		std::vector<unsigned>independent_set;
+
+		unsigned contracted_node_count = 0;
+		unsigned round_count = 0;
+
+		while(contracted_node_count != node_count){
+			const unsigned remaining_node_count = remaining_node_list.size();
+
+			#ifdef _OPENMP
+			#pragma omp parallel for num_threads(thread_count) schedule(dynamic, 1024)
+			#endif
+			for(unsigned i=0; i<remaining_node_count; ++i){
+				unsigned x = remaining_node_list[i];
+				bool has_neighbor_of_smaller_rank = false;
+				for(unsigned out_arc = 0; out_arc < graph.out_deg(x); ++out_arc)
+					if(rank[graph.out(x, out_arc).node] < rank[x])
+						has_neighbor_of_smaller_rank = true;
+				for(unsigned in_arc = 0; in_arc < graph.in_deg(x); ++in_arc)
+					if(rank[graph.in(x, in_arc).node] < rank[x])
+						has_neighbor_of_smaller_rank = true;
+				is_eligible[x] = !has_neighbor_of_smaller_rank;
+			}
+
+			extract_independent_node_set(graph, remaining_node_list, is_in_independent_set, independent_set, is_contracted_earlier, thread_count);
+
+			const unsigned independent_set_size = independent_set.size();
+
+			unsigned max_in_deg = 0, max_out_deg = 0;
+
+			for(auto node_being_contracted:independent_set){
+				add_arcs_of_node_to_ch(graph, ch, ch_extra, node_being_contracted);
+				max_in_deg = std::max(max_in_deg, graph.in_deg(node_being_contracted));
+				max_out_deg = std::max(max_out_deg, graph.out_deg(node_being_contracted));
+			}
+
+			contractor.contract(independent_set, is_in_independent_set);
+
+			for(auto x:independent_set)
+				is_in_independent_set[x] = false;
+
+			contracted_node_count += independent_set_size;
+			++round_count;
+
+			if(log_message){
+				long long current_time = get_micro_time();
+				if(current_time - last_log_message_time > 1000000){
+					last_log_message_time = current_time;
+					log_message("Contracted "+std::to_string(contracted_node_count) + " of " + std::to_string(node_count) + " in "+std::to_string(round_count)+" rounds. The last round contracted "+std::to_string(independent_set_size)+" nodes with a maximum in degree of " + std::to_string(max_in_deg)+ " and a maximum out degree of " + std::to_string(max_out_deg)+". Running for "+std::to_string(timer+current_time)+"musec.");
+				}
+			}
+		}
+
+		shrink_ch_arcs_to_fit(ch, ch_extra);
+
+		if(log_message){
+			timer += get_micro_time();
+			log_message("Finished contracting nodes in "+std::to_string(round_count)+" rounds. Needed "+std::to_string(timer)+"musec.");
+		}
+	}
+
 
 	void make_internal_nodes_and_rank_coincide(
 		ContractionHierarchy&ch,
@@ -1092,8 +1718,9 @@ namespace {
 
 ContractionHierarchy ContractionHierarchy::build(
 	unsigned node_count, std::vector<unsigned>tail, std::vector<unsigned>head, std::vector<unsigned>weight,
-	const std::function<void(std::string)>&log_message, unsigned max_pop_count
+	const std::function<void(std::string)>&log_message, unsigned max_pop_count, unsigned thread_count
 ){
+	assert(thread_count != 0);
 	assert(tail.size() == head.size());
 	assert(tail.size() == weight.size());
 	assert(max_element_of(tail) < node_count);
@@ -1113,7 +1740,11 @@ ContractionHierarchy ContractionHierarchy::build(
 
 	{
 		Graph graph(node_count, tail, head, weight);
-		build_ch_and_order(graph, ch, ch_extra, max_pop_count, log_message);
+		if(thread_count <= 1)
+			build_ch_and_order(graph, ch, ch_extra, max_pop_count, log_message);
+		else
+			build_ch_and_order_in_parallel(graph, ch, ch_extra, max_pop_count, thread_count, log_message);
+		graph.log_memory_statistics(log_message);
 	}
 
 	{
@@ -1137,10 +1768,11 @@ ContractionHierarchy ContractionHierarchy::build(
 ContractionHierarchy ContractionHierarchy::build_given_rank(
 	std::vector<unsigned>rank,
 	std::vector<unsigned>tail, std::vector<unsigned>head, std::vector<unsigned>weight,
-	const std::function<void(std::string)>&log_message, unsigned max_pop_count
+	const std::function<void(std::string)>&log_message, unsigned max_pop_count, unsigned thread_count
 ){
 	unsigned node_count = rank.size();
 
+	assert(thread_count != 0);
 	assert(tail.size() == head.size());
 	assert(tail.size() == weight.size());
 	assert(max_element_of(tail) < node_count);
@@ -1163,7 +1795,11 @@ ContractionHierarchy ContractionHierarchy::build_given_rank(
 
 	{
 		Graph graph(node_count, tail, head, weight);
-		build_ch_given_rank(graph, ch, ch_extra, rank, max_pop_count, log_message);
+		if(thread_count <= 1)
+			build_ch_given_rank(graph, ch, ch_extra, rank, max_pop_count, log_message);
+		else
+			build_ch_given_rank_in_parallel(graph, ch, ch_extra, rank, max_pop_count, thread_count, log_message);
+		graph.log_memory_statistics(log_message);
 	}
 
 	{
@@ -1181,9 +1817,9 @@ ContractionHierarchy ContractionHierarchy::build_given_rank(
 ContractionHierarchy ContractionHierarchy::build_given_order(
 	std::vector<unsigned>order,
 	std::vector<unsigned>tail, std::vector<unsigned>head, std::vector<unsigned>weight,
-	const std::function<void(std::string)>&log_message, unsigned max_pop_count
+	const std::function<void(std::string)>&log_message, unsigned max_pop_count, unsigned thread_count
 ){
-	return build_given_rank(invert_permutation(order), tail, head, weight, log_message, max_pop_count);
+	return build_given_rank(invert_permutation(order), tail, head, weight, log_message, max_pop_count, thread_count);
 }
 
 void check_contraction_hierarchy_for_errors(const ContractionHierarchy&ch){
@@ -1423,19 +2059,218 @@ void ContractionHierarchy::write(std::function<void(const char*, unsigned long l
 	write_vector(out, backward.shortcut_second_arc);
 }
 
-ContractionHierarchyQuery::ContractionHierarchyQuery(const ContractionHierarchy&ch):
-	ch(&ch),
+namespace{
+	const unsigned long long ch_mappable_magic_number = 0x4d61704348696572ull;
+	const unsigned ch_mappable_file_version = 1;
+
+	// Every array starts at a multiple of this. This is the page size on all common platforms.
+	const unsigned long long ch_mappable_alignment = 4096;
+
+	enum CHMappableSection{
+		rank_section,
+		order_section,
+		forward_first_out_section,
+		forward_head_section,
+		forward_weight_section,
+		forward_is_shortcut_an_original_arc_section,
+		forward_shortcut_first_arc_section,
+		forward_shortcut_second_arc_section,
+		backward_first_out_section,
+		backward_head_section,
+		backward_weight_section,
+		backward_is_shortcut_an_original_arc_section,
+		backward_shortcut_first_arc_section,
+		backward_shortcut_second_arc_section,
+		ch_mappable_section_count
+	};
+
+	struct CHMappableFileHeader{
+		unsigned long long magic_number;
+		unsigned version;
+		unsigned node_count;
+		unsigned forward_arc_count;
+		unsigned backward_arc_count;
+		unsigned long long file_size;
+		unsigned long long section_begin[ch_mappable_section_count];
+	};
+
+	unsigned long long get_bit_vector_byte_count(unsigned long long bit_count){
+		return ((bit_count+511)/512)*64;
+	}
+
+	unsigned long long get_section_byte_count(const CHMappableFileHeader&header, unsigned section){
+		switch(section){
+		case rank_section:
+		case order_section:
+			return sizeof(unsigned)*(unsigned long long)header.node_count;
+		case forward_first_out_section:
+		case backward_first_out_section:
+			return sizeof(unsigned)*((unsigned long long)header.node_count+1);
+		case forward_is_shortcut_an_original_arc_section:
+			return get_bit_vector_byte_count(header.forward_arc_count);
+		case backward_is_shortcut_an_original_arc_section:
+			return get_bit_vector_byte_count(header.backward_arc_count);
+		default:
+			if(section < backward_first_out_section)
+				return sizeof(unsigned)*(unsigned long long)header.forward_arc_count;
+			else
+				return sizeof(unsigned)*(unsigned long long)header.backward_arc_count;
+		}
+	}
+
+	unsigned long long round_up_to_alignment(unsigned long long x){
+		return (x + ch_mappable_alignment - 1) / ch_mappable_alignment * ch_mappable_alignment;
+	}
+
+	ContractionHierarchyView::Side make_side_view(const ContractionHierarchy::Side&side){
+		ContractionHierarchyView::Side view;
+		view.first_out = side.first_out;
+		view.head = side.head;
+		view.weight = side.weight;
+		view.is_shortcut_an_original_arc = side.is_shortcut_an_original_arc;
+		view.shortcut_first_arc = side.shortcut_first_arc;
+		view.shortcut_second_arc = side.shortcut_second_arc;
+		return view;
+	}
+}
+
+void ContractionHierarchy::write_mappable(std::function<void(const char*, unsigned long long)>out) const {
+	CHMappableFileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic_number = ch_mappable_magic_number;
+	header.version = ch_mappable_file_version;
+	header.node_count = node_count();
+	header.forward_arc_count = forward.head.size();
+	header.backward_arc_count = backward.head.size();
+
+	unsigned long long pos = round_up_to_alignment(sizeof(header));
+	for(unsigned i=0; i<ch_mappable_section_count; ++i){
+		header.section_begin[i] = pos;
+		pos = round_up_to_alignment(pos + get_section_byte_count(header, i));
+	}
+	header.file_size = pos;
+
+	const char*section_data[ch_mappable_section_count] = {
+		(const char*)rank.data(),
+		(const char*)order.data(),
+		(const char*)forward.first_out.data(),
+		(const char*)forward.head.data(),
+		(const char*)forward.weight.data(),
+		(const char*)forward.is_shortcut_an_original_arc.data(),
+		(const char*)forward.shortcut_first_arc.data(),
+		(const char*)forward.shortcut_second_arc.data(),
+		(const char*)backward.first_out.data(),
+		(const char*)backward.head.data(),
+		(const char*)backward.weight.data(),
+		(const char*)backward.is_shortcut_an_original_arc.data(),
+		(const char*)backward.shortcut_first_arc.data(),
+		(const char*)backward.shortcut_second_arc.data()
+	};
+
+	static const char zero_padding[ch_mappable_alignment] = {};
+
+	out((const char*)&header, sizeof(header));
+	pos = sizeof(header);
+	for(unsigned i=0; i<ch_mappable_section_count; ++i){
+		out(zero_padding, header.section_begin[i] - pos);
+		unsigned long long byte_count = get_section_byte_count(header, i);
+		out(section_data[i], byte_count);
+		pos = header.section_begin[i] + byte_count;
+	}
+	out(zero_padding, header.file_size - pos);
+}
+
+void ContractionHierarchy::save_mappable_file(const std::string&file_name) const {
+	open_file_for_saving(
+		file_name,
+		[&](std::ostream&out){
+			write_mappable(
+				[&](const char*p, unsigned long long l){
+					if(!out.write(p, l))
+						throw std::runtime_error("std::ostream::write failed while writing a contraction hierarchy");
+				}
+			);
+		}
+	);
+}
+
+ContractionHierarchyView::ContractionHierarchyView(const ContractionHierarchy&ch):
+	rank(ch.rank), order(ch.order),
+	forward(make_side_view(ch.forward)), backward(make_side_view(ch.backward)){}
+
+ContractionHierarchyView ContractionHierarchyView::map_file(const std::string&file_name){
+	auto file = RoutingKit::map_file(file_name);
+
+	if(file->size() < sizeof(CHMappableFileHeader))
+		throw std::runtime_error("Mappable CH file \""+file_name+"\" is too small to contain a header. This file is corrupt.");
+
+	CHMappableFileHeader header;
+	memcpy(&header, file->data(), sizeof(header));
+	if(header.magic_number != ch_mappable_magic_number)
+		throw std::runtime_error("Mappable CH file magic number broken. Is \""+file_name+"\" really a CH file written by save_mappable_file?");
+	if(header.version != ch_mappable_file_version)
+		throw std::runtime_error("Mappable CH file \""+file_name+"\" has version "+std::to_string(header.version)+" but only version "+std::to_string(ch_mappable_file_version)+" is supported.");
+	if(header.file_size != file->size())
+		throw std::runtime_error("Mappable CH file \""+file_name+"\" has a different size than specified in the header. This file is corrupt.");
+	for(unsigned i=0; i<ch_mappable_section_count; ++i)
+		if(header.section_begin[i] % ch_mappable_alignment != 0 || header.section_begin[i] + get_section_byte_count(header, i) > header.file_size)
+			throw std::runtime_error("Mappable CH file \""+file_name+"\" has an array that is misaligned or out of bounds. This file is corrupt.");
+
+	auto get_vector = [&](unsigned section){
+		return ConstVectorView<unsigned>((const unsigned*)(file->data() + header.section_begin[section]), get_section_byte_count(header, section)/sizeof(unsigned));
+	};
+
+	auto get_bit_vector = [&](unsigned section, unsigned bit_count){
+		return ConstBitVectorView((const uint64_t*)(file->data() + header.section_begin[section]), bit_count);
+	};
+
+	ContractionHierarchyView ch;
+	ch.rank = get_vector(rank_section);
+	ch.order = get_vector(order_section);
+
+	ch.forward.first_out = get_vector(forward_first_out_section);
+	ch.forward.head = get_vector(forward_head_section);
+	ch.forward.weight = get_vector(forward_weight_section);
+	ch.forward.is_shortcut_an_original_arc = get_bit_vector(forward_is_shortcut_an_original_arc_section, header.forward_arc_count);
+	ch.forward.shortcut_first_arc = get_vector(forward_shortcut_first_arc_section);
+	ch.forward.shortcut_second_arc = get_vector(forward_shortcut_second_arc_section);
+
+	ch.backward.first_out = get_vector(backward_first_out_section);
+	ch.backward.head = get_vector(backward_head_section);
+	ch.backward.weight = get_vector(backward_weight_section);
+	ch.backward.is_shortcut_an_original_arc = get_bit_vector(backward_is_shortcut_an_original_arc_section, header.backward_arc_count);
+	ch.backward.shortcut_first_arc = get_vector(backward_shortcut_first_arc_section);
+	ch.backward.shortcut_second_arc = get_vector(backward_shortcut_second_arc_section);
+
+	if(ch.forward.first_out[header.node_count] != header.forward_arc_count || ch.backward.first_out[header.node_count] != header.backward_arc_count)
+		throw std::runtime_error("Mappable CH file \""+file_name+"\" has inconsistent arc counts. This file is corrupt.");
+
+	ch.mapped_file = std::move(file);
+
+	return ch; // NVRO
+}
+
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>::BasicContractionHierarchyQuery(const ContractionHierarchy&ch):
+	BasicContractionHierarchyQuery(ContractionHierarchyView(ch)){}
+
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>::BasicContractionHierarchyQuery(ContractionHierarchyView ch):
+	ch(ch),
 	was_forward_pushed(ch.node_count()), was_backward_pushed(ch.node_count()),
 	forward_queue(ch.node_count()), backward_queue(ch.node_count()),
 	forward_tentative_distance(ch.node_count()), backward_tentative_distance(ch.node_count()),
 	forward_predecessor_node(ch.node_count()), backward_predecessor_node(ch.node_count()),
 	forward_predecessor_arc(ch.node_count()), backward_predecessor_arc(ch.node_count()),
 	shortest_path_meeting_node(invalid_id),
-	state(ContractionHierarchyQuery::InternalState::initialized)
+	stall_on_demand(true),
+	settled_node_count(0), stalled_node_count(0),
+	state(InternalState::initialized)
 
 {}
 
-ContractionHierarchyQuery&ContractionHierarchyQuery::reset(){
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::reset(){
 	assert(ch && "query object must have an attached CH");
 
 	was_forward_pushed.reset_all();
@@ -1445,26 +2280,41 @@ ContractionHierarchyQuery&ContractionHierarchyQuery::reset(){
 
 	shortest_path_meeting_node = invalid_id;
 
-	state = ContractionHierarchyQuery::InternalState::initialized;
+	state = InternalState::initialized;
 	return *this;
 }
 
-ContractionHierarchyQuery&ContractionHierarchyQuery::reset(const ContractionHierarchy&new_ch){
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::reset(const ContractionHierarchy&new_ch){
+	return reset(ContractionHierarchyView(new_ch));
+}
+
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::reset(ContractionHierarchyView new_ch){
 	if(forward_tentative_distance.size() == new_ch.node_count()){
 		reset();
-		ch = &new_ch;
+		ch = std::move(new_ch);
 	} else {
-		*this = ContractionHierarchyQuery(new_ch);
+		bool old_stall_on_demand = stall_on_demand;
+		*this = BasicContractionHierarchyQuery(new_ch);
+		stall_on_demand = old_stall_on_demand;
 	}
 	return *this;
 }
 
-ContractionHierarchyQuery&ContractionHierarchyQuery::add_source(unsigned external_s, unsigned dist_to_s){
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::set_stall_on_demand(bool enabled){
+	stall_on_demand = enabled;
+	return *this;
+}
+
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::add_source(unsigned external_s, unsigned dist_to_s){
 	assert(ch && "query object must have an attached CH");
-	assert(external_s < ch->node_count() && "node out of bounds");
-	assert(state == ContractionHierarchyQuery::InternalState::initialized || state == ContractionHierarchyQuery::InternalState::target_pinned);
+	assert(external_s < ch.node_count() && "node out of bounds");
+	assert(state == InternalState::initialized || state == InternalState::target_pinned);
 
-	unsigned s = ch->rank[external_s];
+	unsigned s = ch.rank[external_s];
 
 	if(!forward_queue.contains_id(s)){
 		forward_queue.push({s, dist_to_s});
@@ -1481,12 +2331,13 @@ ContractionHierarchyQuery&ContractionHierarchyQuery::add_source(unsigned externa
 	return *this;
 }
 
-ContractionHierarchyQuery&ContractionHierarchyQuery::add_target(unsigned external_t, unsigned dist_to_t){
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::add_target(unsigned external_t, unsigned dist_to_t){
 	assert(ch && "query object must have an attached CH");
-	assert(external_t < ch->node_count() && "node out of bounds");
-	assert(state == ContractionHierarchyQuery::InternalState::initialized || state == ContractionHierarchyQuery::InternalState::source_pinned);
+	assert(external_t < ch.node_count() && "node out of bounds");
+	assert(state == InternalState::initialized || state == InternalState::source_pinned);
 
-	unsigned t = ch->rank[external_t];
+	unsigned t = ch.rank[external_t];
 	if(!backward_queue.contains_id(t)){
 		backward_queue.push({t, dist_to_t});
 		backward_tentative_distance[t] = dist_to_t;
@@ -1504,61 +2355,18 @@ ContractionHierarchyQuery&ContractionHierarchyQuery::add_target(unsigned externa
 
 namespace{
 
-	template<class SetPred>
-	void forward_expand_upward_ch_arcs_of_node(
-		unsigned node,
-		unsigned distance_to_node,
-		const std::vector<unsigned>&forward_first_out,
-		const std::vector<unsigned>&forward_head,
-		const std::vector<unsigned>&forward_weight,
-		TimestampFlags&was_forward_pushed,
-		MinIDQueue&forward_queue,
-		std::vector<unsigned>&forward_tentative_distance,
-		const SetPred&set_predecessor
-	){
-		for(unsigned arc = forward_first_out[node]; arc < forward_first_out[node+1]; ++arc){
-			unsigned h = forward_head[arc], d = distance_to_node + forward_weight[arc];
-			if(was_forward_pushed.is_set(h)){
-				if(d < forward_tentative_distance[h]){
-					forward_queue.decrease_key({h, d});
-					forward_tentative_distance[h] = d;
-					set_predecessor(h, node, arc);
-				}
-			} else if(d < inf_weight){
-				forward_queue.push({h, d});
-				forward_tentative_distance[h] = d;
-				was_forward_pushed.set(h);
-				set_predecessor(h, node, arc);
-			}
-		}
-	}
-
-	bool forward_can_stall_at_node(
-		unsigned node,
-		const std::vector<unsigned>&backward_first_out, const std::vector<unsigned>&backward_head, const std::vector<unsigned>&backward_weight,
-		const TimestampFlags&was_forward_pushed,
-		std::vector<unsigned>&forward_tentative_distance, const std::vector<unsigned>&backward_tentative_distance
-	){
-		for(unsigned arc = backward_first_out[node]; arc < backward_first_out[node+1]; ++arc){
-			unsigned x = backward_head[arc];
-			if(was_forward_pushed.is_set(x)){
-				if(forward_tentative_distance[x] + backward_weight[arc] <= forward_tentative_distance[node])
-					return true;
-			}
-		}
-		return false;
-	}
-
-
+	template<class Queue>
 	void forward_settle_node(
 		unsigned&shortest_path_length,
 		unsigned&shortest_path_meeting_node,
-		const std::vector<unsigned>&forward_first_out, const std::vector<unsigned>&forward_head, const std::vector<unsigned>&forward_weight,
-		const std::vector<unsigned>&backward_first_out, const std::vector<unsigned>&backward_head, const std::vector<unsigned>&backward_weight,
+		ConstVectorView<unsigned>forward_first_out, ConstVectorView<unsigned>forward_head, ConstVectorView<unsigned>forward_weight,
+		ConstVectorView<unsigned>backward_first_out, ConstVectorView<unsigned>backward_head, ConstVectorView<unsigned>backward_weight,
 		TimestampFlags&was_forward_pushed, const TimestampFlags&was_backward_pushed,
-		MinIDQueue&forward_queue,
+		Queue&forward_queue,
 		std::vector<unsigned>&forward_tentative_distance, const std::vector<unsigned>&backward_tentative_distance,
-		std::vector<unsigned>&forward_predecessor_node, std::vector<unsigned>&forward_predecessor_arc
+		std::vector<unsigned>&forward_predecessor_node, std::vector<unsigned>&forward_predecessor_arc,
+		bool stall_on_demand,
+		unsigned&settled_node_count, unsigned&stalled_node_count
 	){
 
 
@@ -1566,6 +2374,8 @@ namespace{
 		auto popped_node = p.id;
 		auto distance_to_popped_node = p.key;
 
+		++settled_node_count;
+
 		if(was_backward_pushed.is_set(popped_node)){
 			if(shortest_path_length > distance_to_popped_node + backward_tentative_distance[popped_node]){
 				shortest_path_length = distance_to_popped_node + backward_tentative_distance[popped_node];
@@ -1574,13 +2384,16 @@ namespace{
 		}
 
 		if(
-			!forward_can_stall_at_node(
+			stall_on_demand &&
+			forward_can_stall_at_node(
 				popped_node,
 				backward_first_out, backward_head, backward_weight,
 				was_forward_pushed,
-				forward_tentative_distance, backward_tentative_distance
+				forward_tentative_distance
 			)
 		)
+			++stalled_node_count;
+		else
 			forward_expand_upward_ch_arcs_of_node(
 				popped_node, distance_to_popped_node,
 				forward_first_out, forward_head, forward_weight,
@@ -1593,18 +2406,39 @@ namespace{
 			);
 	}
 
+	// If stall_on_demand is set, the tentative distances of stalled nodes can be too large.
+	// The caller must correct them by relaxing the downward arcs. pinned_run does this.
+	template<class Queue>
 	void full_forward_search(
-		const std::vector<unsigned>&forward_first_out, const std::vector<unsigned>&forward_head, const std::vector<unsigned>&forward_weight,
+		ConstVectorView<unsigned>forward_first_out, ConstVectorView<unsigned>forward_head, ConstVectorView<unsigned>forward_weight,
+		ConstVectorView<unsigned>backward_first_out, ConstVectorView<unsigned>backward_head, ConstVectorView<unsigned>backward_weight,
 		TimestampFlags&was_forward_pushed,
-		MinIDQueue&forward_queue,
+		Queue&forward_queue,
 		std::vector<unsigned>&forward_tentative_distance,
-		std::vector<unsigned>&forward_predecessor_node, std::vector<unsigned>&forward_predecessor_arc
+		std::vector<unsigned>&forward_predecessor_node, std::vector<unsigned>&forward_predecessor_arc,
+		bool stall_on_demand,
+		unsigned&settled_node_count, unsigned&stalled_node_count
 	){
 		while(!forward_queue.empty()){
 			auto p = forward_queue.pop();
 			auto popped_node = p.id;
 			auto distance_to_popped_node = p.key;
 
+			++settled_node_count;
+
+			if(
+				stall_on_demand &&
+				forward_can_stall_at_node(
+					popped_node,
+					backward_first_out, backward_head, backward_weight,
+					was_forward_pushed,
+					forward_tentative_distance
+				)
+			){
+				++stalled_node_count;
+				continue;
+			}
+
 			forward_expand_upward_ch_arcs_of_node(
 				popped_node, distance_to_popped_node,
 				forward_first_out, forward_head, forward_weight,
@@ -1623,15 +2457,19 @@ namespace{
 
 }
 
-ContractionHierarchyQuery& ContractionHierarchyQuery::run(){
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::run(){
 	assert(ch && "query object must have an attached CH");
 	assert(!forward_queue.empty() && "must add at least one source before calling run");
 	assert(!backward_queue.empty() && "must add at least one target before calling run");
-	assert(state == ContractionHierarchyQuery::InternalState::initialized);
+	assert(state == InternalState::initialized);
 
 	unsigned shortest_path_length = inf_weight;
 	shortest_path_meeting_node = invalid_id;
 
+	settled_node_count = 0;
+	stalled_node_count = 0;
+
 	bool forward_next = true;
 
 	for(;;){
@@ -1658,35 +2496,40 @@ ContractionHierarchyQuery& ContractionHierarchyQuery::run(){
 		if(forward_next){
 			forward_settle_node(
 				shortest_path_length, shortest_path_meeting_node,
-				ch->forward.first_out, ch->forward.head, ch->forward.weight,
-				ch->backward.first_out, ch->backward.head, ch->backward.weight,
+				ch.forward.first_out, ch.forward.head, ch.forward.weight,
+				ch.backward.first_out, ch.backward.head, ch.backward.weight,
 				was_forward_pushed, was_backward_pushed,
 				forward_queue,
 				forward_tentative_distance, backward_tentative_distance,
-				forward_predecessor_node, forward_predecessor_arc
+				forward_predecessor_node, forward_predecessor_arc,
+				stall_on_demand,
+				settled_node_count, stalled_node_count
 			);
 			forward_next = false;
 		} else {
 			forward_settle_node(
 				shortest_path_length, shortest_path_meeting_node,
-				ch->backward.first_out, ch->backward.head, ch->backward.weight,
-				ch->forward.first_out, ch->forward.head, ch->forward.weight,
+				ch.backward.first_out, ch.backward.head, ch.backward.weight,
+				ch.forward.first_out, ch.forward.head, ch.forward.weight,
 				was_backward_pushed, was_forward_pushed,
 				backward_queue,
 				backward_tentative_distance, forward_tentative_distance,
-				backward_predecessor_node, backward_predecessor_arc
+				backward_predecessor_node, backward_predecessor_arc,
+				stall_on_demand,
+				settled_node_count, stalled_node_count
 			);
 			forward_next = true;
 		}
 	}
 
-	state = ContractionHierarchyQuery::InternalState::run;
+	state = InternalState::run;
 	return *this;
 }
 
-unsigned ContractionHierarchyQuery::get_used_source(){
+template<class Queue>
+unsigned BasicContractionHierarchyQuery<Queue>::get_used_source(){
 	assert(ch && "query object must have an attached CH");
-	assert(state == ContractionHierarchyQuery::InternalState::run);
+	assert(state == InternalState::run);
 
 	if(shortest_path_meeting_node == invalid_id)
 		return invalid_id;
@@ -1694,19 +2537,20 @@ unsigned ContractionHierarchyQuery::get_used_source(){
 	while(forward_predecessor_node[x] != invalid_id)
 		x = forward_predecessor_node[x];
 
-	return ch->order[x];
+	return ch.order[x];
 }
 
-unsigned ContractionHierarchyQuery::get_used_target(){
+template<class Queue>
+unsigned BasicContractionHierarchyQuery<Queue>::get_used_target(){
 	assert(ch && "query object must have an attached CH");
-	assert(state == ContractionHierarchyQuery::InternalState::run);
+	assert(state == InternalState::run);
 
 	if(shortest_path_meeting_node == invalid_id)
 		return invalid_id;
 	unsigned x = shortest_path_meeting_node;
 	while(backward_predecessor_node[x] != invalid_id)
 		x = backward_predecessor_node[x];
-	return ch->order[x];
+	return ch.order[x];
 }
 
 namespace{
@@ -1717,13 +2561,13 @@ namespace{
 	// The source node of the path must be obtained by some other mean
 
 	template<class OnNewInputArc>
-	void unpack_forward_arc(const ContractionHierarchy&ch, unsigned arc, const OnNewInputArc&on_new_input_arc);
+	void unpack_forward_arc(const ContractionHierarchyView&ch, unsigned arc, const OnNewInputArc&on_new_input_arc);
 
 	template<class OnNewInputArc>
-	void unpack_backward_arc(const ContractionHierarchy&ch, unsigned arc, const OnNewInputArc&on_new_input_arc);
+	void unpack_backward_arc(const ContractionHierarchyView&ch, unsigned arc, const OnNewInputArc&on_new_input_arc);
 
 	template<class OnNewInputArc>
-	void unpack_forward_arc(const ContractionHierarchy&ch, unsigned arc, const OnNewInputArc&on_new_input_arc){
+	void unpack_forward_arc(const ContractionHierarchyView&ch, unsigned arc, const OnNewInputArc&on_new_input_arc){
 		if(ch.forward.is_shortcut_an_original_arc.is_set(arc)){
 			on_new_input_arc(ch.forward.shortcut_first_arc[arc], ch.forward.shortcut_second_arc[arc]);
 		} else {
@@ -1735,7 +2579,7 @@ namespace{
 	}
 
 	template<class OnNewInputArc>
-	void unpack_backward_arc(const ContractionHierarchy&ch, unsigned arc, const OnNewInputArc&on_new_input_arc){
+	void unpack_backward_arc(const ContractionHierarchyView&ch, unsigned arc, const OnNewInputArc&on_new_input_arc){
 		if(ch.backward.is_shortcut_an_original_arc.is_set(arc)){
 			on_new_input_arc(ch.backward.shortcut_first_arc[arc], ch.backward.shortcut_second_arc[arc]);
 		} else {
@@ -1747,8 +2591,9 @@ namespace{
 	}
 }
 
-unsigned ContractionHierarchyQuery::get_distance() {
-	assert(state == ContractionHierarchyQuery::InternalState::run);
+template<class Queue>
+unsigned BasicContractionHierarchyQuery<Queue>::get_distance() {
+	assert(state == InternalState::run);
 
 	if(shortest_path_meeting_node == invalid_id)
 		return inf_weight;
@@ -1757,9 +2602,10 @@ unsigned ContractionHierarchyQuery::get_distance() {
 }
 
 
-std::vector<unsigned>ContractionHierarchyQuery::get_arc_path(){
+template<class Queue>
+std::vector<unsigned>BasicContractionHierarchyQuery<Queue>::get_arc_path(){
 	assert(ch && "query object must have an attached CH");
-	assert(state == ContractionHierarchyQuery::InternalState::run);
+	assert(state == InternalState::run);
 
 	std::vector<unsigned>path;
 	if(shortest_path_meeting_node != invalid_id)
@@ -1770,19 +2616,19 @@ std::vector<unsigned>ContractionHierarchyQuery::get_arc_path(){
 			while(forward_predecessor_node[x] != invalid_id){
 				assert(was_forward_pushed.is_set(x));
 				up_path.push_back(forward_predecessor_arc[x]);
-				//up_path.push_back(find_arc_given_sorted_head(ch->forward.first_out, ch->forward.head, forward_predecessor_node[x], x));
+				//up_path.push_back(find_arc_given_sorted_head(ch.forward.first_out, ch.forward.head, forward_predecessor_node[x], x));
 				x = forward_predecessor_node[x];
 			}
 		}
 		for(unsigned i=up_path.size(); i>0; --i){
-			unpack_forward_arc(*ch, up_path[i-1], [&](unsigned xy, unsigned y){path.push_back(xy);});
+			unpack_forward_arc(ch, up_path[i-1], [&](unsigned xy, unsigned y){path.push_back(xy);});
 		}
 		{
 			unsigned x = shortest_path_meeting_node;
 			while(backward_predecessor_node[x] != invalid_id){
 				assert(was_backward_pushed.is_set(x));
-				unpack_backward_arc(*ch, backward_predecessor_arc[x], [&](unsigned xy, unsigned y){path.push_back(xy);});
-				//unpack_backward_arc(*ch, find_arc_given_sorted_head(ch->backward.first_out, ch->backward.head, backward_predecessor_node[x], x), [&](unsigned xy, unsigned y){path.push_back(xy);});
+				unpack_backward_arc(ch, backward_predecessor_arc[x], [&](unsigned xy, unsigned y){path.push_back(xy);});
+				//unpack_backward_arc(ch, find_arc_given_sorted_head(ch.backward.first_out, ch.backward.head, backward_predecessor_node[x], x), [&](unsigned xy, unsigned y){path.push_back(xy);});
 				x = backward_predecessor_node[x];
 			}
 		}
@@ -1791,9 +2637,10 @@ std::vector<unsigned>ContractionHierarchyQuery::get_arc_path(){
 }
 
 
-std::vector<unsigned>ContractionHierarchyQuery::get_node_path(){
+template<class Queue>
+std::vector<unsigned>BasicContractionHierarchyQuery<Queue>::get_node_path(){
 	assert(ch && "query object must have an attached CH");
-	assert(state == ContractionHierarchyQuery::InternalState::run);
+	assert(state == InternalState::run);
 
 	std::vector<unsigned>path;
 	if(shortest_path_meeting_node != invalid_id)
@@ -1806,16 +2653,16 @@ std::vector<unsigned>ContractionHierarchyQuery::get_node_path(){
 				up_path.push_back(forward_predecessor_arc[x]);
 				x = forward_predecessor_node[x];
 			}
-			path.push_back(ch->order[x]);
+			path.push_back(ch.order[x]);
 		}
 		for(unsigned i=up_path.size(); i>0; --i){
-			unpack_forward_arc(*ch, up_path[i-1], [&](unsigned xy, unsigned y){path.push_back(y);});
+			unpack_forward_arc(ch, up_path[i-1], [&](unsigned xy, unsigned y){path.push_back(y);});
 		}
 		{
 			unsigned x = shortest_path_meeting_node;
 			while(backward_predecessor_node[x] != invalid_id){
 				assert(was_backward_pushed.is_set(x));
-				unpack_backward_arc(*ch, backward_predecessor_arc[x], [&](unsigned xy, unsigned y){path.push_back(y);});
+				unpack_backward_arc(ch, backward_predecessor_arc[x], [&](unsigned xy, unsigned y){path.push_back(y);});
 				x = backward_predecessor_node[x];
 			}
 		}
@@ -1823,25 +2670,27 @@ std::vector<unsigned>ContractionHierarchyQuery::get_node_path(){
 	return path; // NVRO
 }
 
-ContractionHierarchyQuery&ContractionHierarchyQuery::reset_source(){
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::reset_source(){
 	assert(ch && "query object must have an attached CH");
-	assert(state == ContractionHierarchyQuery::InternalState::target_pinned || state == ContractionHierarchyQuery::InternalState::target_run);
+	assert(state == InternalState::target_pinned || state == InternalState::target_run);
 
 	was_forward_pushed.reset_all();
 	forward_queue.clear();
 
-	state = ContractionHierarchyQuery::InternalState::target_pinned;
+	state = InternalState::target_pinned;
 	return *this;
 }
 
-ContractionHierarchyQuery&ContractionHierarchyQuery::reset_target(){
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::reset_target(){
 	assert(ch && "query object must have an attached CH");
-	assert(state == ContractionHierarchyQuery::InternalState::source_pinned || state == ContractionHierarchyQuery::InternalState::source_run);
+	assert(state == InternalState::source_pinned || state == InternalState::source_run);
 
 	was_backward_pushed.reset_all();
 	backward_queue.clear();
 
-	state = ContractionHierarchyQuery::InternalState::source_pinned;
+	state = InternalState::source_pinned;
 	return *this;
 }
 
@@ -1857,17 +2706,18 @@ namespace{
 	// The IDs are with repect to the CH and not with respect to the input.
 	// select_list is ordered decreasing by rank.
 
+	template<class Queue>
 	void pin(
 		const std::vector<unsigned>&external_target_list,
-		const std::vector<unsigned>&external_node_to_internal_node,
+		ConstVectorView<unsigned>external_node_to_internal_node,
 		std::vector<unsigned>&target_list,
 		unsigned&target_count,
 		std::vector<unsigned>&select_list,
 		unsigned&select_count,
-		MinIDQueue&q,
-		const std::vector<unsigned>&backward_first_out,
-		const std::vector<unsigned>&backward_head,
-		const std::vector<unsigned>&backward_weight
+		Queue&q,
+		ConstVectorView<unsigned>backward_first_out,
+		ConstVectorView<unsigned>backward_head,
+		ConstVectorView<unsigned>backward_weight
 	){
 		target_count = external_target_list.size();
 
@@ -1906,31 +2756,42 @@ namespace{
 	//  2) !has_forward_predecessor.is_set(x)
 	//
 
+	template<class Queue>
 	void pinned_run(
 		std::vector<unsigned>&select_list,
 		unsigned&select_count,
 
 		TimestampFlags&has_forward_predecessor,
-		MinIDQueue&forward_queue,
+		Queue&forward_queue,
 		std::vector<unsigned>&tentative_distance,
 
 		std::vector<unsigned>&forward_predecessor_node,
 		std::vector<unsigned>&predecessor_arc,
 
-		const std::vector<unsigned>&forward_first_out,
-		const std::vector<unsigned>&forward_head,
-		const std::vector<unsigned>&forward_weight,
+		ConstVectorView<unsigned>forward_first_out,
+		ConstVectorView<unsigned>forward_head,
+		ConstVectorView<unsigned>forward_weight,
+
+		ConstVectorView<unsigned>backward_first_out,
+		ConstVectorView<unsigned>backward_head,
+		ConstVectorView<unsigned>backward_weight,
 
-		const std::vector<unsigned>&backward_first_out,
-		const std::vector<unsigned>&backward_head,
-		const std::vector<unsigned>&backward_weight
+		bool stall_on_demand,
+		unsigned&settled_node_count,
+		unsigned&stalled_node_count
 	){
+		settled_node_count = 0;
+		stalled_node_count = 0;
+
 		full_forward_search(
 			forward_first_out, forward_head, forward_weight,
+			backward_first_out, backward_head, backward_weight,
 			has_forward_predecessor,
 			forward_queue,
 			tentative_distance,
-			forward_predecessor_node, predecessor_arc
+			forward_predecessor_node, predecessor_arc,
+			stall_on_demand,
+			settled_node_count, stalled_node_count
 		);
 
 		for(unsigned i=0; i<select_count; ++i){
@@ -1983,14 +2844,15 @@ namespace{
 	}
 }
 
-ContractionHierarchyQuery&ContractionHierarchyQuery::pin_targets(const std::vector<unsigned>&external_target_list){
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::pin_targets(const std::vector<unsigned>&external_target_list){
 	assert(ch && "query object must have an attached CH");
-	assert((external_target_list.empty() || max_element_of(external_target_list) < ch->node_count()) && "node id out of bounds");
-	assert(state == ContractionHierarchyQuery::InternalState::initialized);
+	assert((external_target_list.empty() || max_element_of(external_target_list) < ch.node_count()) && "node id out of bounds");
+	assert(state == InternalState::initialized);
 
 	pin(
 		external_target_list,
-		ch->rank,
+		ch.rank,
 
 		// the following 4 variables happen to be unused and of the
 		// required size -> use them to avoid allocating unnecessary
@@ -1999,43 +2861,45 @@ ContractionHierarchyQuery&ContractionHierarchyQuery::pin_targets(const std::vect
 
 		backward_queue,
 
-		ch->backward.first_out,
-		ch->backward.head,
-		ch->backward.weight
+		ch.backward.first_out,
+		ch.backward.head,
+		ch.backward.weight
 	);
 
-	state = ContractionHierarchyQuery::InternalState::target_pinned;
+	state = InternalState::target_pinned;
 	return *this;
 }
 
-ContractionHierarchyQuery& ContractionHierarchyQuery::pin_sources(const std::vector<unsigned>&external_source_list){
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::pin_sources(const std::vector<unsigned>&external_source_list){
 	assert(ch && "query object must have an attached CH");
-	assert((external_source_list.empty() || max_element_of(external_source_list) < ch->node_count()) && "node id out of bounds");
-	assert(state == ContractionHierarchyQuery::InternalState::initialized);
+	assert((external_source_list.empty() || max_element_of(external_source_list) < ch.node_count()) && "node id out of bounds");
+	assert(state == InternalState::initialized);
 
 	pin(
 		external_source_list,
-		ch->rank,
+		ch.rank,
 
 		forward_predecessor_node, many_to_many_source_or_target_count, forward_tentative_distance, shortest_path_meeting_node,
 
 		forward_queue,
-		ch->forward.first_out,
-		ch->forward.head,
-		ch->forward.weight
+		ch.forward.first_out,
+		ch.forward.head,
+		ch.forward.weight
 	);
 
-	state = ContractionHierarchyQuery::InternalState::source_pinned;
+	state = InternalState::source_pinned;
 	return *this;
 }
 
 
 
 
-ContractionHierarchyQuery& ContractionHierarchyQuery::run_to_pinned_targets(){
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::run_to_pinned_targets(){
 	assert(ch && "query object must have an attached CH");
 	assert(!forward_queue.empty() && "must add at least one source before calling run");
-	assert(state == ContractionHierarchyQuery::InternalState::target_pinned);
+	assert(state == InternalState::target_pinned);
 
 	pinned_run(
 		backward_tentative_distance, shortest_path_meeting_node,
@@ -2046,24 +2910,29 @@ ContractionHierarchyQuery& ContractionHierarchyQuery::run_to_pinned_targets(){
 
 		forward_predecessor_node, forward_predecessor_arc,
 
-		ch->forward.first_out,
-		ch->forward.head,
-		ch->forward.weight,
+		ch.forward.first_out,
+		ch.forward.head,
+		ch.forward.weight,
 
-		ch->backward.first_out,
-		ch->backward.head,
-		ch->backward.weight
+		ch.backward.first_out,
+		ch.backward.head,
+		ch.backward.weight,
+
+		stall_on_demand,
+		settled_node_count,
+		stalled_node_count
 	);
 
-	state = ContractionHierarchyQuery::InternalState::target_run;
+	state = InternalState::target_run;
 	return *this;
 }
 
 
-ContractionHierarchyQuery& ContractionHierarchyQuery::run_to_pinned_sources(){
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::run_to_pinned_sources(){
 	assert(ch && "query object must have an attached CH");
 	assert(!backward_queue.empty() && "must add at least one target before calling run");
-	assert(state == ContractionHierarchyQuery::InternalState::source_pinned);
+	assert(state == InternalState::source_pinned);
 
 	pinned_run(
 		forward_tentative_distance, shortest_path_meeting_node,
@@ -2074,39 +2943,47 @@ ContractionHierarchyQuery& ContractionHierarchyQuery::run_to_pinned_sources(){
 
 		backward_predecessor_node, backward_predecessor_arc,
 
-		ch->backward.first_out,
-		ch->backward.head,
-		ch->backward.weight,
+		ch.backward.first_out,
+		ch.backward.head,
+		ch.backward.weight,
+
+		ch.forward.first_out,
+		ch.forward.head,
+		ch.forward.weight,
 
-		ch->forward.first_out,
-		ch->forward.head,
-		ch->forward.weight
+		stall_on_demand,
+		settled_node_count,
+		stalled_node_count
 	);
-	state = ContractionHierarchyQuery::InternalState::source_run;
+	state = InternalState::source_run;
 	return *this;
 }
 
 
-ContractionHierarchyQuery& ContractionHierarchyQuery::get_distances_to_targets(unsigned*dist){
-	assert(state == ContractionHierarchyQuery::InternalState::target_run);
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::get_distances_to_targets(unsigned*dist){
+	assert(state == InternalState::target_run);
 	extract_distances_to_targets(backward_predecessor_node, many_to_many_source_or_target_count, forward_tentative_distance, dist);
 	return *this;
 }
 
-std::vector<unsigned> ContractionHierarchyQuery::get_distances_to_targets(){
-	assert(state == ContractionHierarchyQuery::InternalState::target_run);
+template<class Queue>
+std::vector<unsigned> BasicContractionHierarchyQuery<Queue>::get_distances_to_targets(){
+	assert(state == InternalState::target_run);
 	return extract_distances_to_targets(backward_predecessor_node, many_to_many_source_or_target_count, forward_tentative_distance);
 }
 
 
-ContractionHierarchyQuery& ContractionHierarchyQuery::get_distances_to_sources(unsigned*dist){
-	assert(state == ContractionHierarchyQuery::InternalState::source_run);
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::get_distances_to_sources(unsigned*dist){
+	assert(state == InternalState::source_run);
 	extract_distances_to_targets(forward_predecessor_node, many_to_many_source_or_target_count, backward_tentative_distance, dist);
 	return *this;
 }
 
-std::vector<unsigned> ContractionHierarchyQuery::get_distances_to_sources(){
-	assert(state == ContractionHierarchyQuery::InternalState::source_run);
+template<class Queue>
+std::vector<unsigned> BasicContractionHierarchyQuery<Queue>::get_distances_to_sources(){
+	assert(state == InternalState::source_run);
 	return extract_distances_to_targets(forward_predecessor_node, many_to_many_source_or_target_count, backward_tentative_distance);
 }
 
@@ -2119,9 +2996,9 @@ namespace{
 		const std::vector<unsigned>&forward_predecessor_node,
 		const std::vector<unsigned>&predecessor_arc,
 
-		const std::vector<unsigned>&backward_head,
+		ConstVectorView<unsigned>backward_head,
 
-		const std::vector<unsigned>&ch_order,
+		ConstVectorView<unsigned>ch_order,
 
 		unsigned*output
 	){
@@ -2147,8 +3024,9 @@ namespace{
 	}
 }
 
-ContractionHierarchyQuery& ContractionHierarchyQuery::get_used_sources_to_targets(unsigned*output){
-	assert(state == ContractionHierarchyQuery::InternalState::target_run);
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::get_used_sources_to_targets(unsigned*output){
+	assert(state == InternalState::target_run);
 
 	internal_get_used_sources_to_targets(
 		backward_predecessor_node, many_to_many_source_or_target_count,
@@ -2156,8 +3034,8 @@ ContractionHierarchyQuery& ContractionHierarchyQuery::get_used_sources_to_target
 		was_forward_pushed,
 		forward_predecessor_node, forward_predecessor_arc,
 
-		ch->backward.head,
-		ch->order,
+		ch.backward.head,
+		ch.order,
 
 		output
 	);
@@ -2165,15 +3043,17 @@ ContractionHierarchyQuery& ContractionHierarchyQuery::get_used_sources_to_target
 	return *this;
 }
 
-std::vector<unsigned> ContractionHierarchyQuery::get_used_sources_to_targets(){
-	assert(state == ContractionHierarchyQuery::InternalState::target_run);
+template<class Queue>
+std::vector<unsigned> BasicContractionHierarchyQuery<Queue>::get_used_sources_to_targets(){
+	assert(state == InternalState::target_run);
 	std::vector<unsigned>ret(many_to_many_source_or_target_count);
 	get_used_sources_to_targets(&ret[0]);
 	return ret; // NVRO
 }
 
-ContractionHierarchyQuery& ContractionHierarchyQuery::get_used_targets_to_sources(unsigned*output){
-	assert(state == ContractionHierarchyQuery::InternalState::source_run);
+template<class Queue>
+BasicContractionHierarchyQuery<Queue>&BasicContractionHierarchyQuery<Queue>::get_used_targets_to_sources(unsigned*output){
+	assert(state == InternalState::source_run);
 
 	internal_get_used_sources_to_targets(
 		forward_predecessor_node, many_to_many_source_or_target_count,
@@ -2181,8 +3061,8 @@ ContractionHierarchyQuery& ContractionHierarchyQuery::get_used_targets_to_source
 		was_backward_pushed,
 		backward_predecessor_node, backward_predecessor_arc,
 
-		ch->forward.head,
-		ch->order,
+		ch.forward.head,
+		ch.order,
 
 		output
 	);
@@ -2190,13 +3070,207 @@ ContractionHierarchyQuery& ContractionHierarchyQuery::get_used_targets_to_source
 	return *this;
 }
 
-std::vector<unsigned> ContractionHierarchyQuery::get_used_targets_to_sources(){
-	assert(state == ContractionHierarchyQuery::InternalState::source_run);
+template<class Queue>
+std::vector<unsigned> BasicContractionHierarchyQuery<Queue>::get_used_targets_to_sources(){
+	assert(state == InternalState::source_run);
 	std::vector<unsigned>ret(many_to_many_source_or_target_count);
 	get_used_targets_to_sources(&ret[0]);
 	return ret; // NVRO
 }
 
+namespace{
+	// Runs a complete upward search from s using stall-on-demand and calls
+	// on_settle(node, distance) for every settled node that is not stalled.
+	template<class OnSettle>
+	void forall_nodes_in_stalled_upward_search_space(
+		unsigned s,
+		const ContractionHierarchy::Side&forward, const ContractionHierarchy::Side&backward,
+		TimestampFlags&was_pushed, MinIDQueue&queue, std::vector<unsigned>&tentative_distance,
+		const OnSettle&on_settle
+	){
+		was_pushed.reset_all();
+		queue.clear();
+
+		queue.push({s, 0});
+		tentative_distance[s] = 0;
+		was_pushed.set(s);
+
+		run_stalled_upward_search(forward, backward, was_pushed, queue, tentative_distance, on_settle, [](unsigned, unsigned){});
+	}
+}
+
+ContractionHierarchyManyToMany::ContractionHierarchyManyToMany(const ContractionHierarchy&ch):
+	ch(&ch), target_count(0){}
+
+ContractionHierarchyManyToMany&ContractionHierarchyManyToMany::reset(const ContractionHierarchy&new_ch){
+	if(ch == nullptr || ch->node_count() != new_ch.node_count())
+		search_state.clear();
+	ch = &new_ch;
+	target_count = 0;
+	bucket_first_entry.clear();
+	bucket_entry.clear();
+	return *this;
+}
+
+void ContractionHierarchyManyToMany::prepare_search_states(unsigned thread_count){
+	unsigned node_count = ch->node_count();
+	while(search_state.size() < thread_count)
+		search_state.push_back({TimestampFlags(node_count), MinIDQueue(node_count), std::vector<unsigned>(node_count)});
+}
+
+ContractionHierarchyManyToMany&ContractionHierarchyManyToMany::set_targets(const std::vector<unsigned>&target_list, unsigned thread_count){
+	assert(ch && "many-to-many object must have an attached CH");
+	assert(thread_count != 0);
+	assert((target_list.empty() || max_element_of(target_list) < ch->node_count()) && "node id out of bounds");
+
+	prepare_search_states(thread_count);
+
+	const unsigned node_count = ch->node_count();
+	target_count = target_list.size();
+
+	struct NodeBucketEntry{
+		unsigned node;
+		BucketEntry entry;
+	};
+
+	std::vector<std::vector<NodeBucketEntry>>entries_of_thread(thread_count);
+
+	#ifdef _OPENMP
+	#pragma omp parallel for num_threads(thread_count) schedule(dynamic, 16)
+	#endif
+	for(unsigned i=0; i<target_count; ++i){
+		SearchState&state = search_state[get_thread_id()];
+		std::vector<NodeBucketEntry>&entries = entries_of_thread[get_thread_id()];
+		forall_nodes_in_stalled_upward_search_space(
+			ch->rank[target_list[i]],
+			ch->backward, ch->forward,
+			state.was_pushed, state.queue, state.tentative_distance,
+			[&](unsigned x, unsigned d){
+				entries.push_back({x, {i, d}});
+			}
+		);
+	}
+
+	bucket_first_entry.assign(node_count+1, 0);
+	for(auto&entries:entries_of_thread)
+		for(auto&e:entries)
+			++bucket_first_entry[e.node+1];
+	for(unsigned x=0; x<node_count; ++x)
+		bucket_first_entry[x+1] += bucket_first_entry[x];
+
+	bucket_entry.resize(bucket_first_entry[node_count]);
+	{
+		std::vector<unsigned>next_entry(bucket_first_entry.begin(), bucket_first_entry.end()-1);
+		for(auto&entries:entries_of_thread)
+			for(auto&e:entries)
+				bucket_entry[next_entry[e.node]++] = e.entry;
+	}
+
+	return *this;
+}
+
+ContractionHierarchyManyToMany&ContractionHierarchyManyToMany::get_distances(const std::vector<unsigned>&source_list, unsigned*dist, unsigned thread_count){
+	assert(ch && "many-to-many object must have an attached CH");
+	assert(thread_count != 0);
+	assert((source_list.empty() || max_element_of(source_list) < ch->node_count()) && "node id out of bounds");
+	assert(bucket_first_entry.size() == ch->node_count()+1 && "set_targets must be called before get_distances");
+
+	prepare_search_states(thread_count);
+
+	const unsigned source_count = source_list.size();
+
+	#ifdef _OPENMP
+	#pragma omp parallel for num_threads(thread_count) schedule(dynamic, 4)
+	#endif
+	for(unsigned i=0; i<source_count; ++i){
+		SearchState&state = search_state[get_thread_id()];
+		unsigned*row = dist + (unsigned long long)i*target_count;
+		std::fill(row, row+target_count, inf_weight);
+
+		forall_nodes_in_stalled_upward_search_space(
+			ch->rank[source_list[i]],
+			ch->forward, ch->backward,
+			state.was_pushed, state.queue, state.tentative_distance,
+			[&](unsigned x, unsigned d){
+				for(unsigned j=bucket_first_entry[x]; j<bucket_first_entry[x+1]; ++j){
+					unsigned new_dist = d + bucket_entry[j].distance;
+					if(new_dist < row[bucket_entry[j].target])
+						row[bucket_entry[j].target] = new_dist;
+				}
+			}
+		);
+	}
+
+	return *this;
+}
+
+std::vector<unsigned>ContractionHierarchyManyToMany::get_distances(const std::vector<unsigned>&source_list, unsigned thread_count){
+	std::vector<unsigned>dist((unsigned long long)source_list.size()*target_count);
+	get_distances(source_list, dist.data(), thread_count);
+	return dist; // NVRO
+}
+
+ContractionHierarchyBatchQuery::ContractionHierarchyBatchQuery(ContractionHierarchyView ch, unsigned thread_count){
+	reset(std::move(ch), thread_count);
+}
+
+ContractionHierarchyBatchQuery&ContractionHierarchyBatchQuery::reset(ContractionHierarchyView ch, unsigned thread_count){
+	assert(thread_count != 0);
+
+	#ifndef _OPENMP
+	thread_count = 1;
+	#endif
+
+	query.resize(thread_count);
+	for(auto&q:query)
+		q.reset(ch);
+	return *this;
+}
+
+ContractionHierarchyBatchQuery&ContractionHierarchyBatchQuery::run(
+	const unsigned*source_list, const unsigned*target_list, unsigned query_count,
+	unsigned*dist,
+	std::vector<unsigned>*node_path,
+	std::vector<unsigned>*arc_path,
+	long long*query_time
+){
+	assert(!query.empty() && "batch query object must have an attached CH");
+
+	#ifdef _OPENMP
+	#pragma omp parallel for num_threads(query.size()) schedule(dynamic, 8)
+	#endif
+	for(unsigned i=0; i<query_count; ++i){
+		ContractionHierarchyQuery&q = query[get_thread_id()];
+
+		long long time = 0;  // initialize to avoid warning, not needed
+		if(query_time)
+			time = -get_micro_time();
+
+		q.reset().add_source(source_list[i]).add_target(target_list[i]).run();
+		dist[i] = q.get_distance();
+		if(node_path)
+			node_path[i] = q.get_node_path();
+		if(arc_path)
+			arc_path[i] = q.get_arc_path();
+
+		if(query_time)
+			query_time[i] = time + get_micro_time();
+	}
+
+	return *this;
+}
+
+std::vector<unsigned>ContractionHierarchyBatchQuery::get_distances(const std::vector<unsigned>&source_list, const std::vector<unsigned>&target_list){
+	assert(source_list.size() == target_list.size());
+	std::vector<unsigned>dist(source_list.size());
+	run(source_list.data(), target_list.data(), source_list.size(), dist.data());
+	return dist; // NVRO
+}
+
+template class BasicContractionHierarchyQuery<BasicMinIDQueue<2, unsigned>>;
+template class BasicContractionHierarchyQuery<MinIDQueue>;
+template class BasicContractionHierarchyQuery<BasicMinIDQueue<8, unsigned>>;
+template class BasicContractionHierarchyQuery<MinIDRadixQueue>;
 template struct ContractionHierarchyExtraWeight<unsigned>;
 template struct ContractionHierarchyExtraWeight<int>;
 template ContractionHierarchyQuery& ContractionHierarchyQuery::get_extra_weight_distances_to_targets<std::vector<int>, SaturatedWeightAddition, std::vector<int>, std::vector<int>>(const std::vector<int>&, const SaturatedWeightAddition&, std::vector<int>&, std::vector<int>&);
@@ -0,0 +1,348 @@
+#include <routingkit/contraction_hierarchy_phast.h>
+#include <routingkit/constants.h>
+#include <routingkit/min_max.h>
+#include "contraction_hierarchy_upward_search.h"
+#include "interleaved_relaxation.h"
+
+#include <algorithm>
+
+namespace RoutingKit{
+
+namespace{
+	// Processes the nodes by decreasing rank. When a node is processed, all nodes of higher
+	// rank have their final distance. Nodes not reached by the upward search start at inf_weight.
+	void downward_sweep(
+		const ContractionHierarchy::Side&backward,
+		const TimestampFlags&was_pushed,
+		std::vector<unsigned>&distance
+	){
+		const unsigned*first_out = backward.first_out.data();
+		const unsigned*head = backward.head.data();
+		const unsigned*weight = backward.weight.data();
+		unsigned*dist = distance.data();
+
+		for(unsigned x = distance.size(); x > 0;){
+			--x;
+			unsigned d = was_pushed.is_set(x) ? dist[x] : inf_weight;
+			for(unsigned arc = first_out[x]; arc < first_out[x+1]; ++arc){
+				unsigned new_d = dist[head[arc]] + weight[arc];
+				if(new_d < d)
+					d = new_d;
+			}
+			dist[x] = d;
+		}
+	}
+
+	// Same as downward_sweep but for K interleaved distance arrays. Nodes that were not
+	// reached by any upward search start at inf_weight.
+	template<unsigned K>
+	void interleaved_downward_sweep(
+		const ContractionHierarchy::Side&backward,
+		const TimestampFlags&was_reached,
+		std::vector<unsigned>&distance
+	){
+		const unsigned*first_out = backward.first_out.data();
+		const unsigned*head = backward.head.data();
+		const unsigned*weight = backward.weight.data();
+		unsigned*dist = distance.data();
+
+		alignas(64) unsigned d[K];
+
+		for(unsigned x = distance.size()/K; x > 0;){
+			--x;
+			unsigned*dist_x = dist + (unsigned long long)x*K;
+			if(was_reached.is_set(x))
+				std::copy(dist_x, dist_x+K, d);
+			else
+				std::fill(d, d+K, inf_weight);
+			for(unsigned arc = first_out[x]; arc < first_out[x+1]; ++arc)
+				relax_interleaved<K>(d, dist + (unsigned long long)head[arc]*K, weight[arc]);
+			std::copy(d, d+K, dist_x);
+		}
+	}
+}
+
+ContractionHierarchyPHAST::ContractionHierarchyPHAST(const ContractionHierarchy&ch):
+	ch(&ch),
+	was_pushed(ch.node_count()),
+	queue(ch.node_count()),
+	distance(ch.node_count()),
+	state(ContractionHierarchyPHAST::InternalState::initialized){}
+
+ContractionHierarchyPHAST&ContractionHierarchyPHAST::reset(){
+	assert(ch && "PHAST object must have an attached CH");
+	was_pushed.reset_all();
+	queue.clear();
+	state = ContractionHierarchyPHAST::InternalState::initialized;
+	return *this;
+}
+
+ContractionHierarchyPHAST&ContractionHierarchyPHAST::reset(const ContractionHierarchy&new_ch){
+	if(distance.size() == new_ch.node_count()){
+		ch = &new_ch;
+		reset();
+	}else{
+		*this = ContractionHierarchyPHAST(new_ch);
+	}
+	return *this;
+}
+
+ContractionHierarchyPHAST&ContractionHierarchyPHAST::add_source(unsigned external_s, unsigned dist_to_s){
+	assert(ch && "PHAST object must have an attached CH");
+	assert(external_s < ch->node_count() && "node out of bounds");
+	assert(state == ContractionHierarchyPHAST::InternalState::initialized);
+
+	unsigned s = ch->rank[external_s];
+	if(!was_pushed.is_set(s)){
+		queue.push({s, dist_to_s});
+		distance[s] = dist_to_s;
+		was_pushed.set(s);
+	}else if(dist_to_s < distance[s]){
+		queue.decrease_key({s, dist_to_s});
+		distance[s] = dist_to_s;
+	}
+	return *this;
+}
+
+ContractionHierarchyPHAST&ContractionHierarchyPHAST::run(){
+	assert(ch && "PHAST object must have an attached CH");
+	assert(state == ContractionHierarchyPHAST::InternalState::initialized);
+
+	// The tentative distances of stalled nodes can be too large. The downward sweep corrects them.
+	run_stalled_upward_search(ch->forward, ch->backward, was_pushed, queue, distance, [](unsigned, unsigned){}, [](unsigned, unsigned){});
+	downward_sweep(ch->backward, was_pushed, distance);
+
+	state = ContractionHierarchyPHAST::InternalState::run;
+	return *this;
+}
+
+ContractionHierarchyPHAST&ContractionHierarchyPHAST::get_distances(unsigned*dist){
+	assert(state == ContractionHierarchyPHAST::InternalState::run);
+	const unsigned node_count = ch->node_count();
+	for(unsigned r=0; r<node_count; ++r)
+		dist[ch->order[r]] = distance[r];
+	return *this;
+}
+
+std::vector<unsigned>ContractionHierarchyPHAST::get_distances(){
+	std::vector<unsigned>dist(ch->node_count());
+	get_distances(dist.data());
+	return dist; // NVRO
+}
+
+template<unsigned K>
+ContractionHierarchyMultiSourcePHAST<K>::ContractionHierarchyMultiSourcePHAST(const ContractionHierarchy&ch):
+	ch(&ch),
+	source_count(0),
+	was_pushed(ch.node_count()),
+	was_reached(ch.node_count()),
+	queue(ch.node_count()),
+	tentative_distance(ch.node_count()),
+	distance((unsigned long long)ch.node_count()*K){}
+
+template<unsigned K>
+ContractionHierarchyMultiSourcePHAST<K>&ContractionHierarchyMultiSourcePHAST<K>::reset(const ContractionHierarchy&new_ch){
+	if(tentative_distance.size() == new_ch.node_count()){
+		ch = &new_ch;
+		source_count = 0;
+	}else{
+		*this = ContractionHierarchyMultiSourcePHAST<K>(new_ch);
+	}
+	return *this;
+}
+
+template<unsigned K>
+ContractionHierarchyMultiSourcePHAST<K>&ContractionHierarchyMultiSourcePHAST<K>::run(const unsigned*source_list, unsigned new_source_count){
+	assert(ch && "PHAST object must have an attached CH");
+	assert(new_source_count <= K && "too many sources");
+
+	source_count = new_source_count;
+
+	was_reached.reset_all();
+	for(unsigned i=0; i<source_count; ++i){
+		assert(source_list[i] < ch->node_count() && "node out of bounds");
+
+		unsigned s = ch->rank[source_list[i]];
+		was_pushed.reset_all();
+		queue.clear();
+		queue.push({s, 0});
+		tentative_distance[s] = 0;
+		was_pushed.set(s);
+
+		// Stalled nodes are also copied. Their distances are corrected by the downward sweep.
+		auto on_pop = [&](unsigned x, unsigned d){
+			unsigned*dist_x = &distance[(unsigned long long)x*K];
+			if(!was_reached.is_set(x)){
+				std::fill(dist_x, dist_x+K, inf_weight);
+				was_reached.set(x);
+			}
+			dist_x[i] = d;
+		};
+		run_stalled_upward_search(ch->forward, ch->backward, was_pushed, queue, tentative_distance, on_pop, on_pop);
+	}
+
+	interleaved_downward_sweep<K>(ch->backward, was_reached, distance);
+
+	return *this;
+}
+
+template<unsigned K>
+ContractionHierarchyMultiSourcePHAST<K>&ContractionHierarchyMultiSourcePHAST<K>::run(const std::vector<unsigned>&source_list){
+	return run(source_list.data(), source_list.size());
+}
+
+template<unsigned K>
+ContractionHierarchyMultiSourcePHAST<K>&ContractionHierarchyMultiSourcePHAST<K>::get_distances(unsigned source_index, unsigned*dist){
+	assert(source_index < source_count && "source index out of bounds");
+	const unsigned node_count = ch->node_count();
+	for(unsigned r=0; r<node_count; ++r)
+		dist[ch->order[r]] = distance[(unsigned long long)r*K + source_index];
+	return *this;
+}
+
+template<unsigned K>
+std::vector<unsigned>ContractionHierarchyMultiSourcePHAST<K>::get_distances(unsigned source_index){
+	std::vector<unsigned>dist(ch->node_count());
+	get_distances(source_index, dist.data());
+	return dist; // NVRO
+}
+
+ContractionHierarchyRPHAST::ContractionHierarchyRPHAST(const ContractionHierarchy&ch):
+	ch(&ch),
+	was_pushed(ch.node_count()),
+	queue(ch.node_count()),
+	tentative_distance(ch.node_count()),
+	target_count(0),
+	state(ContractionHierarchyRPHAST::InternalState::initialized){}
+
+ContractionHierarchyRPHAST&ContractionHierarchyRPHAST::reset(const ContractionHierarchy&new_ch){
+	*this = ContractionHierarchyRPHAST(new_ch);
+	return *this;
+}
+
+ContractionHierarchyRPHAST&ContractionHierarchyRPHAST::select_targets(const std::vector<unsigned>&target_list){
+	assert(ch && "RPHAST object must have an attached CH");
+	assert((target_list.empty() || max_element_of(target_list) < ch->node_count()) && "node id out of bounds");
+
+	const ContractionHierarchy::Side&backward = ch->backward;
+
+	// Collect all nodes reachable from a target in the backward CH. tentative_distance is
+	// used as temporary storage for the local IDs.
+	selected_node_rank.clear();
+	was_pushed.reset_all();
+	for(unsigned t:target_list){
+		t = ch->rank[t];
+		if(!was_pushed.is_set(t)){
+			was_pushed.set(t);
+			selected_node_rank.push_back(t);
+		}
+	}
+	for(unsigned i=0; i<selected_node_rank.size(); ++i){
+		unsigned x = selected_node_rank[i];
+		for(unsigned arc = backward.first_out[x]; arc < backward.first_out[x+1]; ++arc){
+			unsigned y = backward.head[arc];
+			if(!was_pushed.is_set(y)){
+				was_pushed.set(y);
+				selected_node_rank.push_back(y);
+			}
+		}
+	}
+	std::sort(selected_node_rank.begin(), selected_node_rank.end(), [](unsigned l, unsigned r){return l > r;});
+	selected_node_rank.shrink_to_fit();
+
+	const unsigned selected_node_count = selected_node_rank.size();
+	for(unsigned i=0; i<selected_node_count; ++i)
+		tentative_distance[selected_node_rank[i]] = i;
+
+	selected_first_out.resize(selected_node_count+1);
+	selected_head.clear();
+	selected_weight.clear();
+	selected_first_out[0] = 0;
+	for(unsigned i=0; i<selected_node_count; ++i){
+		unsigned x = selected_node_rank[i];
+		for(unsigned arc = backward.first_out[x]; arc < backward.first_out[x+1]; ++arc){
+			unsigned y = tentative_distance[backward.head[arc]];
+			assert(y < i);
+			selected_head.push_back(y);
+			selected_weight.push_back(backward.weight[arc]);
+		}
+		selected_first_out[i+1] = selected_head.size();
+	}
+	selected_head.shrink_to_fit();
+	selected_weight.shrink_to_fit();
+
+	target_count = target_list.size();
+	target_local_id.resize(target_count);
+	for(unsigned i=0; i<target_count; ++i)
+		target_local_id[i] = tentative_distance[ch->rank[target_list[i]]];
+
+	selected_distance.resize(selected_node_count);
+
+	return reset();
+}
+
+ContractionHierarchyRPHAST&ContractionHierarchyRPHAST::reset(){
+	assert(ch && "RPHAST object must have an attached CH");
+	was_pushed.reset_all();
+	queue.clear();
+	state = ContractionHierarchyRPHAST::InternalState::initialized;
+	return *this;
+}
+
+ContractionHierarchyRPHAST&ContractionHierarchyRPHAST::add_source(unsigned external_s, unsigned dist_to_s){
+	assert(ch && "RPHAST object must have an attached CH");
+	assert(external_s < ch->node_count() && "node out of bounds");
+	assert(state == ContractionHierarchyRPHAST::InternalState::initialized);
+
+	unsigned s = ch->rank[external_s];
+	if(!was_pushed.is_set(s)){
+		queue.push({s, dist_to_s});
+		tentative_distance[s] = dist_to_s;
+		was_pushed.set(s);
+	}else if(dist_to_s < tentative_distance[s]){
+		queue.decrease_key({s, dist_to_s});
+		tentative_distance[s] = dist_to_s;
+	}
+	return *this;
+}
+
+ContractionHierarchyRPHAST&ContractionHierarchyRPHAST::run(){
+	assert(ch && "RPHAST object must have an attached CH");
+	assert(state == ContractionHierarchyRPHAST::InternalState::initialized);
+
+	run_stalled_upward_search(ch->forward, ch->backward, was_pushed, queue, tentative_distance, [](unsigned, unsigned){}, [](unsigned, unsigned){});
+
+	const unsigned selected_node_count = selected_node_rank.size();
+	for(unsigned i=0; i<selected_node_count; ++i){
+		unsigned x = selected_node_rank[i];
+		unsigned d = was_pushed.is_set(x) ? tentative_distance[x] : inf_weight;
+		for(unsigned arc = selected_first_out[i]; arc < selected_first_out[i+1]; ++arc){
+			unsigned new_d = selected_distance[selected_head[arc]] + selected_weight[arc];
+			if(new_d < d)
+				d = new_d;
+		}
+		selected_distance[i] = d;
+	}
+
+	state = ContractionHierarchyRPHAST::InternalState::run;
+	return *this;
+}
+
+ContractionHierarchyRPHAST&ContractionHierarchyRPHAST::get_distances_to_targets(unsigned*dist){
+	assert(state == ContractionHierarchyRPHAST::InternalState::run);
+	for(unsigned i=0; i<target_count; ++i)
+		dist[i] = selected_distance[target_local_id[i]];
+	return *this;
+}
+
+std::vector<unsigned>ContractionHierarchyRPHAST::get_distances_to_targets(){
+	std::vector<unsigned>dist(target_count);
+	get_distances_to_targets(dist.data());
+	return dist; // NVRO
+}
+
+template class ContractionHierarchyMultiSourcePHAST<4>;
+template class ContractionHierarchyMultiSourcePHAST<8>;
+template class ContractionHierarchyMultiSourcePHAST<16>;
+
+} // RoutingKit
@@ -0,0 +1,90 @@
+#ifndef CONTRACTION_HIERARCHY_UPWARD_SEARCH_H
+#define CONTRACTION_HIERARCHY_UPWARD_SEARCH_H
+
+#include <routingkit/constants.h>
+#include <routingkit/timestamp_flag.h>
+#include <routingkit/vector_view.h>
+
+#include <vector>
+
+namespace RoutingKit{
+
+// Building blocks of the upward searches in a CH. They are shared by the queries in
+// contraction_hierarchy.cpp and by PHAST.
+
+template<class Queue, class SetPred>
+void forward_expand_upward_ch_arcs_of_node(
+	unsigned node,
+	unsigned distance_to_node,
+	ConstVectorView<unsigned>forward_first_out,
+	ConstVectorView<unsigned>forward_head,
+	ConstVectorView<unsigned>forward_weight,
+	TimestampFlags&was_forward_pushed,
+	Queue&forward_queue,
+	std::vector<unsigned>&forward_tentative_distance,
+	const SetPred&set_predecessor
+){
+	for(unsigned arc = forward_first_out[node]; arc < forward_first_out[node+1]; ++arc){
+		unsigned h = forward_head[arc], d = distance_to_node + forward_weight[arc];
+		if(was_forward_pushed.is_set(h)){
+			if(d < forward_tentative_distance[h]){
+				forward_queue.decrease_key({h, d});
+				forward_tentative_distance[h] = d;
+				set_predecessor(h, node, arc);
+			}
+		} else if(d < inf_weight){
+			forward_queue.push({h, d});
+			forward_tentative_distance[h] = d;
+			was_forward_pushed.set(h);
+			set_predecessor(h, node, arc);
+		}
+	}
+}
+
+inline bool forward_can_stall_at_node(
+	unsigned node,
+	ConstVectorView<unsigned>backward_first_out, ConstVectorView<unsigned>backward_head, ConstVectorView<unsigned>backward_weight,
+	const TimestampFlags&was_forward_pushed,
+	const std::vector<unsigned>&forward_tentative_distance
+){
+	for(unsigned arc = backward_first_out[node]; arc < backward_first_out[node+1]; ++arc){
+		unsigned x = backward_head[arc];
+		if(was_forward_pushed.is_set(x)){
+			if(forward_tentative_distance[x] + backward_weight[arc] <= forward_tentative_distance[node])
+				return true;
+		}
+	}
+	return false;
+}
+
+// Runs the upward search from the nodes in the queue until the queue is empty using
+// stall-on-demand. on_settle(node, distance) is called for every popped node that is not
+// stalled and on_stall(node, distance) for every stalled node. The tentative distances of
+// stalled nodes can be too large.
+template<class Side, class Queue, class OnSettle, class OnStall>
+void run_stalled_upward_search(
+	const Side&forward, const Side&backward,
+	TimestampFlags&was_pushed, Queue&queue, std::vector<unsigned>&tentative_distance,
+	const OnSettle&on_settle, const OnStall&on_stall
+){
+	while(!queue.empty()){
+		auto p = queue.pop();
+		if(forward_can_stall_at_node(p.id, backward.first_out, backward.head, backward.weight, was_pushed, tentative_distance)){
+			on_stall(p.id, p.key);
+			continue;
+		}
+
+		on_settle(p.id, p.key);
+
+		forward_expand_upward_ch_arcs_of_node(
+			p.id, p.key,
+			forward.first_out, forward.head, forward.weight,
+			was_pushed, queue, tentative_distance,
+			[](unsigned, unsigned, unsigned){}
+		);
+	}
+}
+
+} // RoutingKit
+
+#endif
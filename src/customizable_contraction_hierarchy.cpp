@@ -8,13 +8,19 @@
 #include <routingkit/graph_util.h>
 #include <routingkit/id_mapper.h>
 #include <routingkit/timer.h>
+#include <routingkit/vector_io.h>
 
 #include "emulate_gcc_builtin.h"
+#include "mapped_file.h"
+#include "interleaved_relaxation.h"
 
 #include <vector>
 #include <assert.h>
 #include <algorithm>
 #include <stdexcept>
+#include <string.h>
+#include <limits>
+#include <mutex>
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -65,8 +71,8 @@ namespace{
 
 	// Return value forall_*_triangle_of_arc is false if and only if the enumeration was aborted by the callback.
 
-	template<class F>
-	bool forall_upper_triangles_of_arc(const CustomizableContractionHierarchy&cch, unsigned x, unsigned y, unsigned xy, const F&f){
+	template<class CCH, class F>
+	bool forall_upper_triangles_of_arc(const CCH&cch, unsigned x, unsigned y, unsigned xy, const F&f){
 		unsigned x_up_arc = xy+1;
 		unsigned x_up_arc_end = cch.up_first_out[x+1];
 
@@ -89,13 +95,13 @@ namespace{
 		return true;
 	}
 
-	template<class F>
-	bool forall_upper_triangles_of_arc(const CustomizableContractionHierarchy&cch, unsigned xy, const F&f){
+	template<class CCH, class F>
+	bool forall_upper_triangles_of_arc(const CCH&cch, unsigned xy, const F&f){
 		return forall_upper_triangles_of_arc(cch, cch.up_tail[xy], cch.up_head[xy], xy, f);
 	}
 
-	template<class F>
-	bool forall_intermediate_triangles_of_arc(const CustomizableContractionHierarchy&cch, unsigned x, unsigned y, unsigned xy, const F&f){
+	template<class CCH, class F>
+	bool forall_intermediate_triangles_of_arc(const CCH&cch, unsigned x, unsigned y, unsigned xy, const F&f){
 		unsigned x_up_arc = cch.up_first_out[x];
 		unsigned x_up_arc_end = xy;
 
@@ -118,13 +124,13 @@ namespace{
 		return true;
 	}
 
-	template<class F>
-	bool forall_intermediate_triangles_of_arc(const CustomizableContractionHierarchy&cch, unsigned xy, const F&f){
+	template<class CCH, class F>
+	bool forall_intermediate_triangles_of_arc(const CCH&cch, unsigned xy, const F&f){
 		return forall_intermediate_triangles_of_arc(cch, cch.up_tail[xy], cch.up_head[xy], xy, f);
 	}
 
-	template<class F>
-	bool forall_lower_triangles_of_arc(const CustomizableContractionHierarchy&cch, unsigned x, unsigned y, unsigned xy, const F&f){
+	template<class CCH, class F>
+	bool forall_lower_triangles_of_arc(const CCH&cch, unsigned x, unsigned y, unsigned xy, const F&f){
 		unsigned x_down_arc = cch.down_first_out[x];
 		unsigned x_down_arc_end = cch.down_first_out[x+1];
 
@@ -147,8 +153,8 @@ namespace{
 		return true;
 	}
 
-	template<class F>
-	bool forall_lower_triangles_of_arc(const CustomizableContractionHierarchy&cch, unsigned xy, const F&f){
+	template<class CCH, class F>
+	bool forall_lower_triangles_of_arc(const CCH&cch, unsigned xy, const F&f){
 		return forall_lower_triangles_of_arc(cch, cch.up_tail[xy], cch.up_head[xy], xy, f);
 	}
 
@@ -408,6 +414,14 @@ CustomizableContractionHierarchy::CustomizableContractionHierarchy(
 			}
 		}
 		#endif
+
+		elimination_tree_depth.resize(node_count);
+		for(unsigned x=node_count-1; x!=(unsigned)-1; --x){
+			if(elimination_tree_parent[x] != invalid_id)
+				elimination_tree_depth[x] = elimination_tree_depth[elimination_tree_parent[x]] + 1;
+			else
+				elimination_tree_depth[x] = 0;
+		}
 	}
 
 
@@ -709,6 +723,44 @@ namespace{
 		CustomizableContractionHierarchyMetric*metric;
 	};
 
+	// Calls relax for the lower triangles of all upward arcs xz of x. arc_id_cache is a
+	// scratch array with one entry per node.
+	template<class Relaxer>
+	void forall_lower_triangles_of_upward_arcs_of_node(
+		const CustomizableContractionHierarchy&cch,
+		unsigned x, std::vector<unsigned>&arc_id_cache,
+		const Relaxer&relax
+	){
+		const unsigned xz_up_end = cch.up_first_out[x+1];
+		for(unsigned xz_up = cch.up_first_out[x]; xz_up < xz_up_end; ++xz_up){
+			arc_id_cache[cch.up_head[xz_up]] = xz_up;
+		}
+
+		const unsigned xy_down_end = cch.down_first_out[x+1];
+		for(unsigned xy_down = cch.down_first_out[x]; xy_down < xy_down_end; ++xy_down){
+			const unsigned yx_up = cch.down_to_up[xy_down];
+			const unsigned y = cch.down_head[xy_down];
+			const unsigned yz_up_end_reversed = cch.up_first_out[y];
+			for(unsigned yz_up_reversed = cch.up_first_out[y+1]; yz_up_reversed > yz_up_end_reversed; --yz_up_reversed){
+				const unsigned yz_up = yz_up_reversed-1;
+				const unsigned z = cch.up_head[yz_up];
+				if (z <= x) { break; }
+				relax(yx_up, yz_up, arc_id_cache[z], y, x, z);
+			}
+		}
+	}
+
+	// Relaxes the lower triangles of all upward arcs xz of x. Only the weights of these arcs
+	// are modified. All arcs whose tail is a descendant of x in the elimination tree must
+	// already be customized.
+	void relax_lower_triangles_of_upward_arcs_of_node(
+		const CustomizableContractionHierarchy&cch, CustomizableContractionHierarchyMetric&metric,
+		unsigned x, std::vector<unsigned>&arc_id_cache
+	){
+		LowerTriangleRelaxer relax(metric);
+		forall_lower_triangles_of_upward_arcs_of_node(cch, x, arc_id_cache, relax);
+	}
+
 	#ifndef NDEBUG
 	struct LowerTriangleInequalityVerifier{
 
@@ -777,25 +829,8 @@ CustomizableContractionHierarchyMetric& CustomizableContractionHierarchyMetric::
 
 	std::vector<unsigned> arc_id_cache(cch->node_count());
 
-	for(unsigned x=0; x<cch->node_count(); ++x){
-		const unsigned xz_up_end = cch->up_first_out[x+1];
-		for(unsigned xz_up = cch->up_first_out[x]; xz_up < xz_up_end; ++xz_up){
-			arc_id_cache[cch->up_head[xz_up]] = xz_up;
-		}
-
-		const unsigned xy_down_end = cch->down_first_out[x+1];
-		for(unsigned xy_down = cch->down_first_out[x]; xy_down < xy_down_end; ++xy_down){
-			const unsigned yx_up = cch->down_to_up[xy_down];
-			const unsigned y = cch->down_head[xy_down];
-			const unsigned yz_up_end_reversed = cch->up_first_out[y];
-			for(unsigned yz_up_reversed = cch->up_first_out[y+1]; yz_up_reversed > yz_up_end_reversed; --yz_up_reversed){
-				const unsigned yz_up = yz_up_reversed-1;
-				const unsigned z = cch->up_head[yz_up];
-				if (z <= x) { break; }
-				LowerTriangleRelaxer(*this)(yx_up, yz_up, arc_id_cache[z], y, x, z);
-			}
-		}
-	}
+	for(unsigned x=0; x<cch->node_count(); ++x)
+		relax_lower_triangles_of_upward_arcs_of_node(*cch, *this, x, arc_id_cache);
 
 	#ifndef NDEBUG
 	for(unsigned a=0; a<cch->cch_arc_count(); ++a)
@@ -833,64 +868,72 @@ namespace{
 	};
 }
 
-CustomizableContractionHierarchyParallelization::CustomizableContractionHierarchyParallelization(const CustomizableContractionHierarchy&cch){
-	const unsigned node_count = cch.node_count();
+namespace{
+	// The level of a node is the length of the longest downward path starting at it. The
+	// upward arcs are ordered by the level of their tail. Returns the number of levels.
+	unsigned compute_arcs_ordered_by_level(const CustomizableContractionHierarchy&cch, std::vector<unsigned>&arcs_ordered_by_level, std::vector<unsigned>&first_arc_of_level){
+		const unsigned node_count = cch.node_count();
 
-	std::vector<unsigned>node_level(node_count);
-	unsigned level_count;
-	{
-		std::vector<unsigned>lock(node_count);
-		std::vector<unsigned>zero_lock_list(node_count);
-		unsigned zero_lock_count = 0;
-		for(unsigned x=0; x<node_count; ++x){
-			lock[x] = cch.down_first_out[x+1] - cch.down_first_out[x];
-			if(lock[x] == 0){
-				zero_lock_list[zero_lock_count] = x;
-				++zero_lock_count;
-			}
-		}
-
-		level_count = 0;
-		std::vector<unsigned>next_zero_lock_list(node_count);
-		while(zero_lock_count != 0){
-			unsigned next_zero_lock_count = 0;
-			for(unsigned i=0; i<zero_lock_count; ++i){
-				unsigned x = zero_lock_list[i];
-				node_level[x] = level_count;
-				for(unsigned xy=cch.up_first_out[x]; xy < cch.up_first_out[x+1]; ++xy){
-					unsigned y = cch.up_head[xy];
-					--lock[y];
-					if(lock[y] == 0){
-						next_zero_lock_list[next_zero_lock_count] = y;
-						++next_zero_lock_count;
+		std::vector<unsigned>node_level(node_count);
+		unsigned level_count;
+		{
+			std::vector<unsigned>lock(node_count);
+			std::vector<unsigned>zero_lock_list(node_count);
+			unsigned zero_lock_count = 0;
+			for(unsigned x=0; x<node_count; ++x){
+				lock[x] = cch.down_first_out[x+1] - cch.down_first_out[x];
+				if(lock[x] == 0){
+					zero_lock_list[zero_lock_count] = x;
+					++zero_lock_count;
+				}
+			}
+
+			level_count = 0;
+			std::vector<unsigned>next_zero_lock_list(node_count);
+			while(zero_lock_count != 0){
+				unsigned next_zero_lock_count = 0;
+				for(unsigned i=0; i<zero_lock_count; ++i){
+					unsigned x = zero_lock_list[i];
+					node_level[x] = level_count;
+					for(unsigned xy=cch.up_first_out[x]; xy < cch.up_first_out[x+1]; ++xy){
+						unsigned y = cch.up_head[xy];
+						--lock[y];
+						if(lock[y] == 0){
+							next_zero_lock_list[next_zero_lock_count] = y;
+							++next_zero_lock_count;
+						}
 					}
 				}
+				++level_count;
+				std::swap(next_zero_lock_list, zero_lock_list);
+				zero_lock_count = next_zero_lock_count;
 			}
-			++level_count;
-			std::swap(next_zero_lock_list, zero_lock_list);
-			zero_lock_count = next_zero_lock_count;
 		}
-	}
 
-	const unsigned arc_count = cch.cch_arc_count();
+		const unsigned arc_count = cch.cch_arc_count();
 
-	std::vector<unsigned>arc_level(arc_count);
-	arcs_ordered_by_level.resize(arc_count);
+		std::vector<unsigned>arc_level(arc_count);
+		arcs_ordered_by_level.resize(arc_count);
 
-	auto p = compute_stable_sort_permutation_using_key(node_level, level_count, [&](unsigned x){ return x; });
+		auto p = compute_stable_sort_permutation_using_key(node_level, level_count, [&](unsigned x){ return x; });
 
-	unsigned j = 0;
-	for(unsigned i=0; i<node_count; ++i){
-		unsigned x = p[i];
-		for(unsigned xy=cch.up_first_out[x]; xy<cch.up_first_out[x+1]; ++xy){
-			arc_level[j] = node_level[x];
-			arcs_ordered_by_level[j] = xy;
-			++j;
+		unsigned j = 0;
+		for(unsigned i=0; i<node_count; ++i){
+			unsigned x = p[i];
+			for(unsigned xy=cch.up_first_out[x]; xy<cch.up_first_out[x+1]; ++xy){
+				arc_level[j] = node_level[x];
+				arcs_ordered_by_level[j] = xy;
+				++j;
+			}
 		}
-	}
 
-	first_arc_of_level = invert_vector(arc_level, level_count);
+		first_arc_of_level = invert_vector(arc_level, level_count);
+		return level_count;
+	}
+}
 
+CustomizableContractionHierarchyParallelization::CustomizableContractionHierarchyParallelization(const CustomizableContractionHierarchy&cch){
+	compute_arcs_ordered_by_level(cch, arcs_ordered_by_level, first_arc_of_level);
 	this->cch = &cch;
 }
 
@@ -944,9 +987,243 @@ CustomizableContractionHierarchyParallelization& CustomizableContractionHierarch
 	return *this;
 }
 
+namespace{
+	// The subtrees should be small enough to give every thread many tasks, but large enough
+	// that only the few nodes at the top of the elimination tree need to be synchronized.
+	const unsigned target_subtree_count = 1024;
+}
+
+CustomizableContractionHierarchySubtreeParallelization::CustomizableContractionHierarchySubtreeParallelization(const CustomizableContractionHierarchy&cch){
+	const unsigned node_count = cch.node_count();
+	const unsigned arc_count = cch.cch_arc_count();
+
+	// The parent of a node always has a higher ID. Processing the nodes by increasing ID
+	// therefore visits all children before their parent.
+	std::vector<unsigned>subtree_arc_count(node_count);
+	std::vector<unsigned>height(node_count, 0);
+	for(unsigned x=0; x<node_count; ++x){
+		subtree_arc_count[x] += cch.up_first_out[x+1] - cch.up_first_out[x];
+		unsigned p = cch.elimination_tree_parent[x];
+		if(p != invalid_id){
+			subtree_arc_count[p] += subtree_arc_count[x];
+			max_to(height[p], height[x]+1);
+		}
+	}
+
+	const unsigned max_subtree_arc_count = std::max(arc_count / target_subtree_count, 1u);
+
+	// A node belongs to the top if its subtree is too large. All other nodes belong to the
+	// subtree of their highest ancestor that does not belong to the top.
+	std::vector<unsigned>subtree_of_node(node_count);
+	std::vector<unsigned>subtree_size;
+	for(unsigned x=node_count; x>0;){
+		--x;
+		unsigned p = cch.elimination_tree_parent[x];
+		if(subtree_arc_count[x] > max_subtree_arc_count){
+			subtree_of_node[x] = invalid_id;
+		}else if(p == invalid_id || subtree_of_node[p] == invalid_id){
+			subtree_of_node[x] = subtree_size.size();
+			subtree_size.push_back(subtree_arc_count[x]);
+		}else{
+			subtree_of_node[x] = subtree_of_node[p];
+		}
+	}
+	const unsigned subtree_count = subtree_size.size();
+
+	// Start with the largest subtrees to balance the load.
+	{
+		std::vector<unsigned>subtree_by_size(subtree_count);
+		for(unsigned i=0; i<subtree_count; ++i)
+			subtree_by_size[i] = i;
+		std::stable_sort(subtree_by_size.begin(), subtree_by_size.end(), [&](unsigned l, unsigned r){ return subtree_size[l] > subtree_size[r]; });
+		std::vector<unsigned>new_subtree_id = invert_permutation(subtree_by_size);
+		for(auto&t:subtree_of_node)
+			if(t != invalid_id)
+				t = new_subtree_id[t];
+	}
+
+	std::vector<unsigned>subtree_of_subtree_node;
+	std::vector<unsigned>top_node_height;
+	std::vector<unsigned>top_node;
+	for(unsigned x=0; x<node_count; ++x){
+		if(subtree_of_node[x] != invalid_id){
+			subtree_node.push_back(x);
+			subtree_of_subtree_node.push_back(subtree_of_node[x]);
+		}else{
+			top_node.push_back(x);
+			top_node_height.push_back(height[x]);
+		}
+	}
+
+	// A stable sort keeps the nodes of every subtree in increasing order.
+	subtree_node = apply_permutation(
+		compute_stable_sort_permutation_using_key(subtree_of_subtree_node, subtree_count, [](unsigned x){ return x; }),
+		subtree_node
+	);
+	std::sort(subtree_of_subtree_node.begin(), subtree_of_subtree_node.end());
+	first_node_of_subtree = invert_vector(subtree_of_subtree_node, subtree_count);
+
+	// Nodes of the same height are not ancestors of each other. All descendants of a node
+	// have a smaller height.
+	std::vector<unsigned>top_arc_height;
+	for(unsigned i=0; i<top_node.size(); ++i){
+		unsigned x = top_node[i];
+		for(unsigned xy=cch.up_first_out[x]; xy<cch.up_first_out[x+1]; ++xy){
+			top_arc.push_back(xy);
+			top_arc_height.push_back(top_node_height[i]);
+		}
+	}
+
+	const unsigned height_count = node_count == 0 ? 0 : *std::max_element(height.begin(), height.end()) + 1;
+	{
+		auto p = compute_stable_sort_permutation_using_key(top_arc_height, height_count, [](unsigned x){ return x; });
+		top_arc = apply_permutation(p, top_arc);
+		top_arc_height = apply_permutation(p, top_arc_height);
+	}
+
+	first_arc_of_top_level = {0};
+	for(unsigned i=1; i<=top_arc.size(); ++i)
+		if(i == top_arc.size() || top_arc_height[i] != top_arc_height[i-1])
+			first_arc_of_top_level.push_back(i);
+
+	this->cch = &cch;
+}
+
+CustomizableContractionHierarchySubtreeParallelization& CustomizableContractionHierarchySubtreeParallelization::customize(CustomizableContractionHierarchyMetric&metric) {
+	#ifdef _OPENMP
+	customize(metric, omp_get_num_procs());
+	#else
+	customize(metric, 1);
+	#endif
+	return *this;
+}
+
+CustomizableContractionHierarchySubtreeParallelization& CustomizableContractionHierarchySubtreeParallelization::customize(CustomizableContractionHierarchyMetric&metric, unsigned thread_count) {
+	assert(cch == metric.cch);
+	assert(thread_count != 0);
+	assert(metric.input_weight != nullptr && "Metric must be connected to a weight vector");
+
+	if(thread_count == 1){
+		metric.customize();
+	} else {
+		#ifdef _OPENMP
+		#pragma omp parallel num_threads(thread_count)
+		#endif
+		{
+			#ifdef _OPENMP
+			#pragma omp for
+			#endif
+			for(unsigned cch_arc=0; cch_arc<cch->cch_arc_count(); ++cch_arc){
+				extract_initial_metric_of_cch_arc(*cch, metric, cch_arc);
+			}
+
+			// Every task only writes the arcs leaving its own subtree and only reads arcs of
+			// its own subtree. No synchronization is needed.
+			std::vector<unsigned>arc_id_cache(cch->node_count());
+			#ifdef _OPENMP
+			#pragma omp for schedule(dynamic,1)
+			#endif
+			for(unsigned i=0; i<first_node_of_subtree.size()-1; ++i){
+				for(unsigned j=first_node_of_subtree[i]; j<first_node_of_subtree[i+1]; ++j)
+					relax_lower_triangles_of_upward_arcs_of_node(*cch, metric, subtree_node[j], arc_id_cache);
+			}
+
+			// Each arc only writes its own weights.
+			for(unsigned l=0; l<first_arc_of_top_level.size()-1; ++l){
+				#ifdef _OPENMP
+				#pragma omp for schedule(dynamic,16)
+				#endif
+				for(unsigned i=first_arc_of_top_level[l]; i<first_arc_of_top_level[l+1]; ++i){
+					forall_lower_triangles_of_arc(*cch, top_arc[i], LowerTriangleRelaxer(metric));
+				}
+			}
+		}
+
+		#ifndef NDEBUG
+		for(unsigned a=0; a<cch->cch_arc_count(); ++a)
+			forall_upper_triangles_of_arc(*cch, a, LowerTriangleInequalityVerifier(metric));
+		#endif
+	}
+	return *this;
+}
+
+CustomizableContractionHierarchyTriangles::CustomizableContractionHierarchyTriangles(const CustomizableContractionHierarchy&cch, const std::function<void(const std::string&)>&log_message){
+	long long timer = 0;
+	if(log_message){
+		log_message("Start enumerating lower triangles");
+		timer = -get_micro_time();
+	}
+
+	const unsigned cch_arc_count = cch.cch_arc_count();
+
+	first_triangle_of_arc.resize(cch_arc_count+1);
+	first_triangle_of_arc[0] = 0;
+	for(unsigned xy=0; xy<cch_arc_count; ++xy){
+		forall_lower_triangles_of_arc(
+			cch, xy,
+			[&](unsigned bottom_arc, unsigned mid_arc, unsigned top_arc, unsigned bottom_node, unsigned mid_node, unsigned top_node){
+				(void)top_arc;
+				(void)bottom_node;
+				(void)mid_node;
+				(void)top_node;
+				triangle_arcs.push_back(bottom_arc);
+				triangle_arcs.push_back(mid_arc);
+				return true;
+			}
+		);
+		if(triangle_arcs.size()/2 > (unsigned long long)std::numeric_limits<unsigned>::max())
+			throw std::runtime_error("The CCH has too many triangles to store them in a CustomizableContractionHierarchyTriangles object");
+		first_triangle_of_arc[xy+1] = triangle_arcs.size()/2;
+	}
+	triangle_arcs.shrink_to_fit();
+
+	this->cch = &cch;
+
+	if(log_message){
+		timer += get_micro_time();
+		log_message("Finished enumerating "+std::to_string(triangle_count())+" lower triangles, needed "+std::to_string(timer)+"musec");
+		log_message("The triangle list uses "+std::to_string(memory_usage())+" bytes");
+	}
+}
+
+CustomizableContractionHierarchyTriangles& CustomizableContractionHierarchyTriangles::customize(CustomizableContractionHierarchyMetric&metric){
+	assert(cch == metric.cch);
+	assert(metric.input_weight != nullptr && "Metric must be connected to a weight vector");
+
+	extract_initial_metric(*cch, metric);
+
+	unsigned*forward = metric.forward.data();
+	unsigned*backward = metric.backward.data();
+	const unsigned*triangle = triangle_arcs.data();
+
+	const unsigned cch_arc_count = cch->cch_arc_count();
+	for(unsigned xy=0; xy<cch_arc_count; ++xy){
+		unsigned forward_weight = forward[xy];
+		unsigned backward_weight = backward[xy];
+		const unsigned*triangle_end = triangle_arcs.data() + 2*(unsigned long long)first_triangle_of_arc[xy+1];
+		for(; triangle != triangle_end; triangle += 2){
+			const unsigned bottom_arc = triangle[0];
+			const unsigned mid_arc = triangle[1];
+			min_to(forward_weight,  backward[bottom_arc] + forward[mid_arc]);
+			min_to(backward_weight, forward[bottom_arc]  + backward[mid_arc]);
+		}
+		forward[xy] = forward_weight;
+		backward[xy] = backward_weight;
+	}
+
+	#ifndef NDEBUG
+	for(unsigned a=0; a<cch->cch_arc_count(); ++a)
+		forall_upper_triangles_of_arc(*cch, a, LowerTriangleInequalityVerifier(metric));
+	#endif
+	return *this;
+}
+
 CustomizableContractionHierarchyPartialCustomization::CustomizableContractionHierarchyPartialCustomization(const CustomizableContractionHierarchy&cch_):
 	q(cch_.cch_arc_count()),
-	cch(&cch_){
+	cch(&cch_),
+	full_customization_threshold(default_full_customization_threshold),
+	last_customization_method(CustomizationMethod::none),
+	last_recomputed_arc_count(0){
 }
 
 CustomizableContractionHierarchyPartialCustomization&CustomizableContractionHierarchyPartialCustomization::reset(){
@@ -960,6 +1237,11 @@ CustomizableContractionHierarchyPartialCustomization&CustomizableContractionHier
 	} else {
 		q.clear();
 		cch = &cch_;
+		first_arc_of_level.clear();
+		arcs_ordered_by_level.clear();
+		arc_level.clear();
+		dirty_arcs_of_level.clear();
+		dirty_arc_index.clear();
 	}
 	return *this;
 }
@@ -971,65 +1253,102 @@ CustomizableContractionHierarchyPartialCustomization&CustomizableContractionHier
 	return *this;
 }
 
-CustomizableContractionHierarchyPartialCustomization&CustomizableContractionHierarchyPartialCustomization::customize(CustomizableContractionHierarchyMetric&metric){
-	assert(cch == metric.cch);
-	assert(metric.input_weight != nullptr && "Metric must be connected to a weight vector");
-
-	while(!q.empty()){
-		unsigned xy = q.pop();
-
-		unsigned old_forward = metric.forward[xy];
-		unsigned old_backward = metric.backward[xy];
+namespace{
+	// Recomputes the weights of xy from its input arcs and its lower triangles. Only the
+	// weights of xy are modified. All arcs of lower triangles of xy must already be correct.
+	// Returns whether the weights changed.
+	bool recompute_arc(const CustomizableContractionHierarchy&cch, CustomizableContractionHierarchyMetric&metric, unsigned xy, unsigned&old_forward, unsigned&old_backward){
+		old_forward = metric.forward[xy];
+		old_backward = metric.backward[xy];
 
 		metric.forward[xy] = inf_weight;
 		metric.backward[xy] = inf_weight;
 
-		extract_initial_metric_of_cch_arc(*cch, metric, xy);
+		extract_initial_metric_of_cch_arc(cch, metric, xy);
 
 		forall_lower_triangles_of_arc(
-			*cch, xy,
+			cch, xy,
 			LowerTriangleRelaxer(metric)
 		);
 
+		return old_forward != metric.forward[xy] || old_backward != metric.backward[xy];
+	}
+
+	// Calls on_affected_arc for every arc whose weights might change because the weights
+	// of xy changed from old_forward and old_backward to their current values. The other
+	// arc of a triangle might have been recomputed as well. get_old_weights(arc, forward,
+	// backward) must therefore return the weights of that arc from before the recomputation.
+	template<class GetOldWeights, class OnAffectedArc>
+	void forall_arcs_affected_by_changed_arc(
+		const CustomizableContractionHierarchy&cch, const CustomizableContractionHierarchyMetric&metric,
+		unsigned xy, unsigned old_forward, unsigned old_backward,
+		const GetOldWeights&get_old_weights, const OnAffectedArc&on_affected_arc
+	){
 		unsigned new_forward = metric.forward[xy];
 		unsigned new_backward = metric.backward[xy];
 
-		if(old_forward != new_forward || old_backward != new_backward){
-			forall_intermediate_triangles_of_arc(
-				*cch, xy,
-				[&](
-					unsigned bottom_arc, unsigned mid_arc, unsigned top_arc,
-					unsigned bottom_node, unsigned mid_node, unsigned top_node
+		forall_intermediate_triangles_of_arc(
+			cch, xy,
+			[&](
+				unsigned bottom_arc, unsigned mid_arc, unsigned top_arc,
+				unsigned bottom_node, unsigned mid_node, unsigned top_node
+			){
+				assert(mid_arc == xy);
+				unsigned old_bottom_forward, old_bottom_backward;
+				get_old_weights(bottom_arc, old_bottom_forward, old_bottom_backward);
+				if(
+					old_bottom_backward + old_forward == metric.forward[top_arc] ||
+					old_bottom_forward + old_backward == metric.backward[top_arc] ||
+					metric.backward[bottom_arc] + new_forward < metric.forward[top_arc] ||
+					metric.forward[bottom_arc] + new_backward < metric.backward[top_arc]
 				){
-					assert(mid_arc == xy);
-					if(
-						metric.backward[bottom_arc] + old_forward == metric.forward[top_arc] ||
-						metric.forward[bottom_arc] + old_backward == metric.backward[top_arc] ||
-						metric.backward[bottom_arc] + new_forward < metric.forward[top_arc] ||
-						metric.forward[bottom_arc] + new_backward < metric.backward[top_arc]
-					){
-						q.push(top_arc);
-					}
-					return true;
+					on_affected_arc(top_arc);
 				}
-			);
-			forall_upper_triangles_of_arc(
-				*cch, xy,
-				[&](
-					unsigned bottom_arc, unsigned mid_arc, unsigned top_arc,
-					unsigned bottom_node, unsigned mid_node, unsigned top_node
+				return true;
+			}
+		);
+		forall_upper_triangles_of_arc(
+			cch, xy,
+			[&](
+				unsigned bottom_arc, unsigned mid_arc, unsigned top_arc,
+				unsigned bottom_node, unsigned mid_node, unsigned top_node
+			){
+				assert(bottom_arc == xy);
+				unsigned old_mid_forward, old_mid_backward;
+				get_old_weights(mid_arc, old_mid_forward, old_mid_backward);
+				if(
+					old_mid_forward + old_backward == metric.forward[top_arc] ||
+					old_mid_backward + old_forward == metric.backward[top_arc] ||
+					metric.forward[mid_arc] + new_backward < metric.forward[top_arc] ||
+					metric.backward[mid_arc] + new_forward < metric.backward[top_arc]
 				){
-					assert(bottom_arc == xy);
-					if(
-						metric.forward[mid_arc] + old_backward == metric.forward[top_arc] ||
-						metric.backward[mid_arc] + old_forward == metric.backward[top_arc] ||
-						metric.forward[mid_arc] + new_backward < metric.forward[top_arc] ||
-						metric.backward[mid_arc] + new_forward < metric.backward[top_arc]
-					){
-						q.push(top_arc);
-					}
-					return true;
+					on_affected_arc(top_arc);
 				}
+				return true;
+			}
+		);
+	}
+}
+
+CustomizableContractionHierarchyPartialCustomization&CustomizableContractionHierarchyPartialCustomization::customize(CustomizableContractionHierarchyMetric&metric){
+	assert(cch == metric.cch);
+	assert(metric.input_weight != nullptr && "Metric must be connected to a weight vector");
+
+	last_customization_method = CustomizationMethod::sequential;
+	last_recomputed_arc_count = 0;
+
+	while(!q.empty()){
+		unsigned xy = q.pop();
+		++last_recomputed_arc_count;
+		unsigned old_forward, old_backward;
+		if(recompute_arc(*cch, metric, xy, old_forward, old_backward)){
+			forall_arcs_affected_by_changed_arc(
+				*cch, metric, xy, old_forward, old_backward,
+				[&](unsigned arc, unsigned&forward, unsigned&backward){
+					forward = metric.forward[arc];
+					backward = metric.backward[arc];
+				},
+				[&](unsigned top_arc){ q.push(top_arc); }
 			);
 		}
 	}
@@ -1040,44 +1359,745 @@ CustomizableContractionHierarchyPartialCustomization&CustomizableContractionHier
 	return *this;
 }
 
-namespace{
-	const unsigned query_state_initialized = 0;
-	const unsigned query_state_run = 1;
-	const unsigned query_state_source_pinned = 2;
-	const unsigned query_state_source_run = 3;
-	const unsigned query_state_target_pinned = 4;
-	const unsigned query_state_target_run = 5;
-}
-
-namespace{
+CustomizableContractionHierarchyPartialCustomization&CustomizableContractionHierarchyPartialCustomization::customize(CustomizableContractionHierarchyMetric&metric, unsigned thread_count){
+	assert(cch == metric.cch);
+	assert(thread_count != 0);
+	assert(metric.input_weight != nullptr && "Metric must be connected to a weight vector");
 
-	template<class F>
-	void forall_ancestors(const std::vector<unsigned>&parent, unsigned x, unsigned stop_at, const F&f){
-		assert(x < parent.size());
-		assert(stop_at < parent.size() || stop_at == invalid_id);
+	#ifndef _OPENMP
+	thread_count = 1;
+	#endif
 
-		while(x != stop_at){
-			assert(x < parent.size() && "stop_at is not an ancestor of x");
-			if(!f(x))
-				return;
-			assert(parent[x] > x);
-			x = parent[x];
-		}
+	const unsigned arc_count = cch->cch_arc_count();
+
+	if(first_arc_of_level.empty()){
+		unsigned level_count = compute_arcs_ordered_by_level(*cch, arcs_ordered_by_level, first_arc_of_level);
+		arc_level.resize(arc_count);
+		for(unsigned l=0; l<level_count; ++l)
+			for(unsigned i=first_arc_of_level[l]; i<first_arc_of_level[l+1]; ++i)
+				arc_level[arcs_ordered_by_level[i]] = l;
+		dirty_arcs_of_level.resize(level_count);
+		is_arc_dirty = BitVector(arc_count);
+		dirty_arc_index.resize(arc_count);
 	}
+	const unsigned level_count = first_arc_of_level.size()-1;
+
+	unsigned long long dirty_arc_count = 0;
+	auto mark_dirty = [&](unsigned xy){
+		if(!is_arc_dirty.is_set(xy)){
+			is_arc_dirty.set(xy);
+			dirty_arcs_of_level[arc_level[xy]].push_back(xy);
+			++dirty_arc_count;
+		}
+	};
 
-	template<class F>
-	void forall_ancestors(const std::vector<unsigned>&parent, unsigned x, const F&f){
-		forall_ancestors(parent, x, invalid_id, f);
-	}
+	while(!q.empty())
+		mark_dirty(q.pop());
 
+	const unsigned long long max_dirty_arc_count = full_customization_threshold * arc_count;
 
-	void reset_source_list(
-		const std::vector<unsigned>&elimination_tree_parent,
-		std::vector<unsigned>&source_node, std::vector<unsigned>&source_elimination_tree_end,
-		std::vector<bool>&in_forward_search_space, std::vector<unsigned>&forward_tentative_distance
-	){
-		for(unsigned i=0; i<source_node.size(); ++i){
-			forall_ancestors(
+	last_customization_method = CustomizationMethod::parallel_levels;
+	last_recomputed_arc_count = 0;
+
+	std::vector<std::vector<unsigned>>affected_arcs(thread_count);
+	std::vector<unsigned>old_forward, old_backward;
+	std::vector<char>was_changed;
+
+	unsigned l = 0;
+	for(; l<level_count; ++l){
+		if(dirty_arc_count > max_dirty_arc_count){
+			last_customization_method = CustomizationMethod::full;
+			break;
+		}
+
+		std::vector<unsigned>&dirty_arcs = dirty_arcs_of_level[l];
+		if(dirty_arcs.empty())
+			continue;
+
+		// The lower triangles of an arc only contain arcs of lower levels. The arcs of a level
+		// can therefore be recomputed in parallel. The other arc of a triangle that contains
+		// a changed arc has the same tail and therefore is on the same level. Affected arcs
+		// are therefore only searched once the whole level is recomputed, using the saved old
+		// weights of the other arc. Affected arcs are always on higher levels.
+		for(unsigned i=0; i<dirty_arcs.size(); ++i)
+			dirty_arc_index[dirty_arcs[i]] = i;
+		old_forward.resize(dirty_arcs.size());
+		old_backward.resize(dirty_arcs.size());
+		was_changed.resize(dirty_arcs.size());
+		#ifdef _OPENMP
+		#pragma omp parallel num_threads(thread_count) if(dirty_arcs.size() >= 64)
+		#endif
+		{
+			#ifdef _OPENMP
+			#pragma omp for schedule(dynamic,16)
+			#endif
+			for(unsigned i=0; i<dirty_arcs.size(); ++i)
+				was_changed[i] = recompute_arc(*cch, metric, dirty_arcs[i], old_forward[i], old_backward[i]);
+
+			#ifdef _OPENMP
+			std::vector<unsigned>&my_affected_arcs = affected_arcs[omp_get_thread_num()];
+			#pragma omp for schedule(dynamic,16)
+			#else
+			std::vector<unsigned>&my_affected_arcs = affected_arcs[0];
+			#endif
+			for(unsigned i=0; i<dirty_arcs.size(); ++i){
+				if(was_changed[i]){
+					forall_arcs_affected_by_changed_arc(
+						*cch, metric, dirty_arcs[i], old_forward[i], old_backward[i],
+						[&](unsigned arc, unsigned&forward, unsigned&backward){
+							if(is_arc_dirty.is_set(arc)){
+								forward = old_forward[dirty_arc_index[arc]];
+								backward = old_backward[dirty_arc_index[arc]];
+							}else{
+								forward = metric.forward[arc];
+								backward = metric.backward[arc];
+							}
+						},
+						[&](unsigned top_arc){ my_affected_arcs.push_back(top_arc); }
+					);
+				}
+			}
+		}
+
+		last_recomputed_arc_count += dirty_arcs.size();
+		for(unsigned xy:dirty_arcs)
+			is_arc_dirty.reset(xy);
+		dirty_arcs.clear();
+
+		for(auto&a:affected_arcs){
+			for(unsigned xy:a)
+				mark_dirty(xy);
+			a.clear();
+		}
+	}
+
+	if(last_customization_method == CustomizationMethod::full){
+		// All levels below l are correct. Recompute everything from level l on.
+		for(unsigned j=l; j<level_count; ++j){
+			for(unsigned xy:dirty_arcs_of_level[j])
+				is_arc_dirty.reset(xy);
+			dirty_arcs_of_level[j].clear();
+		}
+
+		for(; l<level_count; ++l){
+			#ifdef _OPENMP
+			#pragma omp parallel for num_threads(thread_count) schedule(dynamic,256)
+			#endif
+			for(unsigned i=first_arc_of_level[l]; i<first_arc_of_level[l+1]; ++i){
+				unsigned xy = arcs_ordered_by_level[i];
+				metric.forward[xy] = inf_weight;
+				metric.backward[xy] = inf_weight;
+				extract_initial_metric_of_cch_arc(*cch, metric, xy);
+				forall_lower_triangles_of_arc(*cch, xy, LowerTriangleRelaxer(metric));
+			}
+			last_recomputed_arc_count += first_arc_of_level[l+1] - first_arc_of_level[l];
+		}
+	}
+
+	#ifndef NDEBUG
+	for(unsigned a=0; a<cch->cch_arc_count(); ++a)
+		forall_upper_triangles_of_arc(*cch, a, LowerTriangleInequalityVerifier(metric));
+	#endif
+	return *this;
+}
+
+namespace{
+	const unsigned long long cch_magic_number = 0x43434846696c6531ull;
+	const unsigned long long cch_metric_magic_number = 0x4343484d65747231ull;
+	const unsigned cch_file_version = 1;
+
+	// Every array starts at a multiple of this. This is the page size on all common platforms.
+	const unsigned long long cch_file_alignment = 4096;
+
+	enum CCHSection{
+		order_section,
+		rank_section,
+		elimination_tree_parent_section,
+		elimination_tree_depth_section,
+		up_first_out_section,
+		up_head_section,
+		up_tail_section,
+		down_first_out_section,
+		down_head_section,
+		down_to_up_section,
+		input_arc_to_cch_arc_section,
+		is_input_arc_upward_section,
+		does_cch_arc_have_input_arc_section,
+		forward_input_arc_of_cch_section,
+		backward_input_arc_of_cch_section,
+		does_cch_arc_have_extra_input_arc_section,
+		first_extra_forward_input_arc_of_cch_section,
+		first_extra_backward_input_arc_of_cch_section,
+		extra_forward_input_arc_of_cch_section,
+		extra_backward_input_arc_of_cch_section,
+		cch_section_count
+	};
+
+	enum CCHMetricSection{
+		forward_section,
+		backward_section,
+		cch_metric_section_count
+	};
+
+	// Both file types share the header layout. The CCH file stores the byte count of every
+	// section because the number of extra input arcs is not determined by the other counts.
+	// Metric files leave input_arc_count and the unused sections zero.
+	struct CCHFileHeader{
+		unsigned long long magic_number;
+		unsigned version;
+		unsigned node_count;
+		unsigned cch_arc_count;
+		unsigned input_arc_count;
+		unsigned long long file_size;
+		unsigned long long section_begin[cch_section_count];
+		unsigned long long section_byte_count[cch_section_count];
+	};
+
+	unsigned long long get_bit_vector_byte_count(unsigned long long bit_count){
+		return ((bit_count+511)/512)*64;
+	}
+
+	unsigned long long round_up_to_cch_file_alignment(unsigned long long x){
+		return (x + cch_file_alignment - 1) / cch_file_alignment * cch_file_alignment;
+	}
+
+	void write_sections(
+		std::function<void(const char*, unsigned long long)>&out,
+		CCHFileHeader header, unsigned section_count, const char*const*section_data
+	){
+		unsigned long long pos = round_up_to_cch_file_alignment(sizeof(header));
+		for(unsigned i=0; i<section_count; ++i){
+			header.section_begin[i] = pos;
+			pos = round_up_to_cch_file_alignment(pos + header.section_byte_count[i]);
+		}
+		header.file_size = pos;
+
+		static const char zero_padding[cch_file_alignment] = {};
+
+		out((const char*)&header, sizeof(header));
+		pos = sizeof(header);
+		for(unsigned i=0; i<section_count; ++i){
+			out(zero_padding, header.section_begin[i] - pos);
+			out(section_data[i], header.section_byte_count[i]);
+			pos = header.section_begin[i] + header.section_byte_count[i];
+		}
+		out(zero_padding, header.file_size - pos);
+	}
+
+	void check_header(const CCHFileHeader&header, unsigned long long magic_number, unsigned section_count, const char*what){
+		if(header.magic_number != magic_number)
+			throw std::runtime_error(std::string(what)+" file magic number broken. Is this really a "+what+" file written by save_file?");
+		if(header.version != cch_file_version)
+			throw std::runtime_error(std::string(what)+" file has version "+std::to_string(header.version)+" but only version "+std::to_string(cch_file_version)+" is supported.");
+		unsigned long long end = sizeof(header);
+		for(unsigned i=0; i<section_count; ++i){
+			if(header.section_begin[i] % cch_file_alignment != 0 || header.section_begin[i] < end || header.section_byte_count[i] % sizeof(unsigned) != 0)
+				throw std::runtime_error(std::string(what)+" file has an array that is misaligned. This file is corrupt.");
+			end = header.section_begin[i] + header.section_byte_count[i];
+		}
+		if(end > header.file_size)
+			throw std::runtime_error(std::string(what)+" file has an array that is out of bounds. This file is corrupt.");
+	}
+
+	// Reads the sections in file order. get_destination is called with the section ID
+	// and its byte count and returns where the data should be stored.
+	template<class F>
+	void read_sections(
+		std::function<void(char*, unsigned long long)>&in,
+		const CCHFileHeader&header, unsigned section_count, const F&get_destination
+	){
+		std::vector<char>padding(cch_file_alignment);
+		unsigned long long pos = sizeof(header);
+		for(unsigned i=0; i<section_count; ++i){
+			in(padding.data(), header.section_begin[i] - pos);
+			in(get_destination(i, header.section_byte_count[i]), header.section_byte_count[i]);
+			pos = header.section_begin[i] + header.section_byte_count[i];
+		}
+		while(pos < header.file_size){
+			unsigned long long l = std::min(cch_file_alignment, header.file_size - pos);
+			in(padding.data(), l);
+			pos += l;
+		}
+	}
+
+	CCHFileHeader map_header(const MappedFile&file, unsigned long long magic_number, unsigned section_count, const char*what, const std::string&file_name){
+		if(file.size() < sizeof(CCHFileHeader))
+			throw std::runtime_error(std::string(what)+" file \""+file_name+"\" is too small to contain a header. This file is corrupt.");
+		CCHFileHeader header;
+		memcpy(&header, file.data(), sizeof(header));
+		check_header(header, magic_number, section_count, what);
+		if(header.file_size != file.size())
+			throw std::runtime_error(std::string(what)+" file \""+file_name+"\" has a different size than specified in the header. This file is corrupt.");
+		return header;
+	}
+
+	void check_cch_section_sizes(const CCHFileHeader&header){
+		auto check = [&](unsigned section, unsigned long long byte_count){
+			if(header.section_byte_count[section] != byte_count)
+				throw std::runtime_error("CCH file has an array of the wrong size. This file is corrupt.");
+		};
+		const unsigned long long node_bytes = sizeof(unsigned)*(unsigned long long)header.node_count;
+		const unsigned long long cch_arc_bytes = sizeof(unsigned)*(unsigned long long)header.cch_arc_count;
+		const unsigned long long input_arc_bytes = sizeof(unsigned)*(unsigned long long)header.input_arc_count;
+		check(order_section, node_bytes);
+		check(rank_section, node_bytes);
+		check(elimination_tree_parent_section, node_bytes);
+		check(elimination_tree_depth_section, node_bytes);
+		check(up_first_out_section, node_bytes + sizeof(unsigned));
+		check(up_head_section, cch_arc_bytes);
+		check(up_tail_section, cch_arc_bytes);
+		check(down_first_out_section, node_bytes + sizeof(unsigned));
+		check(down_head_section, cch_arc_bytes);
+		check(down_to_up_section, cch_arc_bytes);
+		check(input_arc_to_cch_arc_section, input_arc_bytes);
+		check(is_input_arc_upward_section, get_bit_vector_byte_count(header.input_arc_count));
+		check(does_cch_arc_have_input_arc_section, get_bit_vector_byte_count(header.cch_arc_count));
+		if(header.section_byte_count[forward_input_arc_of_cch_section] != header.section_byte_count[backward_input_arc_of_cch_section])
+			throw std::runtime_error("CCH file has an array of the wrong size. This file is corrupt.");
+		check(does_cch_arc_have_extra_input_arc_section, get_bit_vector_byte_count(header.cch_arc_count));
+		if(header.section_byte_count[first_extra_forward_input_arc_of_cch_section] != header.section_byte_count[first_extra_backward_input_arc_of_cch_section])
+			throw std::runtime_error("CCH file has an array of the wrong size. This file is corrupt.");
+	}
+
+	// Holds the mapped file of a CustomizableContractionHierarchyView together with the
+	// ID mappers, which are rebuilt from the mapped bit vectors.
+	struct MappedCCH{
+		std::shared_ptr<const MappedFile>file;
+		LocalIDMapper does_cch_arc_have_input_arc_mapper;
+		LocalIDMapper does_cch_arc_have_extra_input_arc_mapper;
+	};
+}
+
+void CustomizableContractionHierarchy::write(std::function<void(const char*, unsigned long long)>out) const {
+	CCHFileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic_number = cch_magic_number;
+	header.version = cch_file_version;
+	header.node_count = node_count();
+	header.cch_arc_count = cch_arc_count();
+	header.input_arc_count = input_arc_count();
+
+	const std::vector<unsigned>*vectors[cch_section_count] = {
+		&order, &rank, &elimination_tree_parent, &elimination_tree_depth,
+		&up_first_out, &up_head, &up_tail,
+		&down_first_out, &down_head, &down_to_up,
+		&input_arc_to_cch_arc, nullptr, nullptr,
+		&forward_input_arc_of_cch, &backward_input_arc_of_cch, nullptr,
+		&first_extra_forward_input_arc_of_cch, &first_extra_backward_input_arc_of_cch,
+		&extra_forward_input_arc_of_cch, &extra_backward_input_arc_of_cch
+	};
+	const BitVector*bit_vectors[cch_section_count] = {};
+	bit_vectors[is_input_arc_upward_section] = &is_input_arc_upward;
+	bit_vectors[does_cch_arc_have_input_arc_section] = &does_cch_arc_have_input_arc;
+	bit_vectors[does_cch_arc_have_extra_input_arc_section] = &does_cch_arc_have_extra_input_arc;
+
+	const char*section_data[cch_section_count];
+	for(unsigned i=0; i<cch_section_count; ++i){
+		if(vectors[i] != nullptr){
+			section_data[i] = (const char*)vectors[i]->data();
+			header.section_byte_count[i] = sizeof(unsigned)*(unsigned long long)vectors[i]->size();
+		}else{
+			section_data[i] = (const char*)bit_vectors[i]->data();
+			header.section_byte_count[i] = get_bit_vector_byte_count(bit_vectors[i]->size());
+		}
+	}
+
+	write_sections(out, header, cch_section_count, section_data);
+}
+
+void CustomizableContractionHierarchy::save_file(const std::string&file_name) const {
+	open_file_for_saving(
+		file_name,
+		[&](std::ostream&out){
+			write(
+				[&](const char*p, unsigned long long l){
+					if(!out.write(p, l))
+						throw std::runtime_error("std::ostream::write failed while writing a CCH");
+				}
+			);
+		}
+	);
+}
+
+CustomizableContractionHierarchy CustomizableContractionHierarchy::read(std::function<void(char*, unsigned long long)>in){
+	CCHFileHeader header;
+	in((char*)&header, sizeof(header));
+	check_header(header, cch_magic_number, cch_section_count, "CCH");
+	check_cch_section_sizes(header);
+
+	CustomizableContractionHierarchy cch;
+	std::vector<unsigned>*vectors[cch_section_count] = {
+		&cch.order, &cch.rank, &cch.elimination_tree_parent, &cch.elimination_tree_depth,
+		&cch.up_first_out, &cch.up_head, &cch.up_tail,
+		&cch.down_first_out, &cch.down_head, &cch.down_to_up,
+		&cch.input_arc_to_cch_arc, nullptr, nullptr,
+		&cch.forward_input_arc_of_cch, &cch.backward_input_arc_of_cch, nullptr,
+		&cch.first_extra_forward_input_arc_of_cch, &cch.first_extra_backward_input_arc_of_cch,
+		&cch.extra_forward_input_arc_of_cch, &cch.extra_backward_input_arc_of_cch
+	};
+
+	cch.is_input_arc_upward = BitVector(header.input_arc_count, BitVector::uninitialized);
+	cch.does_cch_arc_have_input_arc = BitVector(header.cch_arc_count, BitVector::uninitialized);
+	cch.does_cch_arc_have_extra_input_arc = BitVector(header.cch_arc_count, BitVector::uninitialized);
+	BitVector*bit_vectors[cch_section_count] = {};
+	bit_vectors[is_input_arc_upward_section] = &cch.is_input_arc_upward;
+	bit_vectors[does_cch_arc_have_input_arc_section] = &cch.does_cch_arc_have_input_arc;
+	bit_vectors[does_cch_arc_have_extra_input_arc_section] = &cch.does_cch_arc_have_extra_input_arc;
+
+	read_sections(
+		in, header, cch_section_count,
+		[&](unsigned section, unsigned long long byte_count)->char*{
+			if(vectors[section] != nullptr){
+				vectors[section]->resize(byte_count/sizeof(unsigned));
+				return (char*)vectors[section]->data();
+			}else{
+				return (char*)bit_vectors[section]->data();
+			}
+		}
+	);
+
+	cch.does_cch_arc_have_input_arc_mapper = LocalIDMapper(cch.does_cch_arc_have_input_arc);
+	cch.does_cch_arc_have_extra_input_arc_mapper = LocalIDMapper(cch.does_cch_arc_have_extra_input_arc);
+
+	return cch; // NVRO
+}
+
+CustomizableContractionHierarchy CustomizableContractionHierarchy::load_file(const std::string&file_name){
+	CustomizableContractionHierarchy cch;
+	open_file_for_loading(
+		file_name,
+		[&](std::istream&in, unsigned long long file_size){
+			cch = read(
+				[&](char*p, unsigned long long l){
+					if(!in.read(p, l))
+						throw std::runtime_error("std::istream::read failed while reading a CCH. Is the file truncated?");
+				}
+			);
+		}
+	);
+	return cch; // NVRO
+}
+
+CustomizableContractionHierarchyView::CustomizableContractionHierarchyView(const CustomizableContractionHierarchy&cch):
+	order(cch.order), rank(cch.rank),
+	elimination_tree_parent(cch.elimination_tree_parent), elimination_tree_depth(cch.elimination_tree_depth),
+	up_first_out(cch.up_first_out), up_head(cch.up_head), up_tail(cch.up_tail),
+	down_first_out(cch.down_first_out), down_head(cch.down_head), down_to_up(cch.down_to_up),
+	input_arc_to_cch_arc(cch.input_arc_to_cch_arc), is_input_arc_upward(cch.is_input_arc_upward),
+	does_cch_arc_have_input_arc(cch.does_cch_arc_have_input_arc), does_cch_arc_have_input_arc_mapper(&cch.does_cch_arc_have_input_arc_mapper),
+	forward_input_arc_of_cch(cch.forward_input_arc_of_cch), backward_input_arc_of_cch(cch.backward_input_arc_of_cch),
+	does_cch_arc_have_extra_input_arc(cch.does_cch_arc_have_extra_input_arc), does_cch_arc_have_extra_input_arc_mapper(&cch.does_cch_arc_have_extra_input_arc_mapper),
+	first_extra_forward_input_arc_of_cch(cch.first_extra_forward_input_arc_of_cch), first_extra_backward_input_arc_of_cch(cch.first_extra_backward_input_arc_of_cch),
+	extra_forward_input_arc_of_cch(cch.extra_forward_input_arc_of_cch), extra_backward_input_arc_of_cch(cch.extra_backward_input_arc_of_cch){}
+
+CustomizableContractionHierarchyView CustomizableContractionHierarchyView::map_file(const std::string&file_name){
+	auto mapped = std::make_shared<MappedCCH>();
+	mapped->file = RoutingKit::map_file(file_name);
+	const MappedFile&file = *mapped->file;
+
+	CCHFileHeader header = map_header(file, cch_magic_number, cch_section_count, "CCH", file_name);
+	check_cch_section_sizes(header);
+
+	auto get_vector = [&](unsigned section){
+		return ConstVectorView<unsigned>((const unsigned*)(file.data() + header.section_begin[section]), header.section_byte_count[section]/sizeof(unsigned));
+	};
+
+	auto get_bit_vector = [&](unsigned section, unsigned bit_count){
+		return ConstBitVectorView((const uint64_t*)(file.data() + header.section_begin[section]), bit_count);
+	};
+
+	CustomizableContractionHierarchyView cch;
+	cch.order = get_vector(order_section);
+	cch.rank = get_vector(rank_section);
+	cch.elimination_tree_parent = get_vector(elimination_tree_parent_section);
+	cch.elimination_tree_depth = get_vector(elimination_tree_depth_section);
+	cch.up_first_out = get_vector(up_first_out_section);
+	cch.up_head = get_vector(up_head_section);
+	cch.up_tail = get_vector(up_tail_section);
+	cch.down_first_out = get_vector(down_first_out_section);
+	cch.down_head = get_vector(down_head_section);
+	cch.down_to_up = get_vector(down_to_up_section);
+	cch.input_arc_to_cch_arc = get_vector(input_arc_to_cch_arc_section);
+	cch.is_input_arc_upward = get_bit_vector(is_input_arc_upward_section, header.input_arc_count);
+	cch.does_cch_arc_have_input_arc = get_bit_vector(does_cch_arc_have_input_arc_section, header.cch_arc_count);
+	cch.forward_input_arc_of_cch = get_vector(forward_input_arc_of_cch_section);
+	cch.backward_input_arc_of_cch = get_vector(backward_input_arc_of_cch_section);
+	cch.does_cch_arc_have_extra_input_arc = get_bit_vector(does_cch_arc_have_extra_input_arc_section, header.cch_arc_count);
+	cch.first_extra_forward_input_arc_of_cch = get_vector(first_extra_forward_input_arc_of_cch_section);
+	cch.first_extra_backward_input_arc_of_cch = get_vector(first_extra_backward_input_arc_of_cch_section);
+	cch.extra_forward_input_arc_of_cch = get_vector(extra_forward_input_arc_of_cch_section);
+	cch.extra_backward_input_arc_of_cch = get_vector(extra_backward_input_arc_of_cch_section);
+
+	if(cch.up_first_out[header.node_count] != header.cch_arc_count || cch.down_first_out[header.node_count] != header.cch_arc_count)
+		throw std::runtime_error("CCH file \""+file_name+"\" has inconsistent arc counts. This file is corrupt.");
+
+	mapped->does_cch_arc_have_input_arc_mapper = LocalIDMapper(header.cch_arc_count, cch.does_cch_arc_have_input_arc.data());
+	mapped->does_cch_arc_have_extra_input_arc_mapper = LocalIDMapper(header.cch_arc_count, cch.does_cch_arc_have_extra_input_arc.data());
+	cch.does_cch_arc_have_input_arc_mapper = &mapped->does_cch_arc_have_input_arc_mapper;
+	cch.does_cch_arc_have_extra_input_arc_mapper = &mapped->does_cch_arc_have_extra_input_arc_mapper;
+
+	if(cch.forward_input_arc_of_cch.size() != cch.does_cch_arc_have_input_arc_mapper->local_id_count())
+		throw std::runtime_error("CCH file \""+file_name+"\" has inconsistent input arc counts. This file is corrupt.");
+
+	cch.mapped_file = std::move(mapped);
+
+	return cch; // NVRO
+}
+
+namespace{
+	CCHFileHeader make_metric_header(unsigned node_count, unsigned cch_arc_count){
+		CCHFileHeader header;
+		memset(&header, 0, sizeof(header));
+		header.magic_number = cch_metric_magic_number;
+		header.version = cch_file_version;
+		header.node_count = node_count;
+		header.cch_arc_count = cch_arc_count;
+		header.section_byte_count[forward_section] = sizeof(unsigned)*(unsigned long long)cch_arc_count;
+		header.section_byte_count[backward_section] = sizeof(unsigned)*(unsigned long long)cch_arc_count;
+		return header;
+	}
+
+	void check_metric_header(const CCHFileHeader&header, unsigned node_count, unsigned cch_arc_count){
+		CCHFileHeader expected = make_metric_header(node_count, cch_arc_count);
+		if(header.node_count != node_count || header.cch_arc_count != cch_arc_count)
+			throw std::runtime_error("CCH metric file was saved for a different CCH.");
+		for(unsigned i=0; i<cch_metric_section_count; ++i)
+			if(header.section_byte_count[i] != expected.section_byte_count[i])
+				throw std::runtime_error("CCH metric file has an array of the wrong size. This file is corrupt.");
+	}
+}
+
+void CustomizableContractionHierarchyMetric::write(std::function<void(const char*, unsigned long long)>out) const {
+	assert(forward.size() == cch->cch_arc_count() && "metric must be customized before it is saved");
+	const char*section_data[cch_metric_section_count] = {
+		(const char*)forward.data(),
+		(const char*)backward.data()
+	};
+	write_sections(out, make_metric_header(cch->node_count(), cch->cch_arc_count()), cch_metric_section_count, section_data);
+}
+
+void CustomizableContractionHierarchyMetric::save_file(const std::string&file_name) const {
+	open_file_for_saving(
+		file_name,
+		[&](std::ostream&out){
+			write(
+				[&](const char*p, unsigned long long l){
+					if(!out.write(p, l))
+						throw std::runtime_error("std::ostream::write failed while writing a CCH metric");
+				}
+			);
+		}
+	);
+}
+
+CustomizableContractionHierarchyMetric& CustomizableContractionHierarchyMetric::read(std::function<void(char*, unsigned long long)>in){
+	CCHFileHeader header;
+	in((char*)&header, sizeof(header));
+	check_header(header, cch_metric_magic_number, cch_metric_section_count, "CCH metric");
+	check_metric_header(header, cch->node_count(), cch->cch_arc_count());
+
+	forward.resize(cch->cch_arc_count());
+	backward.resize(cch->cch_arc_count());
+	read_sections(
+		in, header, cch_metric_section_count,
+		[&](unsigned section, unsigned long long)->char*{
+			return (char*)(section == forward_section ? forward.data() : backward.data());
+		}
+	);
+	return *this;
+}
+
+CustomizableContractionHierarchyMetric& CustomizableContractionHierarchyMetric::load_file(const std::string&file_name){
+	open_file_for_loading(
+		file_name,
+		[&](std::istream&in, unsigned long long file_size){
+			read(
+				[&](char*p, unsigned long long l){
+					if(!in.read(p, l))
+						throw std::runtime_error("std::istream::read failed while reading a CCH metric. Is the file truncated?");
+				}
+			);
+		}
+	);
+	return *this;
+}
+
+CustomizableContractionHierarchyMetricView::CustomizableContractionHierarchyMetricView(const CustomizableContractionHierarchyMetric&metric):
+	forward(metric.forward), backward(metric.backward), cch(*metric.cch), input_weight(metric.input_weight){}
+
+CustomizableContractionHierarchyMetricView CustomizableContractionHierarchyMetricView::map_file(CustomizableContractionHierarchyView cch, const std::string&file_name, const unsigned*input_weight){
+	auto file = RoutingKit::map_file(file_name);
+
+	CCHFileHeader header = map_header(*file, cch_metric_magic_number, cch_metric_section_count, "CCH metric", file_name);
+	check_metric_header(header, cch.node_count(), cch.cch_arc_count());
+
+	CustomizableContractionHierarchyMetricView metric;
+	metric.forward = ConstVectorView<unsigned>((const unsigned*)(file->data() + header.section_begin[forward_section]), header.cch_arc_count);
+	metric.backward = ConstVectorView<unsigned>((const unsigned*)(file->data() + header.section_begin[backward_section]), header.cch_arc_count);
+	metric.cch = std::move(cch);
+	metric.input_weight = input_weight;
+	metric.mapped_file = std::move(file);
+	return metric; // NVRO
+}
+
+CustomizableContractionHierarchyMetricManager::CustomizableContractionHierarchyMetricManager(const CustomizableContractionHierarchy&cch, std::vector<unsigned>input_weight, unsigned thread_count):
+	cch(&cch), free_buffers(std::make_shared<FreeBufferList>()), last_epoch(0), partial_customization(cch){
+	customize(std::move(input_weight), thread_count);
+}
+
+CustomizableContractionHierarchyMetricView CustomizableContractionHierarchyMetricManager::get_metric(unsigned long long*epoch)const{
+	std::shared_ptr<Buffer>buffer = std::atomic_load(&current);
+	assert(buffer != nullptr && "The manager has no metric");
+	if(epoch != nullptr)
+		*epoch = buffer->epoch;
+	CustomizableContractionHierarchyMetricView view(buffer->metric);
+	view.mapped_file = std::move(buffer);
+	return view; // NVRO
+}
+
+unsigned long long CustomizableContractionHierarchyMetricManager::get_epoch()const{
+	std::shared_ptr<Buffer>buffer = std::atomic_load(&current);
+	return buffer == nullptr ? 0 : buffer->epoch;
+}
+
+unsigned CustomizableContractionHierarchyMetricManager::get_buffer_count()const{
+	if(free_buffers == nullptr)
+		return 0;
+	std::lock_guard<std::mutex>guard(free_buffers->lock);
+	return free_buffers->allocated_buffer_count;
+}
+
+std::unique_ptr<CustomizableContractionHierarchyMetricManager::Buffer>CustomizableContractionHierarchyMetricManager::acquire_back_buffer(){
+	// One free buffer is reused and the others are freed outside of the lock.
+	std::unique_ptr<Buffer>back;
+	std::vector<std::unique_ptr<Buffer>>unused;
+	{
+		std::lock_guard<std::mutex>guard(free_buffers->lock);
+		if(free_buffers->buffer.empty()){
+			back.reset(new Buffer);
+			++free_buffers->allocated_buffer_count;
+			free_buffers->buffer.reserve(free_buffers->allocated_buffer_count);
+		}else{
+			back = std::move(free_buffers->buffer.back());
+			free_buffers->buffer.pop_back();
+			free_buffers->allocated_buffer_count -= free_buffers->buffer.size();
+			for(auto&b:free_buffers->buffer)
+				unused.push_back(std::move(b));
+			free_buffers->buffer.clear();
+		}
+	}
+	return back; // NVRO
+}
+
+unsigned long long CustomizableContractionHierarchyMetricManager::publish(std::unique_ptr<Buffer>buffer){
+	buffer->epoch = ++last_epoch;
+	std::shared_ptr<FreeBufferList>list = free_buffers;
+	std::shared_ptr<Buffer>shared_buffer(
+		buffer.release(),
+		[list](Buffer*b){
+			std::lock_guard<std::mutex>guard(list->lock);
+			list->buffer.emplace_back(b);
+		}
+	);
+	// If no view refers to the old buffer, it is moved into the free list when old is destroyed.
+	std::shared_ptr<Buffer>old = std::atomic_load(&current);
+	std::atomic_store(&current, std::move(shared_buffer));
+	return last_epoch;
+}
+
+unsigned long long CustomizableContractionHierarchyMetricManager::customize(std::vector<unsigned>input_weight, unsigned thread_count){
+	assert(cch != nullptr && "Manager must be attached to a CCH");
+	assert(input_weight.size() == cch->input_arc_count() && "Input weight vector has the wrong size");
+	assert(thread_count != 0);
+
+	std::lock_guard<std::mutex>guard(writer_lock);
+
+	std::unique_ptr<Buffer>back = acquire_back_buffer();
+	back->input_weight = std::move(input_weight);
+	back->metric.reset(*cch, back->input_weight.data());
+
+	#ifdef _OPENMP
+	if(thread_count > 1){
+		if(parallelization.first_arc_of_level.empty())
+			parallelization.reset(*cch);
+		parallelization.customize(back->metric, thread_count);
+	}else
+	#endif
+	{
+		back->metric.customize();
+	}
+
+	return publish(std::move(back));
+}
+
+unsigned long long CustomizableContractionHierarchyMetricManager::update_arcs(const std::vector<unsigned>&arc, const std::vector<unsigned>&new_weight, unsigned thread_count){
+	assert(cch != nullptr && "Manager must be attached to a CCH");
+	assert(arc.size() == new_weight.size() && "Need one weight per arc");
+	assert(thread_count != 0);
+
+	std::lock_guard<std::mutex>guard(writer_lock);
+
+	std::shared_ptr<Buffer>front = std::atomic_load(&current);
+	std::unique_ptr<Buffer>back = acquire_back_buffer();
+
+	back->input_weight = front->input_weight;
+	back->metric.reset(*cch, back->input_weight.data());
+	back->metric.forward = front->metric.forward;
+	back->metric.backward = front->metric.backward;
+
+	partial_customization.reset();
+	for(unsigned i=0; i<arc.size(); ++i){
+		assert(arc[i] < cch->input_arc_count() && "arc out of bounds");
+		back->input_weight[arc[i]] = new_weight[i];
+		partial_customization.update_arc(arc[i]);
+	}
+
+	if(thread_count == 1)
+		partial_customization.customize(back->metric);
+	else
+		partial_customization.customize(back->metric, thread_count);
+
+	return publish(std::move(back));
+}
+
+namespace{
+	const unsigned query_state_initialized = 0;
+	const unsigned query_state_run = 1;
+	const unsigned query_state_source_pinned = 2;
+	const unsigned query_state_source_run = 3;
+	const unsigned query_state_target_pinned = 4;
+	const unsigned query_state_target_run = 5;
+}
+
+namespace{
+
+	template<class F>
+	void forall_ancestors(ConstVectorView<unsigned>parent, unsigned x, unsigned stop_at, const F&f){
+		assert(x < parent.size());
+		assert(stop_at < parent.size() || stop_at == invalid_id);
+
+		while(x != stop_at){
+			assert(x < parent.size() && "stop_at is not an ancestor of x");
+			if(!f(x))
+				return;
+			assert(parent[x] > x);
+			x = parent[x];
+		}
+	}
+
+	template<class F>
+	void forall_ancestors(ConstVectorView<unsigned>parent, unsigned x, const F&f){
+		forall_ancestors(parent, x, invalid_id, f);
+	}
+
+
+	void reset_source_list(
+		ConstVectorView<unsigned>elimination_tree_parent,
+		std::vector<unsigned>&source_node, std::vector<unsigned>&source_elimination_tree_end,
+		std::vector<bool>&in_forward_search_space, std::vector<unsigned>&forward_tentative_distance
+	){
+		for(unsigned i=0; i<source_node.size(); ++i){
+			forall_ancestors(
 				elimination_tree_parent,
 				source_node[i], source_elimination_tree_end[i],
 				[&](unsigned x){
@@ -1093,22 +2113,37 @@ namespace{
 }
 
 CustomizableContractionHierarchyQuery::CustomizableContractionHierarchyQuery(const CustomizableContractionHierarchyMetric&metric):
-	forward_tentative_distance(metric.cch->node_count(), inf_weight),
-	backward_tentative_distance(metric.cch->node_count(), inf_weight),
-	forward_predecessor_node(metric.cch->node_count()),
-	backward_predecessor_node(metric.cch->node_count()),
-	in_forward_search_space(metric.cch->node_count(), false),
-	in_backward_search_space(metric.cch->node_count(), false),
+	CustomizableContractionHierarchyQuery(CustomizableContractionHierarchyMetricView(metric)){
+	owning_metric = &metric;
+}
+
+CustomizableContractionHierarchyQuery::CustomizableContractionHierarchyQuery(CustomizableContractionHierarchyMetricView metric):
+	forward_tentative_distance(metric.cch.node_count(), inf_weight),
+	backward_tentative_distance(metric.cch.node_count(), inf_weight),
+	forward_predecessor_node(metric.cch.node_count()),
+	backward_predecessor_node(metric.cch.node_count()),
+	in_forward_search_space(metric.cch.node_count(), false),
+	in_backward_search_space(metric.cch.node_count(), false),
 	shortest_path_meeting_node(invalid_id),
+	use_pruning(false), use_stall_on_demand(false),
+	scanned_node_count(0), pruned_node_count(0), stalled_node_count(0), relaxed_arc_count(0),
 	cch(metric.cch),
-	metric(&metric),
-	state(query_state_initialized){}
+	metric(std::move(metric)),
+	state(query_state_initialized),
+	owning_metric(nullptr){}
+
+void CustomizableContractionHierarchyQuery::update_metric_from_owning_metric(){
+	if(owning_metric != nullptr){
+		metric = CustomizableContractionHierarchyMetricView(*owning_metric);
+		assert(metric.cch.up_head.data() == cch.up_head.data() && "The metric was attached to another CCH since the last reset");
+	}
+}
 
 namespace{
 	void internal_add_source(
 		unsigned external_s, unsigned dist_to_s,
-		const std::vector<unsigned>&rank,
-		const std::vector<unsigned>&elimination_tree_parent,
+		ConstVectorView<unsigned>rank,
+		ConstVectorView<unsigned>elimination_tree_parent,
 		std::vector<unsigned>&forward_tentative_distance,
 		std::vector<unsigned>&forward_predecessor_node,
 		std::vector<bool>&in_forward_search_space,
@@ -1147,12 +2182,12 @@ namespace{
 
 
 CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::add_source(unsigned external_s, unsigned dist_to_s){
-	assert(external_s < cch->node_count());
+	assert(external_s < cch.node_count());
 	assert(state == query_state_initialized || state == query_state_target_pinned);
 	internal_add_source(
 		external_s, dist_to_s,
-		cch->rank,
-		cch->elimination_tree_parent,
+		cch.rank,
+		cch.elimination_tree_parent,
 		forward_tentative_distance,
 		forward_predecessor_node,
 		in_forward_search_space,
@@ -1163,12 +2198,12 @@ CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::ad
 }
 
 CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::add_target(unsigned external_t, unsigned dist_to_t){
-	assert(external_t < cch->node_count());
+	assert(external_t < cch.node_count());
 	assert(state == query_state_initialized || state == query_state_source_pinned);
 	internal_add_source(
 		external_t, dist_to_t,
-		cch->rank,
-		cch->elimination_tree_parent,
+		cch.rank,
+		cch.elimination_tree_parent,
 		backward_tentative_distance,
 		backward_predecessor_node,
 		in_backward_search_space,
@@ -1181,9 +2216,9 @@ CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::ad
 namespace{
 	template<class SetPred>
 	void relax_outgoing_arcs(
-		const std::vector<unsigned>&first_out,
-		const std::vector<unsigned>&head,
-		const std::vector<unsigned>&weight,
+		ConstVectorView<unsigned>first_out,
+		ConstVectorView<unsigned>head,
+		ConstVectorView<unsigned>weight,
 		std::vector<unsigned>&tentative_distance,
 		const SetPred&set_node_predecessor,
 		unsigned x
@@ -1200,9 +2235,9 @@ namespace{
 
 	template<class SetPred>
 	void relax_incoming_arcs(
-		const std::vector<unsigned>&first_out,
-		const std::vector<unsigned>&head,
-		const std::vector<unsigned>&weight,
+		ConstVectorView<unsigned>first_out,
+		ConstVectorView<unsigned>head,
+		ConstVectorView<unsigned>weight,
 		std::vector<unsigned>&tentative_distance,
 		const SetPred&set_node_predecessor,
 		unsigned x
@@ -1218,17 +2253,156 @@ namespace{
 }
 
 
+namespace{
+	// Collects the nodes on the elimination tree paths of the sources ordered by rank. The
+	// paths are disjoint by construction.
+	void collect_search_space(
+		ConstVectorView<unsigned>elimination_tree_parent,
+		const std::vector<unsigned>&source_node, const std::vector<unsigned>&source_elimination_tree_end,
+		std::vector<unsigned>&search_space
+	){
+		search_space.clear();
+		for(unsigned i=0; i<source_node.size(); ++i){
+			forall_ancestors(
+				elimination_tree_parent,
+				source_node[i], source_elimination_tree_end[i],
+				[&](unsigned x){
+					search_space.push_back(x);
+					return true;
+				}
+			);
+		}
+		if(source_node.size() > 1)
+			std::sort(search_space.begin(), search_space.end());
+	}
+
+	// The tentative distances of higher nodes are lengths of actual paths. If one of them
+	// plus the arc down to x is shorter than the tentative distance of x, then x is not on
+	// any shortest up-down path in the role in which it is reached.
+	bool can_stall_at_node(
+		ConstVectorView<unsigned>up_first_out, ConstVectorView<unsigned>up_head,
+		ConstVectorView<unsigned>reverse_weight,
+		const std::vector<unsigned>&tentative_distance,
+		unsigned x
+	){
+		for(unsigned xy=up_first_out[x]; xy<up_first_out[x+1]; ++xy)
+			if(tentative_distance[up_head[xy]] + reverse_weight[xy] < tentative_distance[x])
+				return true;
+		return false;
+	}
+}
+
+CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::set_pruning(bool enabled){
+	use_pruning = enabled;
+	return *this;
+}
+
+CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::set_stall_on_demand(bool enabled){
+	use_stall_on_demand = enabled;
+	return *this;
+}
+
+unsigned CustomizableContractionHierarchyQuery::get_scanned_node_count()const{
+	return scanned_node_count;
+}
+
+unsigned CustomizableContractionHierarchyQuery::get_pruned_node_count()const{
+	return pruned_node_count;
+}
+
+unsigned CustomizableContractionHierarchyQuery::get_stalled_node_count()const{
+	return stalled_node_count;
+}
+
+unsigned CustomizableContractionHierarchyQuery::get_relaxed_arc_count()const{
+	return relaxed_arc_count;
+}
+
 CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::run(){
 	assert(state == query_state_initialized);
+	update_metric_from_owning_metric();
+
+	scanned_node_count = 0;
+	pruned_node_count = 0;
+	stalled_node_count = 0;
+	relaxed_arc_count = 0;
+
+	if(use_pruning || use_stall_on_demand){
+		collect_search_space(cch.elimination_tree_parent, source_node, source_elimination_tree_end, forward_search_space);
+		collect_search_space(cch.elimination_tree_parent, target_node, target_elimination_tree_end, backward_search_space);
+
+		shortest_path_meeting_node = invalid_id;
+		unsigned shortest_path_length = inf_weight;
+
+		// Every node is processed after all nodes below it. Its tentative distances are
+		// therefore final when it is reached.
+		auto relax_if_useful = [&](
+			ConstVectorView<unsigned>weight, ConstVectorView<unsigned>reverse_weight,
+			std::vector<unsigned>&tentative_distance, std::vector<unsigned>&predecessor_node,
+			unsigned x
+		){
+			if(tentative_distance[x] >= shortest_path_length){
+				if(use_pruning || tentative_distance[x] == inf_weight){
+					++pruned_node_count;
+					return;
+				}
+			}
+			if(use_stall_on_demand && can_stall_at_node(cch.up_first_out, cch.up_head, reverse_weight, tentative_distance, x)){
+				++stalled_node_count;
+				return;
+			}
+			relaxed_arc_count += cch.up_first_out[x+1] - cch.up_first_out[x];
+			relax_outgoing_arcs(
+				cch.up_first_out, cch.up_head, weight,
+				tentative_distance, [&](unsigned a, unsigned b){predecessor_node[a] = b;},
+				x
+			);
+		};
+
+		unsigned i = 0, j = 0;
+		while(i < forward_search_space.size() || j < backward_search_space.size()){
+			unsigned x;
+			if(j == backward_search_space.size() || (i < forward_search_space.size() && forward_search_space[i] <= backward_search_space[j]))
+				x = forward_search_space[i];
+			else
+				x = backward_search_space[j];
+
+			bool is_forward = i < forward_search_space.size() && forward_search_space[i] == x;
+			bool is_backward = j < backward_search_space.size() && backward_search_space[j] == x;
+
+			if(is_forward && is_backward){
+				unsigned l = forward_tentative_distance[x] + backward_tentative_distance[x];
+				if(l < shortest_path_length){
+					shortest_path_length = l;
+					shortest_path_meeting_node = x;
+				}
+			}
+
+			if(is_forward){
+				++scanned_node_count;
+				relax_if_useful(metric.forward, metric.backward, forward_tentative_distance, forward_predecessor_node, x);
+				++i;
+			}
+			if(is_backward){
+				++scanned_node_count;
+				relax_if_useful(metric.backward, metric.forward, backward_tentative_distance, backward_predecessor_node, x);
+				++j;
+			}
+		}
+
+		state = query_state_run;
+		return *this;
+	}
 
 	for(unsigned i = source_node.size()-1; i!=(unsigned)-1; --i){
 		forall_ancestors(
-			cch->elimination_tree_parent,
+			cch.elimination_tree_parent,
 			source_node[i], source_elimination_tree_end[i],
 			[&](unsigned x){
-
+				++scanned_node_count;
+				relaxed_arc_count += cch.up_first_out[x+1] - cch.up_first_out[x];
 				relax_outgoing_arcs(
-					cch->up_first_out, cch->up_head, metric->forward,
+					cch.up_first_out, cch.up_head, metric.forward,
 					forward_tentative_distance, [&](unsigned a, unsigned b){forward_predecessor_node[a] = b;},
 					x
 				);
@@ -1237,10 +2411,10 @@ CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::ru
 		);
 	}
 
-//	for(unsigned x=0; x<cch->node_count(); ++x){
-//		for(unsigned xy=cch->up_first_out[x]; xy < cch->up_first_out[x+1]; ++xy){
-//			unsigned y = cch->up_head[xy];
-//			assert(forward_tentative_distance[y] <= forward_tentative_distance[x] + metric->forward[xy] && "not all forward arcs relaxed");
+//	for(unsigned x=0; x<cch.node_count(); ++x){
+//		for(unsigned xy=cch.up_first_out[x]; xy < cch.up_first_out[x+1]; ++xy){
+//			unsigned y = cch.up_head[xy];
+//			assert(forward_tentative_distance[y] <= forward_tentative_distance[x] + metric.forward[xy] && "not all forward arcs relaxed");
 //		}
 //	}
 
@@ -1249,11 +2423,13 @@ CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::ru
 
 	for(unsigned i = target_node.size()-1; i!=(unsigned)-1; --i){
 		forall_ancestors(
-			cch->elimination_tree_parent,
+			cch.elimination_tree_parent,
 			target_node[i], target_elimination_tree_end[i],
 			[&](unsigned x){
+				++scanned_node_count;
+				relaxed_arc_count += cch.up_first_out[x+1] - cch.up_first_out[x];
 				relax_outgoing_arcs(
-					cch->up_first_out, cch->up_head, metric->backward,
+					cch.up_first_out, cch.up_head, metric.backward,
 					backward_tentative_distance, [&](unsigned a, unsigned b){backward_predecessor_node[a] = b;},
 					x
 				);
@@ -1269,7 +2445,7 @@ CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::ru
 		);
 	}
 
-//	for(unsigned x=0; x < cch->node_count(); ++x){
+//	for(unsigned x=0; x < cch.node_count(); ++x){
 //		unsigned l = forward_tentative_distance[x] + backward_tentative_distance[x];
 //		assert(l >= shortest_path_length);
 //	}
@@ -1295,7 +2471,7 @@ unsigned CustomizableContractionHierarchyQuery::get_used_source(){
 		while(forward_predecessor_node[x] != invalid_id){
 			x = forward_predecessor_node[x];
 		}
-		return cch->order[x];
+		return cch.order[x];
 	}
 }
 
@@ -1308,7 +2484,7 @@ unsigned CustomizableContractionHierarchyQuery::get_used_target(){
 		while(backward_predecessor_node[x] != invalid_id){
 			x = backward_predecessor_node[x];
 		}
-		return cch->order[x];
+		return cch.order[x];
 	}
 }
 
@@ -1341,7 +2517,7 @@ namespace{
 
 	template<class OnNewSegment>
 	void unpack_arc(
-		const CustomizableContractionHierarchy&cch, const CustomizableContractionHierarchyMetric&metric,
+		const CustomizableContractionHierarchyView&cch, const CustomizableContractionHierarchyMetricView&metric,
 		bool is_forward,
 		unsigned x, unsigned y, unsigned xy,
 		const OnNewSegment&on_new_segment
@@ -1391,63 +2567,92 @@ namespace{
 		}
 	}
 
-	template<class OnNewSegment>
-	unsigned unpack_shortest_path(
-		const CustomizableContractionHierarchy&cch, const CustomizableContractionHierarchyMetric&metric, const CustomizableContractionHierarchyQuery&query,
-		const OnNewSegment&on_new_segment
+	// Calls on_arc(x, y, xy, is_forward) for the CCH arcs of the shortest path in path order.
+	// Returns the last node of the path.
+	template<class GetForwardPredecessor, class GetBackwardPredecessor, class OnArc>
+	unsigned forall_cch_arcs_of_shortest_path(
+		const CustomizableContractionHierarchyView&cch,
+		unsigned shortest_path_meeting_node,
+		const GetForwardPredecessor&get_forward_predecessor, const GetBackwardPredecessor&get_backward_predecessor,
+		const OnArc&on_arc
 	){
-		if(query.shortest_path_meeting_node == invalid_id)
+		if(shortest_path_meeting_node == invalid_id)
 			return invalid_id;
 
 		{
-			std::vector<unsigned>up_path = {query.shortest_path_meeting_node};
+			std::vector<unsigned>up_path = {shortest_path_meeting_node};
 
-			unsigned x = query.shortest_path_meeting_node;
-			while(query.forward_predecessor_node[x] != invalid_id){
-				x = query.forward_predecessor_node[x];
+			unsigned x = shortest_path_meeting_node;
+			while(get_forward_predecessor(x) != invalid_id){
+				x = get_forward_predecessor(x);
 				up_path.push_back(x);
 			}
 
 			for(unsigned i=up_path.size()-1; i!=0; --i){
-				unpack_arc(
-					cch, metric,
-					true,
+				on_arc(
 					up_path[i], up_path[i-1], find_arc_given_sorted_head(cch.up_first_out, cch.up_head, up_path[i], up_path[i-1]),
-					on_new_segment
+					true
 				);
 			}
 		}
 		{
-			unsigned x = query.shortest_path_meeting_node;
-			unsigned y = query.backward_predecessor_node[x];
+			unsigned x = shortest_path_meeting_node;
+			unsigned y = get_backward_predecessor(x);
 			while(y != invalid_id){
-				unpack_arc(
-					cch, metric,
-					false,
+				on_arc(
 					y, x, find_arc_given_sorted_head(cch.up_first_out, cch.up_head, y, x),
-					on_new_segment
+					false
 				);
 				x = y;
-				y = query.backward_predecessor_node[y];
+				y = get_backward_predecessor(y);
 			}
 			return x;
 		}
 	}
+
+	template<class GetForwardPredecessor, class GetBackwardPredecessor, class OnNewSegment>
+	unsigned unpack_shortest_path(
+		const CustomizableContractionHierarchyView&cch, const CustomizableContractionHierarchyMetricView&metric,
+		unsigned shortest_path_meeting_node,
+		const GetForwardPredecessor&get_forward_predecessor, const GetBackwardPredecessor&get_backward_predecessor,
+		const OnNewSegment&on_new_segment
+	){
+		return forall_cch_arcs_of_shortest_path(
+			cch, shortest_path_meeting_node,
+			get_forward_predecessor, get_backward_predecessor,
+			[&](unsigned x, unsigned y, unsigned xy, bool is_forward){
+				unpack_arc(cch, metric, is_forward, x, y, xy, on_new_segment);
+			}
+		);
+	}
+
+	template<class OnNewSegment>
+	unsigned unpack_shortest_path(
+		const CustomizableContractionHierarchyView&cch, const CustomizableContractionHierarchyMetricView&metric, const CustomizableContractionHierarchyQuery&query,
+		const OnNewSegment&on_new_segment
+	){
+		return unpack_shortest_path(
+			cch, metric, query.shortest_path_meeting_node,
+			[&](unsigned x){return query.forward_predecessor_node[x];},
+			[&](unsigned x){return query.backward_predecessor_node[x];},
+			on_new_segment
+		);
+	}
 }
 
 std::vector<unsigned>CustomizableContractionHierarchyQuery::get_node_path(){
 	assert(state == query_state_run);
 	std::vector<unsigned>path;
 	unsigned last = unpack_shortest_path(
-		*cch, *metric, *this,
+		cch, metric, *this,
 		[&](unsigned cch_node, unsigned cch_arc, bool forward){
-			path.push_back(cch->order[cch_node]);
+			path.push_back(cch.order[cch_node]);
 			(void)forward;
 			(void)cch_arc;
 		}
 	);
 	if(last != invalid_id)
-		path.push_back(cch->order[last]);
+		path.push_back(cch.order[last]);
 	return path; // NVRO
 }
 
@@ -1456,18 +2661,18 @@ namespace{
 	// exists and has the same length as the cch_arc
 
 	unsigned unpack_original_forward_arc(
-		const CustomizableContractionHierarchy&cch, const CustomizableContractionHierarchyMetric&metric,
+		const CustomizableContractionHierarchyView&cch, const CustomizableContractionHierarchyMetricView&metric,
 		unsigned cch_arc
 	){
 		if(cch.does_cch_arc_have_input_arc.is_set(cch_arc)){
-			unsigned i = cch.does_cch_arc_have_input_arc_mapper.to_local(cch_arc);
+			unsigned i = cch.does_cch_arc_have_input_arc_mapper->to_local(cch_arc);
 			if(cch.forward_input_arc_of_cch[i] != invalid_id){
 				unsigned original_arc = cch.forward_input_arc_of_cch[i];
 				if(metric.forward[cch_arc] == metric.input_weight[original_arc])
 					return original_arc;
 
 				if(cch.does_cch_arc_have_extra_input_arc.is_set(cch_arc)){
-					unsigned j = cch.does_cch_arc_have_extra_input_arc_mapper.to_local(cch_arc);
+					unsigned j = cch.does_cch_arc_have_extra_input_arc_mapper->to_local(cch_arc);
 					for(unsigned k = cch.first_extra_forward_input_arc_of_cch[j]; k < cch.first_extra_forward_input_arc_of_cch[j+1]; ++k){
 						unsigned original_arc = cch.extra_forward_input_arc_of_cch[k];
 						if(metric.forward[cch_arc] == metric.input_weight[original_arc])
@@ -1480,17 +2685,17 @@ namespace{
 	}
 
 	unsigned unpack_original_backward_arc(
-		const CustomizableContractionHierarchy&cch, const CustomizableContractionHierarchyMetric&metric,
+		const CustomizableContractionHierarchyView&cch, const CustomizableContractionHierarchyMetricView&metric,
 		unsigned cch_arc
 	){
 		if(cch.does_cch_arc_have_input_arc.is_set(cch_arc)){
-			unsigned i = cch.does_cch_arc_have_input_arc_mapper.to_local(cch_arc);
+			unsigned i = cch.does_cch_arc_have_input_arc_mapper->to_local(cch_arc);
 			if(cch.backward_input_arc_of_cch[i] != invalid_id){
 				unsigned original_arc = cch.backward_input_arc_of_cch[i];
 				if(metric.backward[cch_arc] == metric.input_weight[original_arc])
 					return original_arc;
 				if(cch.does_cch_arc_have_extra_input_arc.is_set(cch_arc)){
-					unsigned j = cch.does_cch_arc_have_extra_input_arc_mapper.to_local(cch_arc);
+					unsigned j = cch.does_cch_arc_have_extra_input_arc_mapper->to_local(cch_arc);
 					for(unsigned k = cch.first_extra_backward_input_arc_of_cch[j]; k < cch.first_extra_backward_input_arc_of_cch[j+1]; ++k){
 						unsigned original_arc = cch.extra_backward_input_arc_of_cch[k];
 						if(metric.backward[cch_arc] == metric.input_weight[original_arc])
@@ -1504,7 +2709,7 @@ namespace{
 
 
 	unsigned unpack_original_arc(
-		const CustomizableContractionHierarchy&cch, const CustomizableContractionHierarchyMetric&metric,
+		const CustomizableContractionHierarchyView&cch, const CustomizableContractionHierarchyMetricView&metric,
 		unsigned cch_arc, bool is_forward
 	){
 		if(is_forward)
@@ -1518,17 +2723,17 @@ std::vector<unsigned>CustomizableContractionHierarchyQuery::get_arc_path(){
 	assert(state == query_state_run);
 	std::vector<unsigned>path;
 	unpack_shortest_path(
-		*cch, *metric, *this,
+		cch, metric, *this,
 		[&](unsigned cch_node, unsigned cch_arc, bool is_forward){
 
 			if(is_forward)
-				assert(cch_node == cch->up_tail[cch_arc]);
+				assert(cch_node == cch.up_tail[cch_arc]);
 			else
-				assert(cch_node == cch->up_head[cch_arc]);
+				assert(cch_node == cch.up_head[cch_arc]);
 
 			(void)cch_node;
 
-			unsigned arc = unpack_original_arc(*cch, *metric, cch_arc, is_forward);
+			unsigned arc = unpack_original_arc(cch, metric, cch_arc, is_forward);
 			assert(arc != invalid_id);
 			path.push_back(arc);
 		}
@@ -1536,13 +2741,253 @@ std::vector<unsigned>CustomizableContractionHierarchyQuery::get_arc_path(){
 	return path; // NVRO
 }
 
+namespace{
+	struct RecordingLowerTriangleRelaxer{
+		RecordingLowerTriangleRelaxer(CustomizableContractionHierarchyMetric&metric, CustomizableContractionHierarchyMiddleNodes&middle_nodes):
+			metric(&metric), middle_nodes(&middle_nodes){}
+
+		bool operator()(
+			unsigned bottom_arc, unsigned mid_arc, unsigned top_arc,
+			unsigned bottom_node, unsigned mid_node, unsigned top_node
+		) const {
+			(void)mid_node;
+			(void)top_node;
+			if(metric->backward[bottom_arc] + metric->forward[mid_arc] < metric->forward[top_arc]){
+				metric->forward[top_arc] = metric->backward[bottom_arc] + metric->forward[mid_arc];
+				middle_nodes->forward_middle_node[top_arc] = bottom_node;
+			}
+			if(metric->forward[bottom_arc] + metric->backward[mid_arc] < metric->backward[top_arc]){
+				metric->backward[top_arc] = metric->forward[bottom_arc] + metric->backward[mid_arc];
+				middle_nodes->backward_middle_node[top_arc] = bottom_node;
+			}
+			return true;
+		}
+
+		CustomizableContractionHierarchyMetric*metric;
+		CustomizableContractionHierarchyMiddleNodes*middle_nodes;
+	};
+
+	unsigned find_middle_node(
+		const CustomizableContractionHierarchyView&cch, const CustomizableContractionHierarchyMetricView&metric,
+		unsigned xy, bool is_forward
+	){
+		ConstVectorView<unsigned>weight = is_forward ? metric.forward : metric.backward;
+		ConstVectorView<unsigned>reverse_weight = is_forward ? metric.backward : metric.forward;
+
+		if(weight[xy] == inf_weight || unpack_original_arc(cch, metric, xy, is_forward) != invalid_id)
+			return invalid_id;
+
+		unsigned middle_node = invalid_id;
+		forall_lower_triangles_of_arc(
+			cch, xy,
+			[&](
+				unsigned bottom_arc, unsigned mid_arc, unsigned top_arc,
+				unsigned bottom_node, unsigned mid_node, unsigned top_node
+			){
+				(void)top_arc; (void)mid_node; (void)top_node;
+				if(weight[xy] == reverse_weight[bottom_arc] + weight[mid_arc]){
+					middle_node = bottom_node;
+					return false;
+				}
+				return true;
+			}
+		);
+		assert(middle_node != invalid_id && "the weight of the arc is neither that of an input arc nor that of a triangle");
+		return middle_node;
+	}
+
+	// Calls on_input_arc for the input arcs of the path represented by xy in path order.
+	template<class OnInputArc>
+	void unpack_arc_using_middle_nodes(
+		const CustomizableContractionHierarchyView&cch, const CustomizableContractionHierarchyMetricView&metric,
+		const CustomizableContractionHierarchyMiddleNodes&middle_nodes,
+		unsigned xy, bool is_forward,
+		const OnInputArc&on_input_arc
+	){
+		unsigned z = is_forward ? middle_nodes.forward_middle_node[xy] : middle_nodes.backward_middle_node[xy];
+		if(z == invalid_id){
+			unsigned arc = unpack_original_arc(cch, metric, xy, is_forward);
+			assert(arc != invalid_id);
+			on_input_arc(arc);
+		}else{
+			unsigned x = cch.up_tail[xy];
+			unsigned y = cch.up_head[xy];
+			unsigned zx = find_arc_given_sorted_head(cch.up_first_out, cch.up_head, z, x);
+			unsigned zy = find_arc_given_sorted_head(cch.up_first_out, cch.up_head, z, y);
+			if(is_forward){
+				unpack_arc_using_middle_nodes(cch, metric, middle_nodes, zx, false, on_input_arc);
+				unpack_arc_using_middle_nodes(cch, metric, middle_nodes, zy, true, on_input_arc);
+			}else{
+				unpack_arc_using_middle_nodes(cch, metric, middle_nodes, zy, false, on_input_arc);
+				unpack_arc_using_middle_nodes(cch, metric, middle_nodes, zx, true, on_input_arc);
+			}
+		}
+	}
+}
+
+CustomizableContractionHierarchyMiddleNodes& CustomizableContractionHierarchyMiddleNodes::customize(CustomizableContractionHierarchyMetric&metric){
+	assert(metric.input_weight != nullptr && "Metric must be connected to a weight vector");
+
+	const CustomizableContractionHierarchy&cch = *metric.cch;
+
+	extract_initial_metric(cch, metric);
+	forward_middle_node.assign(cch.cch_arc_count(), invalid_id);
+	backward_middle_node.assign(cch.cch_arc_count(), invalid_id);
+
+	std::vector<unsigned> arc_id_cache(cch.node_count());
+
+	RecordingLowerTriangleRelaxer relax(metric, *this);
+	for(unsigned x=0; x<cch.node_count(); ++x)
+		forall_lower_triangles_of_upward_arcs_of_node(cch, x, arc_id_cache, relax);
+
+	return *this;
+}
+
+CustomizableContractionHierarchyMiddleNodes& CustomizableContractionHierarchyMiddleNodes::compute(const CustomizableContractionHierarchyMetric&metric_, unsigned thread_count){
+	assert(thread_count != 0);
+	(void)thread_count;
+
+	CustomizableContractionHierarchyMetricView metric(metric_);
+	const CustomizableContractionHierarchyView&cch = metric.cch;
+
+	forward_middle_node.resize(cch.cch_arc_count());
+	backward_middle_node.resize(cch.cch_arc_count());
+
+	#ifdef _OPENMP
+	#pragma omp parallel for num_threads(thread_count) schedule(dynamic, 1024)
+	#endif
+	for(unsigned xy=0; xy<cch.cch_arc_count(); ++xy){
+		forward_middle_node[xy] = find_middle_node(cch, metric, xy, true);
+		backward_middle_node[xy] = find_middle_node(cch, metric, xy, false);
+	}
+
+	return *this;
+}
+
+CustomizableContractionHierarchyUnpackingCache::CustomizableContractionHierarchyUnpackingCache(unsigned long long max_input_arc_count):
+	max_input_arc_count(max_input_arc_count), cached_input_arc_count(0), hit_count(0), miss_count(0){}
+
+void CustomizableContractionHierarchyUnpackingCache::clear(){
+	std::lock_guard<std::mutex>guard(lock);
+	entry_list.clear();
+	entry_of_key.clear();
+	cached_input_arc_count = 0;
+}
+
+unsigned long long CustomizableContractionHierarchyUnpackingCache::get_hit_count()const{
+	std::lock_guard<std::mutex>guard(lock);
+	return hit_count;
+}
+
+unsigned long long CustomizableContractionHierarchyUnpackingCache::get_miss_count()const{
+	std::lock_guard<std::mutex>guard(lock);
+	return miss_count;
+}
+
+unsigned long long CustomizableContractionHierarchyUnpackingCache::get_cached_input_arc_count()const{
+	std::lock_guard<std::mutex>guard(lock);
+	return cached_input_arc_count;
+}
+
+bool CustomizableContractionHierarchyUnpackingCache::append_if_cached(unsigned long long key, std::vector<unsigned>&path){
+	std::lock_guard<std::mutex>guard(lock);
+	auto i = entry_of_key.find(key);
+	if(i == entry_of_key.end()){
+		++miss_count;
+		return false;
+	}
+	++hit_count;
+	entry_list.splice(entry_list.begin(), entry_list, i->second);
+	const std::vector<unsigned>&input_arc = i->second->input_arc;
+	path.insert(path.end(), input_arc.begin(), input_arc.end());
+	return true;
+}
+
+void CustomizableContractionHierarchyUnpackingCache::insert(unsigned long long key, std::vector<unsigned>input_arc){
+	if(input_arc.size() > max_input_arc_count)
+		return;
+
+	std::lock_guard<std::mutex>guard(lock);
+	// Another thread may have inserted the same key in the meantime.
+	if(entry_of_key.find(key) != entry_of_key.end())
+		return;
+
+	cached_input_arc_count += input_arc.size();
+	entry_list.push_front({key, std::move(input_arc)});
+	entry_of_key[key] = entry_list.begin();
+
+	while(cached_input_arc_count > max_input_arc_count){
+		cached_input_arc_count -= entry_list.back().input_arc.size();
+		entry_of_key.erase(entry_list.back().key);
+		entry_list.pop_back();
+	}
+}
+
+namespace{
+	void append_unpacked_arc(
+		const CustomizableContractionHierarchyView&cch, const CustomizableContractionHierarchyMetricView&metric,
+		const CustomizableContractionHierarchyMiddleNodes&middle_nodes, CustomizableContractionHierarchyUnpackingCache*cache,
+		unsigned xy, bool is_forward,
+		std::vector<unsigned>&path
+	){
+		unsigned z = is_forward ? middle_nodes.forward_middle_node[xy] : middle_nodes.backward_middle_node[xy];
+		if(cache == nullptr || z == invalid_id){
+			unpack_arc_using_middle_nodes(cch, metric, middle_nodes, xy, is_forward, [&](unsigned a){path.push_back(a);});
+		}else{
+			unsigned long long key = 2*(unsigned long long)xy + (is_forward ? 1 : 0);
+			if(!cache->append_if_cached(key, path)){
+				unsigned begin = path.size();
+				unpack_arc_using_middle_nodes(cch, metric, middle_nodes, xy, is_forward, [&](unsigned a){path.push_back(a);});
+				cache->insert(key, std::vector<unsigned>(path.begin()+begin, path.end()));
+			}
+		}
+	}
+}
+
+std::vector<unsigned>CustomizableContractionHierarchyQuery::get_arc_path(const CustomizableContractionHierarchyMiddleNodes&middle_nodes, CustomizableContractionHierarchyUnpackingCache*cache){
+	assert(state == query_state_run);
+	assert(middle_nodes.forward_middle_node.size() == cch.cch_arc_count() && "middle nodes do not belong to this CCH");
+	std::vector<unsigned>path;
+	forall_cch_arcs_of_shortest_path(
+		cch, shortest_path_meeting_node,
+		[&](unsigned x){return forward_predecessor_node[x];},
+		[&](unsigned x){return backward_predecessor_node[x];},
+		[&](unsigned x, unsigned y, unsigned xy, bool is_forward){
+			(void)x; (void)y;
+			append_unpacked_arc(cch, metric, middle_nodes, cache, xy, is_forward, path);
+		}
+	);
+	return path; // NVRO
+}
+
+std::vector<unsigned>CustomizableContractionHierarchyQuery::get_node_path(const CustomizableContractionHierarchyMiddleNodes&middle_nodes, CustomizableContractionHierarchyUnpackingCache*cache){
+	assert(state == query_state_run);
+	std::vector<unsigned>path;
+	if(shortest_path_meeting_node == invalid_id)
+		return path; // NVRO
+
+	std::vector<unsigned>arc_path = get_arc_path(middle_nodes, cache);
+	if(arc_path.empty()){
+		path.push_back(cch.order[shortest_path_meeting_node]);
+	}else{
+		// An upward input arc goes from the tail to the head of its CCH arc.
+		for(auto a:arc_path){
+			unsigned xy = cch.input_arc_to_cch_arc[a];
+			path.push_back(cch.order[cch.is_input_arc_upward.is_set(a) ? cch.up_tail[xy] : cch.up_head[xy]]);
+		}
+		unsigned xy = cch.input_arc_to_cch_arc[arc_path.back()];
+		path.push_back(cch.order[cch.is_input_arc_upward.is_set(arc_path.back()) ? cch.up_head[xy] : cch.up_tail[xy]]);
+	}
+	return path; // NVRO
+}
+
 namespace{
 	void internal_pin_targets(
 		std::vector<unsigned>&target_node,
 		std::vector<unsigned>&target_elimination_tree_end,
 		std::vector<bool>&in_backward_search_space,
-		const std::vector<unsigned>&elimination_tree_parent,
-		const std::vector<unsigned>&rank,
+		ConstVectorView<unsigned>elimination_tree_parent,
+		ConstVectorView<unsigned>rank,
 		const std::vector<unsigned>&target_list
 	){
 		target_node.resize(target_list.size());
@@ -1569,21 +3014,21 @@ namespace{
 
 CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::pin_targets(const std::vector<unsigned>&target_list){
 	assert(state == query_state_initialized);
-	internal_pin_targets(target_node, target_elimination_tree_end, in_backward_search_space, cch->elimination_tree_parent, cch->rank, target_list);
+	internal_pin_targets(target_node, target_elimination_tree_end, in_backward_search_space, cch.elimination_tree_parent, cch.rank, target_list);
 	state = query_state_target_pinned;
 	return *this;
 }
 
 CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::pin_sources(const std::vector<unsigned>&source_list){
 	assert(state == query_state_initialized);
-	internal_pin_targets(source_node, source_elimination_tree_end, in_forward_search_space, cch->elimination_tree_parent, cch->rank, source_list);
+	internal_pin_targets(source_node, source_elimination_tree_end, in_forward_search_space, cch.elimination_tree_parent, cch.rank, source_list);
 	state = query_state_source_pinned;
 	return *this;
 }
 
 namespace{
 	void reset_target_distances(
-		const std::vector<unsigned>&elimination_tree_parent,
+		ConstVectorView<unsigned>elimination_tree_parent,
 		const std::vector<unsigned>&target_node,
 		const std::vector<unsigned>&target_elimination_tree_end,
 		std::vector<unsigned>&forward_tentative_distance
@@ -1604,8 +3049,8 @@ namespace{
 CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::reset_source(){
 	assert(state == query_state_target_pinned || state == query_state_target_run);
 
-	reset_source_list(cch->elimination_tree_parent, source_node, source_elimination_tree_end, in_forward_search_space, forward_tentative_distance);
-	reset_target_distances(cch->elimination_tree_parent, target_node, target_elimination_tree_end, forward_tentative_distance);
+	reset_source_list(cch.elimination_tree_parent, source_node, source_elimination_tree_end, in_forward_search_space, forward_tentative_distance);
+	reset_target_distances(cch.elimination_tree_parent, target_node, target_elimination_tree_end, forward_tentative_distance);
 
 	state = query_state_target_pinned;
 	return *this;
@@ -1614,8 +3059,8 @@ CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::re
 CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::reset_target(){
 	assert(state == query_state_source_pinned || state == query_state_source_run);
 
-	reset_source_list(cch->elimination_tree_parent, target_node, target_elimination_tree_end, in_backward_search_space, backward_tentative_distance);
-	reset_target_distances(cch->elimination_tree_parent, source_node, source_elimination_tree_end, backward_tentative_distance);
+	reset_source_list(cch.elimination_tree_parent, target_node, target_elimination_tree_end, in_backward_search_space, backward_tentative_distance);
+	reset_target_distances(cch.elimination_tree_parent, source_node, source_elimination_tree_end, backward_tentative_distance);
 
 	state = query_state_source_pinned;
 	return *this;
@@ -1623,8 +3068,8 @@ CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::re
 
 namespace{
 	void internal_run_to_pinned_targets(
-		const CustomizableContractionHierarchy&cch,
-		const std::vector<unsigned>&forward_weight, const std::vector<unsigned>&backward_weight,
+		const CustomizableContractionHierarchyView&cch,
+		ConstVectorView<unsigned>forward_weight, ConstVectorView<unsigned>backward_weight,
 		std::vector<unsigned>&forward_tentative_distance, std::vector<unsigned>&backward_tentative_distance,
 		const std::vector<unsigned>&source_node, const std::vector<unsigned>&source_elimination_tree_end,
 		const std::vector<unsigned>&target_node, const std::vector<unsigned>&target_elimination_tree_end
@@ -1672,9 +3117,10 @@ namespace{
 
 CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::run_to_pinned_targets(){
 	assert(state == query_state_target_pinned);
+	update_metric_from_owning_metric();
 	internal_run_to_pinned_targets(
-		*cch,
-		metric->forward, metric->backward,
+		cch,
+		metric.forward, metric.backward,
 		forward_tentative_distance, backward_tentative_distance,
 		source_node, source_elimination_tree_end,
 		target_node, target_elimination_tree_end
@@ -1683,45 +3129,209 @@ CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::ru
 	return *this;
 }
 
-CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::run_to_pinned_sources(){
-	assert(state == query_state_source_pinned);
-	internal_run_to_pinned_targets(
-		*cch,
-		metric->backward, metric->forward,
-		backward_tentative_distance, forward_tentative_distance,
-		target_node, target_elimination_tree_end,
-		source_node, source_elimination_tree_end
-	);
-	state = query_state_source_run;
-	return *this;
-}
+CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::run_to_pinned_sources(){
+	assert(state == query_state_source_pinned);
+	update_metric_from_owning_metric();
+	internal_run_to_pinned_targets(
+		cch,
+		metric.backward, metric.forward,
+		backward_tentative_distance, forward_tentative_distance,
+		target_node, target_elimination_tree_end,
+		source_node, source_elimination_tree_end
+	);
+	state = query_state_source_run;
+	return *this;
+}
+
+CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::get_distances_to_targets(unsigned*dist){
+	assert(state == query_state_target_run);
+	for(unsigned i=0; i<target_node.size(); ++i)
+		dist[i] = forward_tentative_distance[target_node[i]];
+	return *this;
+}
+
+std::vector<unsigned> CustomizableContractionHierarchyQuery::get_distances_to_targets(){
+	assert(state == query_state_target_run);
+	std::vector<unsigned>v(target_node.size());
+	get_distances_to_targets(&v[0]);
+	return v;
+}
+
+CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::get_distances_to_sources(unsigned*dist){
+	assert(state == query_state_source_run);
+	for(unsigned i=0; i<source_node.size(); ++i)
+		dist[i] = backward_tentative_distance[source_node[i]];
+	return *this;
+}
+
+std::vector<unsigned> CustomizableContractionHierarchyQuery::get_distances_to_sources(){
+	assert(state == query_state_source_run);
+	std::vector<unsigned>v(source_node.size());
+	get_distances_to_sources(&v[0]);
+	return v;
+}
+
+namespace{
+	unsigned get_thread_id(){
+		#ifdef _OPENMP
+		return omp_get_thread_num();
+		#else
+		return 0;
+		#endif
+	}
+
+	// Runs an upward search from x along its elimination tree path and calls
+	// on_reached(y, dist) for every node y on the path that is reachable. The distances are
+	// final as all arcs into y in the search space start at descendants of y. Afterwards,
+	// tentative_distance is inf_weight everywhere again.
+	template<class OnReached>
+	void forall_nodes_in_elimination_tree_search_space(
+		const CustomizableContractionHierarchyView&cch, ConstVectorView<unsigned>weight,
+		unsigned x, std::vector<unsigned>&tentative_distance,
+		const OnReached&on_reached
+	){
+		tentative_distance[x] = 0;
+		forall_ancestors(
+			cch.elimination_tree_parent, x,
+			[&](unsigned y){
+				unsigned dist_to_y = tentative_distance[y];
+				if(dist_to_y != inf_weight){
+					on_reached(y, dist_to_y);
+					for(unsigned yz=cch.up_first_out[y]; yz<cch.up_first_out[y+1]; ++yz){
+						unsigned z = cch.up_head[yz];
+						if(dist_to_y + weight[yz] < tentative_distance[z])
+							tentative_distance[z] = dist_to_y + weight[yz];
+					}
+				}
+				return true;
+			}
+		);
+		forall_ancestors(
+			cch.elimination_tree_parent, x,
+			[&](unsigned y){
+				tentative_distance[y] = inf_weight;
+				return true;
+			}
+		);
+	}
+}
+
+CustomizableContractionHierarchyManyToMany::CustomizableContractionHierarchyManyToMany(const CustomizableContractionHierarchyMetric&metric):
+	CustomizableContractionHierarchyManyToMany(CustomizableContractionHierarchyMetricView(metric)){}
+
+CustomizableContractionHierarchyManyToMany::CustomizableContractionHierarchyManyToMany(CustomizableContractionHierarchyMetricView metric):
+	metric(std::move(metric)), target_count(0){}
+
+CustomizableContractionHierarchyManyToMany&CustomizableContractionHierarchyManyToMany::reset(const CustomizableContractionHierarchyMetric&metric){
+	return reset(CustomizableContractionHierarchyMetricView(metric));
+}
+
+CustomizableContractionHierarchyManyToMany&CustomizableContractionHierarchyManyToMany::reset(CustomizableContractionHierarchyMetricView new_metric){
+	if(metric.cch.node_count() != new_metric.cch.node_count())
+		tentative_distance_of_thread.clear();
+	metric = std::move(new_metric);
+	target_count = 0;
+	bucket_first_entry.clear();
+	bucket_entry.clear();
+	return *this;
+}
+
+void CustomizableContractionHierarchyManyToMany::prepare_tentative_distances(unsigned thread_count){
+	while(tentative_distance_of_thread.size() < thread_count)
+		tentative_distance_of_thread.emplace_back(metric.cch.node_count(), inf_weight);
+}
+
+unsigned CustomizableContractionHierarchyManyToMany::get_target_count()const{
+	return target_count;
+}
+
+CustomizableContractionHierarchyManyToMany&CustomizableContractionHierarchyManyToMany::set_targets(const std::vector<unsigned>&target_list, unsigned thread_count){
+	assert(metric.cch.up_first_out.size() != 0 && "many-to-many object must have an attached metric");
+	assert(thread_count != 0);
+	assert((target_list.empty() || max_element_of(target_list) < metric.cch.node_count()) && "node id out of bounds");
+
+	prepare_tentative_distances(thread_count);
+
+	const CustomizableContractionHierarchyView&cch = metric.cch;
+	const unsigned node_count = cch.node_count();
+	target_count = target_list.size();
+
+	struct NodeBucketEntry{
+		unsigned node;
+		BucketEntry entry;
+	};
+
+	std::vector<std::vector<NodeBucketEntry>>entries_of_thread(thread_count);
+
+	#ifdef _OPENMP
+	#pragma omp parallel for num_threads(thread_count) schedule(dynamic, 16)
+	#endif
+	for(unsigned i=0; i<target_count; ++i){
+		std::vector<NodeBucketEntry>&entries = entries_of_thread[get_thread_id()];
+		forall_nodes_in_elimination_tree_search_space(
+			cch, metric.backward,
+			cch.rank[target_list[i]], tentative_distance_of_thread[get_thread_id()],
+			[&](unsigned x, unsigned d){
+				entries.push_back({x, {i, d}});
+			}
+		);
+	}
+
+	bucket_first_entry.assign(node_count+1, 0);
+	for(auto&entries:entries_of_thread)
+		for(auto&e:entries)
+			++bucket_first_entry[e.node+1];
+	for(unsigned x=0; x<node_count; ++x)
+		bucket_first_entry[x+1] += bucket_first_entry[x];
+
+	bucket_entry.resize(bucket_first_entry[node_count]);
+	{
+		std::vector<unsigned>next_entry(bucket_first_entry.begin(), bucket_first_entry.end()-1);
+		for(auto&entries:entries_of_thread)
+			for(auto&e:entries)
+				bucket_entry[next_entry[e.node]++] = e.entry;
+	}
 
-CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::get_distances_to_targets(unsigned*dist){
-	assert(state == query_state_target_run);
-	for(unsigned i=0; i<target_node.size(); ++i)
-		dist[i] = forward_tentative_distance[target_node[i]];
 	return *this;
 }
 
-std::vector<unsigned> CustomizableContractionHierarchyQuery::get_distances_to_targets(){
-	assert(state == query_state_target_run);
-	std::vector<unsigned>v(target_node.size());
-	get_distances_to_targets(&v[0]);
-	return v;
-}
+CustomizableContractionHierarchyManyToMany&CustomizableContractionHierarchyManyToMany::get_distances(const std::vector<unsigned>&source_list, unsigned*dist, unsigned thread_count){
+	assert(thread_count != 0);
+	assert((source_list.empty() || max_element_of(source_list) < metric.cch.node_count()) && "node id out of bounds");
+	assert(bucket_first_entry.size() == metric.cch.node_count()+1 && "set_targets must be called before get_distances");
+
+	prepare_tentative_distances(thread_count);
+
+	const CustomizableContractionHierarchyView&cch = metric.cch;
+	const unsigned source_count = source_list.size();
+
+	#ifdef _OPENMP
+	#pragma omp parallel for num_threads(thread_count) schedule(dynamic, 4)
+	#endif
+	for(unsigned i=0; i<source_count; ++i){
+		unsigned*row = dist + (unsigned long long)i*target_count;
+		std::fill(row, row+target_count, inf_weight);
+
+		forall_nodes_in_elimination_tree_search_space(
+			cch, metric.forward,
+			cch.rank[source_list[i]], tentative_distance_of_thread[get_thread_id()],
+			[&](unsigned x, unsigned d){
+				for(unsigned j=bucket_first_entry[x]; j<bucket_first_entry[x+1]; ++j){
+					unsigned new_dist = d + bucket_entry[j].distance;
+					if(new_dist < row[bucket_entry[j].target])
+						row[bucket_entry[j].target] = new_dist;
+				}
+			}
+		);
+	}
 
-CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::get_distances_to_sources(unsigned*dist){
-	assert(state == query_state_source_run);
-	for(unsigned i=0; i<source_node.size(); ++i)
-		dist[i] = backward_tentative_distance[source_node[i]];
 	return *this;
 }
 
-std::vector<unsigned> CustomizableContractionHierarchyQuery::get_distances_to_sources(){
-	assert(state == query_state_source_run);
-	std::vector<unsigned>v(source_node.size());
-	get_distances_to_sources(&v[0]);
-	return v;
+std::vector<unsigned>CustomizableContractionHierarchyManyToMany::get_distances(const std::vector<unsigned>&source_list, unsigned thread_count){
+	std::vector<unsigned>dist((unsigned long long)source_list.size()*target_count);
+	get_distances(source_list, dist.data(), thread_count);
+	return dist; // NVRO
 }
 
 ContractionHierarchy CustomizableContractionHierarchyMetric::build_contraction_hierarchy_using_perfect_witness_search(){
@@ -1892,28 +3502,518 @@ ContractionHierarchy CustomizableContractionHierarchyMetric::build_contraction_h
 
 
 CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::reset(){
+	if(owning_metric != nullptr)
+		return reset(*owning_metric);
+	return reset_search_state();
+}
+
+CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::reset_search_state(){
 	if(state == query_state_target_pinned || state == query_state_target_run){
-		reset_target_distances(cch->elimination_tree_parent, target_node, target_elimination_tree_end, forward_tentative_distance);
+		reset_target_distances(cch.elimination_tree_parent, target_node, target_elimination_tree_end, forward_tentative_distance);
 	}else if(state == query_state_source_pinned || state == query_state_source_run){
-		reset_target_distances(cch->elimination_tree_parent, source_node, source_elimination_tree_end, backward_tentative_distance);
+		reset_target_distances(cch.elimination_tree_parent, source_node, source_elimination_tree_end, backward_tentative_distance);
 	}
-	reset_source_list(cch->elimination_tree_parent, source_node, source_elimination_tree_end, in_forward_search_space, forward_tentative_distance);
-	reset_source_list(cch->elimination_tree_parent, target_node, target_elimination_tree_end, in_backward_search_space, backward_tentative_distance);
+	reset_source_list(cch.elimination_tree_parent, source_node, source_elimination_tree_end, in_forward_search_space, forward_tentative_distance);
+	reset_source_list(cch.elimination_tree_parent, target_node, target_elimination_tree_end, in_backward_search_space, backward_tentative_distance);
 	state = query_state_initialized;
 	return *this;
 }
 
 CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::reset(const CustomizableContractionHierarchyMetric&metric){
-	if(this->cch == metric.cch) {
-		this->metric = &metric;
-		reset();
+	reset(CustomizableContractionHierarchyMetricView(metric));
+	owning_metric = &metric;
+	return *this;
+}
+
+CustomizableContractionHierarchyQuery& CustomizableContractionHierarchyQuery::reset(CustomizableContractionHierarchyMetricView metric){
+	owning_metric = nullptr;
+	if(cch.up_head.data() == metric.cch.up_head.data() && cch.node_count() == metric.cch.node_count()) {
+		reset_search_state();
+		this->metric = std::move(metric);
 	} else {
-		*this = CustomizableContractionHierarchyQuery(metric);
+		bool old_use_pruning = use_pruning;
+		bool old_use_stall_on_demand = use_stall_on_demand;
+		*this = CustomizableContractionHierarchyQuery(std::move(metric));
+		use_pruning = old_use_pruning;
+		use_stall_on_demand = old_use_stall_on_demand;
+	}
+	state = query_state_initialized;
+	return *this;
+}
+
+
+namespace{
+	const unsigned compact_query_state_initialized = 0;
+	const unsigned compact_query_state_source_added = 1;
+	const unsigned compact_query_state_target_added = 2;
+	const unsigned compact_query_state_both_added = 3;
+	const unsigned compact_query_state_run = 4;
+
+	void init_compact_search(
+		ConstVectorView<unsigned>elimination_tree_parent, unsigned s, unsigned dist_to_s,
+		std::vector<unsigned>&node, std::vector<unsigned>&tentative_distance, std::vector<unsigned>&predecessor_node
+	){
+		node.clear();
+		forall_ancestors(
+			elimination_tree_parent, s,
+			[&](unsigned x){
+				node.push_back(x);
+				return true;
+			}
+		);
+		tentative_distance.assign(node.size(), inf_weight);
+		tentative_distance[0] = dist_to_s;
+		predecessor_node.assign(node.size(), invalid_id);
+	}
+
+	// All upward neighbors of a node are ancestors in the elimination tree, i.e., they are
+	// on the same path. The position of an ancestor on the path follows from its depth, as
+	// the last node on the path is a root.
+	unsigned relax_compact_outgoing_arcs(
+		const CustomizableContractionHierarchyView&cch, ConstVectorView<unsigned>weight,
+		const std::vector<unsigned>&node, std::vector<unsigned>&tentative_distance, std::vector<unsigned>&predecessor_node,
+		unsigned i
+	){
+		unsigned x = node[i];
+		unsigned dist_to_x = tentative_distance[i];
+		unsigned root_position = node.size()-1;
+		for(unsigned xy=cch.up_first_out[x]; xy<cch.up_first_out[x+1]; ++xy){
+			unsigned y = cch.up_head[xy];
+			unsigned j = root_position - cch.elimination_tree_depth[y];
+			assert(node[j] == y && "upward neighbor is not an ancestor");
+			if(dist_to_x + weight[xy] < tentative_distance[j]){
+				tentative_distance[j] = dist_to_x + weight[xy];
+				predecessor_node[j] = x;
+			}
+		}
+		return cch.up_first_out[x+1] - cch.up_first_out[x];
+	}
+
+	unsigned get_compact_predecessor(ConstVectorView<unsigned>elimination_tree_depth, const std::vector<unsigned>&node, const std::vector<unsigned>&predecessor_node, unsigned x){
+		unsigned i = node.size()-1-elimination_tree_depth[x];
+		assert(node[i] == x);
+		return predecessor_node[i];
+	}
+}
+
+CustomizableContractionHierarchyCompactQuery::CustomizableContractionHierarchyCompactQuery(const CustomizableContractionHierarchyMetric&metric):
+	CustomizableContractionHierarchyCompactQuery(CustomizableContractionHierarchyMetricView(metric)){
+	owning_metric = &metric;
+}
+
+CustomizableContractionHierarchyCompactQuery::CustomizableContractionHierarchyCompactQuery(CustomizableContractionHierarchyMetricView metric):
+	shortest_path_meeting_node(invalid_id),
+	shortest_path_length(inf_weight),
+	relaxed_arc_count(0),
+	metric(std::move(metric)),
+	state(compact_query_state_initialized),
+	owning_metric(nullptr){}
+
+CustomizableContractionHierarchyCompactQuery& CustomizableContractionHierarchyCompactQuery::reset(){
+	// The search state does not depend on the CCH, so the metric may also have been
+	// attached to another CCH in the meantime.
+	if(owning_metric != nullptr)
+		metric = CustomizableContractionHierarchyMetricView(*owning_metric);
+	shortest_path_meeting_node = invalid_id;
+	shortest_path_length = inf_weight;
+	state = compact_query_state_initialized;
+	return *this;
+}
+
+CustomizableContractionHierarchyCompactQuery& CustomizableContractionHierarchyCompactQuery::reset(const CustomizableContractionHierarchyMetric&metric){
+	owning_metric = &metric;
+	return reset();
+}
+
+CustomizableContractionHierarchyCompactQuery& CustomizableContractionHierarchyCompactQuery::reset(CustomizableContractionHierarchyMetricView metric){
+	owning_metric = nullptr;
+	this->metric = std::move(metric);
+	return reset();
+}
+
+CustomizableContractionHierarchyCompactQuery& CustomizableContractionHierarchyCompactQuery::add_source(unsigned external_s, unsigned dist_to_s){
+	assert(external_s < metric.cch.node_count());
+	assert((state == compact_query_state_initialized || state == compact_query_state_target_added) && "only one source is supported");
+	init_compact_search(metric.cch.elimination_tree_parent, metric.cch.rank[external_s], dist_to_s, forward_node, forward_tentative_distance, forward_predecessor_node);
+	state |= compact_query_state_source_added;
+	return *this;
+}
+
+CustomizableContractionHierarchyCompactQuery& CustomizableContractionHierarchyCompactQuery::add_target(unsigned external_t, unsigned dist_to_t){
+	assert(external_t < metric.cch.node_count());
+	assert((state == compact_query_state_initialized || state == compact_query_state_source_added) && "only one target is supported");
+	init_compact_search(metric.cch.elimination_tree_parent, metric.cch.rank[external_t], dist_to_t, backward_node, backward_tentative_distance, backward_predecessor_node);
+	state |= compact_query_state_target_added;
+	return *this;
+}
+
+CustomizableContractionHierarchyCompactQuery& CustomizableContractionHierarchyCompactQuery::run(){
+	assert(state == compact_query_state_both_added && "a source and a target must be added before run");
+
+	const CustomizableContractionHierarchyView&cch = metric.cch;
+
+	shortest_path_meeting_node = invalid_id;
+	shortest_path_length = inf_weight;
+	relaxed_arc_count = 0;
+
+	// Both paths end at the root of the elimination tree. Every node is processed after all
+	// nodes below it on the paths. Its tentative distances are therefore final when it is reached.
+	unsigned i = 0, j = 0;
+	while(i < forward_node.size() || j < backward_node.size()){
+		bool is_forward = i < forward_node.size() && (j == backward_node.size() || forward_node[i] <= backward_node[j]);
+		bool is_backward = j < backward_node.size() && (i == forward_node.size() || backward_node[j] <= forward_node[i]);
+
+		if(is_forward && is_backward){
+			unsigned l = forward_tentative_distance[i] + backward_tentative_distance[j];
+			if(l < shortest_path_length){
+				shortest_path_length = l;
+				shortest_path_meeting_node = forward_node[i];
+			}
+		}
+
+		if(is_forward){
+			if(forward_tentative_distance[i] < shortest_path_length)
+				relaxed_arc_count += relax_compact_outgoing_arcs(cch, metric.forward, forward_node, forward_tentative_distance, forward_predecessor_node, i);
+			++i;
+		}
+		if(is_backward){
+			if(backward_tentative_distance[j] < shortest_path_length)
+				relaxed_arc_count += relax_compact_outgoing_arcs(cch, metric.backward, backward_node, backward_tentative_distance, backward_predecessor_node, j);
+			++j;
+		}
+	}
+
+	state = compact_query_state_run;
+	return *this;
+}
+
+unsigned CustomizableContractionHierarchyCompactQuery::get_distance(){
+	assert(state == compact_query_state_run);
+	return shortest_path_length;
+}
+
+unsigned CustomizableContractionHierarchyCompactQuery::get_used_source(){
+	assert(state == compact_query_state_run);
+	if(shortest_path_meeting_node == invalid_id)
+		return invalid_id;
+	else
+		return metric.cch.order[forward_node[0]];
+}
+
+unsigned CustomizableContractionHierarchyCompactQuery::get_used_target(){
+	assert(state == compact_query_state_run);
+	if(shortest_path_meeting_node == invalid_id)
+		return invalid_id;
+	else
+		return metric.cch.order[backward_node[0]];
+}
+
+unsigned CustomizableContractionHierarchyCompactQuery::get_relaxed_arc_count()const{
+	return relaxed_arc_count;
+}
+
+unsigned long long CustomizableContractionHierarchyCompactQuery::memory_usage()const{
+	return sizeof(unsigned)*(
+		forward_node.capacity() + backward_node.capacity() +
+		forward_tentative_distance.capacity() + backward_tentative_distance.capacity() +
+		forward_predecessor_node.capacity() + backward_predecessor_node.capacity()
+	);
+}
+
+std::vector<unsigned>CustomizableContractionHierarchyCompactQuery::get_node_path(){
+	assert(state == compact_query_state_run);
+	const CustomizableContractionHierarchyView&cch = metric.cch;
+	std::vector<unsigned>path;
+	unsigned last = unpack_shortest_path(
+		cch, metric, shortest_path_meeting_node,
+		[&](unsigned x){return get_compact_predecessor(cch.elimination_tree_depth, forward_node, forward_predecessor_node, x);},
+		[&](unsigned x){return get_compact_predecessor(cch.elimination_tree_depth, backward_node, backward_predecessor_node, x);},
+		[&](unsigned cch_node, unsigned cch_arc, bool forward){
+			path.push_back(cch.order[cch_node]);
+			(void)forward;
+			(void)cch_arc;
+		}
+	);
+	if(last != invalid_id)
+		path.push_back(cch.order[last]);
+	return path; // NVRO
+}
+
+std::vector<unsigned>CustomizableContractionHierarchyCompactQuery::get_arc_path(){
+	assert(state == compact_query_state_run);
+	const CustomizableContractionHierarchyView&cch = metric.cch;
+	std::vector<unsigned>path;
+	unpack_shortest_path(
+		cch, metric, shortest_path_meeting_node,
+		[&](unsigned x){return get_compact_predecessor(cch.elimination_tree_depth, forward_node, forward_predecessor_node, x);},
+		[&](unsigned x){return get_compact_predecessor(cch.elimination_tree_depth, backward_node, backward_predecessor_node, x);},
+		[&](unsigned cch_node, unsigned cch_arc, bool is_forward){
+			(void)cch_node;
+			unsigned arc = unpack_original_arc(cch, metric, cch_arc, is_forward);
+			assert(arc != invalid_id);
+			path.push_back(arc);
+		}
+	);
+	return path; // NVRO
+}
+
+namespace{
+	template<unsigned K>
+	void extract_initial_multi_metric(
+		const CustomizableContractionHierarchy&cch, const std::array<const unsigned*, K>&input_weight,
+		std::vector<unsigned>&forward, std::vector<unsigned>&backward
+	){
+		std::fill(forward.begin(), forward.end(), inf_weight);
+		std::fill(backward.begin(), backward.end(), inf_weight);
+
+		auto min_to_input_weight = [&](std::vector<unsigned>&weight, unsigned cch_arc, unsigned input_arc){
+			for(unsigned k=0; k<K; ++k)
+				min_to(weight[(unsigned long long)cch_arc*K+k], input_weight[k][input_arc]);
+		};
+
+		for(unsigned cch_arc=0; cch_arc<cch.cch_arc_count(); ++cch_arc){
+			if(__builtin_expect(!cch.does_cch_arc_have_input_arc.is_set(cch_arc), true))
+				continue;
+			{
+				unsigned i = cch.does_cch_arc_have_input_arc_mapper.to_local(cch_arc);
+				if(cch.forward_input_arc_of_cch[i] != invalid_id)
+					min_to_input_weight(forward, cch_arc, cch.forward_input_arc_of_cch[i]);
+				if(cch.backward_input_arc_of_cch[i] != invalid_id)
+					min_to_input_weight(backward, cch_arc, cch.backward_input_arc_of_cch[i]);
+			}
+			if(cch.does_cch_arc_have_extra_input_arc.is_set(cch_arc)){
+				unsigned i = cch.does_cch_arc_have_extra_input_arc_mapper.to_local(cch_arc);
+				for(unsigned j=cch.first_extra_forward_input_arc_of_cch[i]; j<cch.first_extra_forward_input_arc_of_cch[i+1]; ++j)
+					min_to_input_weight(forward, cch_arc, cch.extra_forward_input_arc_of_cch[j]);
+				for(unsigned j=cch.first_extra_backward_input_arc_of_cch[i]; j<cch.first_extra_backward_input_arc_of_cch[i+1]; ++j)
+					min_to_input_weight(backward, cch_arc, cch.extra_backward_input_arc_of_cch[j]);
+			}
+		}
+	}
+}
+
+template<unsigned K>
+CustomizableContractionHierarchyMultiMetric<K>::CustomizableContractionHierarchyMultiMetric(const CustomizableContractionHierarchy&cch, const std::array<const unsigned*, K>&input_weight):
+	forward((unsigned long long)cch.cch_arc_count()*K), backward((unsigned long long)cch.cch_arc_count()*K), cch(&cch), input_weight(input_weight){
+	for(unsigned k=0; k<K; ++k)
+		assert(input_weight[k] != nullptr && "Input weight pointer must not be null");
+}
+
+template<unsigned K>
+CustomizableContractionHierarchyMultiMetric<K>::CustomizableContractionHierarchyMultiMetric(const CustomizableContractionHierarchy&cch, const std::vector<std::vector<unsigned>>&input_weight):
+	forward((unsigned long long)cch.cch_arc_count()*K), backward((unsigned long long)cch.cch_arc_count()*K), cch(&cch){
+	assert(input_weight.size() == K && "Need exactly K input weight vectors");
+	for(unsigned k=0; k<K; ++k){
+		assert(input_weight[k].size() == cch.input_arc_count() && "Input weight vector has the wrong size");
+		this->input_weight[k] = input_weight[k].data();
+	}
+}
+
+template<unsigned K>
+CustomizableContractionHierarchyMultiMetric<K>& CustomizableContractionHierarchyMultiMetric<K>::reset(const CustomizableContractionHierarchy&cch, const std::array<const unsigned*, K>&input_weight){
+	if((unsigned long long)cch.cch_arc_count()*K != forward.size()){
+		*this = CustomizableContractionHierarchyMultiMetric(cch, input_weight);
+	}else{
+		this->cch = &cch;
+		this->input_weight = input_weight;
+	}
+	return *this;
+}
+
+template<unsigned K>
+CustomizableContractionHierarchyMultiMetric<K>& CustomizableContractionHierarchyMultiMetric<K>::reset(const CustomizableContractionHierarchy&cch, const std::vector<std::vector<unsigned>>&input_weight){
+	assert(input_weight.size() == K && "Need exactly K input weight vectors");
+	std::array<const unsigned*, K>p;
+	for(unsigned k=0; k<K; ++k){
+		assert(input_weight[k].size() == cch.input_arc_count() && "Input weight vector has the wrong size");
+		p[k] = input_weight[k].data();
+	}
+	return reset(cch, p);
+}
+
+template<unsigned K>
+CustomizableContractionHierarchyMultiMetric<K>& CustomizableContractionHierarchyMultiMetric<K>::customize(){
+	assert(cch != nullptr && "Metric must be attached to a CCH");
+
+	extract_initial_multi_metric<K>(*cch, input_weight, forward, backward);
+
+	unsigned*f = forward.data();
+	unsigned*b = backward.data();
+
+	std::vector<unsigned> arc_id_cache(cch->node_count());
+
+	for(unsigned x=0; x<cch->node_count(); ++x){
+		const unsigned xz_up_end = cch->up_first_out[x+1];
+		for(unsigned xz_up = cch->up_first_out[x]; xz_up < xz_up_end; ++xz_up){
+			arc_id_cache[cch->up_head[xz_up]] = xz_up;
+		}
+
+		const unsigned xy_down_end = cch->down_first_out[x+1];
+		for(unsigned xy_down = cch->down_first_out[x]; xy_down < xy_down_end; ++xy_down){
+			const unsigned long long yx_up = cch->down_to_up[xy_down];
+			const unsigned y = cch->down_head[xy_down];
+			const unsigned yz_up_end_reversed = cch->up_first_out[y];
+			for(unsigned yz_up_reversed = cch->up_first_out[y+1]; yz_up_reversed > yz_up_end_reversed; --yz_up_reversed){
+				const unsigned long long yz_up = yz_up_reversed-1;
+				const unsigned z = cch->up_head[yz_up];
+				if (z <= x) { break; }
+				const unsigned long long xz_up = arc_id_cache[z];
+				relax_interleaved<K>(f + xz_up*K, b + yx_up*K, f + yz_up*K);
+				relax_interleaved<K>(b + xz_up*K, f + yx_up*K, b + yz_up*K);
+			}
+		}
+	}
+	return *this;
+}
+
+template<unsigned K>
+void CustomizableContractionHierarchyMultiMetric<K>::extract_metric(unsigned metric_index, CustomizableContractionHierarchyMetric&metric)const{
+	assert(metric_index < K && "metric index out of bounds");
+	assert(metric.cch == cch && "metric must be attached to the same CCH");
+	const unsigned cch_arc_count = cch->cch_arc_count();
+	metric.forward.resize(cch_arc_count);
+	metric.backward.resize(cch_arc_count);
+	for(unsigned a=0; a<cch_arc_count; ++a){
+		metric.forward[a] = forward[(unsigned long long)a*K+metric_index];
+		metric.backward[a] = backward[(unsigned long long)a*K+metric_index];
+	}
+}
+
+namespace{
+	template<unsigned K>
+	void reset_multi_metric_search_space(std::vector<unsigned>&search_space, BitVector&in_search_space, std::vector<unsigned>&tentative_distance){
+		for(unsigned x:search_space){
+			in_search_space.reset(x);
+			std::fill(tentative_distance.begin() + (unsigned long long)x*K, tentative_distance.begin() + (unsigned long long)(x+1)*K, inf_weight);
+		}
+		search_space.clear();
+	}
+
+	template<unsigned K>
+	void add_to_multi_metric_search_space(unsigned x, unsigned dist, std::vector<unsigned>&search_space, BitVector&in_search_space, std::vector<unsigned>&tentative_distance){
+		if(!in_search_space.is_set(x)){
+			in_search_space.set(x);
+			search_space.push_back(x);
+		}
+		for(unsigned k=0; k<K; ++k)
+			min_to(tentative_distance[(unsigned long long)x*K+k], dist);
+	}
+
+	// Adds all ancestors of the nodes in the search space to it and relaxes the upward arcs
+	// of all nodes by increasing rank.
+	template<unsigned K>
+	void run_multi_metric_search(
+		const CustomizableContractionHierarchy&cch, const std::vector<unsigned>&weight,
+		std::vector<unsigned>&search_space, BitVector&in_search_space, std::vector<unsigned>&tentative_distance
+	){
+		const unsigned initial_node_count = search_space.size();
+		for(unsigned i=0; i<initial_node_count; ++i){
+			unsigned x = cch.elimination_tree_parent[search_space[i]];
+			while(x != invalid_id && !in_search_space.is_set(x)){
+				in_search_space.set(x);
+				search_space.push_back(x);
+				x = cch.elimination_tree_parent[x];
+			}
+		}
+		std::sort(search_space.begin(), search_space.end());
+
+		unsigned*d = tentative_distance.data();
+		const unsigned*w = weight.data();
+		for(unsigned x:search_space){
+			for(unsigned xy=cch.up_first_out[x]; xy<cch.up_first_out[x+1]; ++xy){
+				unsigned long long y = cch.up_head[xy];
+				relax_interleaved<K>(d + y*K, d + (unsigned long long)x*K, w + (unsigned long long)xy*K);
+			}
+		}
 	}
+}
+
+template<unsigned K>
+CustomizableContractionHierarchyMultiMetricQuery<K>::CustomizableContractionHierarchyMultiMetricQuery(const CustomizableContractionHierarchyMultiMetric<K>&metric):
+	metric(&metric),
+	forward_tentative_distance((unsigned long long)metric.cch->node_count()*K, inf_weight),
+	backward_tentative_distance((unsigned long long)metric.cch->node_count()*K, inf_weight),
+	in_forward_search_space(metric.cch->node_count()),
+	in_backward_search_space(metric.cch->node_count()),
+	state(query_state_initialized){
+}
+
+template<unsigned K>
+CustomizableContractionHierarchyMultiMetricQuery<K>& CustomizableContractionHierarchyMultiMetricQuery<K>::reset(){
+	reset_multi_metric_search_space<K>(forward_search_space, in_forward_search_space, forward_tentative_distance);
+	reset_multi_metric_search_space<K>(backward_search_space, in_backward_search_space, backward_tentative_distance);
 	state = query_state_initialized;
 	return *this;
 }
 
+template<unsigned K>
+CustomizableContractionHierarchyMultiMetricQuery<K>& CustomizableContractionHierarchyMultiMetricQuery<K>::reset(const CustomizableContractionHierarchyMultiMetric<K>&metric){
+	if(this->metric != nullptr && this->metric->cch == metric.cch){
+		reset();
+		this->metric = &metric;
+	}else{
+		*this = CustomizableContractionHierarchyMultiMetricQuery(metric);
+	}
+	return *this;
+}
+
+template<unsigned K>
+CustomizableContractionHierarchyMultiMetricQuery<K>& CustomizableContractionHierarchyMultiMetricQuery<K>::add_source(unsigned s, unsigned dist_to_s){
+	assert(state == query_state_initialized);
+	assert(s < metric->cch->node_count() && "node out of bounds");
+	add_to_multi_metric_search_space<K>(metric->cch->rank[s], dist_to_s, forward_search_space, in_forward_search_space, forward_tentative_distance);
+	return *this;
+}
+
+template<unsigned K>
+CustomizableContractionHierarchyMultiMetricQuery<K>& CustomizableContractionHierarchyMultiMetricQuery<K>::add_target(unsigned t, unsigned dist_to_t){
+	assert(state == query_state_initialized);
+	assert(t < metric->cch->node_count() && "node out of bounds");
+	add_to_multi_metric_search_space<K>(metric->cch->rank[t], dist_to_t, backward_search_space, in_backward_search_space, backward_tentative_distance);
+	return *this;
+}
+
+template<unsigned K>
+CustomizableContractionHierarchyMultiMetricQuery<K>& CustomizableContractionHierarchyMultiMetricQuery<K>::run(){
+	assert(state == query_state_initialized);
+
+	run_multi_metric_search<K>(*metric->cch, metric->forward, forward_search_space, in_forward_search_space, forward_tentative_distance);
+	run_multi_metric_search<K>(*metric->cch, metric->backward, backward_search_space, in_backward_search_space, backward_tentative_distance);
+
+	shortest_path_length.fill(inf_weight);
+	for(unsigned x:forward_search_space){
+		if(in_backward_search_space.is_set(x)){
+			for(unsigned k=0; k<K; ++k)
+				min_to(shortest_path_length[k], forward_tentative_distance[(unsigned long long)x*K+k] + backward_tentative_distance[(unsigned long long)x*K+k]);
+		}
+	}
+
+	state = query_state_run;
+	return *this;
+}
+
+template<unsigned K>
+unsigned CustomizableContractionHierarchyMultiMetricQuery<K>::get_distance(unsigned metric_index)const{
+	assert(state == query_state_run);
+	assert(metric_index < K && "metric index out of bounds");
+	return shortest_path_length[metric_index];
+}
+
+template<unsigned K>
+std::array<unsigned, K> CustomizableContractionHierarchyMultiMetricQuery<K>::get_distances()const{
+	assert(state == query_state_run);
+	return shortest_path_length;
+}
+
+template struct CustomizableContractionHierarchyMultiMetric<2>;
+template struct CustomizableContractionHierarchyMultiMetric<4>;
+template struct CustomizableContractionHierarchyMultiMetric<8>;
+template struct CustomizableContractionHierarchyMultiMetric<16>;
+
+template struct CustomizableContractionHierarchyMultiMetricQuery<2>;
+template struct CustomizableContractionHierarchyMultiMetricQuery<4>;
+template struct CustomizableContractionHierarchyMultiMetricQuery<8>;
+template struct CustomizableContractionHierarchyMultiMetricQuery<16>;
 
 } // namespace RoutingKit
 
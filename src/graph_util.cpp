@@ -8,13 +8,13 @@
 
 namespace RoutingKit{
 
-unsigned find_arc(const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, unsigned x, unsigned y){
+unsigned find_arc(ConstVectorView<unsigned>first_out, ConstVectorView<unsigned>head, unsigned x, unsigned y){
 	unsigned ret = find_arc_or_return_invalid(first_out, head, x, y);
 	assert(ret != invalid_id && "arc does not exist");
 	return ret;
 }
 
-unsigned find_arc_or_return_invalid(const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, unsigned x, unsigned y){
+unsigned find_arc_or_return_invalid(ConstVectorView<unsigned>first_out, ConstVectorView<unsigned>head, unsigned x, unsigned y){
 	assert(x < first_out.size()-1 && "node id out of bounds");
 	assert(y < first_out.size()-1 && "node id out of bounds");
 
@@ -24,13 +24,13 @@ unsigned find_arc_or_return_invalid(const std::vector<unsigned>&first_out, const
 	return invalid_id;
 }
 
-unsigned find_arc_given_sorted_head(const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, unsigned x, unsigned y){
+unsigned find_arc_given_sorted_head(ConstVectorView<unsigned>first_out, ConstVectorView<unsigned>head, unsigned x, unsigned y){
 	unsigned ret = find_arc_or_return_invalid_given_sorted_head(first_out, head, x, y);
 	assert(ret != invalid_id && "arc does not exist");
 	return ret;
 }
 
-unsigned find_arc_or_return_invalid_given_sorted_head(const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, unsigned x, unsigned y){
+unsigned find_arc_or_return_invalid_given_sorted_head(ConstVectorView<unsigned>first_out, ConstVectorView<unsigned>head, unsigned x, unsigned y){
 	assert(x < first_out.size()-1 && "node id out of bounds");
 	assert(y < first_out.size()-1 && "node id out of bounds");
 
@@ -0,0 +1,75 @@
+#ifndef INTERLEAVED_RELAXATION_H
+#define INTERLEAVED_RELAXATION_H
+
+#if defined(__SSE4_1__) || defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace RoutingKit{
+
+// The SIMD min-plus kernel shared by PHAST and the multi-metric CCH. K distances are stored
+// next to each other. The second summand is either an array of K weights or a single weight
+// that is added to all K distances.
+
+namespace interleaved_relaxation_detail{
+	inline unsigned get(const unsigned*b, unsigned i){ return b[i]; }
+	inline unsigned get(unsigned w, unsigned){ return w; }
+
+	#ifdef __AVX512F__
+	inline __m512i load16(const unsigned*b, unsigned i){ return _mm512_loadu_si512((const void*)(b+i)); }
+	inline __m512i load16(unsigned w, unsigned){ return _mm512_set1_epi32(w); }
+	#endif
+	#ifdef __AVX2__
+	inline __m256i load8(const unsigned*b, unsigned i){ return _mm256_loadu_si256((const __m256i*)(b+i)); }
+	inline __m256i load8(unsigned w, unsigned){ return _mm256_set1_epi32(w); }
+	#endif
+	#ifdef __SSE4_1__
+	inline __m128i load4(const unsigned*b, unsigned i){ return _mm_loadu_si128((const __m128i*)(b+i)); }
+	inline __m128i load4(unsigned w, unsigned){ return _mm_set1_epi32(w); }
+	#endif
+}
+
+// Sets d[i] to min(d[i], a[i]+b[i]) for all i < K, or to min(d[i], a[i]+b) if b is a single
+// weight. Uses the widest available SIMD instructions whose width divides K and falls back to
+// scalar code otherwise. As all weights are at most inf_weight = 2^31-1, the additions do not
+// overflow.
+template<unsigned K, class B>
+inline void relax_interleaved(unsigned*__restrict__ d, const unsigned*__restrict__ a, B b){
+	using namespace interleaved_relaxation_detail;
+	#ifdef __AVX512F__
+	if(K % 16 == 0){
+		for(unsigned i=0; i<K; i+=16){
+			__m512i sv = _mm512_add_epi32(_mm512_loadu_si512((const void*)(a+i)), load16(b, i));
+			__m512i dv = _mm512_loadu_si512((const void*)(d+i));
+			// The masked variant avoids a spurious uninitialized warning in GCC's _mm512_min_epu32
+			_mm512_storeu_si512((void*)(d+i), _mm512_mask_min_epu32(dv, 0xFFFF, dv, sv));
+		}
+		return;
+	}
+	#endif
+	#ifdef __AVX2__
+	if(K % 8 == 0){
+		for(unsigned i=0; i<K; i+=8){
+			__m256i sv = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(a+i)), load8(b, i));
+			_mm256_storeu_si256((__m256i*)(d+i), _mm256_min_epu32(_mm256_loadu_si256((const __m256i*)(d+i)), sv));
+		}
+		return;
+	}
+	#endif
+	#ifdef __SSE4_1__
+	if(K % 4 == 0){
+		for(unsigned i=0; i<K; i+=4){
+			__m128i sv = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(a+i)), load4(b, i));
+			_mm_storeu_si128((__m128i*)(d+i), _mm_min_epu32(_mm_loadu_si128((const __m128i*)(d+i)), sv));
+		}
+		return;
+	}
+	#endif
+	for(unsigned i=0; i<K; ++i)
+		if(a[i] + get(b, i) < d[i])
+			d[i] = a[i] + get(b, i);
+}
+
+} // RoutingKit
+
+#endif
@@ -0,0 +1,378 @@
+#include <routingkit/landmark_potential.h>
+#include <routingkit/id_queue.h>
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/permutation.h>
+#include <routingkit/sort.h>
+
+#include "mapped_file.h"
+
+#include <vector>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace RoutingKit{
+
+namespace{
+	struct Graph{
+		std::vector<unsigned>first_out;
+		std::vector<unsigned>head;
+		std::vector<unsigned>weight;
+	};
+
+	Graph build_backward_graph(const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, const std::vector<unsigned>&weight){
+		const unsigned node_count = first_out.size()-1;
+		auto tail = invert_inverse_vector(first_out);
+		auto backward_arc_to_forward_arc = compute_stable_sort_permutation_using_key(head, node_count, [](unsigned x){return x;});
+		Graph backward;
+		backward.first_out = invert_vector(apply_permutation(backward_arc_to_forward_arc, head), node_count);
+		backward.head = apply_permutation(backward_arc_to_forward_arc, tail);
+		backward.weight = apply_permutation(backward_arc_to_forward_arc, weight);
+		return backward; // NVRO
+	}
+
+	void check_graph(const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, const std::vector<unsigned>&weight){
+		if(first_out.empty() || first_out.front() != 0 || first_out.back() != head.size())
+			throw std::invalid_argument("first_out and head do not form an adjacency array");
+		if(weight.size() != head.size())
+			throw std::invalid_argument("The weight vector must be as long as the number of arcs");
+	}
+
+	// Runs Dijkstra's algorithm from source to all nodes. Unreachable nodes get distance
+	// inf_weight. If requested, the settled nodes and their parents in the shortest path
+	// tree are stored. Arcs with a weight of at least inf_weight are closed.
+	void compute_distances_from(
+		const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, const std::vector<unsigned>&weight,
+		unsigned source, MinIDQueue&queue, std::vector<unsigned>&distance,
+		std::vector<unsigned>*settle_order = nullptr, std::vector<unsigned>*parent = nullptr
+	){
+		std::fill(distance.begin(), distance.end(), inf_weight);
+		if(settle_order)
+			settle_order->clear();
+		if(parent){
+			parent->resize(distance.size());
+			(*parent)[source] = invalid_id;
+		}
+
+		queue.clear();
+		distance[source] = 0;
+		queue.push({source, 0});
+		while(!queue.empty()){
+			auto p = queue.pop();
+			unsigned x = p.id;
+			if(settle_order)
+				settle_order->push_back(x);
+			for(unsigned xy=first_out[x]; xy<first_out[x+1]; ++xy){
+				if(weight[xy] >= inf_weight)
+					continue;
+				unsigned y = head[xy];
+				unsigned d = p.key + weight[xy];
+				if(d < distance[y]){
+					if(distance[y] == inf_weight)
+						queue.push({y, d});
+					else
+						queue.decrease_key({y, d});
+					distance[y] = d;
+					if(parent)
+						(*parent)[y] = x;
+				}
+			}
+		}
+	}
+
+	// Among the nodes that are no landmarks, picks one that cannot be reached from any
+	// landmark or, if none exists, the last one settled by a search from all landmarks.
+	unsigned find_farthest_node(
+		const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, const std::vector<unsigned>&weight,
+		const std::vector<unsigned>&landmark, const std::vector<bool>&is_landmark
+	){
+		const unsigned node_count = first_out.size()-1;
+		MinIDQueue queue(node_count);
+		std::vector<unsigned>distance(node_count, inf_weight);
+		for(auto l:landmark){
+			distance[l] = 0;
+			queue.push({l, 0});
+		}
+		unsigned farthest_node = invalid_id;
+		while(!queue.empty()){
+			auto p = queue.pop();
+			unsigned x = p.id;
+			if(!is_landmark[x])
+				farthest_node = x;
+			for(unsigned xy=first_out[x]; xy<first_out[x+1]; ++xy){
+				if(weight[xy] >= inf_weight)
+					continue;
+				unsigned y = head[xy];
+				unsigned d = p.key + weight[xy];
+				if(d < distance[y]){
+					if(distance[y] == inf_weight)
+						queue.push({y, d});
+					else
+						queue.decrease_key({y, d});
+					distance[y] = d;
+				}
+			}
+		}
+		for(unsigned x=0; x<node_count; ++x)
+			if(distance[x] == inf_weight && !is_landmark[x])
+				return x;
+		return farthest_node;
+	}
+}
+
+std::vector<unsigned>select_farthest_landmarks(
+	const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, const std::vector<unsigned>&weight,
+	unsigned landmark_count, unsigned seed
+){
+	check_graph(first_out, head, weight);
+	const unsigned node_count = first_out.size()-1;
+	if(landmark_count > node_count)
+		throw std::invalid_argument("There can not be more landmarks than nodes");
+
+	std::vector<unsigned>landmark;
+	std::vector<bool>is_landmark(node_count, false);
+	if(landmark_count == 0)
+		return landmark; // NVRO
+
+	std::minstd_rand gen(seed);
+	unsigned start = std::uniform_int_distribution<unsigned>(0, node_count-1)(gen);
+
+	// The first landmark is the node farthest away from a random start node.
+	landmark.push_back(start);
+	is_landmark[start] = true;
+	unsigned first = find_farthest_node(first_out, head, weight, landmark, is_landmark);
+	if(first != invalid_id){
+		is_landmark[start] = false;
+		is_landmark[first] = true;
+		landmark[0] = first;
+	}
+
+	while(landmark.size() < landmark_count){
+		unsigned x = find_farthest_node(first_out, head, weight, landmark, is_landmark);
+		assert(x != invalid_id);
+		landmark.push_back(x);
+		is_landmark[x] = true;
+	}
+	return landmark; // NVRO
+}
+
+std::vector<unsigned>select_avoid_landmarks(
+	const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, const std::vector<unsigned>&weight,
+	unsigned landmark_count, unsigned seed, unsigned*farthest_fallback_count
+){
+	check_graph(first_out, head, weight);
+	if(farthest_fallback_count != nullptr)
+		*farthest_fallback_count = 0;
+	const unsigned node_count = first_out.size()-1;
+	if(landmark_count > node_count)
+		throw std::invalid_argument("There can not be more landmarks than nodes");
+
+	std::vector<unsigned>landmark;
+	if(landmark_count == 0)
+		return landmark; // NVRO
+
+	Graph backward = build_backward_graph(first_out, head, weight);
+
+	std::minstd_rand gen(seed);
+	std::uniform_int_distribution<unsigned>node_dist(0, node_count-1);
+
+	std::vector<bool>is_landmark(node_count, false);
+	std::vector<std::vector<unsigned>>distance_from_landmark, distance_to_landmark;
+
+	MinIDQueue queue(node_count);
+	std::vector<unsigned>distance_from_root(node_count), settle_order, parent;
+	std::vector<unsigned long long>subtree_weight(node_count);
+	std::vector<unsigned>heaviest_child(node_count);
+	std::vector<bool>does_subtree_contain_landmark(node_count);
+
+	// Selects a new landmark using a shortest path tree rooted at root. The landmark is a leaf
+	// of the heaviest subtree that contains no landmark. Returns invalid_id if every subtree
+	// contains a landmark, i.e., if all leaves are landmarks.
+	auto select_using_tree = [&](unsigned root){
+		compute_distances_from(first_out, head, weight, root, queue, distance_from_root, &settle_order, &parent);
+
+		for(auto x:settle_order){
+			// The weight of x is by how much the landmarks underestimate the distance from the root to x.
+			unsigned lower_bound = 0;
+			for(unsigned i=0; i<landmark.size(); ++i){
+				const auto&from = distance_from_landmark[i];
+				const auto&to = distance_to_landmark[i];
+				if(from[root] != inf_weight && from[x] > from[root] && from[x] - from[root] > lower_bound)
+					lower_bound = from[x] - from[root];
+				if(to[root] != inf_weight && to[x] != inf_weight && to[root] > to[x] && to[root] - to[x] > lower_bound)
+					lower_bound = to[root] - to[x];
+			}
+			subtree_weight[x] = distance_from_root[x] - lower_bound;
+			heaviest_child[x] = invalid_id;
+			does_subtree_contain_landmark[x] = is_landmark[x];
+		}
+
+		// Children are settled after their parents and are therefore finished before them.
+		// heaviest_child only considers children whose subtree contains no landmark.
+		for(unsigned i=settle_order.size(); i>0; --i){
+			unsigned x = settle_order[i-1];
+			unsigned p = parent[x];
+			if(p == invalid_id)
+				continue;
+			subtree_weight[p] += subtree_weight[x];
+			if(does_subtree_contain_landmark[x])
+				does_subtree_contain_landmark[p] = true;
+			else if(heaviest_child[p] == invalid_id || subtree_weight[x] > subtree_weight[heaviest_child[p]])
+				heaviest_child[p] = x;
+		}
+
+		unsigned x = invalid_id;
+		for(auto y:settle_order)
+			if(!does_subtree_contain_landmark[y] && (x == invalid_id || subtree_weight[y] > subtree_weight[x]))
+				x = y;
+		if(x == invalid_id)
+			return invalid_id;
+
+		// All nodes in the subtree of x are no landmarks. Descend to a leaf.
+		while(heaviest_child[x] != invalid_id)
+			x = heaviest_child[x];
+		assert(!is_landmark[x]);
+		return x;
+	};
+
+	while(landmark.size() < landmark_count){
+		unsigned x = invalid_id;
+		for(unsigned attempt=0; attempt<16 && x == invalid_id; ++attempt)
+			x = select_using_tree(node_dist(gen));
+		// If the leaves of all trees are landmarks, nearly all nodes are landmarks.
+		if(x == invalid_id){
+			x = find_farthest_node(first_out, head, weight, landmark, is_landmark);
+			if(farthest_fallback_count != nullptr)
+				++*farthest_fallback_count;
+		}
+		assert(x != invalid_id);
+
+		landmark.push_back(x);
+		is_landmark[x] = true;
+
+		distance_from_landmark.emplace_back(node_count);
+		compute_distances_from(first_out, head, weight, x, queue, distance_from_landmark.back());
+		distance_to_landmark.emplace_back(node_count);
+		compute_distances_from(backward.first_out, backward.head, backward.weight, x, queue, distance_to_landmark.back());
+	}
+	return landmark; // NVRO
+}
+
+LandmarkPotential::LandmarkPotential(
+	const std::vector<unsigned>&first_out, const std::vector<unsigned>&head, const std::vector<unsigned>&weight,
+	std::vector<unsigned>landmark_, unsigned thread_count
+):landmark(std::move(landmark_)){
+	check_graph(first_out, head, weight);
+	const unsigned node_count = first_out.size()-1;
+	const unsigned landmark_count = landmark.size();
+	if(landmark_count == 0)
+		throw std::invalid_argument("There must be at least one landmark");
+	for(auto l:landmark)
+		if(l >= node_count)
+			throw std::invalid_argument("Landmark ID out of bounds");
+	if(thread_count == 0)
+		thread_count = 1;
+
+	Graph backward = build_backward_graph(first_out, head, weight);
+
+	distance_from_landmark.resize((unsigned long long)node_count*landmark_count);
+	distance_to_landmark.resize((unsigned long long)node_count*landmark_count);
+
+	// Every search writes one column of a table.
+	#ifdef _OPENMP
+	#pragma omp parallel num_threads(thread_count)
+	#endif
+	{
+		MinIDQueue queue(node_count);
+		std::vector<unsigned>distance(node_count);
+
+		#ifdef _OPENMP
+		#pragma omp for schedule(dynamic, 1)
+		#endif
+		for(unsigned i=0; i<2*landmark_count; ++i){
+			unsigned l = i/2;
+			std::vector<unsigned>&table = i%2 == 0 ? distance_from_landmark : distance_to_landmark;
+			if(i%2 == 0)
+				compute_distances_from(first_out, head, weight, landmark[l], queue, distance);
+			else
+				compute_distances_from(backward.first_out, backward.head, backward.weight, landmark[l], queue, distance);
+			for(unsigned x=0; x<node_count; ++x)
+				table[(unsigned long long)x*landmark_count + l] = distance[x];
+		}
+	}
+}
+
+void LandmarkPotential::save_files(const std::string&landmark_file, const std::string&distance_from_landmark_file, const std::string&distance_to_landmark_file)const{
+	save_vector(landmark_file, landmark);
+	save_vector(distance_from_landmark_file, distance_from_landmark);
+	save_vector(distance_to_landmark_file, distance_to_landmark);
+}
+
+namespace{
+	void check_landmark_table_sizes(unsigned long long landmark_count, unsigned long long distance_from_landmark_size, unsigned long long distance_to_landmark_size){
+		if(landmark_count == 0)
+			throw std::runtime_error("The landmark file is empty.");
+		if(distance_from_landmark_size != distance_to_landmark_size)
+			throw std::runtime_error("The distance tables from and to the landmarks have different sizes.");
+		if(distance_from_landmark_size % landmark_count != 0)
+			throw std::runtime_error("The size of the distance tables is no multiple of the number of landmarks.");
+	}
+}
+
+LandmarkPotential LandmarkPotential::load_files(const std::string&landmark_file, const std::string&distance_from_landmark_file, const std::string&distance_to_landmark_file){
+	LandmarkPotential p;
+	p.landmark = load_vector<unsigned>(landmark_file);
+	p.distance_from_landmark = load_vector<unsigned>(distance_from_landmark_file);
+	p.distance_to_landmark = load_vector<unsigned>(distance_to_landmark_file);
+	check_landmark_table_sizes(p.landmark.size(), p.distance_from_landmark.size(), p.distance_to_landmark.size());
+	for(auto l:p.landmark)
+		if(l >= p.node_count())
+			throw std::runtime_error("Landmark ID out of bounds in \""+landmark_file+"\".");
+	return p; // NVRO
+}
+
+LandmarkPotentialView::LandmarkPotentialView(const LandmarkPotential&p):
+	landmark(p.landmark),
+	distance_from_landmark(p.distance_from_landmark),
+	distance_to_landmark(p.distance_to_landmark){}
+
+namespace{
+	// Holds the mapped files of a LandmarkPotentialView.
+	struct MappedLandmarkFiles{
+		std::shared_ptr<const MappedFile>landmark;
+		std::shared_ptr<const MappedFile>distance_from_landmark;
+		std::shared_ptr<const MappedFile>distance_to_landmark;
+	};
+
+	ConstVectorView<unsigned>get_mapped_vector(const MappedFile&file, const std::string&file_name){
+		if(file.size() % sizeof(unsigned) != 0)
+			throw std::runtime_error("File \""+file_name+"\" can not be a vector of unsigned because it's size is no multiple of the element type's size.");
+		return ConstVectorView<unsigned>((const unsigned*)file.data(), file.size()/sizeof(unsigned));
+	}
+}
+
+LandmarkPotentialView LandmarkPotentialView::map_files(const std::string&landmark_file, const std::string&distance_from_landmark_file, const std::string&distance_to_landmark_file){
+	auto files = std::make_shared<MappedLandmarkFiles>();
+	files->landmark = map_file(landmark_file);
+	files->distance_from_landmark = map_file(distance_from_landmark_file);
+	files->distance_to_landmark = map_file(distance_to_landmark_file);
+
+	LandmarkPotentialView p;
+	p.landmark = get_mapped_vector(*files->landmark, landmark_file);
+	p.distance_from_landmark = get_mapped_vector(*files->distance_from_landmark, distance_from_landmark_file);
+	p.distance_to_landmark = get_mapped_vector(*files->distance_to_landmark, distance_to_landmark_file);
+	check_landmark_table_sizes(p.landmark.size(), p.distance_from_landmark.size(), p.distance_to_landmark.size());
+	for(auto l:p.landmark)
+		if(l >= p.node_count())
+			throw std::runtime_error("Landmark ID out of bounds in \""+landmark_file+"\".");
+	p.mapped_file = std::move(files);
+	return p; // NVRO
+}
+
+} // RoutingKit
@@ -0,0 +1,91 @@
+#include "mapped_file.h"
+#include <stdexcept>
+#include <string>
+
+#ifndef ROUTING_KIT_NO_POSIX
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#else
+#include <stdio.h>
+#endif
+
+#include <string.h>
+
+namespace RoutingKit{
+
+#ifndef ROUTING_KIT_NO_POSIX
+
+MappedFile::MappedFile(const std::string&file_name):
+	data_(nullptr), size_(0){
+	int file_descriptor = ::open(file_name.c_str(), O_RDONLY);
+	if(file_descriptor == -1){
+		int error = errno;
+		throw std::runtime_error("Could not open file \""+file_name +"\" for mapping. The errno is "+std::to_string(error)+". strerror(errno) says the following : "+strerror(error));
+	}
+
+	struct ::stat buf;
+	if(::fstat(file_descriptor, &buf) != 0){
+		int error = errno;
+		::close(file_descriptor);
+		throw std::runtime_error("Could not determine the size of file \""+file_name +"\". The errno is "+std::to_string(error)+". strerror(errno) says the following : "+strerror(error));
+	}
+	size_ = buf.st_size;
+
+	if(size_ != 0){
+		void*p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, file_descriptor, 0);
+		if(p == MAP_FAILED){
+			int error = errno;
+			::close(file_descriptor);
+			throw std::runtime_error("Could not map file \""+file_name +"\" into memory. The errno is "+std::to_string(error)+". strerror(errno) says the following : "+strerror(error));
+		}
+		data_ = (char*)p;
+	}
+
+	// The mapping stays valid after the file descriptor is closed.
+	::close(file_descriptor);
+}
+
+MappedFile::~MappedFile(){
+	if(data_ != nullptr)
+		::munmap(data_, size_);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string&file_name):
+	data_(nullptr), size_(0){
+	FILE*file = fopen(file_name.c_str(), "rb");
+	if(file == nullptr)
+		throw std::runtime_error("Could not open file \""+file_name +"\" for reading.");
+	if(fseek(file, 0, SEEK_END) != 0 || ftell(file) == -1L){
+		fclose(file);
+		throw std::runtime_error("Could not determine the size of file \""+file_name +"\".");
+	}
+	size_ = ftell(file);
+	rewind(file);
+
+	// operator new returns memory that is suitably aligned for every scalar type.
+	data_ = (char*)::operator new(size_+1);
+	if(fread(data_, 1, size_, file) != size_){
+		fclose(file);
+		::operator delete(data_);
+		throw std::runtime_error("Could not read file \""+file_name +"\".");
+	}
+	fclose(file);
+}
+
+MappedFile::~MappedFile(){
+	::operator delete(data_);
+}
+
+#endif
+
+std::shared_ptr<const MappedFile>map_file(const std::string&file_name){
+	return std::make_shared<const MappedFile>(file_name);
+}
+
+} // namespace RoutingKit
@@ -0,0 +1,31 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <memory>
+
+namespace RoutingKit{
+
+// Maps a whole file read-only into memory. All processes that map the same file share the
+// pages in the page cache. If ROUTING_KIT_NO_POSIX is defined, the file is read into a
+// private buffer instead.
+class MappedFile{
+public:
+	explicit MappedFile(const std::string&file_name);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	const MappedFile&operator=(const MappedFile&) = delete;
+
+	const char*data()const{ return data_; }
+	unsigned long long size()const{ return size_; }
+private:
+	char*data_;
+	unsigned long long size_;
+};
+
+std::shared_ptr<const MappedFile>map_file(const std::string&file_name);
+
+} // RoutingKit
+
+#endif
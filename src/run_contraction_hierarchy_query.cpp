@@ -7,6 +7,8 @@
 #include <iostream>
 #include <stdexcept>
 #include <vector>
+#include <string>
+#include <algorithm>
 
 using namespace RoutingKit;
 using namespace std;
@@ -18,15 +20,26 @@ int main(int argc, char*argv[]){
 		string source_file;
 		string target_file;
 		string distance_file;
+		unsigned thread_count = 0;
 
-		if(argc != 5){
-			cerr << argv[0] << " ch_file source_file target_file distance_file" << endl;
-			return 1;
-		}else{
+		if(argc == 5){
+			ch_file = argv[1];
+			source_file = argv[2];
+			target_file = argv[3];
+			distance_file = argv[4];
+		}else if(argc == 7 && string(argv[5]) == "--threads"){
 			ch_file = argv[1];
 			source_file = argv[2];
 			target_file = argv[3];
 			distance_file = argv[4];
+			thread_count = stoul(argv[6]);
+			if(thread_count == 0){
+				cerr << "thread count must be at least 1" << endl;
+				return 1;
+			}
+		}else{
+			cerr << argv[0] << " ch_file source_file target_file distance_file [--threads thread_count]" << endl;
+			return 1;
 		}
 
 		cout << "Loading graph ... " << flush;
@@ -47,6 +60,34 @@ int main(int argc, char*argv[]){
 		cout << "Loaded " << query_count << " test queries" << endl;
 
 		vector<unsigned>distance(query_count);
+
+		if(thread_count != 0){
+			ContractionHierarchyBatchQuery batch_query(ch, thread_count);
+
+			cout << "Running test queries using " << batch_query.get_thread_count() << " threads ... " << flush;
+
+			vector<long long>query_time(query_count);
+			long long time = -get_micro_time();
+			batch_query.run(source.data(), target.data(), query_count, distance.data(), nullptr, nullptr, query_time.data());
+			time += get_micro_time();
+
+			cout << "done" << endl;
+
+			sort(query_time.begin(), query_time.end());
+
+			cout << "total running time : " << time << "musec" << endl;
+			if(query_count != 0 && time > 0)
+				cout << "queries per second : " << (long long)(query_count / (time / 1000000.0)) << endl;
+			if(query_count != 0){
+				cout << "p50 query latency : " << query_time[query_count/2] << "musec" << endl;
+				cout << "p99 query latency : " << query_time[(unsigned long long)query_count*99/100] << "musec" << endl;
+				cout << "max query latency : " << query_time.back() << "musec" << endl;
+			}
+
+			save_vector(distance_file, distance);
+			return 0;
+		}
+
 		ContractionHierarchyQuery ch_query(ch);
 
 		cout << "Running test queries ... " << flush;
@@ -54,6 +95,9 @@ int main(int argc, char*argv[]){
 		long long time_max = 0;
 		long long time_sum = 0;
 
+		unsigned long long settled_node_count_sum = 0;
+		unsigned long long stalled_node_count_sum = 0;
+
 		for(unsigned i=0; i<query_count; ++i){
 
 			long long time = -get_micro_time();
@@ -62,12 +106,17 @@ int main(int argc, char*argv[]){
 
 			time_max = std::max(time_max, time);
 			time_sum += time;
+
+			settled_node_count_sum += ch_query.get_settled_node_count();
+			stalled_node_count_sum += ch_query.get_stalled_node_count();
 		}
 
 		cout << "done" << endl;
 
 		cout << "max running time : " << time_max << "musec" << endl;
 		cout << "avg running time : " << time_sum/query_count << "musec" << endl;
+		cout << "avg settled nodes : " << settled_node_count_sum/query_count << endl;
+		cout << "avg stalled nodes : " << stalled_node_count_sum/query_count << endl;
 
 		save_vector(distance_file, distance);
 
@@ -0,0 +1,156 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/timer.h>
+#include <routingkit/min_max.h>
+#include <routingkit/id_queue.h>
+#include <routingkit/dijkstra.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/inverse_vector.h>
+
+#include "verify.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <string>
+
+using namespace RoutingKit;
+using namespace std;
+
+// Runs the same s-t queries with every priority queue and reports the average running time.
+// The distances of all queues are compared to those of the first queue.
+
+template<class Queue>
+void benchmark_dijkstra(
+	const string&queue_name,
+	const vector<unsigned>&first_out, const vector<unsigned>&tail, const vector<unsigned>&head, const vector<unsigned>&weight,
+	const vector<unsigned>&source, const vector<unsigned>&target,
+	vector<unsigned>&reference_distance
+){
+	BasicDijkstra<Queue>dij(first_out, tail, head);
+	vector<unsigned>distance(source.size());
+
+	long long time = -get_micro_time();
+	for(unsigned i=0; i<source.size(); ++i){
+		dij.reset().add_source(source[i]);
+		while(!dij.is_finished()){
+			auto x = dij.settle(ScalarGetWeight(weight)).node;
+			if(x == target[i])
+				break;
+		}
+		distance[i] = dij.get_distance_to(target[i]);
+	}
+	time += get_micro_time();
+
+	cout << "Dijkstra with " << queue_name << " : " << time/(long long)source.size() << "musec/query" << endl;
+
+	if(reference_distance.empty())
+		reference_distance = distance;
+	else if(reference_distance != distance)
+		throw runtime_error("Dijkstra with "+queue_name+" computed wrong distances.");
+}
+
+template<class Queue>
+void benchmark_contraction_hierarchy(
+	const string&queue_name,
+	const ContractionHierarchy&ch,
+	const vector<unsigned>&source, const vector<unsigned>&target,
+	vector<unsigned>&reference_distance
+){
+	BasicContractionHierarchyQuery<Queue>query(ch);
+	vector<unsigned>distance(source.size());
+
+	long long time = -get_micro_time();
+	for(unsigned i=0; i<source.size(); ++i)
+		distance[i] = query.reset().add_source(source[i]).add_target(target[i]).run().get_distance();
+	time += get_micro_time();
+
+	cout << "CH query with " << queue_name << " : " << time/(long long)source.size() << "musec/query" << endl;
+
+	if(reference_distance.empty())
+		reference_distance = distance;
+	else if(reference_distance != distance)
+		throw runtime_error("CH query with "+queue_name+" computed wrong distances.");
+}
+
+int main(int argc, char*argv[]){
+
+	try{
+		string first_out_file;
+		string head_file;
+		string weight_file;
+		string ch_file;
+		string source_file;
+		string target_file;
+
+		if(argc != 7){
+			cerr << argv[0] << " first_out_file head_file weight_file ch_file source_file target_file" << endl;
+			return 1;
+		}else{
+			first_out_file = argv[1];
+			head_file = argv[2];
+			weight_file = argv[3];
+			ch_file = argv[4];
+			source_file = argv[5];
+			target_file = argv[6];
+		}
+
+		cout << "Loading graph ... " << flush;
+
+		vector<unsigned>first_out = load_vector<unsigned>(first_out_file);
+		vector<unsigned>head = load_vector<unsigned>(head_file);
+		vector<unsigned>weight = load_vector<unsigned>(weight_file);
+		ContractionHierarchy ch = ContractionHierarchy::load_file(ch_file);
+
+		cout << "done" << endl;
+
+		cout << "Validity tests ... " << flush;
+		check_if_graph_is_valid(first_out, head);
+		cout << "done" << endl;
+
+		auto tail = invert_inverse_vector(first_out);
+
+		const unsigned node_count = first_out.size()-1;
+		const unsigned arc_count = head.size();
+
+		if(weight.size() != arc_count)
+			throw runtime_error("The weight vector must be as long as the number of arcs");
+		if(ch.node_count() != node_count)
+			throw runtime_error("The CH must have as many nodes as the graph");
+
+		cout << "Loading test queries ... " << flush;
+
+		vector<unsigned>source = load_vector<unsigned>(source_file);
+		vector<unsigned>target = load_vector<unsigned>(target_file);
+
+		cout << "done" << endl;
+
+		if(source.size() != target.size())
+			throw runtime_error("The source and target vectors must be of the same length.");
+		if(source.empty())
+			throw runtime_error("There must be at least one test query.");
+		if(max_element_of(source) >= node_count || max_element_of(target) >= node_count)
+			throw runtime_error("The test queries contain an out-of-bounds node id.");
+
+		cout << "Loaded " << source.size() << " test queries" << endl;
+
+		vector<unsigned>dijkstra_distance;
+		benchmark_dijkstra<BasicMinIDQueue<2, unsigned>>("2-ary heap", first_out, tail, head, weight, source, target, dijkstra_distance);
+		benchmark_dijkstra<BasicMinIDQueue<4, unsigned>>("4-ary heap", first_out, tail, head, weight, source, target, dijkstra_distance);
+		benchmark_dijkstra<BasicMinIDQueue<8, unsigned>>("8-ary heap", first_out, tail, head, weight, source, target, dijkstra_distance);
+		benchmark_dijkstra<BasicMinIDQueue<16, unsigned>>("16-ary heap", first_out, tail, head, weight, source, target, dijkstra_distance);
+		benchmark_dijkstra<MinIDRadixQueue>("radix heap", first_out, tail, head, weight, source, target, dijkstra_distance);
+
+		vector<unsigned>ch_distance;
+		benchmark_contraction_hierarchy<BasicMinIDQueue<2, unsigned>>("2-ary heap", ch, source, target, ch_distance);
+		benchmark_contraction_hierarchy<BasicMinIDQueue<4, unsigned>>("4-ary heap", ch, source, target, ch_distance);
+		benchmark_contraction_hierarchy<BasicMinIDQueue<8, unsigned>>("8-ary heap", ch, source, target, ch_distance);
+		benchmark_contraction_hierarchy<MinIDRadixQueue>("radix heap", ch, source, target, ch_distance);
+
+		if(dijkstra_distance != ch_distance)
+			throw runtime_error("Dijkstra and the CH query computed different distances.");
+
+	}catch(exception&err){
+		cerr << "Stopped on exception : " << err.what() << endl;
+		return 1;
+	}
+}
@@ -0,0 +1,185 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/astar.h>
+#include <routingkit/dijkstra.h>
+#include <routingkit/geo_dist.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/timer.h>
+
+#include <vector>
+#include <random>
+#include <string>
+
+#include "expect.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+// Checks that the potential is consistent for a few targets.
+void check_consistency(const GeoDistancePotential&potential, const vector<unsigned>&first_out, const vector<unsigned>&head, const vector<unsigned>&weight){
+	const unsigned node_count = first_out.size()-1;
+	minstd_rand gen;
+	uniform_int_distribution<unsigned>node_dist(0, node_count-1);
+	for(unsigned i=0; i<10; ++i){
+		unsigned t = node_dist(gen);
+		for(unsigned x=0; x<node_count; ++x)
+			for(unsigned xy=first_out[x]; xy<first_out[x+1]; ++xy)
+				if(weight[xy] < inf_weight)
+					EXPECT_CMP(potential(x, t), <=, weight[xy] + potential(head[xy], t));
+	}
+}
+
+// Runs random point-to-point queries with Dijkstra and AStar and checks that both compute
+// the same distances and that the paths found by AStar are valid.
+template<class Queue>
+void compare_with_dijkstra(
+	const string&name,
+	const vector<unsigned>&first_out, const vector<unsigned>&tail, const vector<unsigned>&head, const vector<unsigned>&weight,
+	const GeoDistancePotential&potential
+){
+	cout << "Testing " << name << " ... " << flush;
+
+	const unsigned node_count = first_out.size()-1;
+	Dijkstra dij(first_out, tail, head);
+	AStar<GeoDistancePotential, Queue>astar(first_out, tail, head, potential);
+
+	minstd_rand gen;
+	uniform_int_distribution<unsigned>node_dist(0, node_count-1);
+
+	long long dijkstra_time = 0, astar_time = 0;
+	unsigned long long dijkstra_settled_node_count = 0, astar_settled_node_count = 0;
+	const unsigned query_count = 200;
+	for(unsigned i=0; i<query_count; ++i){
+		unsigned s = node_dist(gen), t = node_dist(gen);
+
+		dijkstra_time -= get_micro_time();
+		dij.reset().add_source(s);
+		while(!dij.is_finished()){
+			++dijkstra_settled_node_count;
+			if(dij.settle(ScalarGetWeight(weight)).node == t)
+				break;
+		}
+		dijkstra_time += get_micro_time();
+
+		astar_time -= get_micro_time();
+		astar.reset(t).add_source(s);
+		while(!astar.is_finished()){
+			++astar_settled_node_count;
+			astar.settle(ScalarGetWeight(weight));
+		}
+		astar_time += get_micro_time();
+
+		unsigned dist = astar.get_distance_to(t);
+		EXPECT_CMP(dist, ==, dij.get_distance_to(t));
+
+		auto node_path = astar.get_node_path_to(t);
+		auto arc_path = astar.get_arc_path_to(t);
+		if(dist == inf_weight){
+			EXPECT(node_path.empty());
+			EXPECT(arc_path.empty());
+		}else{
+			EXPECT_CMP(node_path.size(), ==, arc_path.size()+1);
+			EXPECT_CMP(node_path.front(), ==, s);
+			EXPECT_CMP(node_path.back(), ==, t);
+			unsigned length = 0;
+			for(unsigned j=0; j<arc_path.size(); ++j){
+				EXPECT_CMP(tail[arc_path[j]], ==, node_path[j]);
+				EXPECT_CMP(head[arc_path[j]], ==, node_path[j+1]);
+				length += weight[arc_path[j]];
+			}
+			EXPECT_CMP(length, ==, dist);
+		}
+	}
+	cout << "done" << endl;
+	cout << "Dijkstra : " << dijkstra_time/query_count << "musec/query, " << dijkstra_settled_node_count/query_count << " settled nodes/query" << endl;
+	cout << "AStar : " << astar_time/query_count << "musec/query, " << astar_settled_node_count/query_count << " settled nodes/query" << endl;
+}
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 6){
+			cout << argv[0] << " first_out head weight latitude longitude" << endl;
+			return 1;
+		}
+
+		cout << "Loading data ... " << flush;
+		auto first_out = load_vector<unsigned>(argv[1]);
+		auto head = load_vector<unsigned>(argv[2]);
+		auto weight = load_vector<unsigned>(argv[3]);
+		auto latitude = load_vector<float>(argv[4]);
+		auto longitude = load_vector<float>(argv[5]);
+		cout << "done" << endl;
+
+		const unsigned node_count = first_out.size()-1;
+		const unsigned arc_count = head.size();
+		auto tail = invert_inverse_vector(first_out);
+
+		// Some arcs are closed.
+		for(unsigned a=0; a<arc_count; a+=97)
+			weight[a] = inf_weight;
+
+		cout << "Testing potential ... " << flush;
+		{
+			GeoDistancePotential potential(latitude, longitude, 1.0);
+			EXPECT_CMP(potential.node_count(), ==, node_count);
+			minstd_rand gen;
+			uniform_int_distribution<unsigned>node_dist(0, node_count-1);
+			for(unsigned i=0; i<1000; ++i){
+				unsigned x = node_dist(gen), y = node_dist(gen);
+				EXPECT_CMP(potential(x, x), ==, 0u);
+				EXPECT_CMP(potential(x, y), ==, potential(y, x));
+				// The straight line is never longer than the great-circle distance.
+				EXPECT_CMP(potential(x, y), <=, geo_dist(latitude[x], longitude[x], latitude[y], longitude[y]) + 1);
+			}
+		}
+		cout << "done" << endl;
+
+		{
+			double weight_per_meter = GeoDistancePotential::compute_largest_valid_weight_per_meter(first_out, head, weight, latitude, longitude);
+			cout << "Largest valid weight per meter of the input weights : " << weight_per_meter << endl;
+			check_consistency(GeoDistancePotential(latitude, longitude, weight_per_meter), first_out, head, weight);
+			GeoDistancePotential potential(latitude, longitude, weight_per_meter);
+			compare_with_dijkstra<MinIDQueue>("input weights", first_out, tail, head, weight, potential);
+		}
+
+		// The weights are rounded down as by compute_geographic_distance_weights and
+		// simple_load_osm_car_routing_graph_from_pbf. Some arcs are therefore shorter than
+		// the straight line between their endpoints.
+		vector<unsigned>geo_weight(arc_count), travel_time(arc_count);
+		{
+			minstd_rand gen;
+			uniform_int_distribution<unsigned>speed_dist(10, 130);
+			for(unsigned a=0; a<arc_count; ++a){
+				geo_weight[a] = static_cast<unsigned>(geo_dist(latitude[tail[a]], longitude[tail[a]], latitude[head[a]], longitude[head[a]]));
+				travel_time[a] = geo_weight[a] * 18000 / speed_dist(gen) / 5;
+				if(weight[a] == inf_weight){
+					geo_weight[a] = inf_weight;
+					travel_time[a] = inf_weight;
+				}
+			}
+		}
+
+		{
+			double weight_per_meter = GeoDistancePotential::compute_largest_valid_weight_per_meter(first_out, head, geo_weight, latitude, longitude);
+			cout << "Largest valid weight per meter of the geo distance weights : " << weight_per_meter << endl;
+			EXPECT_CMP(weight_per_meter, >, 0.0);
+			check_consistency(GeoDistancePotential(latitude, longitude, weight_per_meter), first_out, head, geo_weight);
+			GeoDistancePotential potential(latitude, longitude, weight_per_meter);
+			compare_with_dijkstra<MinIDQueue>("geo distance weights", first_out, tail, head, geo_weight, potential);
+			compare_with_dijkstra<MinIDRadixQueue>("geo distance weights with radix queue", first_out, tail, head, geo_weight, potential);
+		}
+
+		{
+			double weight_per_meter = GeoDistancePotential::compute_largest_valid_weight_per_meter(first_out, head, travel_time, latitude, longitude);
+			cout << "Largest valid weight per meter of the travel times : " << weight_per_meter << endl;
+			EXPECT_CMP(weight_per_meter, >, 0.0);
+			check_consistency(GeoDistancePotential(latitude, longitude, weight_per_meter), first_out, head, travel_time);
+			GeoDistancePotential potential(latitude, longitude, weight_per_meter);
+			compare_with_dijkstra<MinIDQueue>("travel times", first_out, tail, head, travel_time, potential);
+		}
+
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
@@ -0,0 +1,176 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/dijkstra.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/permutation.h>
+#include <routingkit/sort.h>
+#include <routingkit/timer.h>
+
+#include <vector>
+#include <random>
+
+#include "expect.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 4){
+			cout << argv[0] << " first_out head weight" << endl;
+			return 1;
+		}
+
+		cout << "Loading data ... " << flush;
+		auto first_out = load_vector<unsigned>(argv[1]);
+		auto head = load_vector<unsigned>(argv[2]);
+		auto weight = load_vector<unsigned>(argv[3]);
+		cout << "done" << endl;
+
+		const unsigned node_count = first_out.size()-1;
+		auto tail = invert_inverse_vector(first_out);
+
+		// Some arcs are closed.
+		for(unsigned a=0; a<weight.size(); a+=97)
+			weight[a] = inf_weight;
+
+		cout << "Building backward graph ... " << flush;
+		auto backward_arc_to_forward_arc = compute_stable_sort_permutation_using_key(head, node_count, [](unsigned x){return x;});
+		auto backward_first_out = invert_vector(apply_permutation(backward_arc_to_forward_arc, head), node_count);
+		auto backward_head = apply_permutation(backward_arc_to_forward_arc, tail);
+		auto backward_weight = apply_permutation(backward_arc_to_forward_arc, weight);
+		cout << "done" << endl;
+
+		Dijkstra dij(first_out, tail, head);
+		BidirectionalDijkstra bidij(first_out, head, weight, backward_first_out, backward_head, backward_weight, backward_arc_to_forward_arc);
+
+		// Checks that the path found by bidij is a path from a source to a target and that its
+		// length matches the distance.
+		auto check_path = [&](const vector<unsigned>&source, const vector<unsigned>&source_offset, const vector<unsigned>&target, const vector<unsigned>&target_offset){
+			unsigned dist = bidij.get_distance();
+			auto node_path = bidij.get_node_path();
+			auto arc_path = bidij.get_arc_path();
+			if(dist == inf_weight){
+				EXPECT(node_path.empty());
+				EXPECT(arc_path.empty());
+				EXPECT_CMP(bidij.get_used_source(), ==, invalid_id);
+				EXPECT_CMP(bidij.get_used_target(), ==, invalid_id);
+				return;
+			}
+
+			EXPECT_CMP(node_path.size(), ==, arc_path.size()+1);
+			EXPECT_CMP(node_path.front(), ==, bidij.get_used_source());
+			EXPECT_CMP(node_path.back(), ==, bidij.get_used_target());
+
+			unsigned used_source_offset = inf_weight, used_target_offset = inf_weight;
+			for(unsigned i=0; i<source.size(); ++i)
+				if(source[i] == node_path.front())
+					used_source_offset = min(used_source_offset, source_offset[i]);
+			for(unsigned i=0; i<target.size(); ++i)
+				if(target[i] == node_path.back())
+					used_target_offset = min(used_target_offset, target_offset[i]);
+			EXPECT_CMP(used_source_offset, !=, inf_weight);
+			EXPECT_CMP(used_target_offset, !=, inf_weight);
+
+			unsigned length = used_source_offset + used_target_offset;
+			for(unsigned i=0; i<arc_path.size(); ++i){
+				EXPECT_CMP(tail[arc_path[i]], ==, node_path[i]);
+				EXPECT_CMP(head[arc_path[i]], ==, node_path[i+1]);
+				length += weight[arc_path[i]];
+			}
+			EXPECT_CMP(length, ==, dist);
+		};
+
+		minstd_rand gen;
+		uniform_int_distribution<unsigned>node_dist(0, node_count-1), offset_dist(0, 5000);
+
+		cout << "Testing point to point queries ... " << flush;
+		{
+			long long dijkstra_time = 0, bidirectional_time = 0;
+			unsigned long long dijkstra_settled_node_count = 0, bidirectional_settled_node_count = 0;
+			const unsigned query_count = 200;
+			for(unsigned i=0; i<query_count; ++i){
+				unsigned s = node_dist(gen), t = node_dist(gen);
+
+				dijkstra_time -= get_micro_time();
+				dij.reset().add_source(s);
+				while(!dij.is_finished()){
+					++dijkstra_settled_node_count;
+					if(dij.settle(ScalarGetWeight(weight)).node == t)
+						break;
+				}
+				dijkstra_time += get_micro_time();
+
+				bidirectional_time -= get_micro_time();
+				bidij.reset().add_source(s).add_target(t).run();
+				bidirectional_time += get_micro_time();
+				bidirectional_settled_node_count += bidij.get_settled_node_count();
+
+				EXPECT_CMP(bidij.get_distance(), ==, dij.get_distance_to(t));
+				check_path({s}, {0}, {t}, {0});
+			}
+			cout << "done" << endl;
+			cout << "Dijkstra : " << dijkstra_time/query_count << "musec/query, " << dijkstra_settled_node_count/query_count << " settled nodes/query" << endl;
+			cout << "Bidirectional Dijkstra : " << bidirectional_time/query_count << "musec/query, " << bidirectional_settled_node_count/query_count << " settled nodes/query" << endl;
+		}
+
+		cout << "Testing queries with several sources and targets ... " << flush;
+		{
+			for(unsigned i=0; i<100; ++i){
+				unsigned source_count = 1 + i%4, target_count = 1 + i/4%4;
+				vector<unsigned>source(source_count), source_offset(source_count), target(target_count), target_offset(target_count);
+				for(auto&x:source)
+					x = node_dist(gen);
+				for(auto&x:source_offset)
+					x = offset_dist(gen);
+				for(auto&x:target)
+					x = node_dist(gen);
+				for(auto&x:target_offset)
+					x = offset_dist(gen);
+				// Some queries have a node that is a source and a target.
+				if(i % 10 == 0)
+					target[0] = source[0];
+
+				dij.reset();
+				for(unsigned j=0; j<source_count; ++j)
+					dij.add_source(source[j], source_offset[j]);
+				while(!dij.is_finished())
+					dij.settle(ScalarGetWeight(weight));
+
+				unsigned ref_dist = inf_weight;
+				for(unsigned j=0; j<target_count; ++j){
+					unsigned d = dij.get_distance_to(target[j]);
+					if(d != inf_weight && d + target_offset[j] < ref_dist)
+						ref_dist = d + target_offset[j];
+				}
+
+				bidij.reset();
+				for(unsigned j=0; j<source_count; ++j)
+					bidij.add_source(source[j], source_offset[j]);
+				for(unsigned j=0; j<target_count; ++j)
+					bidij.add_target(target[j], target_offset[j]);
+				bidij.run();
+
+				EXPECT_CMP(bidij.get_distance(), ==, ref_dist);
+				check_path(source, source_offset, target, target_offset);
+			}
+		}
+		cout << "done" << endl;
+
+		cout << "Testing radix queue ... " << flush;
+		{
+			BasicBidirectionalDijkstra<MinIDRadixQueue>radix_bidij(first_out, head, weight, backward_first_out, backward_head, backward_weight, backward_arc_to_forward_arc);
+			for(unsigned i=0; i<100; ++i){
+				unsigned s = node_dist(gen), t = node_dist(gen);
+				bidij.reset().add_source(s).add_target(t).run();
+				radix_bidij.reset().add_source(s).add_target(t).run();
+				EXPECT_CMP(bidij.get_distance(), ==, radix_bidij.get_distance());
+			}
+		}
+		cout << "done" << endl;
+
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
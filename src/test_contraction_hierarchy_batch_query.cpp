@@ -0,0 +1,74 @@
+#include <routingkit/contraction_hierarchy.h>
+
+#include <vector>
+#include <random>
+
+#include "expect.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 2){
+			cout << argv[0] << " ch_file" << endl;
+			return 1;
+		}
+
+		cout << "Loading Contraction Hierarchy ... " << flush;
+		ContractionHierarchy ch = ContractionHierarchy::load_file(argv[1]);
+		cout << "done" << endl;
+
+		const unsigned node_count = ch.node_count();
+		const unsigned query_count = 1000;
+
+		minstd_rand gen;
+		uniform_int_distribution<unsigned>node_dist(0, node_count-1);
+
+		vector<unsigned>source(query_count), target(query_count);
+		for(unsigned i=0; i<query_count; ++i){
+			source[i] = node_dist(gen);
+			target[i] = node_dist(gen);
+		}
+
+		cout << "Computing reference answers ... " << flush;
+		vector<unsigned>ref_dist(query_count);
+		vector<vector<unsigned>>ref_node_path(query_count), ref_arc_path(query_count);
+		{
+			ContractionHierarchyQuery query(ch);
+			for(unsigned i=0; i<query_count; ++i){
+				query.reset().add_source(source[i]).add_target(target[i]).run();
+				ref_dist[i] = query.get_distance();
+				ref_node_path[i] = query.get_node_path();
+				ref_arc_path[i] = query.get_arc_path();
+			}
+		}
+		cout << "done" << endl;
+
+		ContractionHierarchyBatchQuery batch_query;
+		for(unsigned thread_count : {1u, 2u, 4u}){
+			cout << "Testing batch queries using " << thread_count << " threads ... " << flush;
+			batch_query.reset(ch, thread_count);
+
+			EXPECT(batch_query.get_distances(source, target) == ref_dist);
+
+			vector<unsigned>dist(query_count);
+			vector<vector<unsigned>>node_path(query_count), arc_path(query_count);
+			vector<long long>query_time(query_count, -1);
+			batch_query.run(source.data(), target.data(), query_count, dist.data(), node_path.data(), arc_path.data(), query_time.data());
+
+			EXPECT(dist == ref_dist);
+			EXPECT(node_path == ref_node_path);
+			EXPECT(arc_path == ref_arc_path);
+			for(auto t:query_time)
+				EXPECT_CMP(t, >=, 0);
+
+			cout << "done" << endl;
+		}
+
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
@@ -0,0 +1,69 @@
+#include <routingkit/contraction_hierarchy.h>
+
+#include <vector>
+#include <random>
+
+#include "expect.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 2){
+			cout << argv[0] << " ch_file" << endl;
+			return 1;
+		}
+
+		cout << "Loading Contraction Hierarchy ... " << flush;
+		ContractionHierarchy ch = ContractionHierarchy::load_file(argv[1]);
+		cout << "done" << endl;
+
+		minstd_rand gen;
+		uniform_int_distribution<unsigned>node_dist(0, ch.node_count()-1);
+
+		ContractionHierarchyQuery query(ch);
+		ContractionHierarchyManyToMany many_to_many(ch);
+
+		for(unsigned source_count : {0u, 1u, 13u, 200u}){
+			for(unsigned target_count : {0u, 1u, 17u, 300u}){
+				cout << "Testing " << source_count << "x" << target_count << " table ... " << flush;
+
+				vector<unsigned>source_list(source_count), target_list(target_count);
+				for(auto&x:source_list)
+					x = node_dist(gen);
+				for(auto&x:target_list)
+					x = node_dist(gen);
+				// Duplicates must be supported
+				if(source_count > 1)
+					source_list.back() = source_list.front();
+				if(target_count > 1)
+					target_list.back() = target_list.front();
+
+				vector<unsigned>ref(source_count*target_count);
+				if(target_count != 0){
+					query.reset().pin_targets(target_list);
+					for(unsigned i=0; i<source_count; ++i){
+						auto d = query.reset_source().add_source(source_list[i]).run_to_pinned_targets().get_distances_to_targets();
+						copy(d.begin(), d.end(), ref.begin() + i*target_count);
+					}
+				}
+
+				for(unsigned thread_count : {1u, 3u}){
+					many_to_many.set_targets(target_list, thread_count);
+					EXPECT_CMP(many_to_many.get_target_count(), ==, target_count);
+					EXPECT(many_to_many.get_distances(source_list, thread_count) == ref);
+
+					vector<unsigned>dist(source_count*target_count, 42);
+					many_to_many.get_distances(source_list, dist.data(), thread_count);
+					EXPECT(dist == ref);
+				}
+				cout << "done" << endl;
+			}
+		}
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
@@ -0,0 +1,134 @@
+#include <routingkit/contraction_hierarchy.h>
+
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "expect.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+template<class T>
+bool is_equal(ConstVectorView<T>l, const vector<T>&r){
+	return l.size() == r.size() && std::equal(l.begin(), l.end(), r.begin());
+}
+
+bool is_equal(ConstBitVectorView l, const BitVector&r){
+	if(l.size() != r.size())
+		return false;
+	for(uint64_t i=0; i<l.size(); ++i)
+		if(l.is_set(i) != r.is_set(i))
+			return false;
+	return true;
+}
+
+bool is_equal(const ContractionHierarchyView::Side&l, const ContractionHierarchy::Side&r){
+	return
+		is_equal(l.first_out, r.first_out) &&
+		is_equal(l.head, r.head) &&
+		is_equal(l.weight, r.weight) &&
+		is_equal(l.is_shortcut_an_original_arc, r.is_shortcut_an_original_arc) &&
+		is_equal(l.shortcut_first_arc, r.shortcut_first_arc) &&
+		is_equal(l.shortcut_second_arc, r.shortcut_second_arc);
+}
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 3){
+			cout << argv[0] << " ch_file mappable_ch_file" << endl;
+			cout << "mappable_ch_file is overwritten" << endl;
+			return 1;
+		}
+
+		cout << "Loading Contraction Hierarchy ... " << flush;
+		ContractionHierarchy ch = ContractionHierarchy::load_file(argv[1]);
+		cout << "done" << endl;
+
+		cout << "Writing mappable Contraction Hierarchy ... " << flush;
+		ch.save_mappable_file(argv[2]);
+		cout << "done" << endl;
+
+		cout << "Mapping Contraction Hierarchy ... " << flush;
+		ContractionHierarchyView mapped_ch = ContractionHierarchyView::map_file(argv[2]);
+		cout << "done" << endl;
+
+		cout << "Comparing arrays ... " << flush;
+		EXPECT(static_cast<bool>(mapped_ch));
+		EXPECT(!static_cast<bool>(ContractionHierarchyView()));
+		EXPECT_CMP(mapped_ch.node_count(), ==, ch.node_count());
+		EXPECT(is_equal(mapped_ch.rank, ch.rank));
+		EXPECT(is_equal(mapped_ch.order, ch.order));
+		EXPECT(is_equal(mapped_ch.forward, ch.forward));
+		EXPECT(is_equal(mapped_ch.backward, ch.backward));
+		EXPECT_CMP((unsigned long long)mapped_ch.forward.head.data() % 4096, ==, 0ull);
+		cout << "done" << endl;
+
+		cout << "Checking that an ordinary CH file is rejected ... " << flush;
+		{
+			bool was_rejected = false;
+			try{
+				ContractionHierarchyView::map_file(argv[1]);
+			}catch(std::runtime_error&){
+				was_rejected = true;
+			}
+			EXPECT(was_rejected);
+		}
+		cout << "done" << endl;
+
+		const unsigned node_count = ch.node_count();
+
+		minstd_rand gen;
+		uniform_int_distribution<unsigned>node_dist(0, node_count-1);
+
+		ContractionHierarchyQuery query(ch), mapped_query(mapped_ch);
+
+		cout << "Testing point to point queries ... " << flush;
+		for(unsigned i=0; i<1000; ++i){
+			unsigned s = node_dist(gen), t = node_dist(gen);
+
+			query.reset().add_source(s).add_target(t).run();
+			mapped_query.reset().add_source(s).add_target(t).run();
+
+			EXPECT_CMP(query.get_distance(), ==, mapped_query.get_distance());
+			EXPECT(query.get_node_path() == mapped_query.get_node_path());
+			EXPECT(query.get_arc_path() == mapped_query.get_arc_path());
+		}
+		cout << "done" << endl;
+
+		cout << "Testing pinned queries ... " << flush;
+		{
+			vector<unsigned>pinned(50);
+			for(auto&x:pinned)
+				x = node_dist(gen);
+
+			query.reset().pin_targets(pinned);
+			mapped_query.reset().pin_targets(pinned);
+			for(unsigned i=0; i<50; ++i){
+				unsigned s = node_dist(gen);
+				query.reset_source().add_source(s).run_to_pinned_targets();
+				mapped_query.reset_source().add_source(s).run_to_pinned_targets();
+				EXPECT(query.get_distances_to_targets() == mapped_query.get_distances_to_targets());
+				EXPECT(query.get_used_sources_to_targets() == mapped_query.get_used_sources_to_targets());
+			}
+		}
+		cout << "done" << endl;
+
+		cout << "Testing that the mapping outlives the view ... " << flush;
+		{
+			ContractionHierarchyQuery detached_query(ContractionHierarchyView::map_file(argv[2]));
+			for(unsigned i=0; i<100; ++i){
+				unsigned s = node_dist(gen), t = node_dist(gen);
+				query.reset().add_source(s).add_target(t).run();
+				detached_query.reset().add_source(s).add_target(t).run();
+				EXPECT_CMP(query.get_distance(), ==, detached_query.get_distance());
+			}
+		}
+		cout << "done" << endl;
+
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
@@ -0,0 +1,121 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/dijkstra.h>
+#include <routingkit/timer.h>
+
+#include <vector>
+#include <random>
+
+#include "expect.h"
+#include "verify.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 4){
+			cout << argv[0] << " first_out head weight" << endl;
+			return 1;
+		}
+		cout << "Loading data ... " << flush;
+		vector<unsigned>
+			first_out = load_vector<unsigned>(argv[1]),
+			head = load_vector<unsigned>(argv[2]),
+			weight = load_vector<unsigned>(argv[3]);
+		cout << "done" << endl;
+
+		cout << "Validity tests ... " << flush;
+		check_if_graph_is_valid(first_out, head);
+		cout << "done" << endl;
+
+		const unsigned node_count = first_out.size()-1;
+		vector<unsigned>tail = invert_inverse_vector(first_out);
+
+		const unsigned query_count = 1000;
+
+		minstd_rand gen;
+		uniform_int_distribution<unsigned>node_dist(0, node_count-1);
+
+		vector<unsigned>source(query_count), target(query_count), ref_distance(query_count);
+		for(unsigned i=0; i<query_count; ++i){
+			source[i] = node_dist(gen);
+			target[i] = node_dist(gen);
+		}
+
+		cout << "Computing reference distances ... " << flush;
+		{
+			Dijkstra dij(first_out, tail, head);
+			for(unsigned i=0; i<query_count; ++i){
+				dij.reset().add_source(source[i]);
+				while(!dij.is_finished())
+					if(dij.settle(ScalarGetWeight(weight)).node == target[i])
+						break;
+				ref_distance[i] = dij.get_distance_to(target[i]);
+			}
+		}
+		cout << "done" << endl;
+
+		auto check_queries = [&](const ContractionHierarchy&ch){
+			check_contraction_hierarchy_for_errors(ch);
+
+			cout << "Running test queries ... " << flush;
+			ContractionHierarchyQuery ch_query(ch);
+			for(unsigned i=0; i<query_count; ++i){
+				ch_query.reset().add_source(source[i]).add_target(target[i]).run();
+				EXPECT_CMP(ch_query.get_distance(), ==, ref_distance[i]);
+
+				auto arc_path = ch_query.get_arc_path();
+				if(ref_distance[i] != inf_weight && source[i] != target[i]){
+					EXPECT(!arc_path.empty());
+					if(!arc_path.empty()){
+						EXPECT_CMP(tail[arc_path.front()], ==, source[i]);
+						EXPECT_CMP(head[arc_path.back()], ==, target[i]);
+						unsigned path_length = 0;
+						for(unsigned j=0; j<arc_path.size(); ++j){
+							path_length += weight[arc_path[j]];
+							if(j != 0)
+								EXPECT_CMP(head[arc_path[j-1]], ==, tail[arc_path[j]]);
+						}
+						EXPECT_CMP(path_length, ==, ref_distance[i]);
+					}
+				}
+			}
+			cout << "done" << endl;
+		};
+
+		vector<unsigned>order;
+
+		for(unsigned thread_count : {1u, 2u, 4u, 7u}){
+			cout << "Building CH using " << thread_count << " threads ... " << flush;
+			long long time = -get_micro_time();
+			auto ch = ContractionHierarchy::build(node_count, tail, head, weight, std::function<void(std::string)>(), ContractionHierarchy::default_max_pop_count, thread_count);
+			time += get_micro_time();
+			cout << "done [" << time << "musec]" << endl;
+			cout << "CH has " << ch.forward.head.size() << " forward and " << ch.backward.head.size() << " backward arcs" << endl;
+
+			check_queries(ch);
+
+			if(thread_count == 1)
+				order = ch.order;
+		}
+
+		for(unsigned thread_count : {1u, 2u, 4u, 7u}){
+			cout << "Building CH given order using " << thread_count << " threads ... " << flush;
+			long long time = -get_micro_time();
+			auto ch = ContractionHierarchy::build_given_order(order, tail, head, weight, std::function<void(std::string)>(), ContractionHierarchy::default_max_pop_count, thread_count);
+			time += get_micro_time();
+			cout << "done [" << time << "musec]" << endl;
+			cout << "CH has " << ch.forward.head.size() << " forward and " << ch.backward.head.size() << " backward arcs" << endl;
+
+			EXPECT(ch.order == order);
+
+			check_queries(ch);
+		}
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
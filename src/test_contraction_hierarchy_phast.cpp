@@ -0,0 +1,176 @@
+#include <routingkit/contraction_hierarchy_phast.h>
+#include <routingkit/dijkstra.h>
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/timer.h>
+
+#include <vector>
+#include <random>
+
+#include "expect.h"
+#include "verify.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+template<unsigned K>
+void test_multi_source_phast(const ContractionHierarchy&ch, ContractionHierarchyPHAST&phast, minstd_rand&gen){
+	const unsigned node_count = ch.node_count();
+	uniform_int_distribution<unsigned>node_dist(0, node_count-1);
+
+	ContractionHierarchyMultiSourcePHAST<K>multi_phast(ch);
+
+	long long single_time = 0, multi_time = 0;
+
+	cout << "Testing " << K << " sources per sweep ... " << flush;
+	for(unsigned source_count : {K, K-1, 1u}){
+		for(unsigned i=0; i<5; ++i){
+			vector<unsigned>source_list(source_count);
+			for(auto&s:source_list)
+				s = node_dist(gen);
+
+			multi_time -= get_micro_time();
+			multi_phast.run(source_list);
+			multi_time += get_micro_time();
+
+			EXPECT_CMP(multi_phast.get_source_count(), ==, source_count);
+
+			for(unsigned j=0; j<source_count; ++j){
+				single_time -= get_micro_time();
+				phast.reset().add_source(source_list[j]).run();
+				single_time += get_micro_time();
+
+				auto dist = multi_phast.get_distances(j);
+				for(unsigned x=0; x<node_count; ++x){
+					EXPECT_CMP(dist[x], ==, phast.get_distance(x));
+					EXPECT_CMP(multi_phast.get_distance(j, x), ==, phast.get_distance(x));
+					EXPECT_CMP(multi_phast.get_interleaved_distances_by_rank()[ch.rank[x]*K+j], ==, phast.get_distance(x));
+				}
+			}
+		}
+	}
+	cout << "done" << endl;
+	cout << "Single source PHAST needed " << single_time << "musec and " << K << " sources per sweep needed " << multi_time << "musec" << endl;
+}
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 5){
+			cout << argv[0] << " first_out head weight ch_file" << endl;
+			return 1;
+		}
+		cout << "Loading data ... " << flush;
+		vector<unsigned>
+			first_out = load_vector<unsigned>(argv[1]),
+			head = load_vector<unsigned>(argv[2]),
+			weight = load_vector<unsigned>(argv[3]);
+		ContractionHierarchy ch = ContractionHierarchy::load_file(argv[4]);
+		cout << "done" << endl;
+
+		check_if_graph_is_valid(first_out, head);
+
+		const unsigned node_count = first_out.size()-1;
+		EXPECT_CMP(ch.node_count(), ==, node_count);
+
+		vector<unsigned>tail = invert_inverse_vector(first_out);
+
+		minstd_rand gen;
+		uniform_int_distribution<unsigned>node_dist(0, node_count-1);
+		uniform_int_distribution<unsigned>offset_dist(0, 10000);
+
+		Dijkstra dij(first_out, tail, head);
+		ContractionHierarchyPHAST phast(ch);
+
+		long long dij_time = 0, phast_time = 0;
+
+		cout << "Testing one-to-all ... " << flush;
+		for(unsigned i=0; i<50; ++i){
+			unsigned s = node_dist(gen);
+
+			dij_time -= get_micro_time();
+			dij.reset().add_source(s);
+			while(!dij.is_finished())
+				dij.settle(ScalarGetWeight(weight));
+			dij_time += get_micro_time();
+
+			phast_time -= get_micro_time();
+			phast.reset().add_source(s).run();
+			phast_time += get_micro_time();
+
+			auto dist = phast.get_distances();
+			for(unsigned x=0; x<node_count; ++x){
+				unsigned ref = dij.was_node_reached(x) ? dij.get_distance_to(x) : inf_weight;
+				EXPECT_CMP(dist[x], ==, ref);
+				EXPECT_CMP(phast.get_distance(x), ==, ref);
+				EXPECT_CMP(phast.get_distances_by_rank()[ch.rank[x]], ==, ref);
+			}
+		}
+		cout << "done" << endl;
+		cout << "Dijkstra needed " << dij_time << "musec and PHAST needed " << phast_time << "musec" << endl;
+
+		cout << "Testing multiple sources ... " << flush;
+		for(unsigned i=0; i<20; ++i){
+			unsigned s1 = node_dist(gen), s2 = node_dist(gen);
+			unsigned d1 = offset_dist(gen), d2 = offset_dist(gen);
+
+			dij.reset().add_source(s1, d1).add_source(s2, d2);
+			while(!dij.is_finished())
+				dij.settle(ScalarGetWeight(weight));
+
+			auto dist = phast.reset().add_source(s1, d1).add_source(s2, d2).run().get_distances();
+			for(unsigned x=0; x<node_count; ++x){
+				unsigned ref = dij.was_node_reached(x) ? dij.get_distance_to(x) : inf_weight;
+				EXPECT_CMP(dist[x], ==, ref);
+			}
+		}
+		cout << "done" << endl;
+
+		cout << "Testing restricted PHAST ... " << flush;
+		{
+			ContractionHierarchyRPHAST rphast(ch);
+			ContractionHierarchyQuery query(ch);
+			long long rphast_time = 0, pinned_time = 0;
+			for(unsigned target_count : {0u, 1u, 100u, 2000u}){
+				vector<unsigned>target_list(target_count);
+				for(auto&t:target_list)
+					t = node_dist(gen);
+				if(target_count > 1)
+					target_list.back() = target_list.front();
+
+				rphast.select_targets(target_list);
+				EXPECT_CMP(rphast.get_target_count(), ==, target_count);
+				EXPECT_CMP(rphast.get_selected_node_count(), <=, node_count);
+				query.reset().pin_targets(target_list);
+
+				for(unsigned i=0; i<20; ++i){
+					unsigned s1 = node_dist(gen), s2 = node_dist(gen);
+					unsigned d2 = offset_dist(gen);
+
+					rphast_time -= get_micro_time();
+					auto dist = rphast.reset().add_source(s1).add_source(s2, d2).run().get_distances_to_targets();
+					rphast_time += get_micro_time();
+
+					phast.reset().add_source(s1).add_source(s2, d2).run();
+					for(unsigned j=0; j<target_count; ++j)
+						EXPECT_CMP(dist[j], ==, phast.get_distance(target_list[j]));
+
+					pinned_time -= get_micro_time();
+					auto pinned_dist = query.reset_source().add_source(s1).add_source(s2, d2).run_to_pinned_targets().get_distances_to_targets();
+					pinned_time += get_micro_time();
+					EXPECT(dist == pinned_dist);
+				}
+			}
+			cout << "done" << endl;
+			cout << "Restricted PHAST needed " << rphast_time << "musec and pinned queries needed " << pinned_time << "musec" << endl;
+		}
+
+		test_multi_source_phast<4>(ch, phast, gen);
+		test_multi_source_phast<8>(ch, phast, gen);
+		test_multi_source_phast<16>(ch, phast, gen);
+
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
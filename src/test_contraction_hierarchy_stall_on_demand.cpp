@@ -0,0 +1,97 @@
+#include <routingkit/contraction_hierarchy.h>
+
+#include <vector>
+#include <random>
+
+#include "expect.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 2){
+			cout << argv[0] << " ch_file" << endl;
+			return 1;
+		}
+
+		cout << "Loading Contraction Hierarchy ... " << flush;
+		ContractionHierarchy ch = ContractionHierarchy::load_file(argv[1]);
+		cout << "done" << endl;
+
+		const unsigned node_count = ch.node_count();
+
+		minstd_rand gen;
+		uniform_int_distribution<unsigned>node_dist(0, node_count-1);
+
+		ContractionHierarchyQuery stall_query(ch), plain_query(ch);
+		plain_query.set_stall_on_demand(false);
+
+		cout << "Testing point to point queries ... " << flush;
+		{
+			unsigned long long stall_settled_node_count = 0, plain_settled_node_count = 0, stalled_node_count = 0;
+			const unsigned query_count = 1000;
+			for(unsigned i=0; i<query_count; ++i){
+				unsigned s = node_dist(gen), t = node_dist(gen);
+
+				stall_query.reset().add_source(s).add_target(t).run();
+				plain_query.reset().add_source(s).add_target(t).run();
+
+				EXPECT_CMP(stall_query.get_distance(), ==, plain_query.get_distance());
+				EXPECT_CMP(plain_query.get_stalled_node_count(), ==, 0u);
+				EXPECT_CMP(stall_query.get_stalled_node_count(), <=, stall_query.get_settled_node_count());
+
+				stall_settled_node_count += stall_query.get_settled_node_count();
+				plain_settled_node_count += plain_query.get_settled_node_count();
+				stalled_node_count += stall_query.get_stalled_node_count();
+			}
+			EXPECT_CMP(stall_settled_node_count, <=, plain_settled_node_count);
+			cout << "done" << endl;
+			cout << "avg settled nodes with stalling : " << stall_settled_node_count/query_count << endl;
+			cout << "avg stalled nodes with stalling : " << stalled_node_count/query_count << endl;
+			cout << "avg settled nodes without stalling : " << plain_settled_node_count/query_count << endl;
+		}
+
+		cout << "Testing pinned queries ... " << flush;
+		{
+			const unsigned pinned_count = 50, query_count = 50;
+
+			vector<unsigned>pinned(pinned_count);
+			for(auto&x:pinned)
+				x = node_dist(gen);
+
+			stall_query.reset().pin_targets(pinned);
+			plain_query.reset().pin_targets(pinned);
+			for(unsigned i=0; i<query_count; ++i){
+				unsigned s = node_dist(gen);
+				auto stall_dist = stall_query.reset_source().add_source(s).run_to_pinned_targets().get_distances_to_targets();
+				auto plain_dist = plain_query.reset_source().add_source(s).run_to_pinned_targets().get_distances_to_targets();
+				EXPECT(stall_dist == plain_dist);
+				EXPECT_CMP(stall_query.get_settled_node_count(), <=, plain_query.get_settled_node_count());
+				EXPECT_CMP(plain_query.get_stalled_node_count(), ==, 0u);
+
+				auto stall_used = stall_query.get_used_sources_to_targets();
+				for(unsigned j=0; j<pinned_count; ++j)
+					if(stall_dist[j] != inf_weight)
+						EXPECT_CMP(stall_used[j], ==, s);
+			}
+
+			stall_query.reset().pin_sources(pinned);
+			plain_query.reset().pin_sources(pinned);
+			for(unsigned i=0; i<query_count; ++i){
+				unsigned t = node_dist(gen);
+				auto stall_dist = stall_query.reset_target().add_target(t).run_to_pinned_sources().get_distances_to_sources();
+				auto plain_dist = plain_query.reset_target().add_target(t).run_to_pinned_sources().get_distances_to_sources();
+				EXPECT(stall_dist == plain_dist);
+				EXPECT_CMP(stall_query.get_settled_node_count(), <=, plain_query.get_settled_node_count());
+				EXPECT_CMP(plain_query.get_stalled_node_count(), ==, 0u);
+			}
+		}
+		cout << "done" << endl;
+
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
@@ -0,0 +1,149 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/customizable_contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include <vector>
+#include <random>
+
+#include "expect.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 5){
+			cout << argv[0] << " first_out head weight cch_order" << endl;
+			return 1;
+		}
+
+		cout << "Loading Graph ... " << flush;
+		auto first_out = load_vector<unsigned>(argv[1]);
+		auto tail = invert_inverse_vector(first_out);
+		auto head = load_vector<unsigned>(argv[2]);
+		auto weight = load_vector<unsigned>(argv[3]);
+		auto cch_order = load_vector<unsigned>(argv[4]);
+		cout << "done" << endl;
+
+		cout << "Building and customizing CCH ... " << flush;
+		CustomizableContractionHierarchy cch(cch_order, tail, head);
+		CustomizableContractionHierarchyMetric metric(cch, weight);
+		metric.customize();
+		cout << "done" << endl;
+
+		minstd_rand gen;
+		uniform_int_distribution<unsigned>node_dist(0, cch.node_count()-1);
+
+		CustomizableContractionHierarchyQuery query(metric);
+		CustomizableContractionHierarchyCompactQuery compact_query(metric);
+
+		const unsigned query_count = 1000;
+		vector<unsigned>source(query_count), target(query_count);
+		for(unsigned i=0; i<query_count; ++i){
+			source[i] = node_dist(gen);
+			target[i] = node_dist(gen);
+		}
+
+		cout << "Testing point to point queries ... " << flush;
+		for(unsigned i=0; i<query_count; ++i){
+			unsigned s = source[i], t = target[i];
+			query.reset().add_source(s).add_target(t).run();
+			// The order in which source and target are added does not matter
+			if(i % 2 == 0)
+				compact_query.reset().add_source(s).add_target(t).run();
+			else
+				compact_query.reset().add_target(t).add_source(s).run();
+
+			EXPECT_CMP(compact_query.get_distance(), ==, query.get_distance());
+			if(query.get_distance() != inf_weight){
+				EXPECT_CMP(compact_query.get_used_source(), ==, s);
+				EXPECT_CMP(compact_query.get_used_target(), ==, t);
+
+				auto node_path = compact_query.get_node_path();
+				auto arc_path = compact_query.get_arc_path();
+				EXPECT_CMP(node_path.front(), ==, s);
+				EXPECT_CMP(node_path.back(), ==, t);
+				EXPECT_CMP(arc_path.size()+1, ==, node_path.size());
+				unsigned path_length = 0;
+				for(unsigned j=0; j<arc_path.size(); ++j){
+					EXPECT_CMP(tail[arc_path[j]], ==, node_path[j]);
+					EXPECT_CMP(head[arc_path[j]], ==, node_path[j+1]);
+					path_length += weight[arc_path[j]];
+				}
+				EXPECT_CMP(path_length, ==, query.get_distance());
+			}else{
+				EXPECT_CMP(compact_query.get_used_source(), ==, invalid_id);
+				EXPECT(compact_query.get_node_path().empty());
+			}
+		}
+		cout << "done" << endl;
+
+		cout << "Testing distance offsets ... " << flush;
+		for(unsigned i=0; i<100; ++i){
+			unsigned s = node_dist(gen), t = node_dist(gen);
+			query.reset().add_source(s, 7).add_target(t, 11).run();
+			compact_query.reset().add_source(s, 7).add_target(t, 11).run();
+			EXPECT_CMP(compact_query.get_distance(), ==, query.get_distance());
+		}
+		cout << "done" << endl;
+
+		cout << "Testing reuse after recustomization ... " << flush;
+		{
+			vector<unsigned>ref_dist(100);
+			for(unsigned i=0; i<100; ++i)
+				ref_dist[i] = query.reset().add_source(source[i]).add_target(target[i]).run().get_distance();
+
+			vector<unsigned>doubled_weight = weight;
+			for(auto&w:doubled_weight)
+				w *= 2;
+			metric.reset(doubled_weight).customize();
+
+			for(unsigned i=0; i<100; ++i){
+				compact_query.reset().add_source(source[i]).add_target(target[i]).run();
+				if(ref_dist[i] == inf_weight){
+					EXPECT_CMP(compact_query.get_distance(), ==, inf_weight);
+					continue;
+				}
+				EXPECT_CMP(compact_query.get_distance(), ==, 2*ref_dist[i]);
+				unsigned path_length = 0;
+				for(unsigned a:compact_query.get_arc_path())
+					path_length += doubled_weight[a];
+				EXPECT_CMP(path_length, ==, 2*ref_dist[i]);
+			}
+
+			metric.reset(weight).customize();
+		}
+		cout << "done" << endl;
+
+		cout << "Measuring query times ... " << flush;
+		long long time = -get_micro_time();
+		for(unsigned i=0; i<query_count; ++i)
+			query.reset().add_source(source[i]).add_target(target[i]).run();
+		time += get_micro_time();
+
+		long long compact_time = -get_micro_time();
+		for(unsigned i=0; i<query_count; ++i)
+			compact_query.reset().add_source(source[i]).add_target(target[i]).run();
+		compact_time += get_micro_time();
+		cout << "done" << endl;
+
+		unsigned long long query_memory =
+			sizeof(unsigned)*(
+				query.forward_tentative_distance.capacity() + query.backward_tentative_distance.capacity() +
+				query.forward_predecessor_node.capacity() + query.backward_predecessor_node.capacity()
+			) + (query.in_forward_search_space.capacity() + query.in_backward_search_space.capacity())/8;
+
+		cout << "avg query time : " << time/query_count << "musec" << endl;
+		cout << "avg compact query time : " << compact_time/query_count << "musec" << endl;
+		cout << "query memory : " << query_memory << " bytes" << endl;
+		cout << "compact query memory : " << compact_query.memory_usage() << " bytes" << endl;
+
+		EXPECT_CMP(compact_query.memory_usage(), <, query_memory);
+
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
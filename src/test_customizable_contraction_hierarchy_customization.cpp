@@ -9,6 +9,11 @@
 #include <iostream>
 #include <stdexcept>
 #include <vector>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace RoutingKit;
 using namespace std;
@@ -31,6 +36,7 @@ int main(int argc, char*argv[]){
 		}
 
 		long long timer;
+		long long regular_customization_time;
 
 		cout << "Loading Graph ... " << flush;
 
@@ -58,13 +64,36 @@ int main(int argc, char*argv[]){
 
 		cout << "Regular CCH Customization ... " << flush;
 
-		timer = -get_micro_time();
+		regular_customization_time = -get_micro_time();
 		CustomizableContractionHierarchyMetric reference_metric(cch, weight);
 		reference_metric.customize();
-		timer += get_micro_time();
+		regular_customization_time += get_micro_time();
+
+		cout << "done [" << regular_customization_time << "musec]" << endl;
 
+		cout << "Enumerating triangles ... " << flush;
+		timer = -get_micro_time();
+		CustomizableContractionHierarchyTriangles triangles(cch);
+		timer += get_micro_time();
 		cout << "done [" << timer << "musec]" << endl;
 
+		cout << "Triangle list CCH Customization ... " << flush;
+		long long triangle_customization_time = -get_micro_time();
+		CustomizableContractionHierarchyMetric triangle_metric(cch, weight);
+		triangles.customize(triangle_metric);
+		triangle_customization_time += get_micro_time();
+		cout << "done [" << triangle_customization_time << "musec]" << endl;
+
+		if(reference_metric.forward != triangle_metric.forward || reference_metric.backward != triangle_metric.backward){
+			throw std::runtime_error("Triangle list Customization is broken");
+		}else{
+			cout << "Triangle list Customization is ok" << endl;
+		}
+
+		cout << "The triangle list stores " << triangles.triangle_count() << " triangles using " << triangles.memory_usage() << " bytes ("
+			<< (double)triangles.memory_usage()/(sizeof(unsigned)*2*cch.cch_arc_count()) << " times the metric) "
+			<< "and customizes " << (double)regular_customization_time/std::max(triangle_customization_time, 1ll) << " times as fast" << endl;
+
 
 		#ifdef _OPENMP
 		cout << "Constructing Parallelization data structures ... " << flush;
@@ -85,6 +114,34 @@ int main(int argc, char*argv[]){
 		}else{
 			cout << "Parallel Customization is ok" << endl;
 		}
+
+		cout << "Constructing Subtree Parallelization data structures ... " << flush;
+		timer = -get_micro_time();
+		CustomizableContractionHierarchySubtreeParallelization subtree_customization(cch);
+		timer += get_micro_time();
+		cout << "done [" << timer << "musec], " << subtree_customization.get_subtree_count() << " subtrees, " << subtree_customization.get_top_level_count() << " top levels" << endl;
+
+		cout << "Comparing level-based and subtree-based Parallel CCH Customization" << endl;
+		cout << "threads, level-based [musec], subtree-based [musec]" << endl;
+		for(unsigned thread_count : {1u, 2u, 4u, 8u, 16u, 32u, 64u}){
+			CustomizableContractionHierarchyMetric level_metric(cch, weight), subtree_metric(cch, weight);
+
+			long long level_time = -get_micro_time();
+			parallel_customization.customize(level_metric, thread_count);
+			level_time += get_micro_time();
+
+			long long subtree_time = -get_micro_time();
+			subtree_customization.customize(subtree_metric, thread_count);
+			subtree_time += get_micro_time();
+
+			cout << thread_count << ", " << level_time << ", " << subtree_time << endl;
+
+			if(reference_metric.forward != level_metric.forward || reference_metric.backward != level_metric.backward)
+				throw std::runtime_error("Parallel Customization is broken with "+std::to_string(thread_count)+" threads");
+			if(reference_metric.forward != subtree_metric.forward || reference_metric.backward != subtree_metric.backward)
+				throw std::runtime_error("Subtree Parallel Customization is broken with "+std::to_string(thread_count)+" threads");
+		}
+		cout << "Subtree Parallel Customization is ok" << endl;
 		#endif
 
 		CustomizableContractionHierarchyMetric partial_metric = reference_metric;
@@ -139,6 +196,79 @@ int main(int argc, char*argv[]){
 		}
 		cout << "Partial Customization is ok" << endl;
 
+		cout << "Parallel Partial Customization ... " << flush;
+		timer = -get_micro_time();
+		for(unsigned i=0; i<1000; ++i){
+			unsigned a = rand()%head.size();
+			weight[a] = rand()%1000;
+			partial_update.update_arc(a);
+		}
+		partial_update.customize(partial_metric, 4);
+		timer += get_micro_time();
+		cout << "done [" << timer << "musec]" << endl;
+
+		reference_metric.customize();
+		if(reference_metric.forward != partial_metric.forward || reference_metric.backward != partial_metric.backward)
+			throw std::runtime_error("Parallel Partial Customization is broken");
+		if(partial_update.get_last_customization_method() == CustomizableContractionHierarchyPartialCustomization::CustomizationMethod::sequential)
+			throw std::runtime_error("Parallel Partial Customization reports the wrong method");
+		cout << "Parallel Partial Customization is ok" << endl;
+
+		cout << "Comparing level-based Partial Customization against full recomputation" << endl;
+		cout << "updated input arcs [%], recomputed CCH arcs [%], levels [musec], full [musec], automatic [musec], automatic method" << endl;
+		for(double updated_fraction : {0.001, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5}){
+			vector<unsigned>updated_arcs;
+			for(unsigned a=0; a<head.size(); ++a)
+				if(rand() < updated_fraction * RAND_MAX)
+					updated_arcs.push_back(a);
+
+			for(unsigned a:updated_arcs)
+				weight[a] = rand()%1000;
+
+			CustomizableContractionHierarchyMetric level_metric = partial_metric, full_metric = partial_metric;
+
+			partial_update.full_customization_threshold = 2.0;
+			long long level_time = -get_micro_time();
+			for(unsigned a:updated_arcs)
+				partial_update.update_arc(a);
+			partial_update.customize(level_metric, 4);
+			level_time += get_micro_time();
+			unsigned recomputed_arc_count = partial_update.get_last_recomputed_arc_count();
+			if(partial_update.get_last_customization_method() != CustomizableContractionHierarchyPartialCustomization::CustomizationMethod::parallel_levels)
+				throw std::runtime_error("Parallel Partial Customization did not use the level-based method");
+
+			partial_update.full_customization_threshold = 0.0;
+			long long full_time = -get_micro_time();
+			for(unsigned a:updated_arcs)
+				partial_update.update_arc(a);
+			partial_update.customize(full_metric, 4);
+			full_time += get_micro_time();
+			if(partial_update.get_last_customization_method() != CustomizableContractionHierarchyPartialCustomization::CustomizationMethod::full)
+				throw std::runtime_error("Parallel Partial Customization did not fall back to full customization");
+
+			CustomizableContractionHierarchyMetric automatic_metric = partial_metric;
+			partial_update.full_customization_threshold = CustomizableContractionHierarchyPartialCustomization::default_full_customization_threshold;
+			long long automatic_time = -get_micro_time();
+			for(unsigned a:updated_arcs)
+				partial_update.update_arc(a);
+			partial_update.customize(automatic_metric, 4);
+			automatic_time += get_micro_time();
+			bool used_full = partial_update.get_last_customization_method() == CustomizableContractionHierarchyPartialCustomization::CustomizationMethod::full;
+
+			cout << 100*updated_fraction << ", " << 100.0*recomputed_arc_count/cch.cch_arc_count() << ", " << level_time << ", " << full_time << ", " << automatic_time << ", " << (used_full ? "full" : "levels") << endl;
+
+			reference_metric.customize();
+			if(reference_metric.forward != level_metric.forward || reference_metric.backward != level_metric.backward)
+				throw std::runtime_error("Parallel Partial Customization is broken");
+			if(reference_metric.forward != full_metric.forward || reference_metric.backward != full_metric.backward)
+				throw std::runtime_error("Parallel Partial Customization with fallback is broken");
+			if(reference_metric.forward != automatic_metric.forward || reference_metric.backward != automatic_metric.backward)
+				throw std::runtime_error("Parallel Partial Customization with automatic fallback is broken");
+
+			partial_metric = reference_metric;
+		}
+		cout << "Parallel Partial Customization with fallback is ok" << endl;
+
 	}catch(exception&err){
 		cerr << "Stopped on exception : " << err.what() << endl;
 		return 1;
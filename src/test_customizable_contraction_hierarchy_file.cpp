@@ -0,0 +1,196 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/customizable_contraction_hierarchy.h>
+
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "expect.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+template<class T>
+bool is_equal(ConstVectorView<T>l, const vector<T>&r){
+	return l.size() == r.size() && std::equal(l.begin(), l.end(), r.begin());
+}
+
+bool is_equal(ConstBitVectorView l, const BitVector&r){
+	if(l.size() != r.size())
+		return false;
+	for(uint64_t i=0; i<l.size(); ++i)
+		if(l.is_set(i) != r.is_set(i))
+			return false;
+	return true;
+}
+
+bool is_equal(const CustomizableContractionHierarchyView&l, const CustomizableContractionHierarchy&r){
+	return
+		is_equal(l.order, r.order) &&
+		is_equal(l.rank, r.rank) &&
+		is_equal(l.elimination_tree_parent, r.elimination_tree_parent) &&
+		is_equal(l.elimination_tree_depth, r.elimination_tree_depth) &&
+		is_equal(l.up_first_out, r.up_first_out) &&
+		is_equal(l.up_head, r.up_head) &&
+		is_equal(l.up_tail, r.up_tail) &&
+		is_equal(l.down_first_out, r.down_first_out) &&
+		is_equal(l.down_head, r.down_head) &&
+		is_equal(l.down_to_up, r.down_to_up) &&
+		is_equal(l.input_arc_to_cch_arc, r.input_arc_to_cch_arc) &&
+		is_equal(l.is_input_arc_upward, r.is_input_arc_upward) &&
+		is_equal(l.does_cch_arc_have_input_arc, r.does_cch_arc_have_input_arc) &&
+		is_equal(l.forward_input_arc_of_cch, r.forward_input_arc_of_cch) &&
+		is_equal(l.backward_input_arc_of_cch, r.backward_input_arc_of_cch) &&
+		is_equal(l.does_cch_arc_have_extra_input_arc, r.does_cch_arc_have_extra_input_arc) &&
+		is_equal(l.first_extra_forward_input_arc_of_cch, r.first_extra_forward_input_arc_of_cch) &&
+		is_equal(l.first_extra_backward_input_arc_of_cch, r.first_extra_backward_input_arc_of_cch) &&
+		is_equal(l.extra_forward_input_arc_of_cch, r.extra_forward_input_arc_of_cch) &&
+		is_equal(l.extra_backward_input_arc_of_cch, r.extra_backward_input_arc_of_cch);
+}
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 7){
+			cout << argv[0] << " first_out head weight cch_order cch_file metric_file" << endl;
+			cout << "cch_file and metric_file are overwritten" << endl;
+			return 1;
+		}
+
+		cout << "Loading Graph ... " << flush;
+		auto first_out = load_vector<unsigned>(argv[1]);
+		auto tail = invert_inverse_vector(first_out);
+		auto head = load_vector<unsigned>(argv[2]);
+		auto weight = load_vector<unsigned>(argv[3]);
+		auto cch_order = load_vector<unsigned>(argv[4]);
+		cout << "done" << endl;
+
+		cout << "Building and customizing CCH ... " << flush;
+		CustomizableContractionHierarchy cch(cch_order, tail, head);
+		CustomizableContractionHierarchyMetric metric(cch, weight);
+		metric.customize();
+		cout << "done" << endl;
+
+		cout << "Saving CCH and metric ... " << flush;
+		cch.save_file(argv[5]);
+		metric.save_file(argv[6]);
+		cout << "done" << endl;
+
+		cout << "Loading CCH and metric ... " << flush;
+		CustomizableContractionHierarchy loaded_cch = CustomizableContractionHierarchy::load_file(argv[5]);
+		CustomizableContractionHierarchyMetric loaded_metric(loaded_cch, weight);
+		loaded_metric.load_file(argv[6]);
+		cout << "done" << endl;
+
+		cout << "Mapping CCH and metric ... " << flush;
+		CustomizableContractionHierarchyView mapped_cch = CustomizableContractionHierarchyView::map_file(argv[5]);
+		CustomizableContractionHierarchyMetricView mapped_metric = CustomizableContractionHierarchyMetricView::map_file(mapped_cch, argv[6], weight.data());
+		cout << "done" << endl;
+
+		cout << "Comparing arrays ... " << flush;
+		EXPECT(is_equal(CustomizableContractionHierarchyView(loaded_cch), cch));
+		EXPECT(is_equal(mapped_cch, cch));
+		EXPECT(loaded_metric.forward == metric.forward);
+		EXPECT(loaded_metric.backward == metric.backward);
+		EXPECT(is_equal(mapped_metric.forward, metric.forward));
+		EXPECT(is_equal(mapped_metric.backward, metric.backward));
+		EXPECT_CMP((unsigned long long)mapped_cch.up_head.data() % 4096, ==, 0ull);
+		EXPECT_CMP((unsigned long long)mapped_metric.forward.data() % 4096, ==, 0ull);
+		for(unsigned i=0; i<cch.cch_arc_count(); ++i){
+			EXPECT_CMP(mapped_cch.does_cch_arc_have_input_arc_mapper->to_local(i, invalid_id), ==, cch.does_cch_arc_have_input_arc_mapper.to_local(i, invalid_id));
+			EXPECT_CMP(loaded_cch.does_cch_arc_have_extra_input_arc_mapper.to_local(i, invalid_id), ==, cch.does_cch_arc_have_extra_input_arc_mapper.to_local(i, invalid_id));
+		}
+		cout << "done" << endl;
+
+		cout << "Checking that mismatched files are rejected ... " << flush;
+		{
+			bool was_rejected = false;
+			try{
+				CustomizableContractionHierarchyView::map_file(argv[6]);
+			}catch(std::runtime_error&){
+				was_rejected = true;
+			}
+			EXPECT(was_rejected);
+
+			was_rejected = false;
+			try{
+				CustomizableContractionHierarchyMetric(cch, weight).load_file(argv[5]);
+			}catch(std::runtime_error&){
+				was_rejected = true;
+			}
+			EXPECT(was_rejected);
+		}
+		cout << "done" << endl;
+
+		cout << "Customizing a loaded CCH ... " << flush;
+		{
+			CustomizableContractionHierarchyMetric recustomized_metric(loaded_cch, weight);
+			recustomized_metric.customize();
+			EXPECT(recustomized_metric.forward == metric.forward);
+			EXPECT(recustomized_metric.backward == metric.backward);
+		}
+		cout << "done" << endl;
+
+		minstd_rand gen;
+		uniform_int_distribution<unsigned>node_dist(0, cch.node_count()-1);
+
+		CustomizableContractionHierarchyQuery query(metric), loaded_query(loaded_metric), mapped_query(mapped_metric);
+
+		cout << "Testing point to point queries ... " << flush;
+		for(unsigned i=0; i<1000; ++i){
+			unsigned s = node_dist(gen), t = node_dist(gen);
+
+			query.reset().add_source(s).add_target(t).run();
+			loaded_query.reset().add_source(s).add_target(t).run();
+			mapped_query.reset().add_source(s).add_target(t).run();
+
+			EXPECT_CMP(query.get_distance(), ==, loaded_query.get_distance());
+			EXPECT_CMP(query.get_distance(), ==, mapped_query.get_distance());
+			EXPECT(query.get_node_path() == loaded_query.get_node_path());
+			EXPECT(query.get_node_path() == mapped_query.get_node_path());
+			EXPECT(query.get_arc_path() == loaded_query.get_arc_path());
+			EXPECT(query.get_arc_path() == mapped_query.get_arc_path());
+		}
+		cout << "done" << endl;
+
+		cout << "Testing pinned queries ... " << flush;
+		{
+			vector<unsigned>pinned(50);
+			for(auto&x:pinned)
+				x = node_dist(gen);
+
+			query.reset().pin_targets(pinned);
+			mapped_query.reset().pin_targets(pinned);
+			for(unsigned i=0; i<50; ++i){
+				unsigned s = node_dist(gen);
+				query.reset_source().add_source(s).run_to_pinned_targets();
+				mapped_query.reset_source().add_source(s).run_to_pinned_targets();
+				EXPECT(query.get_distances_to_targets() == mapped_query.get_distances_to_targets());
+			}
+		}
+		cout << "done" << endl;
+
+		cout << "Testing that the mapping outlives the view ... " << flush;
+		{
+			CustomizableContractionHierarchyQuery detached_query(
+				CustomizableContractionHierarchyMetricView::map_file(
+					CustomizableContractionHierarchyView::map_file(argv[5]),
+					argv[6]
+				)
+			);
+			for(unsigned i=0; i<100; ++i){
+				unsigned s = node_dist(gen), t = node_dist(gen);
+				query.reset().add_source(s).add_target(t).run();
+				detached_query.reset().add_source(s).add_target(t).run();
+				EXPECT_CMP(query.get_distance(), ==, detached_query.get_distance());
+				EXPECT(query.get_node_path() == detached_query.get_node_path());
+			}
+		}
+		cout << "done" << endl;
+
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
@@ -0,0 +1,105 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/customizable_contraction_hierarchy.h>
+
+#include <vector>
+#include <random>
+
+#include "expect.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 5){
+			cout << argv[0] << " first_out head weight cch_order" << endl;
+			return 1;
+		}
+
+		cout << "Loading Graph ... " << flush;
+		auto first_out = load_vector<unsigned>(argv[1]);
+		auto tail = invert_inverse_vector(first_out);
+		auto head = load_vector<unsigned>(argv[2]);
+		auto weight = load_vector<unsigned>(argv[3]);
+		auto cch_order = load_vector<unsigned>(argv[4]);
+		cout << "done" << endl;
+
+		cout << "Building and customizing CCH ... " << flush;
+		CustomizableContractionHierarchy cch(cch_order, tail, head);
+		CustomizableContractionHierarchyMetric metric(cch, weight);
+		metric.customize();
+		cout << "done" << endl;
+
+		minstd_rand gen;
+		uniform_int_distribution<unsigned>node_dist(0, cch.node_count()-1);
+
+		CustomizableContractionHierarchyQuery query(metric);
+		CustomizableContractionHierarchyManyToMany many_to_many(metric);
+
+		for(unsigned source_count : {0u, 1u, 13u, 200u}){
+			for(unsigned target_count : {0u, 1u, 17u, 300u}){
+				cout << "Testing " << source_count << "x" << target_count << " table ... " << flush;
+
+				vector<unsigned>source_list(source_count), target_list(target_count);
+				for(auto&x:source_list)
+					x = node_dist(gen);
+				for(auto&x:target_list)
+					x = node_dist(gen);
+				// Duplicates must be supported
+				if(source_count > 1)
+					source_list.back() = source_list.front();
+				if(target_count > 1)
+					target_list.back() = target_list.front();
+
+				vector<unsigned>ref(source_count*target_count);
+				if(target_count != 0){
+					query.reset().pin_targets(target_list);
+					for(unsigned i=0; i<source_count; ++i){
+						auto d = query.reset_source().add_source(source_list[i]).run_to_pinned_targets().get_distances_to_targets();
+						copy(d.begin(), d.end(), ref.begin() + i*target_count);
+					}
+				}
+
+				for(unsigned thread_count : {1u, 3u}){
+					many_to_many.set_targets(target_list, thread_count);
+					EXPECT_CMP(many_to_many.get_target_count(), ==, target_count);
+					EXPECT(many_to_many.get_distances(source_list, thread_count) == ref);
+
+					vector<unsigned>dist(source_count*target_count, 42);
+					many_to_many.get_distances(source_list, dist.data(), thread_count);
+					EXPECT(dist == ref);
+				}
+				cout << "done" << endl;
+			}
+		}
+
+		cout << "Testing after recustomization ... " << flush;
+		{
+			vector<unsigned>new_weight = weight;
+			for(auto&w:new_weight)
+				w = w*(1+gen()%3);
+			metric.reset(new_weight).customize();
+
+			vector<unsigned>source_list(50), target_list(70);
+			for(auto&x:source_list)
+				x = node_dist(gen);
+			for(auto&x:target_list)
+				x = node_dist(gen);
+
+			many_to_many.set_targets(target_list);
+			auto dist = many_to_many.get_distances(source_list);
+
+			query.reset().pin_targets(target_list);
+			for(unsigned i=0; i<source_list.size(); ++i){
+				auto d = query.reset_source().add_source(source_list[i]).run_to_pinned_targets().get_distances_to_targets();
+				EXPECT(equal(d.begin(), d.end(), dist.begin() + i*target_list.size()));
+			}
+		}
+		cout << "done" << endl;
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
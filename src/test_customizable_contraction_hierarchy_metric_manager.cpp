@@ -0,0 +1,179 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/customizable_contraction_hierarchy.h>
+
+#include <vector>
+#include <random>
+#include <thread>
+#include <atomic>
+
+#include "expect.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 5){
+			cout << argv[0] << " first_out head weight cch_order" << endl;
+			return 1;
+		}
+
+		cout << "Loading Graph ... " << flush;
+		auto first_out = load_vector<unsigned>(argv[1]);
+		auto tail = invert_inverse_vector(first_out);
+		auto head = load_vector<unsigned>(argv[2]);
+		auto weight = load_vector<unsigned>(argv[3]);
+		auto cch_order = load_vector<unsigned>(argv[4]);
+		cout << "done" << endl;
+
+		cout << "Building CCH ... " << flush;
+		CustomizableContractionHierarchy cch(cch_order, tail, head);
+		cout << "done" << endl;
+
+		// Odd epochs use weight and even epochs use doubled_weight. All distances in the
+		// second metric are exactly twice as long.
+		vector<unsigned>doubled_weight = weight;
+		for(auto&w:doubled_weight)
+			w *= 2;
+
+		const unsigned node_count = cch.node_count();
+		const unsigned query_count = 200;
+		minstd_rand gen;
+		uniform_int_distribution<unsigned>node_dist(0, node_count-1);
+		vector<unsigned>source(query_count), target(query_count), ref_dist(query_count);
+		for(unsigned i=0; i<query_count; ++i){
+			source[i] = node_dist(gen);
+			target[i] = node_dist(gen);
+		}
+
+		cout << "Computing reference distances ... " << flush;
+		{
+			CustomizableContractionHierarchyMetric metric(cch, weight);
+			metric.customize();
+			CustomizableContractionHierarchyQuery query(metric);
+			for(unsigned i=0; i<query_count; ++i)
+				ref_dist[i] = query.reset().add_source(source[i]).add_target(target[i]).run().get_distance();
+		}
+		cout << "done" << endl;
+
+		cout << "Testing sequential publication ... " << flush;
+		CustomizableContractionHierarchyMetricManager manager(cch, weight);
+		EXPECT_CMP(manager.get_epoch(), ==, 1ull);
+		{
+			unsigned long long epoch;
+			CustomizableContractionHierarchyMetricView pinned_metric = manager.get_metric(&epoch);
+			EXPECT_CMP(epoch, ==, 1ull);
+
+			EXPECT_CMP(manager.customize(doubled_weight), ==, 2ull);
+			EXPECT_CMP(manager.get_epoch(), ==, 2ull);
+
+			CustomizableContractionHierarchyQuery old_query(pinned_metric), new_query(manager.get_metric());
+			for(unsigned i=0; i<query_count; ++i){
+				EXPECT_CMP(old_query.reset().add_source(source[i]).add_target(target[i]).run().get_distance(), ==, ref_dist[i]);
+				EXPECT_CMP(new_query.reset().add_source(source[i]).add_target(target[i]).run().get_distance(), ==, 2*ref_dist[i]);
+			}
+
+			// The pinned metric cannot be reused.
+			manager.customize(weight);
+			EXPECT_CMP(manager.get_buffer_count(), ==, 3u);
+		}
+		// Now it can.
+		manager.customize(doubled_weight);
+		EXPECT_CMP(manager.get_buffer_count(), ==, 2u);
+		EXPECT_CMP(manager.get_epoch(), ==, 4ull);
+		cout << "done" << endl;
+
+		cout << "Testing partial updates ... " << flush;
+		{
+			vector<unsigned>arc, new_weight;
+			for(unsigned a=0; a<head.size(); ++a){
+				arc.push_back(a);
+				new_weight.push_back(weight[a]);
+			}
+			EXPECT_CMP(manager.update_arcs(arc, new_weight), ==, 5ull);
+			CustomizableContractionHierarchyQuery query(manager.get_metric());
+			for(unsigned i=0; i<query_count; ++i)
+				EXPECT_CMP(query.reset().add_source(source[i]).add_target(target[i]).run().get_distance(), ==, ref_dist[i]);
+
+			vector<unsigned>few_arcs, few_weights;
+			for(unsigned i=0; i<100; ++i){
+				unsigned a = gen() % head.size();
+				few_arcs.push_back(a);
+				few_weights.push_back(weight[a]*3+1);
+			}
+			manager.update_arcs(few_arcs, few_weights, 2);
+
+			vector<unsigned>modified_weight = weight;
+			for(unsigned i=0; i<few_arcs.size(); ++i)
+				modified_weight[few_arcs[i]] = few_weights[i];
+			CustomizableContractionHierarchyMetric reference_metric(cch, modified_weight);
+			reference_metric.customize();
+			CustomizableContractionHierarchyMetricView managed_metric = manager.get_metric();
+			EXPECT(managed_metric.forward.to_vector() == reference_metric.forward);
+			EXPECT(managed_metric.backward.to_vector() == reference_metric.backward);
+
+			manager.update_arcs(few_arcs, vector<unsigned>(few_arcs.size(), 0));
+			for(unsigned i=0; i<few_arcs.size(); ++i)
+				few_weights[i] = weight[few_arcs[i]];
+			manager.update_arcs(few_arcs, few_weights);
+			CustomizableContractionHierarchyQuery restored_query(manager.get_metric());
+			for(unsigned i=0; i<query_count; ++i)
+				EXPECT_CMP(restored_query.reset().add_source(source[i]).add_target(target[i]).run().get_distance(), ==, ref_dist[i]);
+		}
+		cout << "done" << endl;
+
+		cout << "Testing concurrent queries and customizations ... " << flush;
+		if(manager.get_epoch() % 2 == 0)
+			manager.customize(weight);
+		{
+			std::atomic<bool>stop(false);
+			std::atomic<unsigned>wrong_answer_count(0);
+			std::atomic<unsigned long long>answered_query_count(0);
+
+			auto reader = [&](unsigned seed){
+				minstd_rand gen(seed);
+				CustomizableContractionHierarchyQuery query;
+				while(!stop.load()){
+					unsigned long long epoch;
+					query.reset(manager.get_metric(&epoch));
+					unsigned factor = (epoch % 2 == 1) ? 1 : 2;
+					for(unsigned j=0; j<10; ++j){
+						unsigned i = gen() % query_count;
+						unsigned d = query.reset().add_source(source[i]).add_target(target[i]).run().get_distance();
+						if(d != factor * ref_dist[i])
+							++wrong_answer_count;
+						++answered_query_count;
+					}
+				}
+			};
+
+			vector<thread>readers;
+			for(unsigned i=0; i<4; ++i)
+				readers.emplace_back(reader, i);
+
+			for(unsigned round=0; round<20; ++round){
+				if(manager.get_epoch() % 2 == 1)
+					manager.customize(doubled_weight);
+				else
+					manager.customize(weight);
+			}
+
+			stop = true;
+			for(auto&t:readers)
+				t.join();
+
+			EXPECT_CMP(wrong_answer_count.load(), ==, 0u);
+			EXPECT_CMP(answered_query_count.load(), >, 0ull);
+		}
+		// No reader pins a metric anymore. Only one back buffer remains after the next publication.
+		manager.customize(weight);
+		EXPECT_CMP(manager.get_buffer_count(), ==, 2u);
+		cout << "done" << endl;
+
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
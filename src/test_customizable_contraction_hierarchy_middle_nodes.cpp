@@ -0,0 +1,185 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/customizable_contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include <vector>
+#include <random>
+#include <thread>
+
+#include "expect.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 5){
+			cout << argv[0] << " first_out head weight cch_order" << endl;
+			return 1;
+		}
+
+		cout << "Loading Graph ... " << flush;
+		auto first_out = load_vector<unsigned>(argv[1]);
+		auto tail = invert_inverse_vector(first_out);
+		auto head = load_vector<unsigned>(argv[2]);
+		auto weight = load_vector<unsigned>(argv[3]);
+		auto cch_order = load_vector<unsigned>(argv[4]);
+		cout << "done" << endl;
+
+		cout << "Building CCH ... " << flush;
+		CustomizableContractionHierarchy cch(cch_order, tail, head);
+		cout << "done" << endl;
+
+		long long timer;
+
+		cout << "Customizing ... " << flush;
+		timer = -get_micro_time();
+		CustomizableContractionHierarchyMetric metric(cch, weight);
+		metric.customize();
+		timer += get_micro_time();
+		cout << "done [" << timer << "musec]" << endl;
+
+		cout << "Customizing and recording middle nodes ... " << flush;
+		timer = -get_micro_time();
+		CustomizableContractionHierarchyMetric recording_metric(cch, weight);
+		CustomizableContractionHierarchyMiddleNodes middle_nodes;
+		middle_nodes.customize(recording_metric);
+		timer += get_micro_time();
+		cout << "done [" << timer << "musec]" << endl;
+
+		EXPECT(recording_metric.forward == metric.forward);
+		EXPECT(recording_metric.backward == metric.backward);
+
+		cout << "Computing middle nodes of a customized metric ... " << flush;
+		CustomizableContractionHierarchyMiddleNodes computed_middle_nodes;
+		timer = -get_micro_time();
+		computed_middle_nodes.compute(metric, 2);
+		timer += get_micro_time();
+		cout << "done [" << timer << "musec]" << endl;
+
+		minstd_rand gen;
+		uniform_int_distribution<unsigned>node_dist(0, cch.node_count()-1);
+
+		const unsigned query_count = 1000;
+		vector<unsigned>source(query_count), target(query_count);
+		for(unsigned i=0; i<query_count; ++i){
+			source[i] = node_dist(gen);
+			target[i] = node_dist(gen);
+		}
+		// Repeated queries make the cache useful
+		for(unsigned i=query_count/2; i<query_count; ++i){
+			source[i] = source[i-query_count/2];
+			target[i] = target[i-query_count/2];
+		}
+
+		CustomizableContractionHierarchyQuery query(metric);
+		CustomizableContractionHierarchyUnpackingCache cache;
+
+		cout << "Testing paths ... " << flush;
+		for(unsigned i=0; i<query_count; ++i){
+			query.reset().add_source(source[i]).add_target(target[i]).run();
+
+			auto ref_arc_path = query.get_arc_path();
+			auto ref_node_path = query.get_node_path();
+
+			// All variants must produce a valid path of the same length. The paths may only differ
+			// if there are several shortest paths.
+			for(unsigned variant=0; variant<3; ++variant){
+				vector<unsigned>arc_path, node_path;
+				if(variant == 0){
+					arc_path = query.get_arc_path(middle_nodes);
+					node_path = query.get_node_path(middle_nodes);
+				}else if(variant == 1){
+					arc_path = query.get_arc_path(computed_middle_nodes);
+					node_path = query.get_node_path(computed_middle_nodes);
+				}else{
+					arc_path = query.get_arc_path(middle_nodes, &cache);
+					node_path = query.get_node_path(middle_nodes, &cache);
+				}
+
+				if(query.get_distance() == inf_weight){
+					EXPECT(arc_path.empty());
+					EXPECT(node_path.empty());
+					continue;
+				}
+
+				EXPECT_CMP(node_path.size(), ==, arc_path.size()+1);
+				EXPECT_CMP(node_path.front(), ==, source[i]);
+				EXPECT_CMP(node_path.back(), ==, target[i]);
+				unsigned path_length = 0;
+				for(unsigned j=0; j<arc_path.size(); ++j){
+					EXPECT_CMP(tail[arc_path[j]], ==, node_path[j]);
+					EXPECT_CMP(head[arc_path[j]], ==, node_path[j+1]);
+					path_length += weight[arc_path[j]];
+				}
+				EXPECT_CMP(path_length, ==, query.get_distance());
+
+				if(variant == 1){
+					EXPECT(arc_path == ref_arc_path);
+					EXPECT(node_path == ref_node_path);
+				}
+			}
+		}
+		EXPECT_CMP(cache.get_hit_count(), >, 0ull);
+		cout << "done" << endl;
+
+		cout << "Testing a small cache shared by several threads ... " << flush;
+		{
+			CustomizableContractionHierarchyUnpackingCache small_cache(1000);
+			vector<unsigned>wrong_path_count(4, 0);
+			vector<thread>threads;
+			for(unsigned t=0; t<4; ++t){
+				threads.emplace_back([&, t]{
+					CustomizableContractionHierarchyQuery thread_query(metric);
+					for(unsigned i=t; i<query_count; i+=2){
+						thread_query.reset().add_source(source[i]).add_target(target[i]).run();
+						if(thread_query.get_arc_path(computed_middle_nodes, &small_cache) != thread_query.get_arc_path(computed_middle_nodes))
+							++wrong_path_count[t];
+					}
+				});
+			}
+			for(auto&t:threads)
+				t.join();
+			for(auto c:wrong_path_count)
+				EXPECT_CMP(c, ==, 0u);
+			EXPECT_CMP(small_cache.get_cached_input_arc_count(), <=, 1000ull);
+			EXPECT_CMP(small_cache.get_hit_count(), >, 0ull);
+		}
+		cout << "done" << endl;
+
+		cout << "Testing that clear empties the cache ... " << flush;
+		cache.clear();
+		EXPECT_CMP(cache.get_cached_input_arc_count(), ==, 0ull);
+		cout << "done" << endl;
+
+		cout << "Measuring unpacking times ... " << flush;
+		long long triangle_time = 0, middle_node_time = 0, cache_time = 0;
+		for(unsigned i=0; i<query_count; ++i){
+			query.reset().add_source(source[i]).add_target(target[i]).run();
+
+			triangle_time -= get_micro_time();
+			query.get_arc_path();
+			triangle_time += get_micro_time();
+
+			middle_node_time -= get_micro_time();
+			query.get_arc_path(middle_nodes);
+			middle_node_time += get_micro_time();
+
+			cache_time -= get_micro_time();
+			query.get_arc_path(middle_nodes, &cache);
+			cache_time += get_micro_time();
+		}
+		cout << "done" << endl;
+
+		cout << "avg unpacking time using triangle search : " << triangle_time/query_count << "musec" << endl;
+		cout << "avg unpacking time using middle nodes : " << middle_node_time/query_count << "musec" << endl;
+		cout << "avg unpacking time using middle nodes and cache : " << cache_time/query_count << "musec" << endl;
+		cout << "cache hits : " << cache.get_hit_count() << ", misses : " << cache.get_miss_count() << endl;
+
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
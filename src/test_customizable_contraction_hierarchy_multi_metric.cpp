@@ -0,0 +1,118 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/customizable_contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include <vector>
+#include <random>
+
+#include "expect.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+template<unsigned K>
+void test_multi_metric(const CustomizableContractionHierarchy&cch, const vector<vector<unsigned>>&all_weights){
+	vector<vector<unsigned>>weight(all_weights.begin(), all_weights.begin()+K);
+
+	cout << "Testing " << K << " metrics" << endl;
+
+	long long timer;
+
+	cout << "Customizing " << K << " metrics separately ... " << flush;
+	timer = -get_micro_time();
+	vector<CustomizableContractionHierarchyMetric>reference_metric;
+	for(unsigned k=0; k<K; ++k){
+		reference_metric.emplace_back(cch, weight[k]);
+		reference_metric.back().customize();
+	}
+	timer += get_micro_time();
+	cout << "done [" << timer << "musec]" << endl;
+
+	cout << "Customizing " << K << " metrics at once ... " << flush;
+	timer = -get_micro_time();
+	CustomizableContractionHierarchyMultiMetric<K>multi_metric(cch, weight);
+	multi_metric.customize();
+	timer += get_micro_time();
+	cout << "done [" << timer << "musec]" << endl;
+
+	cout << "Comparing weights ... " << flush;
+	for(unsigned k=0; k<K; ++k){
+		CustomizableContractionHierarchyMetric extracted_metric(cch, weight[k]);
+		multi_metric.extract_metric(k, extracted_metric);
+		EXPECT(extracted_metric.forward == reference_metric[k].forward);
+		EXPECT(extracted_metric.backward == reference_metric[k].backward);
+	}
+	cout << "done" << endl;
+
+	cout << "Comparing queries ... " << flush;
+	minstd_rand gen(K);
+	uniform_int_distribution<unsigned>node_dist(0, cch.node_count()-1);
+
+	vector<CustomizableContractionHierarchyQuery>reference_query;
+	for(unsigned k=0; k<K; ++k)
+		reference_query.emplace_back(reference_metric[k]);
+	CustomizableContractionHierarchyMultiMetricQuery<K>multi_query(multi_metric);
+
+	for(unsigned i=0; i<500; ++i){
+		unsigned s = node_dist(gen), t = node_dist(gen);
+		multi_query.reset().add_source(s).add_target(t).run();
+		for(unsigned k=0; k<K; ++k){
+			reference_query[k].reset().add_source(s).add_target(t).run();
+			EXPECT_CMP(multi_query.get_distance(k), ==, reference_query[k].get_distance());
+			EXPECT_CMP(multi_query.get_distances()[k], ==, reference_query[k].get_distance());
+		}
+	}
+
+	for(unsigned i=0; i<100; ++i){
+		unsigned s1 = node_dist(gen), s2 = node_dist(gen), t1 = node_dist(gen), t2 = node_dist(gen);
+		multi_query.reset().add_source(s1).add_source(s2, 7).add_target(t1, 3).add_target(t2).run();
+		for(unsigned k=0; k<K; ++k){
+			reference_query[k].reset().add_source(s1).add_source(s2, 7).add_target(t1, 3).add_target(t2).run();
+			EXPECT_CMP(multi_query.get_distance(k), ==, reference_query[k].get_distance());
+		}
+	}
+	cout << "done" << endl;
+}
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 5){
+			cout << argv[0] << " first_out head weight cch_order" << endl;
+			return 1;
+		}
+
+		cout << "Loading Graph ... " << flush;
+		auto first_out = load_vector<unsigned>(argv[1]);
+		auto tail = invert_inverse_vector(first_out);
+		auto head = load_vector<unsigned>(argv[2]);
+		auto travel_time = load_vector<unsigned>(argv[3]);
+		auto cch_order = load_vector<unsigned>(argv[4]);
+		cout << "done" << endl;
+
+		cout << "Building CCH ... " << flush;
+		CustomizableContractionHierarchy cch(cch_order, tail, head);
+		cout << "done" << endl;
+
+		vector<vector<unsigned>>weight(16, travel_time);
+		minstd_rand gen;
+		for(unsigned k=1; k<16; ++k){
+			uniform_int_distribution<unsigned>factor_dist(1, k+1);
+			for(auto&w:weight[k])
+				w = w * factor_dist(gen);
+		}
+		// Some arcs are closed in some metrics.
+		for(unsigned a=0; a<head.size(); a += 17)
+			weight[3][a] = inf_weight;
+
+		test_multi_metric<2>(cch, weight);
+		test_multi_metric<4>(cch, weight);
+		test_multi_metric<8>(cch, weight);
+		test_multi_metric<16>(cch, weight);
+
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
@@ -0,0 +1,141 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/customizable_contraction_hierarchy.h>
+#include <routingkit/timer.h>
+
+#include <vector>
+#include <random>
+
+#include "expect.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 5){
+			cout << argv[0] << " first_out head weight cch_order" << endl;
+			return 1;
+		}
+
+		cout << "Loading Graph ... " << flush;
+		auto first_out = load_vector<unsigned>(argv[1]);
+		auto tail = invert_inverse_vector(first_out);
+		auto head = load_vector<unsigned>(argv[2]);
+		auto weight = load_vector<unsigned>(argv[3]);
+		auto cch_order = load_vector<unsigned>(argv[4]);
+		cout << "done" << endl;
+
+		cout << "Building and customizing CCH ... " << flush;
+		CustomizableContractionHierarchy cch(cch_order, tail, head);
+		CustomizableContractionHierarchyMetric metric(cch, weight);
+		metric.customize();
+		cout << "done" << endl;
+
+		minstd_rand gen;
+		uniform_int_distribution<unsigned>node_dist(0, cch.node_count()-1);
+
+		CustomizableContractionHierarchyQuery plain_query(metric);
+		CustomizableContractionHierarchyQuery pruned_query[3] = {
+			CustomizableContractionHierarchyQuery(metric),
+			CustomizableContractionHierarchyQuery(metric),
+			CustomizableContractionHierarchyQuery(metric)
+		};
+		pruned_query[0].set_pruning(true);
+		pruned_query[1].set_stall_on_demand(true);
+		pruned_query[2].set_pruning(true).set_stall_on_demand(true);
+		const char*pruned_query_name[3] = {"pruning", "stall-on-demand", "pruning and stall-on-demand"};
+
+		// The setting must survive reset
+		for(auto&q:pruned_query)
+			q.reset(metric);
+
+		cout << "Testing point to point queries ... " << flush;
+		const unsigned query_count = 1000;
+		unsigned long long plain_relaxed_arc_count = 0;
+		unsigned long long pruned_relaxed_arc_count[3] = {0, 0, 0};
+		for(unsigned i=0; i<query_count; ++i){
+			unsigned s = node_dist(gen), t = node_dist(gen);
+
+			plain_query.reset().add_source(s).add_target(t).run();
+			plain_relaxed_arc_count += plain_query.get_relaxed_arc_count();
+			EXPECT_CMP(plain_query.get_pruned_node_count(), ==, 0u);
+			EXPECT_CMP(plain_query.get_stalled_node_count(), ==, 0u);
+
+			for(unsigned k=0; k<3; ++k){
+				auto&q = pruned_query[k];
+				q.reset().add_source(s).add_target(t).run();
+				pruned_relaxed_arc_count[k] += q.get_relaxed_arc_count();
+
+				EXPECT_CMP(q.get_distance(), ==, plain_query.get_distance());
+				EXPECT_CMP(q.get_scanned_node_count(), ==, plain_query.get_scanned_node_count());
+				EXPECT_CMP(q.get_relaxed_arc_count(), <=, plain_query.get_relaxed_arc_count());
+				EXPECT_CMP(q.get_pruned_node_count() + q.get_stalled_node_count(), <=, q.get_scanned_node_count());
+
+				if(q.get_distance() != inf_weight){
+					auto node_path = q.get_node_path();
+					auto arc_path = q.get_arc_path();
+					EXPECT_CMP(node_path.front(), ==, s);
+					EXPECT_CMP(node_path.back(), ==, t);
+					EXPECT_CMP(arc_path.size()+1, ==, node_path.size());
+					unsigned path_length = 0;
+					for(auto a:arc_path)
+						path_length += weight[a];
+					EXPECT_CMP(path_length, ==, q.get_distance());
+				}
+			}
+		}
+		cout << "done" << endl;
+
+		cout << "avg relaxed arcs without pruning : " << plain_relaxed_arc_count/query_count << endl;
+		for(unsigned k=0; k<3; ++k)
+			cout << "avg relaxed arcs with " << pruned_query_name[k] << " : " << pruned_relaxed_arc_count[k]/query_count << endl;
+
+		cout << "Testing queries with several sources and targets ... " << flush;
+		for(unsigned i=0; i<200; ++i){
+			unsigned s1 = node_dist(gen), s2 = node_dist(gen), t1 = node_dist(gen), t2 = node_dist(gen);
+			plain_query.reset().add_source(s1).add_source(s2, 1000).add_target(t1, 3).add_target(t2).run();
+			for(auto&q:pruned_query){
+				q.reset().add_source(s1).add_source(s2, 1000).add_target(t1, 3).add_target(t2).run();
+				EXPECT_CMP(q.get_distance(), ==, plain_query.get_distance());
+				if(q.get_distance() != inf_weight){
+					EXPECT(q.get_used_source() == s1 || q.get_used_source() == s2);
+					EXPECT(q.get_used_target() == t1 || q.get_used_target() == t2);
+				}
+			}
+		}
+		cout << "done" << endl;
+
+		cout << "Measuring query times ... " << flush;
+		{
+			vector<unsigned>source(query_count), target(query_count);
+			for(unsigned i=0; i<query_count; ++i){
+				source[i] = node_dist(gen);
+				target[i] = node_dist(gen);
+			}
+
+			long long plain_time = -get_micro_time();
+			for(unsigned i=0; i<query_count; ++i)
+				plain_query.reset().add_source(source[i]).add_target(target[i]).run();
+			plain_time += get_micro_time();
+
+			long long pruned_time[3];
+			for(unsigned k=0; k<3; ++k){
+				pruned_time[k] = -get_micro_time();
+				for(unsigned i=0; i<query_count; ++i)
+					pruned_query[k].reset().add_source(source[i]).add_target(target[i]).run();
+				pruned_time[k] += get_micro_time();
+			}
+			cout << "done" << endl;
+
+			cout << "avg query time without pruning : " << plain_time/query_count << "musec" << endl;
+			for(unsigned k=0; k<3; ++k)
+				cout << "avg query time with " << pruned_query_name[k] << " : " << pruned_time[k]/query_count << "musec" << endl;
+		}
+
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
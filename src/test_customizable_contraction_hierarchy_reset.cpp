@@ -140,8 +140,8 @@ int main(int argc, char*argv[]){
 
 
 
-			EXPECT_CMP(q.metric, ==, &m1);
-			EXPECT_CMP(q.cch, ==, &cch1);
+			EXPECT_CMP(q.metric.forward.data(), ==, m1.forward.data());
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch1.up_head.data());
 			EXPECT(is_in_forward_search_space_correct()); EXPECT(is_in_backward_search_space_correct());
 			EXPECT(is_forward_tentative_distance_correct()); EXPECT(is_backward_tentative_distance_correct());
 			EXPECT(q.source_node.empty());
@@ -152,8 +152,8 @@ int main(int argc, char*argv[]){
 
 			q.add_source(0).add_target(4).run().reset();
 
-			EXPECT_CMP(q.metric, ==, &m1);
-			EXPECT_CMP(q.cch, ==, &cch1);
+			EXPECT_CMP(q.metric.forward.data(), ==, m1.forward.data());
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch1.up_head.data());
 			EXPECT(is_in_forward_search_space_correct()); EXPECT(is_in_backward_search_space_correct());
 			EXPECT(is_forward_tentative_distance_correct()); EXPECT(is_backward_tentative_distance_correct());
 			EXPECT(q.source_node.empty());
@@ -163,8 +163,8 @@ int main(int argc, char*argv[]){
 
 			q.reset(m1);
 
-			EXPECT_CMP(q.metric, ==, &m1);
-			EXPECT_CMP(q.cch, ==, &cch1);
+			EXPECT_CMP(q.metric.forward.data(), ==, m1.forward.data());
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch1.up_head.data());
 			EXPECT(is_in_forward_search_space_correct()); EXPECT(is_in_backward_search_space_correct());
 			EXPECT(is_forward_tentative_distance_correct()); EXPECT(is_backward_tentative_distance_correct());
 			EXPECT(q.source_node.empty());
@@ -174,8 +174,8 @@ int main(int argc, char*argv[]){
 
 			q.reset(m2);
 
-			EXPECT_CMP(q.metric, ==, &m2);
-			EXPECT_CMP(q.cch, ==, &cch2);
+			EXPECT_CMP(q.metric.forward.data(), ==, m2.forward.data());
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch2.up_head.data());
 			EXPECT(is_in_forward_search_space_correct()); EXPECT(is_in_backward_search_space_correct());
 			EXPECT(is_forward_tentative_distance_correct()); EXPECT(is_backward_tentative_distance_correct());
 			EXPECT(q.source_node.empty());
@@ -185,8 +185,8 @@ int main(int argc, char*argv[]){
 
 			q.add_source(0).add_source(2).add_target(4).add_target(3).run().reset();
 
-			EXPECT_CMP(q.metric, ==, &m2);
-			EXPECT_CMP(q.cch, ==, &cch2);
+			EXPECT_CMP(q.metric.forward.data(), ==, m2.forward.data());
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch2.up_head.data());
 			EXPECT(is_in_forward_search_space_correct()); EXPECT(is_in_backward_search_space_correct());
 			EXPECT(is_forward_tentative_distance_correct()); EXPECT(is_backward_tentative_distance_correct());
 			EXPECT(q.source_node.empty());
@@ -196,8 +196,8 @@ int main(int argc, char*argv[]){
 
 			q.pin_targets({0,2,4,6}).add_source(1).run_to_pinned_targets().reset();
 
-			EXPECT_CMP(q.metric, ==, &m2);
-			EXPECT_CMP(q.cch, ==, &cch2);
+			EXPECT_CMP(q.metric.forward.data(), ==, m2.forward.data());
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch2.up_head.data());
 			EXPECT(is_in_forward_search_space_correct()); EXPECT(is_in_backward_search_space_correct());
 			EXPECT(is_forward_tentative_distance_correct()); EXPECT(is_backward_tentative_distance_correct());
 			EXPECT(q.source_node.empty());
@@ -207,8 +207,8 @@ int main(int argc, char*argv[]){
 
 			q.pin_targets({0,2,4,6}).add_source(1).add_source(3).run_to_pinned_targets().reset();
 
-			EXPECT_CMP(q.metric, ==, &m2);
-			EXPECT_CMP(q.cch, ==, &cch2);
+			EXPECT_CMP(q.metric.forward.data(), ==, m2.forward.data());
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch2.up_head.data());
 			EXPECT(is_in_forward_search_space_correct()); EXPECT(is_in_backward_search_space_correct());
 			EXPECT(is_forward_tentative_distance_correct()); EXPECT(is_backward_tentative_distance_correct());
 			EXPECT(q.source_node.empty());
@@ -218,8 +218,8 @@ int main(int argc, char*argv[]){
 
 			q.pin_sources({0,2,4,6}).add_target(1).run_to_pinned_sources().reset();
 
-			EXPECT_CMP(q.metric, ==, &m2);
-			EXPECT_CMP(q.cch, ==, &cch2);
+			EXPECT_CMP(q.metric.forward.data(), ==, m2.forward.data());
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch2.up_head.data());
 			EXPECT(is_in_forward_search_space_correct()); EXPECT(is_in_backward_search_space_correct());
 			EXPECT(is_forward_tentative_distance_correct()); EXPECT(is_backward_tentative_distance_correct());
 			EXPECT(q.source_node.empty());
@@ -229,8 +229,8 @@ int main(int argc, char*argv[]){
 
 			q.pin_sources({0,2,4,6}).add_target(1).add_target(3).run_to_pinned_sources().reset();
 
-			EXPECT_CMP(q.metric, ==, &m2);
-			EXPECT_CMP(q.cch, ==, &cch2);
+			EXPECT_CMP(q.metric.forward.data(), ==, m2.forward.data());
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch2.up_head.data());
 			EXPECT(is_in_forward_search_space_correct()); EXPECT(is_in_backward_search_space_correct());
 			EXPECT(is_forward_tentative_distance_correct()); EXPECT(is_backward_tentative_distance_correct());
 			EXPECT(q.source_node.empty());
@@ -240,8 +240,8 @@ int main(int argc, char*argv[]){
 
 			q.pin_targets({0,2,4,6}).add_source(1).run_to_pinned_targets().reset(m1);
 
-			EXPECT_CMP(q.metric, ==, &m1);
-			EXPECT_CMP(q.cch, ==, &cch1);
+			EXPECT_CMP(q.metric.forward.data(), ==, m1.forward.data());
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch1.up_head.data());
 			EXPECT(is_in_forward_search_space_correct()); EXPECT(is_in_backward_search_space_correct());
 			EXPECT(is_forward_tentative_distance_correct()); EXPECT(is_backward_tentative_distance_correct());
 			EXPECT(q.source_node.empty());
@@ -251,8 +251,8 @@ int main(int argc, char*argv[]){
 
 			q.pin_targets({0,2,4,6}).add_source(1).add_source(3).run_to_pinned_targets().reset(m2);
 
-			EXPECT_CMP(q.metric, ==, &m2);
-			EXPECT_CMP(q.cch, ==, &cch2);
+			EXPECT_CMP(q.metric.forward.data(), ==, m2.forward.data());
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch2.up_head.data());
 			EXPECT(is_in_forward_search_space_correct()); EXPECT(is_in_backward_search_space_correct());
 			EXPECT(is_forward_tentative_distance_correct()); EXPECT(is_backward_tentative_distance_correct());
 			EXPECT(q.source_node.empty());
@@ -262,8 +262,8 @@ int main(int argc, char*argv[]){
 
 			q.pin_sources({0,2,4,6}).add_target(1).run_to_pinned_sources().reset(m1);
 
-			EXPECT_CMP(q.metric, ==, &m1);
-			EXPECT_CMP(q.cch, ==, &cch1);
+			EXPECT_CMP(q.metric.forward.data(), ==, m1.forward.data());
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch1.up_head.data());
 			EXPECT(is_in_forward_search_space_correct()); EXPECT(is_in_backward_search_space_correct());
 			EXPECT(is_forward_tentative_distance_correct()); EXPECT(is_backward_tentative_distance_correct());
 			EXPECT(q.source_node.empty());
@@ -273,8 +273,8 @@ int main(int argc, char*argv[]){
 
 			q.pin_sources({0,2,4,6}).add_target(1).add_target(3).run_to_pinned_sources().reset(m2);
 
-			EXPECT_CMP(q.metric, ==, &m2);
-			EXPECT_CMP(q.cch, ==, &cch2);
+			EXPECT_CMP(q.metric.forward.data(), ==, m2.forward.data());
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch2.up_head.data());
 			EXPECT(is_in_forward_search_space_correct()); EXPECT(is_in_backward_search_space_correct());
 			EXPECT(is_forward_tentative_distance_correct()); EXPECT(is_backward_tentative_distance_correct());
 			EXPECT(q.source_node.empty());
@@ -285,8 +285,8 @@ int main(int argc, char*argv[]){
 
 			q.reset(m1);
 
-			EXPECT_CMP(q.metric, ==, &m1);
-			EXPECT_CMP(q.cch, ==, &cch1);
+			EXPECT_CMP(q.metric.forward.data(), ==, m1.forward.data());
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch1.up_head.data());
 			EXPECT(is_in_forward_search_space_correct()); EXPECT(is_in_backward_search_space_correct());
 			EXPECT(is_forward_tentative_distance_correct()); EXPECT(is_backward_tentative_distance_correct());
 			EXPECT(q.source_node.empty());
@@ -296,8 +296,8 @@ int main(int argc, char*argv[]){
 
 			q.pin_sources({0,2,4,6}).add_target(1).add_target(3).run_to_pinned_sources().reset(m3);
 
-			EXPECT_CMP(q.metric, ==, &m3);
-			EXPECT_CMP(q.cch, ==, &cch1);
+			EXPECT_CMP(q.metric.forward.data(), ==, m3.forward.data());
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch1.up_head.data());
 			EXPECT(is_in_forward_search_space_correct()); EXPECT(is_in_backward_search_space_correct());
 			EXPECT(is_forward_tentative_distance_correct()); EXPECT(is_backward_tentative_distance_correct());
 			EXPECT(q.source_node.empty());
@@ -307,6 +307,59 @@ int main(int argc, char*argv[]){
 
 		}
 
+		{
+			// A query built from a metric follows the metric when it is reset and customized anew.
+			CustomizableContractionHierarchyMetric m(cch1, weight1);
+			m.customize();
+			CustomizableContractionHierarchyQuery q(m);
+
+			auto check_all_pairs = [&](const CustomizableContractionHierarchyMetric&expected_metric, const vector<unsigned>&weight){
+				CustomizableContractionHierarchyQuery expected_q(expected_metric);
+				for(unsigned s=0; s<node_count; ++s){
+					q.reset().pin_targets({0,1,2,3,4,5,6,7}).add_source(s).run_to_pinned_targets();
+					auto dist = q.get_distances_to_targets();
+					for(unsigned t=0; t<node_count; ++t){
+						unsigned d = expected_q.reset().add_source(s).add_target(t).run().get_distance();
+						EXPECT_CMP(dist[t], ==, d);
+
+						q.reset().add_source(s).add_target(t).run();
+						EXPECT_CMP(q.get_distance(), ==, d);
+						if(d != inf_weight){
+							unsigned length = 0, x = s;
+							for(unsigned a:q.get_arc_path()){
+								EXPECT_CMP(tail[a], ==, x);
+								x = head[a];
+								length += weight[a];
+							}
+							EXPECT_CMP(x, ==, t);
+							EXPECT_CMP(length, ==, d);
+						}
+					}
+				}
+				EXPECT_CMP(q.metric.forward.data(), ==, m.forward.data());
+				EXPECT_CMP(q.metric.input_weight, ==, &weight[0]);
+			};
+
+			check_all_pairs(m, weight1);
+
+			m.reset(weight2).customize();
+			check_all_pairs(CustomizableContractionHierarchyMetric(cch1, weight2).customize(), weight2);
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch1.up_head.data());
+
+			m.reset(cch2, weight1).customize();
+			check_all_pairs(CustomizableContractionHierarchyMetric(cch2, weight1).customize(), weight1);
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch2.up_head.data());
+
+			// A query built from a view keeps using the arrays of the view.
+			CustomizableContractionHierarchyMetric m2(cch2, weight2);
+			m2.customize();
+			q.reset(CustomizableContractionHierarchyMetricView(m2));
+			m.reset(cch1, weight1).customize();
+			q.reset();
+			EXPECT_CMP(q.metric.forward.data(), ==, m2.forward.data());
+			EXPECT_CMP(q.cch.up_head.data(), ==, cch2.up_head.data());
+		}
+
 	}catch(exception&err){
 		cerr << "Stopped on exception : " << err.what() << endl;
 		return 1;
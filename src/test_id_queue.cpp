@@ -0,0 +1,108 @@
+#include <routingkit/id_queue.h>
+
+#include <vector>
+#include <random>
+
+#include "expect.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+// Compares the queue against a plain array of keys on a random sequence of operations.
+template<unsigned Arity, class Key>
+void test_queue(Key max_key){
+	cout << "Testing " << Arity << "-ary heap with " << sizeof(Key)*8 << " bit keys ... " << flush;
+
+	const unsigned id_count = 500;
+	const Key not_contained = max_key;
+
+	minstd_rand gen(Arity);
+	uniform_int_distribution<unsigned>id_dist(0, id_count-1);
+	uniform_int_distribution<Key>key_dist(0, max_key-1);
+
+	BasicMinIDQueue<Arity, Key>q(id_count);
+	vector<Key>key(id_count, not_contained);
+	unsigned size = 0;
+
+	auto get_min_key = [&]{
+		Key min_key = not_contained;
+		for(auto k:key)
+			if(k < min_key)
+				min_key = k;
+		return min_key;
+	};
+
+	for(unsigned step=0; step<100000; ++step){
+		unsigned id = id_dist(gen);
+		Key k = key_dist(gen);
+		switch(gen() % 5){
+		case 0:
+			if(!q.empty()){
+				EXPECT_CMP(q.peek().key, ==, get_min_key());
+				auto p = q.pop();
+				EXPECT_CMP(p.key, ==, key[p.id]);
+				key[p.id] = not_contained;
+				--size;
+			}
+			break;
+		case 1:
+			if(q.contains_id(id)){
+				EXPECT_CMP(q.decrease_key({id, k}), ==, k < key[id]);
+				if(k < key[id])
+					key[id] = k;
+			}
+			break;
+		case 2:
+			if(q.contains_id(id)){
+				EXPECT_CMP(q.increase_key({id, k}), ==, k > key[id]);
+				if(k > key[id])
+					key[id] = k;
+			}
+			break;
+		case 3:
+			if(step % 1000 == 3){
+				q.clear();
+				key.assign(id_count, not_contained);
+				size = 0;
+			}
+			break;
+		default:
+			if(!q.contains_id(id)){
+				q.push({id, k});
+				key[id] = k;
+				++size;
+			}
+		}
+
+		EXPECT_CMP(q.size(), ==, size);
+		EXPECT_CMP(q.contains_id(id), ==, key[id] != not_contained);
+		if(q.contains_id(id))
+			EXPECT_CMP(q.get_key(id), ==, key[id]);
+	}
+
+	Key last_key = 0;
+	while(!q.empty()){
+		auto p = q.pop();
+		EXPECT_CMP(p.key, >=, last_key);
+		last_key = p.key;
+	}
+
+	cout << "done" << endl;
+}
+
+int main(){
+	try{
+		test_queue<2, unsigned>(1000);
+		test_queue<3, unsigned>(1000);
+		test_queue<4, unsigned>(4000000000u);
+		test_queue<8, unsigned>(1000);
+		test_queue<16, unsigned>(1000);
+		test_queue<2, unsigned long long>(1ull<<40);
+		test_queue<4, unsigned long long>(1ull<<40);
+		test_queue<8, unsigned long long>(~0ull);
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
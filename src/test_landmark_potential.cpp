@@ -0,0 +1,227 @@
+#include <routingkit/vector_io.h>
+#include <routingkit/landmark_potential.h>
+#include <routingkit/astar.h>
+#include <routingkit/dijkstra.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/timer.h>
+
+#include <vector>
+#include <random>
+#include <string>
+#include <algorithm>
+
+#include "expect.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+void check_landmarks(const vector<unsigned>&landmark, unsigned landmark_count, unsigned node_count){
+	EXPECT_CMP(landmark.size(), ==, landmark_count);
+	for(auto l:landmark)
+		EXPECT_CMP(l, <, node_count);
+	auto sorted_landmark = landmark;
+	sort(sorted_landmark.begin(), sorted_landmark.end());
+	EXPECT(adjacent_find(sorted_landmark.begin(), sorted_landmark.end()) == sorted_landmark.end());
+}
+
+// Checks that the potential is consistent for the given weights and a few targets.
+template<class Potential>
+void check_consistency(const Potential&potential, const vector<unsigned>&first_out, const vector<unsigned>&head, const vector<unsigned>&weight){
+	const unsigned node_count = first_out.size()-1;
+	minstd_rand gen;
+	uniform_int_distribution<unsigned>node_dist(0, node_count-1);
+	for(unsigned i=0; i<10; ++i){
+		unsigned t = node_dist(gen);
+		EXPECT_CMP(potential(t, t), ==, 0u);
+		for(unsigned x=0; x<node_count; ++x){
+			unsigned px = potential(x, t);
+			EXPECT_CMP(px, <, inf_weight);
+			for(unsigned xy=first_out[x]; xy<first_out[x+1]; ++xy)
+				if(weight[xy] < inf_weight)
+					EXPECT_CMP(px, <=, weight[xy] + potential(head[xy], t));
+		}
+	}
+}
+
+// Runs random point-to-point queries with Dijkstra and AStar and checks that both compute
+// the same distances.
+template<class Potential>
+void compare_with_dijkstra(
+	const string&name, const Potential&potential,
+	const vector<unsigned>&first_out, const vector<unsigned>&tail, const vector<unsigned>&head, const vector<unsigned>&weight
+){
+	cout << "Testing " << name << " ... " << flush;
+	const unsigned node_count = first_out.size()-1;
+	Dijkstra dij(first_out, tail, head);
+	AStar<Potential>astar(first_out, tail, head, potential);
+
+	minstd_rand gen;
+	uniform_int_distribution<unsigned>node_dist(0, node_count-1);
+
+	long long dijkstra_time = 0, astar_time = 0;
+	unsigned long long dijkstra_settled_node_count = 0, astar_settled_node_count = 0;
+	const unsigned query_count = 200;
+	for(unsigned i=0; i<query_count; ++i){
+		unsigned s = node_dist(gen), t = node_dist(gen);
+
+		dijkstra_time -= get_micro_time();
+		dij.reset().add_source(s);
+		while(!dij.is_finished()){
+			++dijkstra_settled_node_count;
+			if(dij.settle(ScalarGetWeight(weight)).node == t)
+				break;
+		}
+		dijkstra_time += get_micro_time();
+
+		astar_time -= get_micro_time();
+		astar.reset(t).add_source(s);
+		while(!astar.is_finished()){
+			++astar_settled_node_count;
+			astar.settle(ScalarGetWeight(weight));
+		}
+		astar_time += get_micro_time();
+
+		unsigned dist = dij.get_distance_to(t);
+		EXPECT_CMP(astar.get_distance_to(t), ==, dist);
+		EXPECT_CMP(potential(s, t), <=, dist);
+
+		unsigned length = 0;
+		for(auto a:astar.get_arc_path_to(t))
+			length += weight[a];
+		if(dist != inf_weight)
+			EXPECT_CMP(length, ==, dist);
+	}
+	cout << "done" << endl;
+	cout << "Dijkstra : " << dijkstra_time/query_count << "musec/query, " << dijkstra_settled_node_count/query_count << " settled nodes/query" << endl;
+	cout << "ALT : " << astar_time/query_count << "musec/query, " << astar_settled_node_count/query_count << " settled nodes/query" << endl;
+}
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 5){
+			cout << argv[0] << " first_out head weight landmark_file_prefix" << endl;
+			cout << "files starting with landmark_file_prefix are overwritten" << endl;
+			return 1;
+		}
+
+		cout << "Loading data ... " << flush;
+		auto first_out = load_vector<unsigned>(argv[1]);
+		auto head = load_vector<unsigned>(argv[2]);
+		auto weight = load_vector<unsigned>(argv[3]);
+		string prefix = argv[4];
+		cout << "done" << endl;
+
+		const unsigned node_count = first_out.size()-1;
+		const unsigned arc_count = head.size();
+		const unsigned landmark_count = 16;
+		auto tail = invert_inverse_vector(first_out);
+
+		// Some arcs are closed.
+		for(unsigned a=0; a<arc_count; a+=97)
+			weight[a] = inf_weight;
+
+		cout << "Selecting landmarks ... " << flush;
+		long long timer = -get_micro_time();
+		auto farthest_landmark = select_farthest_landmarks(first_out, head, weight, landmark_count);
+		timer += get_micro_time();
+		cout << "done [farthest: " << timer << "musec, " << flush;
+		timer = -get_micro_time();
+		auto avoid_landmark = select_avoid_landmarks(first_out, head, weight, landmark_count);
+		timer += get_micro_time();
+		cout << "avoid: " << timer << "musec]" << endl;
+
+		check_landmarks(farthest_landmark, landmark_count, node_count);
+		check_landmarks(avoid_landmark, landmark_count, node_count);
+		EXPECT(farthest_landmark == select_farthest_landmarks(first_out, head, weight, landmark_count));
+		EXPECT(avoid_landmark == select_avoid_landmarks(first_out, head, weight, landmark_count));
+
+		// The avoid heuristic picks all landmarks from shortest path trees and places them
+		// differently than the farthest heuristic.
+		{
+			unsigned farthest_fallback_count = 0;
+			select_avoid_landmarks(first_out, head, weight, landmark_count, 0, &farthest_fallback_count);
+			EXPECT_CMP(farthest_fallback_count, ==, 0u);
+
+			auto sorted_farthest_landmark = farthest_landmark, sorted_avoid_landmark = avoid_landmark;
+			sort(sorted_farthest_landmark.begin(), sorted_farthest_landmark.end());
+			sort(sorted_avoid_landmark.begin(), sorted_avoid_landmark.end());
+			EXPECT(sorted_farthest_landmark != sorted_avoid_landmark);
+		}
+
+		cout << "Computing landmark tables ... " << flush;
+		timer = -get_micro_time();
+		LandmarkPotential farthest_potential(first_out, head, weight, farthest_landmark);
+		LandmarkPotential avoid_potential(first_out, head, weight, avoid_landmark);
+		timer += get_micro_time();
+		cout << "done [" << timer/2 << "musec]" << endl;
+
+		cout << "Comparing with multi-threaded table computation ... " << flush;
+		{
+			LandmarkPotential parallel_potential(first_out, head, weight, avoid_landmark, 4);
+			EXPECT(parallel_potential.landmark == avoid_potential.landmark);
+			EXPECT(parallel_potential.distance_from_landmark == avoid_potential.distance_from_landmark);
+			EXPECT(parallel_potential.distance_to_landmark == avoid_potential.distance_to_landmark);
+		}
+		cout << "done" << endl;
+
+		cout << "Checking consistency ... " << flush;
+		EXPECT_CMP(avoid_potential.node_count(), ==, node_count);
+		EXPECT_CMP(avoid_potential.landmark_count(), ==, landmark_count);
+		check_consistency(farthest_potential, first_out, head, weight);
+		check_consistency(avoid_potential, first_out, head, weight);
+		cout << "done" << endl;
+
+		compare_with_dijkstra("farthest landmarks", farthest_potential, first_out, tail, head, weight);
+		compare_with_dijkstra("avoid landmarks", avoid_potential, first_out, tail, head, weight);
+
+		cout << "Saving, loading, and mapping landmark tables ... " << flush;
+		{
+			avoid_potential.save_files(prefix+".landmark", prefix+".from", prefix+".to");
+
+			auto loaded = LandmarkPotential::load_files(prefix+".landmark", prefix+".from", prefix+".to");
+			EXPECT(loaded.landmark == avoid_potential.landmark);
+			EXPECT(loaded.distance_from_landmark == avoid_potential.distance_from_landmark);
+			EXPECT(loaded.distance_to_landmark == avoid_potential.distance_to_landmark);
+
+			auto mapped = LandmarkPotentialView::map_files(prefix+".landmark", prefix+".from", prefix+".to");
+			EXPECT_CMP(mapped.node_count(), ==, node_count);
+			EXPECT_CMP(mapped.landmark_count(), ==, landmark_count);
+			EXPECT(mapped.landmark.to_vector() == avoid_potential.landmark);
+			EXPECT(mapped.distance_from_landmark.to_vector() == avoid_potential.distance_from_landmark);
+			EXPECT(mapped.distance_to_landmark.to_vector() == avoid_potential.distance_to_landmark);
+
+			bool was_rejected = false;
+			try{
+				LandmarkPotentialView::map_files(prefix+".landmark", prefix+".from", prefix+".landmark");
+			}catch(exception&){
+				was_rejected = true;
+			}
+			EXPECT(was_rejected);
+		}
+		cout << "done" << endl;
+
+		compare_with_dijkstra("mapped avoid landmarks", LandmarkPotentialView::map_files(prefix+".landmark", prefix+".from", prefix+".to"), first_out, tail, head, weight);
+
+		// The tables remain valid if weights increase and arcs are closed.
+		{
+			auto increased_weight = weight;
+			minstd_rand gen;
+			uniform_int_distribution<unsigned>factor_dist(1, 3);
+			for(unsigned a=0; a<arc_count; ++a){
+				if(increased_weight[a] == inf_weight)
+					continue;
+				if(a % 31 == 0)
+					increased_weight[a] = inf_weight;
+				else
+					increased_weight[a] *= factor_dist(gen);
+			}
+			check_consistency(avoid_potential, first_out, head, increased_weight);
+			compare_with_dijkstra("avoid landmarks with increased weights", avoid_potential, first_out, tail, head, increased_weight);
+		}
+
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}
@@ -0,0 +1,221 @@
+#include <routingkit/id_queue.h>
+#include <routingkit/dijkstra.h>
+#include <routingkit/contraction_hierarchy.h>
+#include <routingkit/vector_io.h>
+#include <routingkit/inverse_vector.h>
+#include <routingkit/timer.h>
+
+#include <vector>
+#include <random>
+
+#include "expect.h"
+
+using namespace RoutingKit;
+using namespace std;
+
+void test_random_operations(){
+	cout << "Comparing random queue operations ... " << flush;
+	const unsigned id_count = 1000;
+	minstd_rand gen;
+	uniform_int_distribution<unsigned>id_dist(0, id_count-1), key_offset_dist(0, 1000);
+
+	MinIDQueue heap(id_count);
+	MinIDRadixQueue radix(id_count);
+
+	unsigned last_key = 0;
+	for(unsigned round=0; round<10; ++round){
+		for(unsigned step=0; step<100000; ++step){
+			unsigned id = id_dist(gen), key = last_key + key_offset_dist(gen);
+			unsigned op = gen() % 4;
+			if(op == 0 && !heap.empty()){
+				EXPECT_CMP(heap.peek().key, ==, radix.peek().key);
+				auto h = heap.pop(), r = radix.pop();
+				EXPECT_CMP(h.key, ==, r.key);
+				EXPECT(!radix.contains_id(r.id));
+				// Ties are broken differently. Remove the same element from the heap.
+				if(h.id != r.id){
+					EXPECT(heap.contains_id(r.id));
+					EXPECT_CMP(heap.get_key(r.id), ==, r.key);
+					heap.decrease_key({r.id, 0});
+					heap.pop();
+					heap.push(h);
+				}
+				last_key = r.key;
+			}else if(heap.contains_id(id)){
+				EXPECT(radix.contains_id(id));
+				EXPECT_CMP(heap.get_key(id), ==, radix.get_key(id));
+				if(op == 3)
+					EXPECT_CMP(heap.increase_key({id, key}), ==, radix.increase_key({id, key}));
+				else
+					EXPECT_CMP(heap.decrease_key({id, key}), ==, radix.decrease_key({id, key}));
+				EXPECT_CMP(heap.get_key(id), ==, radix.get_key(id));
+			}else{
+				EXPECT(!radix.contains_id(id));
+				heap.push({id, key});
+				radix.push({id, key});
+			}
+			EXPECT_CMP(heap.size(), ==, radix.size());
+		}
+		// Only the first half of the rounds drain the queues. The others test clear.
+		if(round < 5){
+			while(!heap.empty()){
+				last_key = radix.pop().key;
+				EXPECT_CMP(heap.pop().key, ==, last_key);
+			}
+			EXPECT(radix.empty());
+		}else{
+			heap.clear();
+			radix.clear();
+			// After clear, keys may be smaller than the last popped key.
+			last_key = round % 2 == 0 ? 0 : 4000000000u;
+			EXPECT(radix.empty());
+			for(unsigned id=0; id<id_count; ++id)
+				EXPECT(!radix.contains_id(id));
+		}
+	}
+	cout << "done" << endl;
+}
+
+template<class Queue>
+vector<unsigned>run_dijkstra(
+	const vector<unsigned>&first_out, const vector<unsigned>&tail, const vector<unsigned>&head, const vector<unsigned>&weight,
+	const vector<unsigned>&source, const vector<unsigned>&target
+){
+	vector<unsigned>dist;
+	BasicDijkstra<Queue>dij(first_out, tail, head);
+	for(unsigned i=0; i<source.size(); ++i){
+		dij.reset().add_source(source[i]);
+		while(!dij.is_finished()){
+			if(dij.settle(ScalarGetWeight(weight)).node == target[i])
+				break;
+		}
+		dist.push_back(dij.get_distance_to(target[i]));
+	}
+	return dist; // NVRO
+}
+
+template<class Queue>
+vector<unsigned>run_contraction_hierarchy_queries(const ContractionHierarchy&ch, const vector<unsigned>&source, const vector<unsigned>&target, vector<vector<unsigned>>*path = nullptr){
+	vector<unsigned>dist;
+	BasicContractionHierarchyQuery<Queue>query(ch);
+	for(unsigned i=0; i<source.size(); ++i){
+		dist.push_back(query.reset().add_source(source[i]).add_target(target[i]).run().get_distance());
+		if(path)
+			path->push_back(query.get_node_path());
+	}
+	return dist; // NVRO
+}
+
+template<class Queue>
+vector<unsigned>run_pinned_contraction_hierarchy_queries(const ContractionHierarchy&ch, const vector<unsigned>&source, const vector<unsigned>&target){
+	vector<unsigned>dist;
+	BasicContractionHierarchyQuery<Queue>query(ch);
+	query.reset().pin_targets(target);
+	for(unsigned i=0; i<source.size(); ++i){
+		auto row = query.reset_source().add_source(source[i]).run_to_pinned_targets().get_distances_to_targets();
+		dist.insert(dist.end(), row.begin(), row.end());
+	}
+	return dist; // NVRO
+}
+
+int main(int argc, char*argv[]){
+	try{
+		if(argc != 5){
+			cout << argv[0] << " first_out head weight ch" << endl;
+			return 1;
+		}
+
+		test_random_operations();
+
+		cout << "Loading data ... " << flush;
+		auto first_out = load_vector<unsigned>(argv[1]);
+		auto tail = invert_inverse_vector(first_out);
+		auto head = load_vector<unsigned>(argv[2]);
+		auto weight = load_vector<unsigned>(argv[3]);
+		ContractionHierarchy ch = ContractionHierarchy::load_file(argv[4]);
+		cout << "done" << endl;
+
+		const unsigned node_count = first_out.size()-1;
+		minstd_rand gen;
+		uniform_int_distribution<unsigned>node_dist(0, node_count-1);
+
+		vector<unsigned>source(1000), target(1000);
+		for(auto&x:source)
+			x = node_dist(gen);
+		for(auto&x:target)
+			x = node_dist(gen);
+
+		long long heap_time, radix_time;
+
+		{
+			vector<unsigned>dijkstra_source(source.begin(), source.begin()+100), dijkstra_target(target.begin(), target.begin()+100);
+
+			cout << "Running Dijkstra with 4-ary heap ... " << flush;
+			heap_time = -get_micro_time();
+			auto heap_dist = run_dijkstra<MinIDQueue>(first_out, tail, head, weight, dijkstra_source, dijkstra_target);
+			heap_time += get_micro_time();
+			cout << "done [" << heap_time/dijkstra_source.size() << "musec/query]" << endl;
+
+			cout << "Running Dijkstra with radix queue ... " << flush;
+			radix_time = -get_micro_time();
+			auto radix_dist = run_dijkstra<MinIDRadixQueue>(first_out, tail, head, weight, dijkstra_source, dijkstra_target);
+			radix_time += get_micro_time();
+			cout << "done [" << radix_time/dijkstra_source.size() << "musec/query]" << endl;
+
+			EXPECT(heap_dist == radix_dist);
+		}
+
+		{
+			vector<vector<unsigned>>heap_path, radix_path;
+
+			cout << "Running CH queries with 4-ary heap ... " << flush;
+			heap_time = -get_micro_time();
+			auto heap_dist = run_contraction_hierarchy_queries<MinIDQueue>(ch, source, target);
+			heap_time += get_micro_time();
+			cout << "done [" << heap_time/source.size() << "musec/query]" << endl;
+
+			cout << "Running CH queries with radix queue ... " << flush;
+			radix_time = -get_micro_time();
+			auto radix_dist = run_contraction_hierarchy_queries<MinIDRadixQueue>(ch, source, target);
+			radix_time += get_micro_time();
+			cout << "done [" << radix_time/source.size() << "musec/query]" << endl;
+
+			EXPECT(heap_dist == radix_dist);
+
+			cout << "Comparing paths ... " << flush;
+			run_contraction_hierarchy_queries<MinIDQueue>(ch, source, target, &heap_path);
+			run_contraction_hierarchy_queries<MinIDRadixQueue>(ch, source, target, &radix_path);
+			for(unsigned i=0; i<source.size(); ++i){
+				EXPECT(heap_path[i].empty() == radix_path[i].empty());
+				if(!radix_path[i].empty()){
+					EXPECT_CMP(radix_path[i].front(), ==, source[i]);
+					EXPECT_CMP(radix_path[i].back(), ==, target[i]);
+				}
+			}
+			cout << "done" << endl;
+		}
+
+		{
+			vector<unsigned>pinned_source(source.begin(), source.begin()+100), pinned_target(target.begin(), target.begin()+100);
+
+			cout << "Running pinned CH queries with 4-ary heap ... " << flush;
+			heap_time = -get_micro_time();
+			auto heap_dist = run_pinned_contraction_hierarchy_queries<MinIDQueue>(ch, pinned_source, pinned_target);
+			heap_time += get_micro_time();
+			cout << "done [" << heap_time/pinned_source.size() << "musec/source]" << endl;
+
+			cout << "Running pinned CH queries with radix queue ... " << flush;
+			radix_time = -get_micro_time();
+			auto radix_dist = run_pinned_contraction_hierarchy_queries<MinIDRadixQueue>(ch, pinned_source, pinned_target);
+			radix_time += get_micro_time();
+			cout << "done [" << radix_time/pinned_source.size() << "musec/source]" << endl;
+
+			EXPECT(heap_dist == radix_dist);
+		}
+
+	}catch(exception&err){
+		cout << "Stopped on exception : "<< err.what() << endl;
+		return 1;
+	}
+	return expect_failed;
+}